@@ -0,0 +1,105 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include "arena.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Allocation policy of the Make factories (scene graph objects) and of the
+// node child arrays:
+//   HEAP:   object and shared_ptr control block allocated separately (new)
+//   SHARED: one allocation for both (allocate_shared)
+//   POOL:   as SHARED, from fixed size block pools (one per size class)
+//   ARENA:  as SHARED, from the arena of the current ArenaScope (POOL if none)
+// The policy is global; arenas are set per thread.
+class Allocation {
+public:
+  enum POLICY {HEAP=0, SHARED, POOL, ARENA};
+  static void SetPolicy (POLICY policy);
+  static POLICY GetPolicy ();
+  // objects made by this thread go to arena while the scope lives
+  class ArenaScope {
+    ArenaPtr m_previous;
+  public:
+    ArenaScope (ArenaPtr arena);
+    ~ArenaScope ();
+  };
+  static ArenaPtr GetArena ();
+  // thread-safe fixed size blocks (sizes above MAX_POOLED use the heap)
+  static const size_t MAX_POOLED = 1024;
+  static void* PoolAllocate (size_t size);
+  static void PoolFree (void* ptr, size_t size);
+  template <class T, class... Args>
+  static std::shared_ptr<T> Make (Args&&... args);
+};
+
+// Allocator following the policy in effect when it was created
+template <class T>
+class Allocator {
+  template <class U> friend class Allocator;
+  Allocation::POLICY m_policy;
+  ArenaPtr m_arena;
+public:
+  using value_type = T;
+  Allocator ()
+  : m_policy(Allocation::GetPolicy()),
+    m_arena(m_policy == Allocation::ARENA ? Allocation::GetArena() : nullptr)
+  {
+    if (m_policy == Allocation::ARENA && !m_arena)
+      m_policy = Allocation::POOL;
+  }
+  template <class U>
+  Allocator (const Allocator<U>& other)
+  : m_policy(other.m_policy), m_arena(other.m_arena)
+  {
+  }
+  T* allocate (size_t n)
+  {
+    size_t size = n * sizeof(T);
+    switch (m_policy) {
+      case Allocation::POOL: return (T*)Allocation::PoolAllocate(size);
+      case Allocation::ARENA: return (T*)m_arena->Allocate(size,alignof(T));
+      default: return (T*)::operator new(size);
+    }
+  }
+  void deallocate (T* ptr, size_t n)
+  {
+    switch (m_policy) {
+      case Allocation::POOL: Allocation::PoolFree(ptr,n*sizeof(T)); break;
+      case Allocation::ARENA: break;   // released with the arena
+      default: ::operator delete(ptr);
+    }
+  }
+  template <class U>
+  bool operator== (const Allocator<U>& other) const
+  {
+    return m_policy == other.m_policy && m_arena == other.m_arena;
+  }
+  template <class U>
+  bool operator!= (const Allocator<U>& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+// Gives the factories' protected constructors to allocate_shared
+template <class T>
+struct Allocated : public T {
+  template <class... Args>
+  Allocated (Args&&... args)
+  : T(std::forward<Args>(args)...)
+  {
+  }
+};
+
+template <class T, class... Args>
+std::shared_ptr<T> Allocation::Make (Args&&... args)
+{
+  if (GetPolicy() == HEAP)
+    return std::shared_ptr<T>(new Allocated<T>(std::forward<Args>(args)...));
+  return std::allocate_shared<Allocated<T>>(Allocator<Allocated<T>>(),std::forward<Args>(args)...);
+}
+
+#endif
@@ -5,6 +5,7 @@ using  AppearancePtr = std::shared_ptr<Appearance>;
 #ifndef APPEARANCE_H
 #define APPEARANCE_H
 
+#include "hash.h"
 #include "state.h"
 
 class Appearance {
@@ -12,6 +13,12 @@ public:
   virtual ~Appearance () {}
   virtual void Load (StatePtr st) = 0;
   virtual void Unload (StatePtr ) { }
+  // h accumulated over what the appearance draws with (see Hash), for
+  // caches of rendered images; by default, the appearance identity
+  virtual size_t AddToHash (size_t h) const
+  {
+    return Hash::Value(h,this);
+  }
 };
 
 #endif
\ No newline at end of file
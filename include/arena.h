@@ -0,0 +1,35 @@
+#include <memory>
+class Arena;
+using ArenaPtr = std::shared_ptr<Arena>;
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Bump allocator over large chunks: objects allocated in sequence are
+// contiguous, freeing is a no-op, and the chunks are released at once when
+// the arena goes (allocators given out by Allocation hold a reference, so
+// this happens after the last object built in it is destroyed).
+class Arena {
+  std::vector<char*> m_chunks;
+  size_t m_chunk_size;
+  char* m_ptr;        // free space of the current chunk
+  size_t m_left;
+  size_t m_used;
+  size_t m_reserved;
+  std::mutex m_mutex;
+protected:
+  Arena (size_t chunk_size);
+public:
+  static ArenaPtr Make (size_t chunk_size=1<<20);
+  virtual ~Arena ();
+  void* Allocate (size_t size, size_t align);
+  // bytes handed out / bytes held in chunks
+  size_t GetUsed () const;
+  size_t GetReserved () const;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef BBOX_H
+#define BBOX_H
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box; an empty box means "unknown bounds",
+// which culling tests treat as always visible
+class BBox {
+  glm::vec3 m_min;
+  glm::vec3 m_max;
+public:
+  BBox ();
+  BBox (const glm::vec3& min, const glm::vec3& max);
+  bool IsEmpty () const;
+  const glm::vec3& GetMin () const;
+  const glm::vec3& GetMax () const;
+  glm::vec3 GetCenter () const;
+  glm::vec3 GetExtent () const;   // half size
+  void Extend (const glm::vec3& p);
+  void Extend (const BBox& box);
+  // box enclosing this box transformed by mat
+  BBox Transform (const glm::mat4& mat) const;
+};
+
+#endif
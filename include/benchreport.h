@@ -0,0 +1,40 @@
+#include <memory>
+class BenchReport;
+using BenchReportPtr = std::shared_ptr<BenchReport>;
+
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Benchmark results by scene and metric, saved as JSON:
+//   {"scenes": {"<scene>": {"<metric>": <number>, ...}, ...}}
+// Metrics named *_ms are times, lower is better; Compare lists the ones
+// of a base report that got slower than threshold (0.1: 10%) in another,
+// ignoring changes under min_ms (timer noise).
+class BenchReport {
+  std::map<std::string,std::map<std::string,double>> m_scenes;
+protected:
+  BenchReport ();
+public:
+  struct Regression {
+    std::string scene;
+    std::string metric;
+    double base;
+    double current;
+  };
+  static BenchReportPtr Make ();
+  // null if the file cannot be read or parsed
+  static BenchReportPtr Load (const std::string& filename);
+  virtual ~BenchReport ();
+  void Set (const std::string& scene, const std::string& metric, double value);
+  bool Get (const std::string& scene, const std::string& metric, double& value) const;
+  const std::map<std::string,std::map<std::string,double>>& GetScenes () const;
+  bool Save (const std::string& filename) const;
+  static std::vector<Regression> Compare (const BenchReport& base, const BenchReport& current,
+                                          double threshold=0.1, double min_ms=0.05);
+};
+
+#endif
@@ -14,6 +14,7 @@ class Camera3D : public Camera {
   bool m_ortho;
   float m_fovy;
   float m_znear, m_zfar;
+  float m_aspect;       // width/height (0: from the viewport)
   glm::vec3 m_center;   
   glm::vec3 m_eye;   
   glm::vec3 m_up;   
@@ -30,6 +31,9 @@ public:
   void SetEye (float x, float y, float z);
   void SetUpDir (float x, float y, float z);
   void SetOrtho (bool ortho);
+  // fixed aspect ratio: the projection is then computed without querying
+  // GL, so off the thread owning the context (0: viewport's)
+  void SetAspect (float ratio);
   ArcballPtr CreateArcball ();
   ArcballPtr GetArcball () const;
   void SetReference (NodePtr reference);
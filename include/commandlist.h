@@ -0,0 +1,69 @@
+#include <memory>
+class CommandList;
+using CommandListPtr = std::shared_ptr<CommandList>;
+
+#ifndef COMMAND_LIST_H
+#define COMMAND_LIST_H
+
+#include "camera.h"
+#include "fixedcamera.h"
+#include "frustum.h"
+#include "node.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Frame of a scene graph recorded as a flat list of commands: Record does
+// the traversal, frustum culling and matrix products (no GL call), and
+// Execute replays the shader and appearance loads and the draws, possibly
+// on another thread (see RenderThread). Commands refer to shaders,
+// appearances and shapes by raw pointer: they must stay alive, and
+// unchanged, until the list has been executed; transforms are copied.
+class CommandList {
+public:
+  enum OP {
+    CLEAR,
+    LOAD_SHADER,
+    UNLOAD_SHADER,
+    LOAD_APPEARANCE,
+    UNLOAD_APPEARANCE,
+    DRAW
+  };
+private:
+  struct Command {
+    OP op;
+    void* object;
+    int index;     // first matrix of the command (CLEAR: mask)
+  };
+  std::vector<Command> m_commands;
+  // LOAD_SHADER: model; DRAW: model, mvp, mv, mn
+  std::vector<glm::mat4> m_matrices;
+  // traversal state
+  std::vector<bool> m_camera_space;   // lighting space of the loaded shaders
+  glm::mat4 m_view, m_proj;
+  Frustum m_frustum;
+  bool m_cull;
+  FixedCameraPtr m_camera;
+  int m_draws, m_culled;
+  double m_record_time;               // ms, since Begin
+protected:
+  CommandList ();
+public:
+  static CommandListPtr Make ();
+  virtual ~CommandList ();
+  // start a new frame seen by camera (its matrices are queried here)
+  void Begin (CameraPtr camera);
+  // glClear at this point of the frame
+  void Clear (unsigned int mask);
+  // append the graph under root, as Node::Render would draw it
+  void Record (NodePtr root, bool cull=true);
+  // replay the frame: needs the GL context
+  void Execute ();
+  int GetCommandCount () const;
+  int GetDrawCount () const;
+  int GetCulledCount () const;
+  double GetRecordTime () const;
+private:
+  void RecordNode (const Node* node, const glm::mat4& parent);
+};
+
+#endif
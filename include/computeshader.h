@@ -8,13 +8,39 @@ using ComputeShaderPtr = std::shared_ptr<ComputeShader>;
 #define COMPUTESHADER_H
 
 #include "texbuffer.h"
+#include "storagebuffer.h"
+#include "glhandle.h"
+#include <glm/glm.hpp>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class ComputeShader { 
-  unsigned int m_sid;
-  unsigned int m_pid = 0;
+public:
+  // memory barrier scopes: what the following commands read from the
+  // buffers/images written by a dispatch
+  enum BARRIER {
+    STORAGE=1,           // shader storage buffer accesses
+    TEXTURE_FETCH=2,     // texture (and texture buffer) reads
+    BUFFER_UPDATE=4,     // buffer copies and readbacks
+    IMAGE_ACCESS=8,      // image loads and stores
+    VERTEX_ATTRIB=16,    // vertex data
+    ELEMENT_ARRAY=32,    // index data
+    INDIRECT=64,         // indirect draw/dispatch commands
+    UNIFORM=128,         // uniform buffers
+    ALL=255
+  };
+private:
+  GLShader m_shader;
+  GLProgram m_program;
+  std::string m_filename;
   std::vector<TexBufferPtr> m_texbuffers;
+  std::vector<std::pair<int,StorageBufferPtr>> m_storages;  // (binding, buffer)
+  mutable std::unordered_map<std::string,int> m_uniforms;    // location cache
+  // stage and program being compiled by a reload
+  GLShader m_pending_shader;
+  GLProgram m_pending_program;
+  int m_barrier = STORAGE | TEXTURE_FETCH | BUFFER_UPDATE;  // issued after dispatch
 
 protected:
   ComputeShader(const std::string& filename);
@@ -26,8 +52,30 @@ public:
   // Attach a texture buffer to the compute shader
   void AttachTexBuffer(const TexBufferPtr texbuf);
 
+  // Attach a shader storage buffer to the given binding point
+  // (replacing the buffer previously attached to it)
+  void AttachStorageBuffer(int binding, const StorageBufferPtr buf);
+
+  // Create program if needed and make it current (to set uniforms)
+  void UseProgram();
+  int GetUniformLocation(const std::string& varname) const;
+  void SetUniform(const std::string& varname, int x);
+  void SetUniform(const std::string& varname, float x);
+  void SetUniform(const std::string& varname, const glm::vec4& vet);
+  void SetUniform(const std::string& varname, const glm::mat4& mat);
+
   // Create program if needed, bind images & uniforms, and dispatch
   void Dispatch(int nx, int ny = 1, int nz = 1);
+
+  // Barrier issued after each dispatch (0: none, the caller issues it
+  // with Barrier where the results are consumed)
+  void SetBarrier(int scope);
+  static void Barrier(int scope);
+
+  // Recompile if the source changed; the program is swapped by PollReload
+  bool Reload(const std::unordered_map<std::string,std::string>& changed);
+  bool PollReload();
+  const std::string& GetSourceFile() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef CPU_PRIMITIVES_H
+#define CPU_PRIMITIVES_H
+
+#include <vector>
+
+// Multithreaded CPU versions of the GPU parallel primitives (GPUPrimitives),
+// used as reference results and as a throughput baseline. The input is split
+// in one contiguous chunk per thread; results do not depend on the number
+// of threads.
+class CPUPrimitives {
+public:
+  enum OP {SUM=0, MIN, MAX};
+  // number of worker threads (0: hardware concurrency)
+  static void SetThreadCount (int n);
+  static int GetThreadCount ();
+  // out[i] = in[0] + ... + in[i-1] (out may alias in)
+  static void ExclusiveScan (const std::vector<unsigned int>& in, std::vector<unsigned int>& out);
+  static unsigned int Reduce (const std::vector<unsigned int>& in, OP op=SUM);
+  // keep in[i] where flags[i] != 0, in order; returns the number kept
+  static int Compact (const std::vector<unsigned int>& in, const std::vector<unsigned int>& flags,
+                      std::vector<unsigned int>& out);
+  // stable LSD radix sort of (key, value) pairs by key
+  static void SortPairs (std::vector<unsigned int>& keys, std::vector<unsigned int>& values);
+};
+
+#endif
@@ -6,14 +6,19 @@ using CubePtr = std::shared_ptr<Cube>;
 #define CUBE_H
 
 #include "shape.h"
+#include "vertexarray.h"
 
 class Cube : public Shape {
-  unsigned int m_vao;
+  VertexArrayPtr m_array;   // shared with equal instances
 protected:
   Cube ();
 public:
   static CubePtr Make ();
   virtual ~Cube ();
+  // the triangles of every cube, built on the CPU (no GL call)
+  static MeshData Geometry ();
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
 };
 #endif
\ No newline at end of file
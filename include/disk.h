@@ -6,15 +6,17 @@ using DiskPtr = std::shared_ptr<Disk>;
 #define DISK_H
 
 #include "shape.h"
+#include "vertexarray.h"
 
 class Disk : public Shape {
-  unsigned int m_vao;
-  int m_nslice;
+  VertexArrayPtr m_array;   // shared with equal instances
 protected:
   Disk (int nslice);
 public:
   static DiskPtr Make (int nslice=64);
   virtual ~Disk ();
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
 };
 #endif
\ No newline at end of file
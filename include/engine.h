@@ -5,12 +5,24 @@ using EnginePtr = std::shared_ptr<Engine>;
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include "transform.h"
+#include <vector>
+
 class Engine {
+  // transforms accessed by Update, for Scene::Update to run engines in
+  // parallel; an engine that declares none may touch anything
+  std::vector<const Transform*> m_reads;
+  std::vector<const Transform*> m_writes;
   protected:
   Engine () {}
+  void Reads (TransformPtr trf) { m_reads.push_back(trf.get()); }
+  void Writes (TransformPtr trf) { m_writes.push_back(trf.get()); }
   public:
   virtual ~Engine () {}
   virtual void Update (float dt) = 0;  // to update the world
+  bool HasAccessSet () const { return !m_reads.empty() || !m_writes.empty(); }
+  const std::vector<const Transform*>& GetReads () const { return m_reads; }
+  const std::vector<const Transform*>& GetWrites () const { return m_writes; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,239 @@
+#include <memory>
+class EntityStore;
+using EntityStorePtr = std::shared_ptr<EntityStore>;
+
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include "appearance.h"
+#include "camera.h"
+#include "node.h"
+#include "scene.h"
+#include "shader.h"
+#include "shape.h"
+#include "state.h"
+#include "transform.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <map>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+// Handle to an entity: the slot index plus the generation the slot had when
+// the entity was created, so handles to destroyed entities are detected
+struct Entity {
+  uint32_t index;
+  uint32_t generation;
+  bool operator== (const Entity& other) const { return index == other.index && generation == other.generation; }
+  bool operator!= (const Entity& other) const { return !(*this == other); }
+  static Entity Null () { return {~0u,0u}; }
+};
+
+// Components: plain data, referring to scene objects by raw pointer (the
+// store keeps them alive, see EntityStore::Keep)
+struct TransformComponent {
+  glm::mat4 local;
+  glm::mat4 world;
+  const Transform* source;  // local is pulled from it on update (may be null)
+  int parent;               // dense index of the parent transform (-1: root)
+};
+struct HierarchyComponent {
+  Entity parent;
+};
+struct ShapeComponent {
+  Shape* shape;
+  Entity node;              // entity whose world matrix places the shape
+};
+struct MaterialComponent {
+  int set;                  // appearance set (EntityStore::AddAppearanceSet)
+};
+struct ShaderComponent {
+  Shader* shader;
+};
+
+// Sparse set: components packed in a dense array, with the entity of each
+// element and an entity index to element map. Removal moves the last element
+// into the hole.
+template <class T>
+class ComponentArray {
+  std::vector<T> m_data;
+  std::vector<uint32_t> m_entities;   // entity index of each element
+  std::vector<int> m_sparse;          // entity index -> element (-1: none)
+public:
+  T& Add (uint32_t entity, const T& c)
+  {
+    if (entity >= m_sparse.size())
+      m_sparse.resize(entity+1,-1);
+    if (m_sparse[entity] >= 0)
+      return m_data[m_sparse[entity]] = c;
+    m_sparse[entity] = int(m_data.size());
+    m_data.push_back(c);
+    m_entities.push_back(entity);
+    return m_data.back();
+  }
+  bool Remove (uint32_t entity)
+  {
+    int i = IndexOf(entity);
+    if (i < 0)
+      return false;
+    int last = int(m_data.size()) - 1;
+    m_data[i] = m_data[last];
+    m_entities[i] = m_entities[last];
+    m_sparse[m_entities[i]] = i;
+    m_sparse[entity] = -1;
+    m_data.pop_back();
+    m_entities.pop_back();
+    return true;
+  }
+  int IndexOf (uint32_t entity) const
+  {
+    return entity < m_sparse.size() ? m_sparse[entity] : -1;
+  }
+  T* Get (uint32_t entity)
+  {
+    int i = IndexOf(entity);
+    return i < 0 ? nullptr : &m_data[i];
+  }
+  // rearrange so that element i is the former element order[i]
+  void Reorder (const std::vector<int>& order)
+  {
+    std::vector<T> data(m_data.size());
+    std::vector<uint32_t> entities(m_entities.size());
+    for (size_t i=0; i<order.size(); ++i) {
+      data[i] = m_data[order[i]];
+      entities[i] = m_entities[order[i]];
+      m_sparse[entities[i]] = int(i);
+    }
+    m_data.swap(data);
+    m_entities.swap(entities);
+  }
+  int Size () const { return int(m_data.size()); }
+  T& operator[] (int i) { return m_data[i]; }
+  const T& operator[] (int i) const { return m_data[i]; }
+  uint32_t EntityAt (int i) const { return m_entities[i]; }
+};
+
+// Alternative scene representation: entities are handles, their components
+// live in dense arrays, and systems walk those arrays linearly instead of
+// chasing Node pointers. Transforms are kept parents first, so world matrices
+// are computed in one pass; draws are sorted by shader and appearance set,
+// so state changes happen only between runs of equal keys.
+// Make(scene) builds a store from a scene graph; entities keep pointing at
+// the graph's Transforms, so engines animating them still drive the store.
+// Shaders are loaded with the identity matrix: their light is taken as
+// given in world space.
+class EntityStore {
+  std::vector<uint32_t> m_generations;
+  std::vector<uint32_t> m_free;
+  int m_alive;
+  ComponentArray<TransformComponent> m_transforms;
+  ComponentArray<HierarchyComponent> m_hierarchy;
+  ComponentArray<ShapeComponent> m_shapes;
+  ComponentArray<MaterialComponent> m_materials;
+  ComponentArray<ShaderComponent> m_shaders;
+  std::vector<std::vector<Appearance*>> m_sets;
+  std::map<std::vector<Appearance*>,int> m_set_ids;
+  // objects referred to by components
+  std::vector<std::shared_ptr<void>> m_refs;
+  std::unordered_set<const void*> m_kept;
+  // draw order: dense shape index sorted by (shader, set)
+  struct Draw {
+    Shader* shader;
+    int set;
+    int shape;
+  };
+  std::vector<Draw> m_draws;
+  bool m_order_dirty;   // hierarchy changed: transforms must be re-sorted
+  bool m_draws_dirty;
+protected:
+  EntityStore ();
+public:
+  static EntityStorePtr Make ();
+  static EntityStorePtr Make (ScenePtr scene);
+  virtual ~EntityStore ();
+  Entity Create ();
+  // destroy entity and its components (children keep their own)
+  void Destroy (Entity e);
+  bool IsAlive (Entity e) const;
+  int GetEntityCount () const;
+  int GetDrawCount () const;
+
+  template <class T>
+  ComponentArray<T>& GetComponents ();
+  template <class T>
+  T& Add (Entity e, const T& c)
+  {
+    Touch<T>();
+    return GetComponents<T>().Add(e.index,c);
+  }
+  template <class T>
+  T* Get (Entity e)
+  {
+    return IsAlive(e) ? GetComponents<T>().Get(e.index) : nullptr;
+  }
+  template <class T>
+  void Remove (Entity e)
+  {
+    if (IsAlive(e) && GetComponents<T>().Remove(e.index))
+      Touch<T>();
+  }
+
+  // keep a referenced object alive while the store exists
+  template <class T>
+  T* Keep (const std::shared_ptr<T>& ptr)
+  {
+    if (ptr && m_kept.insert(ptr.get()).second)
+      m_refs.push_back(ptr);
+    return ptr.get();
+  }
+  // appearances loaded in order for a draw; equal sets share their id
+  int AddAppearanceSet (const std::vector<AppearancePtr>& apps);
+  // add the graph under node, with inherited shader and appearances
+  Entity Import (NodePtr node, Entity parent=Entity::Null());
+
+  // systems
+  void UpdateTransforms ();
+  void Render (CameraPtr camera);
+  void Render (StatePtr st);
+private:
+  template <class T>
+  void Touch ()
+  {
+    if (std::is_same<T,TransformComponent>::value || std::is_same<T,HierarchyComponent>::value)
+      m_order_dirty = true;
+    else
+      m_draws_dirty = true;
+  }
+  Entity Import (NodePtr node, Entity parent, ShaderPtr shader, std::vector<AppearancePtr>& apps);
+  void SortTransforms ();
+  void BuildDraws ();
+};
+
+template <>
+inline ComponentArray<TransformComponent>& EntityStore::GetComponents<TransformComponent> ()
+{
+  return m_transforms;
+}
+template <>
+inline ComponentArray<HierarchyComponent>& EntityStore::GetComponents<HierarchyComponent> ()
+{
+  return m_hierarchy;
+}
+template <>
+inline ComponentArray<ShapeComponent>& EntityStore::GetComponents<ShapeComponent> ()
+{
+  return m_shapes;
+}
+template <>
+inline ComponentArray<MaterialComponent>& EntityStore::GetComponents<MaterialComponent> ()
+{
+  return m_materials;
+}
+template <>
+inline ComponentArray<ShaderComponent>& EntityStore::GetComponents<ShaderComponent> ()
+{
+  return m_shaders;
+}
+
+#endif
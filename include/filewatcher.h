@@ -0,0 +1,45 @@
+#include <memory>
+class FileWatcher;
+using FileWatcherPtr = std::shared_ptr<FileWatcher>;
+
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches files from a background thread (inotify on Linux, modification
+// time polling elsewhere) and keeps the new content of the changed ones
+class FileWatcher {
+  struct Entry {
+    std::string filename;
+    std::string dir;
+    std::string name;
+    long long mtime;
+  };
+  int m_fd;                                      // inotify descriptor (-1 if polling)
+  std::unordered_map<int,std::string> m_dirs;    // watch descriptor -> directory
+  std::vector<Entry> m_entries;
+  std::unordered_map<std::string,std::string> m_changes;  // filename -> content
+  std::mutex m_mutex;
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+protected:
+  FileWatcher ();
+public:
+  static FileWatcherPtr Make ();
+  virtual ~FileWatcher ();
+  void Watch (const std::string& filename);
+  // return (and forget) the files changed since the last call
+  std::unordered_map<std::string,std::string> TakeChanges ();
+private:
+  void Run ();
+  void Notify (const std::string& dir, const std::string& name);
+  void PollModificationTimes ();
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include <memory>
+class FixedCamera;
+using FixedCameraPtr = std::shared_ptr<FixedCamera>;
+
+#ifndef FIXED_CAMERA_H
+#define FIXED_CAMERA_H
+
+#include "camera.h"
+#include <glm/glm.hpp>
+
+// Camera with given view and projection matrices (e.g. a light's or a
+// mirrored view rendered by an off-screen pass)
+class FixedCamera : public Camera {
+  glm::mat4 m_view;
+  glm::mat4 m_proj;
+protected:
+  FixedCamera (const glm::mat4& view, const glm::mat4& proj);
+public:
+  static FixedCameraPtr Make (const glm::mat4& view, const glm::mat4& proj);
+  virtual ~FixedCamera ();
+  void SetMatrices (const glm::mat4& view, const glm::mat4& proj);
+  virtual glm::mat4 GetProjMatrix () const;
+  virtual glm::mat4 GetViewMatrix () const;
+  virtual void Load (StatePtr st) const;
+};
+
+#endif
@@ -7,11 +7,12 @@ using FramebufferPtr = std::shared_ptr<Framebuffer>;
 
 #include "texture.h"
 #include "texdepth.h"
+#include "glhandle.h"
 #include <vector>
 #include <initializer_list>
 
 class Framebuffer {
-  unsigned int m_fbo;
+  GLFramebuffer m_fbo;
   TexDepthPtr m_depth;
   std::vector<TexturePtr> m_colors;
 protected:
@@ -21,6 +22,9 @@ public:
   ~Framebuffer ();
   TexDepthPtr GetDepthTexture () const;
   TexturePtr GetColorTexture (int i) const;
+  unsigned int GetId () const;
+  // render to a single face of a cube depth texture (0 to 5: +x, -x, +y, -y, +z, -z)
+  void SetDepthFace (int face);
   void Bind ();
   void Unbind ();
 };
@@ -0,0 +1,19 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "bbox.h"
+#include <glm/glm.hpp>
+
+// Frustum planes extracted from a view-projection matrix
+class Frustum {
+  glm::vec4 m_planes[6];   // left, right, bottom, top, far, near (inward normals)
+  int m_nplanes;
+public:
+  // without near plane, objects between the eye and the frustum are kept
+  // (e.g. shadow casters in front of a light's volume)
+  Frustum (const glm::mat4& viewproj=glm::mat4(1.0f), bool use_near=true);
+  bool Intersects (const BBox& box) const;
+  bool Contains (const glm::vec3& p) const;
+};
+
+#endif
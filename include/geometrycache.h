@@ -0,0 +1,33 @@
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include "vertexarray.h"
+#include <functional>
+#include <string>
+
+// Registry of the vertex arrays of procedural shapes (Cube, Quad, Sphere,
+// Disk), keyed by shape type and parameters: instances with equal keys
+// share one GPU allocation, released with the last of them. Also accounts
+// the GPU memory of all vertex arrays. Used from the GL thread only.
+class GeometryCache {
+public:
+  struct Stats {
+    int arrays;      // shared arrays alive
+    int users;       // instances using them
+    long bytes;      // GPU memory of all vertex arrays alive
+    long saved;      // memory unshared copies would add
+    long hits;       // Get calls served from the cache
+    long misses;     // Get calls that built an array
+  };
+  // array of key, built by build if not cached
+  static VertexArrayPtr Get (const std::string& key, const std::function<VertexArrayPtr()>& build);
+  // disabled: every Get builds a new array (for comparison)
+  static void SetEnabled (bool enabled);
+  static bool IsEnabled ();
+  static Stats GetStats ();
+  static void ResetStats ();
+  // change of the GPU memory in use (by VertexArray)
+  static void Account (long bytes);
+};
+
+#endif
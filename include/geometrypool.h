@@ -0,0 +1,53 @@
+#include <memory>
+class GeometryPool;
+using GeometryPoolPtr = std::shared_ptr<GeometryPool>;
+
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include "bbox.h"
+#include "glhandle.h"
+#include <vector>
+
+// Vertex and index data of many meshes in shared buffers (one vertex array),
+// so that they can all be drawn by a single multi-draw call: each mesh is a
+// range of the index buffer plus a base vertex. Meshes are kept on the CPU
+// as well, and the buffers are re-uploaded on the first bind after a change.
+class GeometryPool {
+public:
+  struct Range {
+    int first;          // first index
+    int count;          // number of indices
+    int base_vertex;
+    BBox bounds;        // model space
+  };
+private:
+  GLVertexArray m_vao;
+  GLBuffer m_buffers[4];       // coord, normal, texcoord, index
+  std::vector<float> m_coords;
+  std::vector<float> m_normals;
+  std::vector<float> m_texcoords;
+  std::vector<unsigned int> m_indices;
+  std::vector<Range> m_ranges;
+  bool m_dirty;
+protected:
+  GeometryPool ();
+public:
+  static GeometryPoolPtr Make ();
+  virtual ~GeometryPool ();
+  // add a mesh of nverts vertices (3 coords, 3 normal and 2 texcoord
+  // components each; normals and texcoords may be null) and nind
+  // triangle indices; returns the mesh id
+  int AddMesh (int nverts, const float* coords, const float* normals, const float* texcoords,
+               int nind, const unsigned int* indices);
+  int GetMeshCount () const;
+  const Range& GetMesh (int id) const;
+  int GetVertexCount () const;
+  int GetIndexCount () const;
+  // bind the vertex array (index buffer included)
+  void Bind ();
+private:
+  void Upload ();
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef GL_HANDLE_H
+#define GL_HANDLE_H
+
+// Accounting of the GL objects owned through GLHandle: objects alive and
+// an estimate of their GPU memory, per kind. A scene rebuilt over and over
+// must keep these flat. Used from the GL thread only.
+class GLObjects {
+public:
+  enum KIND {
+    BUFFER,
+    VERTEX_ARRAY,
+    TEXTURE,
+    FRAMEBUFFER,
+    PROGRAM,
+    SHADER,
+    QUERY,
+    NKINDS
+  };
+  struct Stats {
+    long live;       // objects alive
+    long bytes;      // memory estimate of those alive
+    long created;    // objects created (or adopted)
+    long deleted;
+  };
+  // new object name (shader objects need a type: see GLHandle::Reset)
+  static unsigned int Create (KIND kind);
+  static void Delete (KIND kind, unsigned int id);
+  // objects created elsewhere and adopted by handles
+  static void Track (KIND kind, long count);
+  // change of the memory estimate
+  static void Account (KIND kind, long bytes);
+  static Stats GetStats (KIND kind);
+  // live objects of all kinds
+  static long GetLive ();
+  static long GetBytes ();
+  // zero the created and deleted counters
+  static void ResetStats ();
+  static const char* GetKindName (KIND kind);
+};
+
+// Owner of one GL object name, deleted (and its bytes released from the
+// accounting) when the handle is reset or destroyed. Movable, not copyable:
+// objects shared by several users are held through a shared_ptr.
+template <int KIND>
+class GLHandle {
+  unsigned int m_id;
+  long m_bytes;
+public:
+  GLHandle ()
+  : m_id(0), m_bytes(0)
+  {
+  }
+  // take ownership of an object created by the caller
+  explicit GLHandle (unsigned int id)
+  : m_id(0), m_bytes(0)
+  {
+    Reset(id);
+  }
+  GLHandle (GLHandle&& other)
+  : m_id(other.m_id), m_bytes(other.m_bytes)
+  {
+    other.m_id = 0;
+    other.m_bytes = 0;
+  }
+  GLHandle& operator= (GLHandle&& other)
+  {
+    if (this != &other) {
+      Reset();
+      m_id = other.m_id;
+      m_bytes = other.m_bytes;
+      other.m_id = 0;
+      other.m_bytes = 0;
+    }
+    return *this;
+  }
+  GLHandle (const GLHandle&) = delete;
+  GLHandle& operator= (const GLHandle&) = delete;
+  ~GLHandle ()
+  {
+    Reset();
+  }
+  // replace the object by a new one
+  void Create ()
+  {
+    Reset();
+    m_id = GLObjects::Create(GLObjects::KIND(KIND));
+  }
+  // delete the object; adopt id, if given
+  void Reset (unsigned int id=0)
+  {
+    if (m_id) {
+      SetBytes(0);
+      GLObjects::Delete(GLObjects::KIND(KIND),m_id);
+    }
+    m_id = id;
+    if (m_id)
+      GLObjects::Track(GLObjects::KIND(KIND),1);
+  }
+  unsigned int Get () const
+  {
+    return m_id;
+  }
+  explicit operator bool () const
+  {
+    return m_id != 0;
+  }
+  // memory estimate of the object's storage (e.g. after glBufferData)
+  void SetBytes (long bytes)
+  {
+    GLObjects::Account(GLObjects::KIND(KIND),bytes-m_bytes);
+    m_bytes = bytes;
+  }
+  long GetBytes () const
+  {
+    return m_bytes;
+  }
+};
+
+using GLBuffer = GLHandle<GLObjects::BUFFER>;
+using GLVertexArray = GLHandle<GLObjects::VERTEX_ARRAY>;
+using GLTexture = GLHandle<GLObjects::TEXTURE>;
+using GLFramebuffer = GLHandle<GLObjects::FRAMEBUFFER>;
+using GLProgram = GLHandle<GLObjects::PROGRAM>;
+using GLShader = GLHandle<GLObjects::SHADER>;
+using GLQuery = GLHandle<GLObjects::QUERY>;
+
+#endif
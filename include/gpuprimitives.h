@@ -0,0 +1,57 @@
+#include <memory>
+class GPUPrimitives;
+using GPUPrimitivesPtr = std::shared_ptr<GPUPrimitives>;
+
+#ifndef GPU_PRIMITIVES_H
+#define GPU_PRIMITIVES_H
+
+#include "computeshader.h"
+#include "readback.h"
+#include "storagebuffer.h"
+#include <string>
+#include <vector>
+
+// Data-parallel building blocks for the compute path, on storage buffers of
+// unsigned ints (shaders in shaders/cs): work-efficient exclusive scan
+// (Blelloch, per block of 512 values, recursing on the block sums),
+// reductions, stream compaction and a stable LSD radix sort of key/value
+// pairs (4-bit digits: per block histogram, scan, local split and scatter).
+// Temporary buffers are kept between calls and grow as needed. Inputs hold
+// at most MAX_COUNT values (one invocation each, 1D dispatch limit).
+// CPUPrimitives gives the reference results.
+class GPUPrimitives {
+public:
+  enum OP {SUM=0, MIN, MAX};
+  static const int MAX_COUNT = 65535*256;
+private:
+  ComputeShaderPtr m_scan_block, m_scan_add;
+  ComputeShaderPtr m_reduce;
+  ComputeShaderPtr m_compact;
+  ComputeShaderPtr m_radix_count, m_radix_scatter;
+  std::vector<StorageBufferPtr> m_sums;   // block sums of each scan level
+  StorageBufferPtr m_partial[2];          // reduction ping-pong
+  StorageBufferPtr m_offsets;             // scanned compaction flags
+  StorageBufferPtr m_count;               // values kept by the last compaction
+  StorageBufferPtr m_hist;                // radix digit counts per block
+  StorageBufferPtr m_tkeys, m_tvalues;    // radix sort ping-pong
+protected:
+  GPUPrimitives (const std::string& dir);
+public:
+  static GPUPrimitivesPtr Make (const std::string& dir="shaders/cs/");
+  virtual ~GPUPrimitives ();
+  // out[i] = in[0] + ... + in[i-1] for the first n values (out may be in)
+  void ExclusiveScan (StorageBufferPtr in, StorageBufferPtr out, int n);
+  // reduce the first n values; the result is read back without stalling
+  ReadbackPtr ReduceAsync (StorageBufferPtr in, int n, OP op=SUM);
+  unsigned int Reduce (StorageBufferPtr in, int n, OP op=SUM);
+  // copy in[i] with flags[i] != 0 to out, in order, and return their number
+  // (also left on the GPU, in GetCountBuffer)
+  int Compact (StorageBufferPtr in, StorageBufferPtr flags, StorageBufferPtr out, int n);
+  StorageBufferPtr GetCountBuffer () const;
+  // sort the first n (key, value) pairs by key, in place
+  void SortPairs (StorageBufferPtr keys, StorageBufferPtr values, int n);
+private:
+  void Scan (StorageBufferPtr in, StorageBufferPtr out, int n, int level, bool predicate);
+};
+
+#endif
@@ -5,10 +5,14 @@ using GridPtr = std::shared_ptr<Grid>;
 #ifndef GRID_H
 #define GRID_H
 
+#include <vector>
+
+// Regular (nx x ny) grid over [0,1]^2: vertex coordinates and triangle
+// indices. Grids are immutable, so Make shares equal ones while alive.
 class Grid {
   int m_nx, m_ny;
-  float* m_coords;
-  unsigned int* m_indices;
+  std::vector<float> m_coords;
+  std::vector<unsigned int> m_indices;
 protected:
   Grid (int nx, int ny);
 public:
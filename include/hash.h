@@ -0,0 +1,33 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <string>
+
+// FNV-1a, accumulated over the bytes of several values (e.g. the data
+// that determines a cached render): h = Hash::Value(h,x) for each x,
+// starting from Hash::SEED
+class Hash {
+public:
+  static const size_t SEED = 14695981039346656037ULL;
+  static size_t Bytes (size_t h, const void* data, size_t size)
+  {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i=0; i<size; ++i) {
+      h ^= bytes[i];
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+  template <class T>
+  static size_t Value (size_t h, const T& value)
+  {
+    return Bytes(h,&value,sizeof(T));
+  }
+  static size_t String (const std::string& data, size_t h=SEED)
+  {
+    return Bytes(h,data.data(),data.size());
+  }
+};
+
+#endif
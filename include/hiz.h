@@ -0,0 +1,38 @@
+#include <memory>
+class HiZ;
+using HiZPtr = std::shared_ptr<HiZ>;
+
+#ifndef HIZ_H
+#define HIZ_H
+
+#include "computeshader.h"
+#include "texdepth.h"
+#include "glhandle.h"
+#include <string>
+
+// Hierarchical depth buffer: mipmapped R32F copy of a depth texture in
+// which each texel of a level holds the farthest depth of the texels it
+// covers in the level below. A box whose nearest depth is behind the
+// depth of the (at most 2x2) texels covering its screen rectangle, at the
+// level where they are about its size, is occluded.
+class HiZ {
+  GLTexture m_tex;
+  int m_width, m_height;
+  int m_levels;
+  ComputeShaderPtr m_build;
+protected:
+  HiZ (const std::string& csfile);
+public:
+  static HiZPtr Make (const std::string& csfile="shaders/cs/hiz_build.glsl");
+  virtual ~HiZ ();
+  // rebuild the pyramid from the depth texture (resized to match it)
+  void Build (TexDepthPtr depth);
+  unsigned int GetTexId () const;
+  int GetWidth () const;
+  int GetHeight () const;
+  int GetLevelCount () const;
+private:
+  void Resize (int width, int height);
+};
+
+#endif
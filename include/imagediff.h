@@ -0,0 +1,33 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <string>
+#include <vector>
+
+// Golden image comparison: binary PPM files and a perceptual difference,
+// the CIE76 color distance (delta E in CIELAB, where about 2.3 is a just
+// noticeable difference). Each pixel is matched against the closest one
+// in a (2*radius+1)^2 window of the golden image, so one-pixel shifts of
+// edges between drivers are tolerated; an image passes if the fraction of
+// pixels above the threshold is at most the given one.
+class ImageDiff {
+public:
+  struct Pixels {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> rgb;   // top row first
+  };
+  struct Result {
+    bool same_size;
+    double mean;          // mean delta E
+    double max;           // max delta E
+    double bad;           // fraction of pixels above the threshold
+  };
+  static bool Read (const std::string& filename, Pixels& image);
+  static bool Write (const std::string& filename, const Pixels& image);
+  static Result Compare (const Pixels& golden, const Pixels& image, float threshold=5.0f,
+                         int radius=1);
+  static bool Pass (const Result& result, double max_bad=0.001);
+};
+
+#endif
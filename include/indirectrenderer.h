@@ -0,0 +1,75 @@
+#include <memory>
+class IndirectRenderer;
+using IndirectRendererPtr = std::shared_ptr<IndirectRenderer>;
+
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include "camera.h"
+#include "geometrypool.h"
+#include "hiz.h"
+#include "computeshader.h"
+#include "shape.h"
+#include "storagebuffer.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// GPU-driven drawing of many objects (instances of GeometryPool meshes):
+// transforms, bounds and colors live in a storage buffer, and a compute
+// pass (Cull) tests each object against the view frustum and, optionally,
+// against a HiZ pyramid of the previous frame, appending a draw command
+// for each survivor. Draw then submits everything with one multi-draw
+// indirect call, whatever the number of objects. The vertex shader
+// (shaders/indirect) gets the object index through the OBJECT attribute
+// (instanced, offset by the command's base instance) and reads its data
+// from storage binding OBJECTS.
+class IndirectRenderer : public Shape {
+public:
+  static const int OBJECTS = 5;   // storage binding read by the vertex shader
+private:
+  // std430 layout of Object in the shaders
+  struct ObjectData {
+    glm::mat4 model;
+    glm::vec4 bmin;           // model space bounds
+    glm::vec4 bmax;
+    glm::vec4 color;
+    unsigned int mesh[4];     // index count, first index, base vertex
+  };
+  GeometryPoolPtr m_pool;
+  std::vector<ObjectData> m_objects;
+  int m_dirty_begin, m_dirty_end;   // objects to upload
+  std::string m_csfile;
+  ComputeShaderPtr m_cull;
+  StorageBufferPtr m_object_buf;
+  StorageBufferPtr m_command_buf;
+  StorageBufferPtr m_count_buf;
+  GLBuffer m_ids;                   // object index of each instance
+  int m_ncommands;                  // objects at the last cull
+  HiZPtr m_hiz;
+  glm::mat4 m_hiz_viewproj;
+protected:
+  IndirectRenderer (GeometryPoolPtr pool, const std::string& csfile);
+public:
+  static IndirectRendererPtr Make (GeometryPoolPtr pool,
+                                   const std::string& csfile="shaders/cs/indirect_cull.glsl");
+  virtual ~IndirectRenderer ();
+  int AddObject (int mesh, const glm::mat4& model, const glm::vec4& color=glm::vec4(1.0f));
+  void SetTransform (int id, const glm::mat4& model);
+  void SetColor (int id, const glm::vec4& color);
+  int GetObjectCount () const;
+  // occlusion against hiz, built from a depth buffer rendered with viewproj
+  // (null: frustum culling only)
+  void SetOcclusion (HiZPtr hiz, const glm::mat4& viewproj);
+  void Cull (const glm::mat4& view, const glm::mat4& proj);
+  void Cull (CameraPtr camera);
+  // objects drawn by the last cull (reads back: stats only)
+  int GetVisibleCount () const;
+  virtual void Draw (StatePtr st);
+  // objects are culled on the GPU: never culled by the scene graph
+  virtual BBox GetBounds () const;
+private:
+  void Upload ();
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include <memory>
+class JobSystem;
+using JobSystemPtr = std::shared_ptr<JobSystem>;
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tasks with dependencies, run by JobSystem::Run: a task starts once all
+// the tasks it depends on have finished. The graph can be run many times.
+class TaskGraph {
+  struct Task {
+    std::function<void()> job;
+    std::vector<int> successors;
+    int ndeps;
+  };
+  std::vector<Task> m_tasks;
+  friend class JobSystem;
+public:
+  // returns the task id
+  int Add (const std::function<void()>& job);
+  // task runs after the task before
+  void Depend (int task, int before);
+  int GetTaskCount () const;
+  void Clear ();
+};
+
+// Fixed pool of worker threads with work stealing: each worker pushes and
+// pops jobs at the back of its own deque and, when empty, steals from the
+// front of the others'. Threads that wait on jobs (Wait, ParallelFor, Run)
+// execute jobs meanwhile, through an extra "caller" slot. Idle workers
+// sleep until jobs are queued.
+class JobSystem {
+public:
+  using Job = std::function<void()>;
+  struct Stats {
+    int jobs;              // jobs executed
+    int steals;            // jobs taken from another deque
+    double busy;           // time executing jobs, in ms
+    double utilisation;    // busy fraction of the time since ResetStats
+  };
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+    std::atomic<int> executed;
+    std::atomic<int> steals;
+    std::atomic<long long> busy;   // ns
+  };
+  std::vector<std::unique_ptr<Worker>> m_workers;  // threads, then the caller slot
+  std::vector<std::thread> m_threads;
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+  std::atomic<int> m_queued;
+  std::atomic<bool> m_stop;
+  std::chrono::steady_clock::time_point m_stats_start;
+protected:
+  JobSystem (int nthreads);
+public:
+  // nthreads workers (0: one less than the hardware threads)
+  static JobSystemPtr Make (int nthreads=0);
+  // shared pool, created on first use
+  static JobSystemPtr GetDefault ();
+  virtual ~JobSystem ();
+  int GetWorkerCount () const;
+  void Submit (const Job& job);
+  // execute jobs until counter drops to zero
+  void Wait (const std::atomic<int>& counter);
+  // f(b,e) over chunks [b,e) of at most grain indices of [begin,end)
+  void ParallelFor (int begin, int end, int grain, const std::function<void(int,int)>& f);
+  void Run (const TaskGraph& graph);
+  // one entry per worker, the last for the caller slot
+  std::vector<Stats> GetStats () const;
+  void ResetStats ();
+private:
+  int GetSlot () const;
+  bool RunOne (int slot);
+  void WorkerLoop (int slot);
+};
+
+#endif
@@ -6,16 +6,32 @@ using LightPtr = std::shared_ptr<Light>;
 #define LIGHT_H
 
 #include "node.h"
+#include "uniformbuffer.h"
 #include <glm/glm.hpp>
 #include <string>
 
 class Light {
+  // std140 layout of FrameBlock
+  struct FrameData {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec4 cpos;
+    glm::vec4 lpos;
+    glm::vec4 lamb;
+    glm::vec4 ldif;
+    glm::vec4 lspe;
+  };
   std::string m_space;
   glm::vec4 m_amb;
   glm::vec4 m_dif;
   glm::vec4 m_spe;
   glm::vec4 m_pos;
   NodePtr m_reference;
+  // frame block: one range per lighting space (camera, world), uploaded
+  // only when its content changes
+  mutable UniformBufferPtr m_ubo;
+  mutable FrameData m_frame[2];
+  mutable bool m_uploaded[2];
 protected:
   Light (float x, float y, float z, float w, const std::string& space);
 public:
@@ -27,6 +43,11 @@ public:
   void SetSpecular (float r, float g, float b);
   void SetReference (NodePtr reference);
   NodePtr GetReference () const;
+  const glm::vec4& GetAmbient () const;
+  const glm::vec4& GetDiffuse () const;
+  const glm::vec4& GetSpecular () const;
+  // position (w=1) or direction (w=0) in world space, for the given camera view
+  glm::vec4 GetWorldPosition (const glm::mat4& view) const;
   void Load (StatePtr st) const;
 };
 
@@ -0,0 +1,84 @@
+#include <memory>
+class LightManager;
+using LightManagerPtr = std::shared_ptr<LightManager>;
+
+#ifndef LIGHTMANAGER_H
+#define LIGHTMANAGER_H
+
+#include "appearance.h"
+#include "camera.h"
+#include "computeshader.h"
+#include "storagebuffer.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Many point and spot lights with clustered forward culling: the view
+// frustum is split in nx*ny screen tiles and nz exponential depth slices,
+// and a compute pass lists, for each cluster, the lights that reach it.
+// As an appearance, it binds the lists for the shaders in
+// shaders/clustered, which only loop over their cluster's lights.
+class LightManager : public Appearance {
+public:
+  enum TYPE {
+    POINT=0,
+    SPOT
+  };
+  // std430 layout of the light buffer
+  struct LightData {
+    glm::vec4 position;   // xyz: world position, w: range
+    glm::vec4 color;      // rgb: intensity, a: type
+    glm::vec4 direction;  // xyz: spot direction, w: cosine of cutoff angle
+  };
+  enum BINDING {
+    LIGHTS=0,       // world space lights
+    CLUSTERS,       // cluster bounds in view space (min, max)
+    COUNTS,         // number of lights per cluster
+    INDICES,        // light indices, max per cluster slots for each cluster
+    VIEW_LIGHTS     // lights transformed to view space by the cull pass
+  };
+private:
+  int m_nx, m_ny, m_nz;
+  int m_max;                          // max lights per cluster
+  std::vector<LightData> m_lights;
+  bool m_dirty;                       // lights changed since last upload
+  glm::mat4 m_proj;                   // projection the cluster bounds refer to
+  float m_znear, m_zfar;
+  std::vector<glm::vec4> m_bounds;    // cluster bounds (min, max)
+  bool m_bounds_dirty;
+  std::string m_csfile;               // cull pass source
+  ComputeShaderPtr m_cull;
+  StorageBufferPtr m_buffers[5];
+  // results of the CPU reference
+  std::vector<unsigned int> m_cpu_counts;
+  std::vector<unsigned int> m_cpu_indices;
+protected:
+  LightManager (int nx, int ny, int nz, int max_per_cluster, const std::string& csfile);
+public:
+  static LightManagerPtr Make (int nx=16, int ny=9, int nz=24, int max_per_cluster=128,
+                               const std::string& csfile="shaders/cs/light_cluster.glsl");
+  virtual ~LightManager ();
+  int AddPointLight (const glm::vec3& pos, float range, const glm::vec3& color);
+  int AddSpotLight (const glm::vec3& pos, const glm::vec3& dir, float range,
+                    float angle, const glm::vec3& color);
+  void SetLight (int id, const LightData& light);
+  const LightData& GetLight (int id) const;
+  int GetLightCount () const;
+  int GetClusterCount () const;
+  int GetMaxLightsPerCluster () const;
+  void Clear ();
+  // assign lights to clusters on the GPU (perspective projections only)
+  void Cull (const glm::mat4& view, const glm::mat4& proj);
+  void Cull (CameraPtr camera);
+  void GetClusterCounts (std::vector<unsigned int>& counts) const;
+  void GetClusterIndices (std::vector<unsigned int>& indices) const;
+  // CPU reference of the cull pass, with the same output layout
+  void CullCPU (const glm::mat4& view, const glm::mat4& proj);
+  const std::vector<unsigned int>& GetCPUClusterCounts () const;
+  const std::vector<unsigned int>& GetCPUClusterIndices () const;
+  virtual void Load (StatePtr st);
+private:
+  void UpdateClusterBounds (const glm::mat4& proj);
+};
+
+#endif
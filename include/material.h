@@ -6,6 +6,7 @@ using MaterialPtr = std::shared_ptr<Material>;
 #define MATERIAL_H
 
 #include "appearance.h"
+#include "uniformbuffer.h"
 #include <glm/glm.hpp>
 
 class Material : public Appearance {
@@ -14,6 +15,8 @@ class Material : public Appearance {
   glm::vec4 m_spe;
   float m_shi;
   float m_opacity;
+  UniformBufferPtr m_ubo;  // MaterialBlock, uploaded when modified
+  bool m_dirty;
 protected:
   Material (float r, float g, float b, float opacity);
 public:
@@ -24,6 +27,12 @@ public:
   void SetSpecular (float r, float g, float b);
   void SetShininess (float shi);
   void SetOpacity (float opacity);
+  const glm::vec4& GetAmbient () const;
+  const glm::vec4& GetDiffuse () const;
+  const glm::vec4& GetSpecular () const;
+  float GetShininess () const;
+  float GetOpacity () const;
+  virtual size_t AddToHash (size_t h) const;
   virtual void Load (StatePtr st);
 };
 
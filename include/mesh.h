@@ -6,15 +6,29 @@ using MeshPtr = std::shared_ptr<Mesh>;
 #define MESH_H
 
 #include "shape.h"
+#include "glhandle.h"
 #include <string>
+#include <vector>
 
 class Mesh : public Shape {
-  unsigned int m_vao;
+  struct Attribute {
+    int loc;
+    int buffer;
+    int ncomp;
+    int stride;
+  };
+  GLVertexArray m_vao;
   unsigned int m_nind;  // number of indices
+  std::vector<GLBuffer> m_buffers;
+  std::vector<Attribute> m_attributes;
+  int m_index;          // index buffer in m_buffers (-1: none)
+  long m_bytes;         // GPU memory of the buffers
+  BBox m_bounds;
 protected:
   Mesh (const std::string& filename);
   Mesh ();
 public:
+  // shared with other requests for the file (see ResourceManager)
   static MeshPtr Make (const std::string& filename);
   static MeshPtr Make ();
   virtual ~Mesh ();
@@ -23,6 +37,13 @@ public:
   void SetTangentBuffer (int size, const float* data, int ncomp, int stride);
   void SetTexCoordBuffer (int size, const float* data, int ncomp, int stride);
   void SetIndexBuffer (int size, const unsigned int* data);
+  long GetBytes () const;
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
+private:
+  // new buffer of target, filled with data and bound
+  void AddBuffer (unsigned int target, long bytes, const void* data);
+  void AddAttribute (int loc, int size, const float* data, int ncomp, int stride);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include "bbox.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// CPU copy of a shape's geometry as an indexed triangle list. Attribute
+// arrays hold one entry per vertex, or none if the shape does not give
+// the attribute. Tangents carry the handedness of the texture mapping in
+// w: bitangent = w * cross(normal,tangent).
+struct MeshData {
+  std::vector<glm::vec3> coords;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec4> tangents;
+  std::vector<glm::vec2> texcoords;
+  std::vector<unsigned int> indices;
+
+  int GetVertexCount () const;
+  int GetTriangleCount () const;
+  bool IsEmpty () const;
+  void Clear ();
+  // attribute loc (see Shape::LOC) from n floats with ncomp per vertex;
+  // stride in bytes between vertices (0: packed); tangents without w are
+  // right handed
+  void SetAttribute (int loc, const float* data, int n, int ncomp, int stride=0);
+  // triangle list of count vertices drawn as mode (GL_TRIANGLES,
+  // GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN), through indices if not null;
+  // false for other modes
+  bool SetPrimitives (unsigned int mode, int count, const unsigned int* indices=nullptr);
+  // give missing attributes a constant value (right handed tangents)
+  void Complete (const glm::vec3& normal=glm::vec3(0.0f,0.0f,1.0f),
+                 const glm::vec3& tangent=glm::vec3(1.0f,0.0f,0.0f));
+  // to the space of mat (normals by its inverse transpose); keeps the
+  // triangles front facing and flips the tangent handedness if mat mirrors
+  void Transform (const glm::mat4& mat);
+  // add the vertices and triangles of data (attributes must match)
+  void Append (const MeshData& data);
+  BBox GetBounds () const;
+  long GetBytes () const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef MESH_TOOLS_H
+#define MESH_TOOLS_H
+
+#include "jobsystem.h"
+#include "meshdata.h"
+
+// Normal and tangent generation for meshes that lack them, in parallel
+// over chunks of triangles and vertices; results do not depend on the
+// number of workers. Vertices at the same position are smoothed together
+// (e.g. across texture seams); a vertex is split where its triangles need
+// different values (creases, mirrored texture coordinates), so the
+// indices and vertex count may change.
+class MeshTools {
+public:
+  enum WEIGHT {
+    AREA,          // of each triangle around the vertex
+    ANGLE,         // at the vertex corner (independent of tessellation)
+    AREA_ANGLE
+  };
+  // smooth normals; triangles meeting at more than crease_angle degrees
+  // do not share theirs (180: all smooth)
+  static void ComputeNormals (MeshData& mesh, float crease_angle=60.0f, WEIGHT weight=ANGLE,
+                              JobSystemPtr jobs=nullptr);
+  // the same for the null normals only: vertices given a normal keep it
+  // (e.g. OBJ faces with vn next to faces without)
+  static void FillNormals (MeshData& mesh, float crease_angle=60.0f, WEIGHT weight=ANGLE,
+                           JobSystemPtr jobs=nullptr);
+  // tangents along increasing u, as built by MikkTSpace: per corner,
+  // projected on the vertex normal and weighted by the corner angle, with
+  // vertices split where the texture mapping is mirrored, and the
+  // handedness in w (-1 where mirrored); needs normals
+  // and texcoords (false if missing), null normals fall back to the faces
+  static bool ComputeTangents (MeshData& mesh, JobSystemPtr jobs=nullptr);
+  // normals if missing or null, then tangents if texcoords are given
+  static void Complete (MeshData& mesh, float crease_angle=60.0f, JobSystemPtr jobs=nullptr);
+private:
+  static void Normals (MeshData& mesh, float crease_angle, WEIGHT weight, JobSystemPtr jobs,
+                       bool keep);
+};
+
+#endif
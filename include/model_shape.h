@@ -11,6 +11,7 @@ public:
     virtual ~ModelShape();
     
     void Draw(StatePtr state) override;
+    BBox GetBounds() const override;
 
 private:
     ImportedModel* m_model_ptr;
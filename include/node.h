@@ -5,23 +5,43 @@ using NodePtr = std::shared_ptr<Node>;
 #ifndef NODE_H
 #define NODE_H
 
+#include "allocation.h"
 #include "appearance.h"
 #include "node.h"
 #include "shader.h"
 #include "shape.h"
 #include "transform.h"
+#include "bbox.h"
 #include <glm/glm.hpp>
+#include <functional>
 #include <vector>
 #include <initializer_list>
 
+// Shape drawn with its accumulated model matrix, as collected by
+// Node::Collect for passes that do not need the node appearances
+struct RenderItem {
+  ShapePtr shape;
+  glm::mat4 model;
+  BBox bounds;        // world space (empty if unknown)
+  bool is_static;     // does not move: passes may cache its contribution
+};
+
 class Node : public std::enable_shared_from_this<Node>
 {
   std::weak_ptr<Node> m_parent;       // parent node 
   ShaderPtr m_shader;                 // associated shader
   TransformPtr m_trf;                 // associated transformation
-  std::vector<AppearancePtr> m_apps;  // associated appearances
-  std::vector<ShapePtr> m_shps;       // associated shapes
-  std::vector<NodePtr> m_nodes;       // child nodes
+public:
+  // arrays allocated as the node (see Allocation)
+  template <class T>
+  using Array = std::vector<T,Allocator<T>>;
+private:
+  Array<AppearancePtr> m_apps;        // associated appearances
+  Array<ShapePtr> m_shps;             // associated shapes
+  Array<NodePtr> m_nodes;             // child nodes
+  bool m_static;                      // subtree does not move
+  bool m_occluder;                    // subtree hides what is behind it
+  unsigned int m_features;            // shader features asked for the subtree
 protected:
   Node (ShaderPtr shader=nullptr,
         TransformPtr trf=nullptr, 
@@ -98,11 +118,34 @@ public:
   void AddAppearance (AppearancePtr app);
   void AddShape (ShapePtr shp);
   void AddNode (NodePtr node);
+  // put node in the place of the child old (e.g. a rebuilt subtree)
+  void ReplaceNode (NodePtr old, NodePtr node);
+  // room for n child nodes (e.g. before adding many)
+  void ReserveNodes (int n);
   void SetParent (NodePtr parent);
+  void SetStatic (bool flag);
+  bool IsStatic () const;
+  // shapes of the subtree are drawn into the OcclusionCuller depth
+  void SetOccluder (bool flag);
+  bool IsOccluder () const;
+  // bits of the shader features (see ShaderVariants) the subtree is drawn
+  // with, added to the ones of the ancestors
+  void SetFeatures (unsigned int features);
+  unsigned int GetFeatures () const;
+  // reorder the child nodes, keeping the order of equivalent ones
+  void SortNodes (const std::function<bool(const NodePtr&, const NodePtr&)>& less);
   NodePtr GetParent () const;
+  const ShaderPtr& GetShader () const;
+  const TransformPtr& GetTransform () const;
+  const Array<AppearancePtr>& GetAppearances () const;
+  const Array<ShapePtr>& GetShapes () const;
+  const Array<NodePtr>& GetNodes () const;
   glm::mat4 GetMatrix () const;
   glm::mat4 GetModelMatrix ();
   void Render (StatePtr st);
+  // append the shapes of the subtree; parent is the model matrix of the parent
+  void Collect (std::vector<RenderItem>& items,
+                const glm::mat4& parent=glm::mat4(1.0f), bool is_static=false) const;
 };
 
 #endif
\ No newline at end of file
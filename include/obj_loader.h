@@ -17,13 +17,20 @@ public:
     ~ImportedModel();
 
     void Draw() const;
+    const glm::vec3& getBoundsMin() const { return boundsMin; }
+    const glm::vec3& getBoundsMax() const { return boundsMax; }
 
 private:
     GLuint VAO = 0;
     GLuint VBO = 0;
+    GLuint TBO = 0;     // tangents, for textured models
     GLuint EBO = 0;
 
     GLsizei indexCount = 0;
 
+    // limites das posicoes (para culling)
+    glm::vec3 boundsMin = glm::vec3(1.0f);
+    glm::vec3 boundsMax = glm::vec3(-1.0f);
+
     void loadOBJ(const char* path);
 };
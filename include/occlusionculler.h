@@ -0,0 +1,80 @@
+#include <memory>
+class OcclusionCuller;
+using OcclusionCullerPtr = std::shared_ptr<OcclusionCuller>;
+
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "bbox.h"
+#include "camera.h"
+#include "frustum.h"
+#include "jobsystem.h"
+#include "meshdata.h"
+#include "node.h"
+#include "shape.h"
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+
+// Occlusion culling on the CPU, with no GPU readback. Build rasterizes the
+// triangles of the occluders (shapes under nodes marked with
+// Node::SetOccluder, see Shape::GetMeshData) into a small depth buffer:
+// triangles are clipped by the near plane and binned into tiles, and the
+// tiles are filled by the workers of a JobSystem, 4 pixels at a time
+// (SSE2 where available). A pyramid of the farthest depths is then built,
+// as in HiZ: a box whose nearest depth is behind the texels covering its
+// screen rectangle is occluded. Depth is taken at pixel centers, so gaps
+// narrower than a pixel of the buffer do not show what is behind them.
+class OcclusionCuller {
+public:
+  struct Stats {
+    int occluders;         // shapes drawn into the depth
+    int triangles;         // after clipping
+    double raster_time;    // ms in Build
+    int tested;            // boxes tested since Build
+    int culled;
+  };
+private:
+  // screen space triangle: edge functions and depth plane
+  struct Triangle {
+    float edge[3][3];      // a*x + b*y + c >= 0 inside
+    float depth[3];        // z = a*x + b*y + c
+    int xmin, ymin, xmax, ymax;
+  };
+  int m_width, m_height;
+  int m_tiles_x, m_tiles_y;
+  JobSystemPtr m_jobs;
+  glm::mat4 m_viewproj;
+  Frustum m_frustum;
+  std::vector<std::vector<float>> m_levels;   // farthest depth pyramid
+  std::vector<Triangle> m_triangles;
+  std::vector<std::vector<int>> m_bins;       // triangles per tile
+  std::map<const Shape*,MeshData> m_meshes;   // occluder triangles, read once
+  mutable Stats m_stats;
+protected:
+  OcclusionCuller (int width, int height, JobSystemPtr jobs);
+public:
+  static const int TILE_SIZE = 32;
+  // width is rounded up to a multiple of 4
+  static OcclusionCullerPtr Make (int width=256, int height=128, JobSystemPtr jobs=nullptr);
+  virtual ~OcclusionCuller ();
+  int GetWidth () const;
+  int GetHeight () const;
+  // rasterize the occluders of the graph seen by camera
+  void Build (CameraPtr camera, NodePtr root);
+  // whether a world space box may be visible
+  bool IsVisible (const BBox& bounds) const;
+  // depth of a pyramid level (0: full resolution), row by row
+  const std::vector<float>& GetDepth (int level=0) const;
+  int GetLevelCount () const;
+  const Stats& GetStats () const;
+  // drop the cached occluder triangles (e.g. after shapes changed)
+  void ClearCache ();
+private:
+  void Collect (const Node* node, const glm::mat4& parent, bool occluder);
+  void AddTriangle (const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2);
+  void RasterTile (int tile);
+  void BuildPyramid ();
+};
+
+#endif
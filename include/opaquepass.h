@@ -0,0 +1,110 @@
+#include <memory>
+class OpaquePass;
+using OpaquePassPtr = std::shared_ptr<OpaquePass>;
+
+#ifndef OPAQUE_PASS_H
+#define OPAQUE_PASS_H
+
+#include "camera.h"
+#include "frustum.h"
+#include "glhandle.h"
+#include "node.h"
+#include "shader.h"
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// Opaque geometry drawn in a chosen order rather than the graph order.
+// Record flattens graphs into draws, each with the shader and appearances
+// it inherits; Execute can:
+// - sort them front to back: draws are bucketed by the view depth of their
+//   bounds and grouped by state inside a bucket (radix sort, see
+//   CPUPrimitives::SortPairs);
+// - lay the depth first with a position only shader (shaders/depth), so
+//   the main pass, tested GL_EQUAL without depth writes, shades each pixel
+//   once. Main pass shaders must declare gl_Position invariant; programs
+//   with a geometry or tessellation stage lay their own depth, colors
+//   masked;
+// - show overdraw: fragments of the main pass add up over black (drawn
+//   with the depth shader, so geometry stages are not applied).
+// Fragments shaded by the main pass are counted with a samples passed
+// query, read a frame late. Shaders, appearances and shapes are referred
+// to by raw pointer, as in a CommandList, until the next Begin.
+class OpaquePass {
+public:
+  struct Stats {
+    int draws;
+    int culled;
+    int switches;          // state changes in the main pass
+    int own_depth;         // pre-pass draws with their own program
+    long fragments;        // shaded by the main pass (previous frame)
+    float overdraw;        // fragments per viewport pixel
+  };
+private:
+  // shader and appearances a draw inherits
+  struct DrawState {
+    Shader* shader;
+    int matrix;            // model matrix of the shader node (light space)
+    std::vector<Appearance*> apps;
+    bool own_depth;
+  };
+  struct Draw {
+    Shape* shape;
+    int state;
+    int matrix;            // model, mvp, mv, mn in m_matrices
+    float depth;           // view depth of the bounds center
+  };
+  ShaderPtr m_depth;
+  ShaderPtr m_overdraw;
+  bool m_prepass;
+  bool m_sort;
+  bool m_show_overdraw;
+  std::vector<DrawState> m_states;
+  std::map<std::vector<const void*>,int> m_state_ids;  // shader node, appearances
+  std::vector<Draw> m_draws;
+  std::vector<glm::mat4> m_matrices;
+  std::vector<unsigned int> m_keys;
+  std::vector<unsigned int> m_order;
+  // traversal state
+  glm::mat4 m_view, m_proj;
+  Frustum m_frustum;
+  bool m_cull;
+  CameraPtr m_camera;
+  // samples passed by the main pass, two frames in flight
+  GLQuery m_queries[2];
+  long m_pixels[2];
+  bool m_pending[2];
+  int m_frame;
+  Stats m_stats;
+protected:
+  OpaquePass (const std::string& vertex, const std::string& fragment,
+              const std::string& overdraw);
+public:
+  static OpaquePassPtr Make (const std::string& vertex="shaders/depth/vertex.glsl",
+                             const std::string& fragment="shaders/shadow/depth_fragment.glsl",
+                             const std::string& overdraw="shaders/depth/overdraw_fragment.glsl");
+  virtual ~OpaquePass ();
+  void SetPrepass (bool flag);
+  void SetSort (bool flag);
+  void SetShowOverdraw (bool flag);
+  bool GetPrepass () const;
+  bool GetSort () const;
+  bool GetShowOverdraw () const;
+  // start a new frame seen by camera
+  void Begin (CameraPtr camera);
+  // append the draws of the graph under root
+  void Record (NodePtr root, bool cull=true);
+  // draw what was recorded into the bound framebuffer (not cleared)
+  void Execute ();
+  const Stats& GetStats () const;
+private:
+  void RecordNode (const Node* node, const glm::mat4& parent, const Node* shader_node,
+                   const glm::mat4& shader_model, std::vector<Appearance*>& apps);
+  int FindState (const Node* shader_node, const glm::mat4& shader_model,
+                 const std::vector<Appearance*>& apps);
+  void Switch (const StatePtr& st, int from, int to);
+  void DrawItem (const StatePtr& st, const Draw& draw);
+};
+
+#endif
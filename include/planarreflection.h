@@ -0,0 +1,52 @@
+#include <memory>
+class PlanarReflection;
+using PlanarReflectionPtr = std::shared_ptr<PlanarReflection>;
+
+#ifndef PLANAR_REFLECTION_H
+#define PLANAR_REFLECTION_H
+
+#include "appearance.h"
+#include "camera.h"
+#include "fixedcamera.h"
+#include "framebuffer.h"
+#include "node.h"
+#include "texture.h"
+#include <glm/glm.hpp>
+#include <string>
+
+// Mirror image of a scene about a plane, rendered off-screen at a fraction
+// of the viewport resolution. Update re-renders it only when the camera,
+// viewport, scene transforms, lights or appearances (see
+// Appearance::AddToHash) changed. As an appearance, it binds the image
+// for the reflector's shader (shaders/reflection), which samples it at the
+// fragment's screen position.
+class PlanarReflection : public Appearance {
+  NodePtr m_root;          // reflected scene
+  glm::vec4 m_plane;       // world space plane: dot(n,p) + d = 0
+  float m_scale;           // fraction of the viewport resolution
+  std::string m_varname;
+  int m_width, m_height;
+  TexturePtr m_color;
+  FramebufferPtr m_fbo;
+  FixedCameraPtr m_camera;
+  size_t m_hash;           // camera, viewport and scene of the last render
+  bool m_valid;
+  int m_rendered;          // renders done (stats)
+protected:
+  PlanarReflection (NodePtr root, const glm::vec4& plane, float scale, const std::string& varname);
+public:
+  static PlanarReflectionPtr Make (NodePtr root, const glm::vec4& plane=glm::vec4(0.0f,1.0f,0.0f,0.0f),
+                                   float scale=0.5f, const std::string& varname="reflection");
+  virtual ~PlanarReflection ();
+  void SetPlane (const glm::vec4& plane);
+  void SetScale (float scale);
+  // force a new render on next update (e.g. after a texture image changes)
+  void Invalidate ();
+  int GetRenderCount () const;
+  TexturePtr GetTexture () const;
+  void Update (CameraPtr camera);
+  virtual void Load (StatePtr st);
+  virtual void Unload (StatePtr st);
+};
+
+#endif
@@ -6,15 +6,19 @@ using QuadPtr = std::shared_ptr<Quad>;
 #define QUAD_H
 
 #include "shape.h"
+#include "vertexarray.h"
 
 class Quad : public Shape {
-  unsigned int m_vao;
-  unsigned int m_nind; // number of incident vertices
+  VertexArrayPtr m_array;   // shared with equal instances
 protected:
   Quad (int nx, int ny);
 public:
   static QuadPtr Make (int nx=1, int ny=1);
   virtual ~Quad ();
+  // triangles of a quad of that tessellation, built on the CPU
+  static MeshData Geometry (int nx=1, int ny=1);
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
 };
 #endif
\ No newline at end of file
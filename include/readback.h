@@ -0,0 +1,44 @@
+#include <memory>
+class Readback;
+using ReadbackPtr = std::shared_ptr<Readback>;
+
+#ifndef READBACK_H
+#define READBACK_H
+
+#include "glhandle.h"
+#include <vector>
+
+// Asynchronous copy of a buffer range to the CPU (future-like): the range
+// is copied on the GPU into a read buffer and fenced; IsReady polls the
+// fence without blocking, and Wait/GetData block only if the GPU has not
+// finished yet. With OpenGL 4.4 the read buffer is persistently mapped and
+// read in place; otherwise it is read with glGetBufferSubData once ready.
+class Readback {
+  GLBuffer m_buffer;
+  int m_size;
+  void* m_fence;                // GLsync
+  const unsigned char* m_ptr;   // persistent mapping (null if not available)
+  std::vector<unsigned char> m_data;
+  bool m_ready;
+protected:
+  Readback (unsigned int buffer, int offset, int size);
+public:
+  // issue the copy of size bytes of buffer, starting at offset
+  static ReadbackPtr Make (unsigned int buffer, int offset, int size);
+  virtual ~Readback ();
+  int GetSize () const;
+  bool IsReady ();
+  void Wait ();
+  // wait if needed; the pointer is valid while the readback lives
+  const void* GetData ();
+  template <class T>
+  std::vector<T> GetData ()
+  {
+    const T* data = (const T*)GetData();
+    return std::vector<T>(data,data+m_size/sizeof(T));
+  }
+private:
+  void Finish ();
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <memory>
+class RenderThread;
+using RenderThreadPtr = std::shared_ptr<RenderThread>;
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "commandlist.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread owning the GL context and executing the command lists submitted
+// by the frontend, so that recording frame n+1 overlaps the driver work of
+// frame n. At most frames_in_flight lists wait or execute at once: Acquire
+// blocks beyond that. context(true) makes the context current on the
+// calling thread and context(false) releases it: the render thread holds
+// it from creation to Stop, so no other thread may hold it meanwhile.
+// present ends a frame (e.g. swaps buffers). GL work outside command lists
+// (creating or updating GL objects) is posted with Post.
+class RenderThread {
+public:
+  struct Stats {
+    long frames;           // lists executed
+    double record;         // average CommandList record time, in ms
+    double execute;        // average execute and present time, in ms
+    double latency;        // average time from Submit to presented, in ms
+    double stall;          // average time Acquire waited, in ms
+  };
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Frame {
+    CommandListPtr list;
+    Clock::time_point submitted;
+  };
+  std::function<void(bool)> m_context;
+  std::function<void()> m_present;
+  int m_frames_in_flight;
+  std::mutex m_mutex;
+  std::condition_variable m_work;      // frame or job queued, or stop
+  std::condition_variable m_done;      // frame executed
+  std::deque<Frame> m_queue;
+  std::vector<std::function<void()>> m_jobs;
+  std::vector<CommandListPtr> m_free;
+  int m_pending;                       // acquired or queued, not yet executed
+  bool m_busy;                         // executing
+  bool m_stop;
+  std::thread m_thread;
+  Stats m_stats;
+  long m_acquired;
+protected:
+  RenderThread (std::function<void(bool)> context, std::function<void()> present, int frames_in_flight);
+public:
+  static RenderThreadPtr Make (std::function<void(bool)> context, std::function<void()> present,
+                               int frames_in_flight=2);
+  virtual ~RenderThread ();
+  int GetFramesInFlight () const;
+  // list to record the next frame in (waits for a free one)
+  CommandListPtr Acquire ();
+  void Submit (CommandListPtr list);
+  // run job on the render thread, before the next frame
+  void Post (const std::function<void()>& job);
+  // wait until everything submitted or posted has run
+  void Finish ();
+  // run what is left, release the context and end the thread
+  void Stop ();
+  Stats GetStats ();
+  void ResetStats ();
+private:
+  void Run ();
+};
+
+#endif
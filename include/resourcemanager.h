@@ -0,0 +1,69 @@
+#ifndef RESOURCE_MANAGER_H
+#define RESOURCE_MANAGER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+// Registry of the resources loaded from files (meshes, textures, shader
+// stages): a file is loaded once, and later requests for the same
+// canonical path, or for another path with the same content, share the
+// loaded object. Resources no longer referenced elsewhere are released
+// as soon as the last user drops them or, with a budget, kept and released
+// least recently used first while the GPU memory of all resources exceeds
+// the budget.
+// Used from the GL thread only.
+class ResourceManager {
+public:
+  enum TYPE {
+    MESH,
+    TEXTURE,
+    TEXCUBE,
+    SHADER,
+    NTYPES
+  };
+  // what a loader returns
+  struct Resource {
+    std::shared_ptr<void> object;
+    long cpu_bytes;
+    long gpu_bytes;
+  };
+  struct Stats {
+    int count;          // resources held
+    int referenced;     // held and in use
+    long cpu_bytes;
+    long gpu_bytes;
+    long hits;          // requests served by a held resource
+    long misses;        // requests that loaded
+    long evictions;     // unreferenced resources released by the budget
+  };
+  // resource of file, loaded by load if not held
+  template <class T>
+  static std::shared_ptr<T> Get (TYPE type, const std::string& filename,
+                                 const std::function<Resource()>& load)
+  {
+    return std::static_pointer_cast<T>(Find(type,filename,load));
+  }
+  // resource identified by its content only (e.g. shader source)
+  template <class T>
+  static std::shared_ptr<T> GetByContent (TYPE type, const std::string& content,
+                                          const std::function<Resource()>& load)
+  {
+    return std::static_pointer_cast<T>(FindContent(type,content,load));
+  }
+  // GPU memory budget in bytes (0: unreferenced resources are not kept)
+  static void SetBudget (long bytes);
+  static long GetBudget ();
+  // release unreferenced resources beyond the budget (all, if force)
+  static void Trim (bool force=false);
+  static Stats GetStats (TYPE type);
+  static void ResetStats ();
+  static const char* GetTypeName (TYPE type);
+private:
+  static std::shared_ptr<void> Find (TYPE type, const std::string& filename,
+                                     const std::function<Resource()>& load);
+  static std::shared_ptr<void> FindContent (TYPE type, const std::string& content,
+                                            const std::function<Resource()>& load);
+};
+
+#endif
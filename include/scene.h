@@ -7,12 +7,20 @@ using ScenePtr = std::shared_ptr<Scene>;
 
 #include "node.h"
 #include "engine.h"
+#include "jobsystem.h"
 #include "state.h"
 
 class Scene : public Node
 {
   NodePtr m_root;
   std::vector<EnginePtr> m_engines;
+  // engines run as a task graph: an engine waits for the previous ones it
+  // conflicts with (one writes a transform the other accesses)
+  JobSystemPtr m_jobs;
+  bool m_parallel;
+  mutable TaskGraph m_graph;
+  mutable bool m_graph_dirty;
+  mutable float m_dt;
 protected:
   Scene (NodePtr root);
 public:
@@ -20,8 +28,13 @@ public:
   ~Scene ();
   NodePtr GetRoot () const;
   void AddEngine (EnginePtr engine);
+  // job system running the engines (default and null: serially, in
+  // order; parallel update is opt-in)
+  void SetJobSystem (JobSystemPtr jobs);
   void Update (float dt) const;
   void Render (CameraPtr camera);
+private:
+  void BuildGraph () const;
 };
 
-#endif
\ No newline at end of file
+#endif
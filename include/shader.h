@@ -6,25 +6,60 @@ using ShaderPtr = std::shared_ptr<Shader>;
 #define SHADER_H
 
 #include "light.h"
+#include "glhandle.h"
 #include <glm/glm.hpp>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Shader : public std::enable_shared_from_this<Shader> {
-  unsigned int m_pid;
+  struct Stage {
+    unsigned int type;
+    unsigned int sid;
+    std::string filename;
+    std::string source;
+    // owner of sid: from ResourceManager, shared by programs with the same
+    // source, unless compiled by a reload
+    std::shared_ptr<GLShader> object;
+  };
+  GLProgram m_program;
   int m_texunit;
   LightPtr m_light;
   std::string m_space;  // lighting space
+  std::string m_defines;  // inserted after the #version line of every stage
+  std::vector<Stage> m_stages;
+  unsigned int m_blocks;  // bit mask of UniformBuffer bindings used
+  mutable std::unordered_map<std::string,int> m_uniforms;  // location cache
+  // program being compiled by a reload, swapped in once it is complete
+  GLProgram m_pending_program;
+  std::vector<Stage> m_pending_stages;
 protected:
   Shader (LightPtr light, const std::string& space);
 public:
   static ShaderPtr Make (LightPtr light=nullptr, const std::string& space="camera");
   virtual ~Shader ();
+  // lines (e.g. "#define TEXTURE\n") compiled with the stages attached
+  // after the call (see ShaderVariants)
+  void SetDefines (const std::string& defines);
+  const std::string& GetDefines () const;
   void AttachVertexShader (const std::string& filename);
   void AttachFragmentShader (const std::string& filename);
   void AttachGeometryShader (const std::string& filename);
   void AttachTesselationShader (const std::string& control, const std::string& evaluation);
   void Link ();
+  // recompile the stages whose files changed (filename -> new source);
+  // the current program stays in use until PollReload swaps the new one
+  bool Reload (const std::unordered_map<std::string,std::string>& changed);
+  bool PollReload ();
+  bool IsReloadPending () const;
+  std::vector<std::string> GetSourceFiles () const;
+  // source of the stage read from the file (without defines), as in use
+  const std::string& GetSource (const std::string& filename) const;
+  // whether a stage of the type (e.g. GL_GEOMETRY_SHADER) is attached
+  bool HasStage (unsigned int type) const;
+  int GetUniformLocation (const std::string& varname) const;
+  // whether the program declares the uniform block of a UniformBuffer binding
+  bool HasUniformBlock (int binding) const;
   LightPtr GetLight () const;
   const std::string& GetLightingSpace () const;
   void UseProgram () const;
@@ -46,6 +81,16 @@ public:
   // helper functions
   static unsigned int CreateShader (unsigned int shadertype, const std::string& filename);
   static void LinkProgram (unsigned int pid);
+  // non-fatal variants used by reloads: return 0/false on failure
+  static unsigned int CompileSource (unsigned int shadertype, const std::string& filename, const std::string& source);
+  static bool CheckShader (unsigned int sid, const std::string& filename);
+  static bool CheckProgram (unsigned int pid);
+  static bool IsCompletionPending (unsigned int pid);
+  static std::string ReadSource (const std::string& filename);
+  static std::string InsertDefines (const std::string& source, const std::string& defines);
+private:
+  void BindUniformBlocks ();
+  void AttachStage (unsigned int shadertype, const std::string& filename);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <memory>
+class ShaderReloader;
+using ShaderReloaderPtr = std::shared_ptr<ShaderReloader>;
+
+#ifndef SHADERRELOADER_H
+#define SHADERRELOADER_H
+
+#include "filewatcher.h"
+#include "shader.h"
+#include "computeshader.h"
+#include <vector>
+
+// Hot reload of shader sources: files are watched and read in the
+// background; Update, called between frames, starts the recompilation of
+// the affected programs and swaps in the ones that finished linking
+class ShaderReloader {
+  FileWatcherPtr m_watcher;
+  std::vector<std::weak_ptr<Shader>> m_shaders;
+  std::vector<std::weak_ptr<ComputeShader>> m_computes;
+protected:
+  ShaderReloader ();
+public:
+  static ShaderReloaderPtr Make ();
+  virtual ~ShaderReloader ();
+  void AddShader (ShaderPtr shd);
+  void AddComputeShader (ComputeShaderPtr cs);
+  int Update ();   // return the number of programs swapped
+};
+
+#endif
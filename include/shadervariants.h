@@ -0,0 +1,81 @@
+#include <memory>
+class ShaderVariants;
+using ShaderVariantsPtr = std::shared_ptr<ShaderVariants>;
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "light.h"
+#include "node.h"
+#include "shader.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Programs compiled from one set of stage files with different features:
+// a feature is a bit of a mask, and the variant of a mask is compiled
+// with "#define <NAME>" for each of its features. Variants are compiled
+// on first request (Get) or ahead of time (Precompile) and cached by
+// mask; a stage may be attached only to the variants with some features
+// (e.g. a geometry shader). Apply binds the variants to a graph whose
+// nodes ask for features (Node::SetFeatures) instead of programs.
+class ShaderVariants {
+public:
+  enum STAGE {
+    VERTEX,
+    FRAGMENT,
+    GEOMETRY
+  };
+  struct Stats {
+    int variants;        // compiled so far
+    int nodes;           // nodes visited
+    int bindings;        // nodes a program was bound to
+  };
+private:
+  struct StageFile {
+    STAGE stage;
+    std::string filename;
+    unsigned int features;   // attached to the variants having all of them
+  };
+  LightPtr m_light;
+  std::string m_space;
+  std::vector<std::string> m_features;
+  std::vector<StageFile> m_stages;
+  std::map<unsigned int,ShaderPtr> m_programs;
+protected:
+  ShaderVariants (LightPtr light, const std::string& space);
+public:
+  static ShaderVariantsPtr Make (LightPtr light=nullptr, const std::string& space="camera");
+  virtual ~ShaderVariants ();
+  // bit of a new feature (at most 32)
+  unsigned int AddFeature (const std::string& name);
+  // bits of the named features, separated by spaces (e.g. "TEXTURE FOG")
+  unsigned int GetFeatures (const std::string& names) const;
+  void AttachStage (STAGE stage, const std::string& filename, unsigned int features=0);
+  std::string GetDefines (unsigned int features) const;
+  ShaderPtr Get (unsigned int features);
+  void Precompile (const std::vector<unsigned int>& variants);
+  // variants compiled so far (e.g. for a ShaderReloader)
+  std::vector<ShaderPtr> GetShaders () const;
+  bool IsVariant (const ShaderPtr& shader) const;
+  // bind to the nodes under root the variants of their features (their
+  // own and those of their ancestors). A program is bound at the highest
+  // node of a subtree drawn with a single variant, so nested nodes do not
+  // switch; with group, children are also stably sorted by the variant
+  // they draw with (unless the order matters, e.g. for blending). Nodes
+  // with a shader of their own keep it, with their subtrees. A node may be
+  // shared by several parents, as long as it inherits the same features
+  // through each of them (it holds one program binding).
+  Stats Apply (NodePtr root, bool group=true);
+private:
+  // variants drawn under a node, for the features it inherits
+  using Used = std::map<std::pair<const Node*,unsigned int>,std::set<unsigned int>>;
+  // features inherited by the nodes assigned so far
+  using Seen = std::map<const Node*,unsigned int>;
+  const std::set<unsigned int>& Collect (const Node* node, unsigned int inherited, Used& used);
+  void Assign (const NodePtr& node, unsigned int inherited, ShaderPtr current, Used& used,
+               Seen& seen, bool group, Stats& stats);
+};
+
+#endif
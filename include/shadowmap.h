@@ -0,0 +1,83 @@
+#include <memory>
+class ShadowMap;
+using ShadowMapPtr = std::shared_ptr<ShadowMap>;
+
+#ifndef SHADOWMAP_H
+#define SHADOWMAP_H
+
+#include "appearance.h"
+#include "camera.h"
+#include "framebuffer.h"
+#include "light.h"
+#include "node.h"
+#include "shader.h"
+#include "texdepth.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Shadows of a light: cascaded shadow maps for directional lights (w=0),
+// stored side by side in one depth atlas, and a depth cube for point lights.
+// Update renders the casters depth-only, culled per cascade/face; static
+// casters are kept in a cached copy, and a cascade/face is redrawn only when
+// the casters it sees (or its matrix) changed. As an appearance, it binds
+// the maps for the shaders in shaders/shadow.
+class ShadowMap : public Appearance {
+public:
+  static const int MAX_CASCADES = 4;
+private:
+  // a cascade or a cube face
+  struct Slot {
+    glm::mat4 viewproj;     // matrix the slot was rendered with
+    size_t static_hash;     // casters seen when rendered
+    size_t dynamic_hash;
+    long last_frame;
+    bool valid;
+  };
+  LightPtr m_light;
+  int m_size;                       // resolution of each cascade/face
+  int m_ncascades;
+  float m_lambda;                   // split scheme: 0 uniform, 1 logarithmic
+  float m_max_distance;             // cascades end here or at the far plane
+  int m_interval[MAX_CASCADES];     // frames between cascade updates
+  float m_point_near, m_point_far;  // cube face projection
+  long m_frame;
+  int m_rendered;                   // slots redrawn by the last update
+  bool m_point;                     // last update was for a point light
+  glm::vec3 m_point_pos;            // world position of the point light
+  ShaderPtr m_depth;
+  TexDepthPtr m_atlas, m_static_atlas;
+  FramebufferPtr m_atlas_fbo, m_static_atlas_fbo;
+  TexDepthPtr m_cube, m_static_cube;
+  FramebufferPtr m_cube_fbo, m_static_cube_fbo;
+  Slot m_slots[6];
+protected:
+  ShadowMap (LightPtr light, int size, int ncascades);
+public:
+  static ShadowMapPtr Make (LightPtr light, int size=1024, int ncascades=4);
+  virtual ~ShadowMap ();
+  void SetSplitLambda (float lambda);
+  void SetMaxDistance (float distance);
+  // re-render cascade at most once every frames (1: every frame)
+  void SetUpdateInterval (int cascade, int frames);
+  void SetPointRange (float znear, float zfar);
+  void SetDepthShader (ShaderPtr shader);
+  int GetRenderedCount () const;
+  TexDepthPtr GetAtlas () const;
+  TexDepthPtr GetCube () const;
+  // render the shadow maps of the casters under root for this camera
+  void Update (NodePtr root, CameraPtr camera);
+  virtual void Load (StatePtr st);
+  virtual void Unload (StatePtr st);
+private:
+  void UpdateCascades (const std::vector<RenderItem>& items, const glm::mat4& view,
+                       const glm::mat4& proj, const glm::vec3& dir);
+  void UpdateCube (const std::vector<RenderItem>& items, const glm::vec3& pos);
+  bool RenderSlot (Slot& slot, const glm::mat4& viewproj, bool use_near,
+                   const std::vector<RenderItem>& items, int x, int y,
+                   FramebufferPtr fbo, FramebufferPtr static_fbo);
+  void DrawItems (const std::vector<RenderItem>& items, const std::vector<int>& ids,
+                  const glm::mat4& viewproj);
+};
+
+#endif
@@ -6,6 +6,8 @@ using ShapePtr = std::shared_ptr<Shape>;
 #define SHAPE_H
 
 #include "state.h"
+#include "bbox.h"
+#include "meshdata.h"
 
 class Shape {
 protected:
@@ -14,11 +16,17 @@ public:
   enum LOC {
     COORD=0,
     NORMAL,
-    TANGENT,
-    TEXCOORD
+    TANGENT,    // w: handedness (1 if not given)
+    TEXCOORD,
+    OBJECT      // per instance object index (GPU-driven draws)
   };
   virtual ~Shape () {}
   virtual void Draw (StatePtr st) = 0;
+  // bounds in model space (empty if unknown: never culled)
+  virtual BBox GetBounds () const { return BBox(); }
+  // CPU copy of the triangles in model space (e.g. to batch static
+  // shapes); false if the shape cannot give them
+  virtual bool GetMeshData (MeshData& ) const { return false; }
 };
 
 #endif
\ No newline at end of file
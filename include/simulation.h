@@ -0,0 +1,78 @@
+#include <memory>
+class Simulation;
+using SimulationPtr = std::shared_ptr<Simulation>;
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "camera.h"
+#include "entitystore.h"
+#include "scene.h"
+#include "transform.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed timestep simulation on its own thread: Scene::Update runs every
+// step seconds of wall time, whatever the display rate, and after each
+// step the matrices of the scene's Transforms are copied to a snapshot.
+// Render draws the scene from an EntityStore whose local matrices blend
+// the last two snapshots, so motion is smooth at any frame rate (the view
+// is one step behind the simulation). Engines run on the simulation thread
+// and may only change Transforms while it runs.
+// When a step costs more than step seconds, at most max_steps are run to
+// catch up; the rest of the delay is dropped.
+class Simulation {
+public:
+  struct Stats {
+    long steps;            // simulation steps run
+    long dropped;          // steps skipped to stop falling behind
+    double update;         // average Scene::Update time per step, in ms
+    long frames;           // frames rendered
+    double render;         // average Render time per frame, in ms
+    float alpha;           // blend factor of the last frame
+  };
+private:
+  struct Snapshot {
+    long step;
+    std::vector<glm::mat4> matrices;   // per transform of the store
+  };
+  using SnapshotPtr = std::shared_ptr<Snapshot>;
+  using Clock = std::chrono::steady_clock;
+  ScenePtr m_scene;
+  float m_step;
+  int m_max_steps;
+  EntityStorePtr m_store;
+  std::vector<const Transform*> m_sources;   // per transform of the store
+  // snapshots published by the simulation thread
+  mutable std::mutex m_mutex;
+  SnapshotPtr m_prev, m_curr;
+  std::vector<SnapshotPtr> m_pool;           // owned by the simulation thread
+  Clock::time_point m_start;                 // wall time of step 0
+  std::thread m_thread;
+  std::atomic<bool> m_running;
+  Stats m_stats;
+  double m_update_total, m_render_total;
+protected:
+  Simulation (ScenePtr scene, float step);
+public:
+  static SimulationPtr Make (ScenePtr scene, float step=1.0f/60.0f);
+  virtual ~Simulation ();
+  void SetMaxSteps (int n);
+  float GetStep () const;
+  // builds the render copy of the scene and starts the simulation thread
+  void Start ();
+  void Stop ();
+  bool IsRunning () const;
+  void Render (CameraPtr camera);
+  Stats GetStats () const;
+  void ResetStats ();
+private:
+  void Run ();
+  void Capture (long step);
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <memory>
+class SoftRenderer;
+using SoftRendererPtr = std::shared_ptr<SoftRenderer>;
+
+#ifndef SOFT_RENDERER_H
+#define SOFT_RENDERER_H
+
+#include "camera.h"
+#include "image.h"
+#include "jobsystem.h"
+#include "light.h"
+#include "material.h"
+#include "meshdata.h"
+#include "node.h"
+#include "shape.h"
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// CPU rendering of the pipeline of the ilum_vert shaders, with no GL call:
+// vertices are transformed and lit per vertex (Phong terms of a Light and
+// a Material, in world space), optionally modulated by a texture; depth,
+// stencil and alpha blending follow a per draw state. Draws only set up
+// triangles (near clipped, back faces optionally culled); Finish bins them
+// into tiles, which the workers of a JobSystem fill in submission order,
+// 4 pixels at a time (SSE2 edge functions and depth test where
+// available). Colors are RGBA8, rows bottom up as glReadPixels gives them.
+class SoftRenderer {
+public:
+  static const int TILE_SIZE = 64;
+  enum STENCIL_FUNC {
+    ALWAYS,
+    EQUAL,
+    NOTEQUAL
+  };
+  enum STENCIL_OP {       // applied where stencil and depth pass
+    KEEP,
+    REPLACE,
+    INCR
+  };
+  struct DrawState {
+    bool depth_test;
+    bool depth_write;
+    bool color_write;
+    bool cull_back;
+    bool blend;            // src alpha, one minus src alpha
+    STENCIL_FUNC stencil_func;
+    STENCIL_OP stencil_op;
+    unsigned char stencil_ref;
+    DrawState ()
+    : depth_test(true), depth_write(true), color_write(true), cull_back(false), blend(false),
+      stencil_func(ALWAYS), stencil_op(KEEP), stencil_ref(0)
+    {
+    }
+  };
+  // material terms (alpha: opacity) and optional texture (decal)
+  struct Surface {
+    glm::vec4 amb = glm::vec4(1.0f);
+    glm::vec4 dif = glm::vec4(1.0f);
+    glm::vec4 spe = glm::vec4(1.0f);
+    float shi = 32.0f;
+    float opacity = 1.0f;
+    ImagePtr texture;
+  };
+  struct Stats {
+    int draws;
+    long triangles;        // submitted
+    long rasterized;       // after clipping and culling
+    long fragments;        // shaded
+    double setup_time;     // ms in Draw
+    double raster_time;    // ms in Finish
+  };
+private:
+  struct Vertex {
+    glm::vec4 clip;
+    glm::vec4 color;
+    glm::vec2 texcoord;
+  };
+  struct Triangle {
+    float edge[3][3];      // barycentric of vertex (k+2)%3 = a*x + b*y + c
+    float depth[3];        // z = a*x + b*y + c
+    float invw[3];
+    glm::vec4 color[3];
+    glm::vec2 texcoord[3];
+    int draw;
+    int xmin, ymin, xmax, ymax;
+  };
+  int m_width, m_height;
+  int m_tiles_x, m_tiles_y;
+  JobSystemPtr m_jobs;
+  std::vector<unsigned int> m_color;
+  std::vector<float> m_depth;
+  std::vector<unsigned char> m_stencil;
+  glm::mat4 m_view, m_proj;
+  glm::vec3 m_eye;
+  glm::vec4 m_lpos;        // world space (w=0: direction)
+  glm::vec4 m_lamb, m_ldif, m_lspe;
+  std::vector<Vertex> m_vertices;
+  std::vector<Triangle> m_triangles;
+  std::vector<DrawState> m_states;
+  std::vector<Surface> m_surfaces;
+  std::vector<std::vector<int>> m_bins;
+  std::vector<long> m_fragments;               // per tile
+  std::map<const Shape*,MeshData> m_meshes;    // graph shapes, read once
+  Stats m_stats;
+protected:
+  SoftRenderer (int width, int height, JobSystemPtr jobs);
+public:
+  static SoftRendererPtr Make (int width, int height, JobSystemPtr jobs=nullptr);
+  virtual ~SoftRenderer ();
+  int GetWidth () const;
+  int GetHeight () const;
+  // start a frame: matrices of the camera, stats reset
+  void Begin (const glm::mat4& view, const glm::mat4& proj);
+  void Begin (CameraPtr camera);
+  void Clear (const glm::vec4& color, float depth=1.0f, unsigned char stencil=0);
+  void SetLight (const glm::vec4& position, const glm::vec4& amb, const glm::vec4& dif,
+                 const glm::vec4& spe);
+  void SetLight (LightPtr light);
+  static Surface GetSurface (const Material& material);
+  void Draw (const MeshData& mesh, const glm::mat4& model, const Surface& surface,
+             const DrawState& state=DrawState());
+  // draw the graph under root as Node::Render would (shader lights and
+  // materials; other appearances are ignored)
+  void Render (NodePtr root, const DrawState& state=DrawState());
+  // rasterize the triangles of the draws since the last Finish
+  void Finish ();
+  const std::vector<unsigned int>& GetColor () const;
+  const std::vector<float>& GetDepth () const;
+  const std::vector<unsigned char>& GetStencil () const;
+  // binary PPM, top row first
+  bool Save (const std::string& filename) const;
+  const Stats& GetStats () const;
+  void ClearCache ();
+private:
+  void RenderNode (const Node* node, const glm::mat4& parent, Surface surface,
+                   const DrawState& state);
+  void Setup (const Vertex& v0, const Vertex& v1, const Vertex& v2, int draw, bool cull);
+  void RasterTile (int tile);
+};
+
+#endif
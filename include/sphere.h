@@ -6,15 +6,19 @@ using SpherePtr = std::shared_ptr<Sphere>;
 #define SPHERE_H
 
 #include "shape.h"
+#include "vertexarray.h"
 
 class Sphere : public Shape {
-  unsigned int m_vao;
-  unsigned int m_nind; // number of incident vertices
+  VertexArrayPtr m_array;   // shared with equal instances
 protected:
   Sphere (int nstack, int nslice);
 public:
   static SpherePtr Make (int nstack=64, int nslice=64);
   virtual ~Sphere ();
+  // triangles of a sphere of that tessellation, built on the CPU
+  static MeshData Geometry (int nstack=64, int nslice=64);
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
 };
 #endif
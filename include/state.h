@@ -8,14 +8,26 @@ using StatePtr = std::shared_ptr<State>;
 #include "camera.h"
 #include "light.h"
 #include "shader.h"
+#include "bbox.h"
+#include "frustum.h"
+#include "streambuffer.h"
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
 
+class OcclusionCuller;
+using OcclusionCullerPtr = std::shared_ptr<OcclusionCuller>;
+
 class State : public std::enable_shared_from_this<State> {
   CameraPtr m_camera;
   std::vector<ShaderPtr> m_shader;
   std::vector<glm::mat4> m_stack;
+  bool m_has_matrices;  // camera matrices are queried once per state
+  glm::mat4 m_view;
+  glm::mat4 m_proj;
+  bool m_cull;          // shapes outside the cull frustum are skipped
+  Frustum m_frustum;
+  OcclusionCullerPtr m_occlusion;  // shapes hidden by occluders are skipped
 protected:
   State (CameraPtr camera);
 public:
@@ -30,7 +42,22 @@ public:
   const glm::mat4& GetCurrentMatrix () const;
   ShaderPtr GetShader () const;
   CameraPtr GetCamera () const;
+  const glm::mat4& GetViewMatrix ();
+  const glm::mat4& GetProjMatrix ();
   void LoadMatrices ();
+  // draw matrices computed elsewhere (e.g. recorded in a CommandList)
+  void LoadMatrices (const glm::mat4& mvp, const glm::mat4& mv, const glm::mat4& mn);
+  // world space frustum to cull shapes against (e.g. a mirrored view)
+  void SetCullFrustum (const Frustum& frustum);
+  // occluders rasterized for the same camera (see OcclusionCuller::Build)
+  void SetOcclusionCuller (OcclusionCullerPtr culler);
+  // whether model space bounds, under the current matrix, may be visible
+  bool IsVisible (const BBox& bounds) const;
+  // ring holding the DrawBlock of every draw (stall statistics), made
+  // on first use; released with ReleaseDrawStream, before the context
+  // is destroyed (e.g. glfwTerminate)
+  static StreamBufferPtr GetDrawStream ();
+  static void ReleaseDrawStream ();
 };
 
 #endif
\ No newline at end of file
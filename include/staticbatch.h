@@ -0,0 +1,56 @@
+#include <memory>
+class StaticBatch;
+using StaticBatchPtr = std::shared_ptr<StaticBatch>;
+
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include "node.h"
+#include "shape.h"
+#include "vertexarray.h"
+
+// Shape drawing, in one call, the triangles of many static shapes merged
+// in the space of the subtree they came from. Build turns a subtree that
+// never moves into one node per shader and appearance list, each drawing
+// the batches of the shapes it affected: vertices are pre-transformed,
+// so the node matrices are gone. A batch holds at most max_vertices
+// vertices; with chunk > 0, shapes are also split by the cell of a grid
+// of that size holding their center, so batches stay small enough to be
+// culled. Shapes that cannot give their triangles (see
+// Shape::GetMeshData) keep their own draw. Appearances are assumed to
+// be drawable in any order (e.g. not for blending without depth writes).
+class StaticBatch : public Shape {
+  VertexArrayPtr m_array;
+  BBox m_bounds;
+  int m_shapes;            // shapes merged
+  int m_vertices;
+  int m_triangles;
+protected:
+  StaticBatch (const MeshData& data, int nshapes);
+public:
+  struct Stats {
+    int shapes;            // shapes merged
+    int kept;              // shapes drawn on their own
+    int batches;
+    int nodes;             // nodes replaced
+    long vertices;
+    long triangles;
+  };
+  static StaticBatchPtr Make (const MeshData& data, int nshapes=1);
+  virtual ~StaticBatch ();
+  // node drawing the subtree of root by batches, to replace root in its
+  // parent (the root transformation is included)
+  static NodePtr Build (NodePtr root, int max_vertices=65536, float chunk=0.0f,
+                        Stats* stats=nullptr);
+  // replace the static subtrees below root (see Node::SetStatic) by their
+  // batches; root itself is kept
+  static Stats Apply (NodePtr root, int max_vertices=65536, float chunk=0.0f);
+  int GetShapeCount () const;
+  int GetVertexCount () const;
+  int GetTriangleCount () const;
+  virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include <memory>
+class StorageBuffer;
+using StorageBufferPtr = std::shared_ptr<StorageBuffer>;
+
+template <class T> class StorageArray;
+template <class T> using StorageArrayPtr = std::shared_ptr<StorageArray<T>>;
+
+#ifndef STORAGEBUFFER_H
+#define STORAGEBUFFER_H
+
+#include "readback.h"
+#include "glhandle.h"
+#include <vector>
+
+// Shader storage buffer (std430 data shared by compute and render passes)
+class StorageBuffer {
+  GLBuffer m_buffer;
+  int m_size;
+protected:
+  StorageBuffer (int size, const void* data);
+public:
+  static StorageBufferPtr Make (int size, const void* data=nullptr);
+  virtual ~StorageBuffer ();
+  unsigned int GetId () const;
+  int GetSize () const;
+  // the buffer grows if the data does not fit (content below offset kept)
+  void SetData (const void* data, int size, int offset=0);
+  void GetData (void* data, int size, int offset=0) const;
+  // non-blocking variant: poll or wait on the returned readback
+  ReadbackPtr GetDataAsync (int size, int offset=0) const;
+  // make room for size bytes (content discarded if reallocated)
+  void Reserve (int size);
+  void Bind (int binding) const;
+};
+
+// Storage buffer holding an array of T (e.g. glm::vec4 or a struct): T
+// must follow the std430 layout of the shader declaration (vec3 members
+// are padded to 16 bytes)
+template <class T>
+class StorageArray : public StorageBuffer {
+protected:
+  StorageArray (const std::vector<T>& data)
+  : StorageBuffer(int(data.size()*sizeof(T)),data.empty() ? nullptr : data.data())
+  {
+  }
+public:
+  static StorageArrayPtr<T> Make (const std::vector<T>& data)
+  {
+    return StorageArrayPtr<T>(new StorageArray(data));
+  }
+  static StorageArrayPtr<T> Make (int count)
+  {
+    return StorageArrayPtr<T>(new StorageArray(std::vector<T>(count)));
+  }
+  int GetCount () const
+  {
+    return GetSize() / int(sizeof(T));
+  }
+  void SetData (const std::vector<T>& data)
+  {
+    StorageBuffer::SetData(data.data(),int(data.size()*sizeof(T)));
+  }
+  std::vector<T> GetData () const
+  {
+    std::vector<T> data(GetCount());
+    StorageBuffer::GetData(data.data(),GetSize());
+    return data;
+  }
+  ReadbackPtr GetDataAsync () const
+  {
+    return StorageBuffer::GetDataAsync(GetSize());
+  }
+};
+
+#endif
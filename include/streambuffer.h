@@ -0,0 +1,50 @@
+#include <memory>
+class StreamBuffer;
+using StreamBufferPtr = std::shared_ptr<StreamBuffer>;
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include "glhandle.h"
+#include <vector>
+
+// Ring buffer for data rewritten every frame (per draw uniforms, dynamic
+// texture buffers). The buffer is split in sections: the CPU writes into
+// one section while the GPU may still read the others, and a section is
+// reused only after the fence placed when it was left has signaled, so
+// the storage is never reallocated. With OpenGL 4.4 the buffer is
+// persistently mapped (coherent) and written with memcpy; otherwise data
+// are copied with glBufferSubData into the same fenced sections.
+class StreamBuffer {
+  GLBuffer m_buffer;
+  int m_section_size;
+  int m_nsections;
+  int m_section;                // section being written
+  int m_offset;                 // first free byte in it
+  unsigned char* m_ptr;         // persistent mapping (null if not available)
+  std::vector<void*> m_fences;  // GLsync placed when each section was left
+  // CPU stall statistics: waits for a section still used by the GPU
+  int m_stalls;
+  double m_stall_time;
+protected:
+  StreamBuffer (int section_size, int nsections);
+public:
+  static StreamBufferPtr Make (int section_size, int nsections=3);
+  virtual ~StreamBuffer ();
+  unsigned int GetId () const;
+  int GetSectionSize () const;
+  bool IsPersistent () const;
+  // copy data into the ring; return its offset in the buffer (a multiple
+  // of align); moves to the next section if the current one is full
+  int Write (const void* data, int size, int align=4);
+  // fence the current section and move to the next one (e.g. end of frame)
+  void NextSection ();
+  void BindUniform (int binding, int offset, int size) const;
+  int GetStallCount () const;
+  double GetStallTime () const;   // milliseconds
+  void ResetStats ();
+private:
+  void WaitSection (int section);
+};
+
+#endif
@@ -6,20 +6,42 @@ using TexBufferPtr = std::shared_ptr<TexBuffer>;
 #define TEXBUFFER_H
 
 #include "appearance.h"
+#include "streambuffer.h"
+#include "readback.h"
+#include "glhandle.h"
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
 
 class TexBuffer : public Appearance {
-  unsigned int m_tex;
-  unsigned int m_buffer;
+public:
+  // texel format: number of float components
+  enum FORMAT {
+    R32F=1,
+    RG32F=2,
+    RGBA32F=4
+  };
+private:
+  GLTexture m_tex;
+  GLBuffer m_buffer;
+  // with OpenGL 4.3, data are written into a ring and the texture views
+  // the range of the last write (glTexBufferRange)
+  StreamBufferPtr m_stream;
+  int m_offset;
+  int m_size;
   std::string m_varname;
+  FORMAT m_format;
 protected:
-  TexBuffer (const std::string& varname, const std::vector<float>& data);
+  TexBuffer (const std::string& varname, const std::vector<float>& data, FORMAT format);
 public:
-  static TexBufferPtr Make (const std::string& varname, const std::vector<float>& data);
+  static TexBufferPtr Make (const std::string& varname, const std::vector<float>& data,
+                            FORMAT format=R32F);
   void SetData (const std::vector<float>& data);
   std::vector<float> GetData () const;
+  // non-blocking variant: poll or wait on the returned readback
+  ReadbackPtr GetDataAsync () const;
+  FORMAT GetFormat () const;
+  unsigned int GetInternalFormat () const;   // GL sized format (e.g. for images)
   virtual ~TexBuffer ();
   unsigned int GetTexId () const;
   const std::string& GetName () const;
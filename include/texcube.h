@@ -6,11 +6,13 @@ using TexCubePtr = std::shared_ptr<TexCube>;
 #define TEXCUBE_H
 
 #include "appearance.h"
+#include "glhandle.h"
 #include <glm/glm.hpp>
 #include <string>
 
 class TexCube : public Appearance {
   unsigned int m_tex;
+  std::shared_ptr<GLTexture> m_shared;  // texture of the file, shared
   std::string m_varname;
 protected:
   TexCube (const std::string& varname, const std::string& filename);
@@ -6,20 +6,26 @@ using TexDepthPtr = std::shared_ptr<TexDepth>;
 #define TEXDEPTH_H
 
 #include "appearance.h"
+#include "glhandle.h"
 #include <glm/glm.hpp>
 #include <string>
 
 class TexDepth : public Appearance {
-  unsigned int m_tex;
+  GLTexture m_tex;
   std::string m_varname;
   int m_width;
   int m_height;
+  bool m_cube;   // cube map (e.g. point light shadows)
 protected:
-  TexDepth (const std::string& varname, int width, int height);
+  TexDepth (const std::string& varname, int width, int height, bool cube);
 public:
   static TexDepthPtr Make (const std::string& varname, int width, int height);
+  static TexDepthPtr MakeCube (const std::string& varname, int size);
   virtual ~TexDepth ();
   unsigned int GetTexId () const;
+  int GetWidth () const;
+  int GetHeight () const;
+  bool IsCube () const;
   void SetCompareMode ();
   virtual void Load (StatePtr st);
   virtual void Unload (StatePtr st);
@@ -6,19 +6,31 @@ using TexturePtr = std::shared_ptr<Texture>;
 #define TEXTURE_H
 
 #include "appearance.h"
+#include "glhandle.h"
 #include <glm/glm.hpp>
 #include <string>
 
 class Texture : public Appearance {
+public:
+  // texel format of textures made empty (e.g. render targets)
+  enum FORMAT {
+    RGB8,
+    RGBA8,
+    R16F,
+    RGBA16F
+  };
+private:
   unsigned int m_tex;
+  std::shared_ptr<GLTexture> m_shared;  // shared with other users of its file, if any
   std::string m_varname;
 protected:
   Texture (const std::string& varname, const std::string& filename);
-  Texture (const std::string& varname, int width, int height);
+  Texture (const std::string& varname, int width, int height, FORMAT format);
   Texture (const std::string& varname, const glm::vec3& texel);
 public:
+  // the image is shared with other requests for the file (see ResourceManager)
   static TexturePtr Make (const std::string& varname, const std::string& filename);
-  static TexturePtr Make (const std::string& varname, int width, int height);
+  static TexturePtr Make (const std::string& varname, int width, int height, FORMAT format=RGB8);
   static TexturePtr Make (const std::string& varname, const glm::vec3& texel);
   virtual ~Texture ();
   unsigned int GetTexId () const;
@@ -0,0 +1,56 @@
+#include <memory>
+class TransparencyPass;
+using TransparencyPassPtr = std::shared_ptr<TransparencyPass>;
+
+#ifndef TRANSPARENCY_PASS_H
+#define TRANSPARENCY_PASS_H
+
+#include "framebuffer.h"
+#include "glhandle.h"
+#include "shader.h"
+#include "texdepth.h"
+#include "texture.h"
+#include <string>
+
+// Weighted blended order-independent transparency (McGuire and Bavoil).
+// Opaque geometry is drawn into an off-screen color and depth target;
+// translucent geometry is then drawn, in any order and without depth
+// writes, into an accumulation (RGBA16F) and a revealage (R16F) target
+// sharing that depth; Composite resolves both over the opaque image into
+// the framebuffer bound before BeginOpaque, opaque depth included. The
+// translucent shader must write the two outputs (see shaders/oit). Targets
+// follow the viewport size.
+class TransparencyPass {
+  ShaderPtr m_composite;
+  GLVertexArray m_vao;     // attribute-less full screen triangle
+  int m_width, m_height;
+  TexDepthPtr m_depth;
+  TexturePtr m_opaque;
+  TexturePtr m_accum;
+  TexturePtr m_reveal;
+  FramebufferPtr m_opaque_fbo;
+  FramebufferPtr m_oit_fbo;
+  int m_fbo;               // framebuffer and viewport to composite into
+  int m_viewport[4];
+  bool m_blend;            // state saved by BeginTranslucent
+  int m_blend_func[4];     // src/dst rgb, src/dst alpha
+  int m_depth_func;
+  unsigned char m_depth_mask;
+protected:
+  TransparencyPass (const std::string& vertex, const std::string& fragment);
+public:
+  static TransparencyPassPtr Make (const std::string& vertex="shaders/oit/composite_vertex.glsl",
+                                   const std::string& fragment="shaders/oit/composite_fragment.glsl");
+  virtual ~TransparencyPass ();
+  ShaderPtr GetCompositeShader () const;
+  // redirect rendering to the opaque target, cleared
+  void BeginOpaque ();
+  // switch to the translucent targets: additive accumulation, multiplied
+  // revealage, depth tested against the opaque geometry but not written
+  void BeginTranslucent ();
+  // resolve into the previous framebuffer and restore the blend and depth
+  // state found by BeginTranslucent
+  void Composite ();
+};
+
+#endif
@@ -6,14 +6,18 @@ using TrianglePtr = std::shared_ptr<Triangle>;
 #define TRIANGLE_H
 
 #include "shape.h"
+#include "glhandle.h"
 
 class Triangle : public Shape {
-  unsigned int m_vao;
+  GLVertexArray m_vao;
+  GLBuffer m_coords;
 protected:
   Triangle ();
 public:
   static TrianglePtr Make ();
   virtual ~Triangle ();
   virtual void Draw (StatePtr st);
+  virtual BBox GetBounds () const;
+  virtual bool GetMeshData (MeshData& data) const;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <memory>
+class UniformBuffer;
+using UniformBufferPtr = std::shared_ptr<UniformBuffer>;
+
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include "glhandle.h"
+
+// std140 uniform block storage shared by all programs through fixed
+// binding points (see Shader: blocks are bound by name after linking)
+class UniformBuffer {
+  GLBuffer m_ubo;
+  int m_size;
+protected:
+  UniformBuffer (int size);
+public:
+  enum BINDING {
+    FRAME=0,     // FrameBlock: view, projection, camera and light
+    DRAW,        // DrawBlock: Mvp, Mv, Mn
+    MATERIAL     // MaterialBlock: mamb, mdif, mspe, mshi, mopacity
+  };
+  static UniformBufferPtr Make (int size);
+  virtual ~UniformBuffer ();
+  unsigned int GetId () const;
+  int GetSize () const;
+  void SetData (const void* data, int size, int offset=0);
+  void Bind (int binding) const;
+  void BindRange (int binding, int offset, int size) const;
+  // offsets given to BindRange must be multiple of this value
+  static int GetOffsetAlignment ();
+  static const char* GetBlockName (int binding);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include <memory>
+class VertexArray;
+using VertexArrayPtr = std::shared_ptr<VertexArray>;
+
+#ifndef VERTEX_ARRAY_H
+#define VERTEX_ARRAY_H
+
+#include "glhandle.h"
+#include "meshdata.h"
+#include <vector>
+
+// Vertex array object with the buffers it reads, owned (deleted with it).
+// Shapes with the same geometry share one through GeometryCache.
+class VertexArray {
+  struct Attribute {
+    int loc;
+    int buffer;
+    int ncomp;
+  };
+  GLVertexArray m_vao;
+  std::vector<GLBuffer> m_buffers;
+  std::vector<Attribute> m_attributes;
+  GLBuffer m_index;          // element buffer (empty: none)
+  unsigned int m_mode;       // primitive type
+  int m_count;               // indices, or vertices if not indexed
+  long m_bytes;              // GPU memory of the buffers
+protected:
+  VertexArray ();
+public:
+  static VertexArrayPtr Make ();
+  virtual ~VertexArray ();
+  // new vertex buffer of n floats; returns its id for SetAttribute
+  int AddBuffer (int n, const float* data);
+  // attribute loc reads ncomp floats per vertex from buffer
+  void SetAttribute (int loc, int buffer, int ncomp);
+  void SetIndices (int n, const unsigned int* indices);
+  // draw mode and vertex count of non-indexed arrays (default: triangles)
+  void SetMode (unsigned int mode, int count=0);
+  long GetBytes () const;
+  // read the triangles back from the GPU (false for line or point modes)
+  bool Read (MeshData& data) const;
+  void Draw () const;
+};
+
+#endif
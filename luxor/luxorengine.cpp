@@ -23,6 +23,8 @@ LuxorEngine::LuxorEngine (
   m_trf_cupula(trf_cupula),
   m_trf_lampada(trf_lampada)
 {
+  for (TransformPtr trf : {trf_all,trf_base,trf_haste1,trf_haste2,trf_haste3,trf_cupula,trf_lampada})
+    Writes(trf);
   CreateStandDownAnimation();
   CreateJumpForwardAnimation();
 }
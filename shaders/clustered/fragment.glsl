@@ -0,0 +1,68 @@
+#version 430
+
+// Forward shading with the lights of the fragment's cluster (LightManager)
+
+struct Light {
+  vec4 position;   // xyz: view position, w: range
+  vec4 color;      // rgb: intensity, a: type (0: point, 1: spot)
+  vec4 direction;  // xyz: spot direction, w: cosine of cutoff angle
+};
+
+layout(std430, binding = 2) readonly buffer Counts { uint counts[]; };
+layout(std430, binding = 3) readonly buffer Indices { uint indices[]; };
+layout(std430, binding = 4) readonly buffer ViewLights { Light lights[]; };
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+uniform vec4 cdims;     // nx, ny, nz, max lights per cluster
+uniform vec4 czparams;  // near, far, nz/log(far/near), log(near)*nz/log(far/near)
+uniform vec4 viewport;  // x0, y0, w, h
+uniform vec4 lamb = vec4(0.2, 0.2, 0.2, 1.0);
+
+in VertexData {
+    vec3 veye;
+    vec3 neye;
+} f_in;
+
+out vec4 fcolor;
+
+void main(void)
+{
+    ivec3 dims = ivec3(cdims.xyz);
+    vec2 tile = (gl_FragCoord.xy - viewport.xy) / viewport.zw * vec2(dims.xy);
+    int k = int(log(max(-f_in.veye.z, czparams.x)) * czparams.z - czparams.w);
+    ivec3 cell = clamp(ivec3(ivec2(tile), k), ivec3(0), dims - 1);
+    uint c = uint(cell.x + dims.x * (cell.y + dims.y * cell.z));
+    uint base = c * uint(cdims.w);
+
+    vec3 neye = normalize(f_in.neye);
+    vec3 vdir = normalize(-f_in.veye);
+    vec4 color = mamb * lamb;
+    for (uint i = 0; i < counts[c]; ++i) {
+        Light light = lights[indices[base + i]];
+        vec3 ldir = light.position.xyz - f_in.veye;
+        float dist = length(ldir);
+        ldir /= dist;
+        // windowed inverse square falloff, zero at range
+        float w = clamp(1.0 - pow(dist / light.position.w, 4.0), 0.0, 1.0);
+        float att = w * w / (dist * dist + 1.0);
+        if (int(light.color.a) == 1) {
+            float cosa = dot(-ldir, light.direction.xyz);
+            float cosc = light.direction.w;
+            att *= smoothstep(cosc, mix(cosc, 1.0, 0.1), cosa);
+        }
+        float ndotl = dot(neye, ldir);
+        if (ndotl > 0.0) {
+            vec3 refl = normalize(reflect(-ldir, neye));
+            color += att * light.color * (mdif * ndotl +
+                     mspe * pow(max(0.0, dot(refl, vdir)), mshi));
+        }
+    }
+    fcolor = vec4(color.rgb, mopacity);
+}
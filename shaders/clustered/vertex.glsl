@@ -0,0 +1,22 @@
+#version 430
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+out VertexData {
+    vec3 veye;
+    vec3 neye;
+} v_out;
+
+void main(void)
+{
+    v_out.veye = vec3(Mv * coord);
+    v_out.neye = vec3(Mn * vec4(normal, 0.0));
+    gl_Position = Mvp * coord;
+}
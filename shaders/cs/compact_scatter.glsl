@@ -0,0 +1,26 @@
+#version 430
+
+// Stream compaction: values with a non-zero flag go to their scanned
+// position; the last invocation writes the number of kept values
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint data_in[]; };
+layout(std430, binding = 1) readonly buffer Flags { uint flags[]; };
+layout(std430, binding = 2) readonly buffer Offsets { uint offsets[]; };
+layout(std430, binding = 3) writeonly buffer Output { uint data_out[]; };
+layout(std430, binding = 4) writeonly buffer Count { uint count[]; };
+
+uniform int n;
+
+void main ()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= uint(n))
+    return;
+  uint keep = flags[i] != 0u ? 1u : 0u;
+  if (keep == 1u)
+    data_out[offsets[i]] = data_in[i];
+  if (i == uint(n) - 1u)
+    count[0] = offsets[i] + keep;
+}
@@ -0,0 +1,35 @@
+#version 430
+
+// One level of the depth pyramid (HiZ): level 0 copies the depth texture,
+// the others keep the farthest of the texels covered in the level below
+// (three wide at the last row/column of an odd sized level)
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 0) writeonly uniform image2D dst;
+uniform sampler2D src;
+uniform int level;
+
+void main ()
+{
+  ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+  ivec2 size = imageSize(dst);
+  if (any(greaterThanEqual(p, size)))
+    return;
+  float depth;
+  if (level == 0)
+    depth = texelFetch(src, p, 0).r;
+  else {
+    ivec2 below = textureSize(src, level - 1);
+    ivec2 n = ivec2(2);
+    if ((below.x & 1) != 0 && p.x == size.x - 1) n.x = 3;
+    if ((below.y & 1) != 0 && p.y == size.y - 1) n.y = 3;
+    depth = 0.0;
+    for (int j = 0; j < n.y; ++j)
+      for (int i = 0; i < n.x; ++i) {
+        ivec2 q = min(2 * p + ivec2(i, j), below - 1);
+        depth = max(depth, texelFetch(src, q, level - 1).r);
+      }
+  }
+  imageStore(dst, p, vec4(depth));
+}
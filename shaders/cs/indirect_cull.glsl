@@ -0,0 +1,98 @@
+#version 430
+
+// GPU-driven culling (IndirectRenderer): each invocation tests an object's
+// bounds against the frustum and, if enabled, the HiZ pyramid of the
+// previous frame, and appends a draw command if it may be visible
+
+layout(local_size_x = 64) in;
+
+struct Object {
+  mat4 model;
+  vec4 bmin;      // model space bounds
+  vec4 bmax;
+  vec4 color;
+  uvec4 mesh;     // index count, first index, base vertex
+};
+
+struct Command {
+  uint count;
+  uint instances;
+  uint first;
+  uint base_vertex;
+  uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects { Object objects[]; };
+layout(std430, binding = 1) writeonly buffer Commands { Command commands[]; };
+layout(std430, binding = 2) buffer Count { uint count; };
+
+uniform mat4 viewproj;
+uniform int nobjects;
+uniform int occlusion;
+uniform mat4 hiz_viewproj;  // matrix the HiZ depth was rendered with
+uniform vec4 hiz_size;      // width, height, levels
+uniform sampler2D hiz;
+
+vec3 Corner (vec3 bmin, vec3 bmax, int i)
+{
+  return mix(bmin, bmax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+}
+
+// false if all corners are outside one of the clip planes
+bool InFrustum (vec3 bmin, vec3 bmax, mat4 mvp)
+{
+  uint outside = 63u;
+  for (int i = 0; i < 8; ++i) {
+    vec4 q = mvp * vec4(Corner(bmin, bmax, i), 1.0);
+    uint o = 0u;
+    if (q.x < -q.w) o |= 1u;
+    if (q.x > q.w) o |= 2u;
+    if (q.y < -q.w) o |= 4u;
+    if (q.y > q.w) o |= 8u;
+    if (q.z < -q.w) o |= 16u;
+    if (q.z > q.w) o |= 32u;
+    outside &= o;
+  }
+  return outside == 0u;
+}
+
+bool Occluded (vec3 bmin, vec3 bmax, mat4 mvp)
+{
+  vec2 lo = vec2(1.0), hi = vec2(0.0);
+  float zmin = 1.0;
+  for (int i = 0; i < 8; ++i) {
+    vec4 q = mvp * vec4(Corner(bmin, bmax, i), 1.0);
+    if (q.w <= 0.0)
+      return false;   // crosses the eye plane
+    vec3 ndc = q.xyz / q.w;
+    lo = min(lo, ndc.xy * 0.5 + 0.5);
+    hi = max(hi, ndc.xy * 0.5 + 0.5);
+    zmin = min(zmin, ndc.z * 0.5 + 0.5);
+  }
+  lo = clamp(lo, 0.0, 1.0);
+  hi = clamp(hi, 0.0, 1.0);
+  // level where the rectangle spans at most 2x2 texels
+  vec2 extent = (hi - lo) * hiz_size.xy;
+  float level = ceil(log2(max(max(extent.x, extent.y), 1.0)));
+  level = min(level, hiz_size.z - 1.0);
+  float depth = max(max(textureLod(hiz, lo, level).r, textureLod(hiz, vec2(hi.x, lo.y), level).r),
+                    max(textureLod(hiz, vec2(lo.x, hi.y), level).r, textureLod(hiz, hi, level).r));
+  return zmin > depth;
+}
+
+void main ()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= uint(nobjects))
+    return;
+  vec3 bmin = objects[i].bmin.xyz;
+  vec3 bmax = objects[i].bmax.xyz;
+  mat4 model = objects[i].model;
+  if (!InFrustum(bmin, bmax, viewproj * model))
+    return;
+  if (occlusion != 0 && Occluded(bmin, bmax, hiz_viewproj * model))
+    return;
+  uvec4 mesh = objects[i].mesh;
+  uint slot = atomicAdd(count, 1u);
+  commands[slot] = Command(mesh.x, 1u, mesh.y, mesh.z, i);
+}
@@ -0,0 +1,78 @@
+#version 430
+
+// Clustered light culling: each invocation lists the lights whose bounding
+// sphere reaches its cluster, and transforms one light to view space.
+// Must match LightManager::CullCPU.
+
+layout(local_size_x = 64) in;
+
+struct Light {
+  vec4 position;   // xyz: world position, w: range
+  vec4 color;      // rgb: intensity, a: type (0: point, 1: spot)
+  vec4 direction;  // xyz: spot direction, w: cosine of cutoff angle
+};
+
+layout(std430, binding = 0) readonly buffer Lights { Light lights[]; };
+layout(std430, binding = 1) readonly buffer Clusters { vec4 bounds[]; };
+layout(std430, binding = 2) writeonly buffer Counts { uint counts[]; };
+layout(std430, binding = 3) writeonly buffer Indices { uint indices[]; };
+layout(std430, binding = 4) writeonly buffer ViewLights { Light vlights[]; };
+
+uniform mat4 view;
+uniform int nlights;
+uniform int nclusters;
+uniform int maxlights;
+
+shared vec4 spheres[64];
+
+vec4 LightSphere (Light light)
+{
+  vec3 pos = vec3(view * vec4(light.position.xyz, 1.0));
+  float range = light.position.w;
+  if (int(light.color.a) != 1)
+    return vec4(pos, range);
+  vec3 dir = normalize(vec3(view * vec4(light.direction.xyz, 0.0)));
+  float c = light.direction.w;
+  if (c < 0.70710678)
+    return vec4(pos + dir * (range * c), range * sqrt(1.0 - c * c));
+  float r = range / (2.0 * c);
+  return vec4(pos + dir * r, r);
+}
+
+void main ()
+{
+  uint id = gl_GlobalInvocationID.x;
+  uint lid = gl_LocalInvocationID.x;
+
+  if (id < uint(nlights)) {
+    Light light = lights[id];
+    vlights[id] = Light(vec4(vec3(view * vec4(light.position.xyz, 1.0)), light.position.w),
+                        light.color,
+                        vec4(normalize(vec3(view * vec4(light.direction.xyz, 0.0))), light.direction.w));
+  }
+
+  bool active = id < uint(nclusters);
+  vec3 bmin = vec3(0.0), bmax = vec3(0.0);
+  if (active) {
+    bmin = bounds[2 * id].xyz;
+    bmax = bounds[2 * id + 1].xyz;
+  }
+  uint n = 0;
+  // lights are processed in batches shared by the work group
+  for (int base = 0; base < nlights; base += 64) {
+    int l = base + int(lid);
+    if (l < nlights)
+      spheres[lid] = LightSphere(lights[l]);
+    barrier();
+    int batch = min(64, nlights - base);
+    for (int i = 0; active && i < batch && n < uint(maxlights); ++i) {
+      vec4 s = spheres[i];
+      vec3 d = clamp(s.xyz, bmin, bmax) - s.xyz;
+      if (dot(d, d) <= s.w * s.w)
+        indices[id * uint(maxlights) + n++] = uint(base + i);
+    }
+    barrier();
+  }
+  if (active)
+    counts[id] = n;
+}
@@ -0,0 +1,30 @@
+#version 430
+
+// Radix sort, step 1: histogram of the 4-bit digit of each block of 256
+// keys, stored digit major (hist[digit*nblocks + block]) so that one
+// exclusive scan gives the output offset of each (digit, block)
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Keys { uint keys[]; };
+layout(std430, binding = 4) writeonly buffer Histogram { uint hist[]; };
+
+uniform int n;
+uniform int shift;
+uniform int nblocks;
+
+shared uint counts[16];
+
+void main ()
+{
+  uint lid = gl_LocalInvocationID.x;
+  uint i = gl_GlobalInvocationID.x;
+  if (lid < 16u)
+    counts[lid] = 0u;
+  barrier();
+  if (i < uint(n))
+    atomicAdd(counts[(keys[i] >> shift) & 15u], 1u);
+  barrier();
+  if (lid < 16u)
+    hist[lid * uint(nblocks) + gl_WorkGroupID.x] = counts[lid];
+}
@@ -0,0 +1,91 @@
+#version 430
+
+// Radix sort, step 2: stable sort of each block of 256 pairs by the 4-bit
+// digit (four 1-bit splits in shared memory), then scatter to the scanned
+// histogram offsets
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer KeysIn { uint keys_in[]; };
+layout(std430, binding = 1) readonly buffer ValuesIn { uint values_in[]; };
+layout(std430, binding = 2) writeonly buffer KeysOut { uint keys_out[]; };
+layout(std430, binding = 3) writeonly buffer ValuesOut { uint values_out[]; };
+layout(std430, binding = 4) readonly buffer Offsets { uint offsets[]; };
+
+uniform int n;
+uniform int shift;
+uniform int nblocks;
+
+shared uint s_keys[256];
+shared uint s_values[256];
+shared uint s_scan[256];
+shared uint s_total;
+shared uint s_first[16];
+
+// exclusive scan of s_scan (Blelloch); total in s_total
+void ScanShared (uint lid)
+{
+  uint offset = 1u;
+  for (uint d = 128u; d > 0u; d >>= 1) {
+    barrier();
+    if (lid < d) {
+      uint ai = offset * (2u * lid + 1u) - 1u;
+      uint bi = offset * (2u * lid + 2u) - 1u;
+      s_scan[bi] += s_scan[ai];
+    }
+    offset <<= 1;
+  }
+  barrier();
+  if (lid == 0u) {
+    s_total = s_scan[255];
+    s_scan[255] = 0u;
+  }
+  for (uint d = 1u; d < 256u; d <<= 1) {
+    offset >>= 1;
+    barrier();
+    if (lid < d) {
+      uint ai = offset * (2u * lid + 1u) - 1u;
+      uint bi = offset * (2u * lid + 2u) - 1u;
+      uint t = s_scan[ai];
+      s_scan[ai] = s_scan[bi];
+      s_scan[bi] += t;
+    }
+  }
+  barrier();
+}
+
+void main ()
+{
+  uint lid = gl_LocalInvocationID.x;
+  uint i = gl_GlobalInvocationID.x;
+  uint block = gl_WorkGroupID.x;
+  // padding keys sort last in the block and are not written
+  uint nvalid = uint(min(256, n - int(block) * 256));
+  uint key = i < uint(n) ? keys_in[i] : 0xFFFFFFFFu;
+  uint value = i < uint(n) ? values_in[i] : 0u;
+
+  for (int bit = 0; bit < 4; ++bit) {
+    uint b = (key >> (shift + bit)) & 1u;
+    s_scan[lid] = 1u - b;
+    ScanShared(lid);
+    uint zeros = s_total;
+    uint pos = b == 0u ? s_scan[lid] : zeros + lid - s_scan[lid];
+    s_keys[pos] = key;
+    s_values[pos] = value;
+    barrier();
+    key = s_keys[lid];
+    value = s_values[lid];
+    barrier();
+  }
+
+  // first local position of each digit
+  uint digit = (key >> shift) & 15u;
+  if (lid == 0u || ((s_keys[lid - 1u] >> shift) & 15u) != digit)
+    s_first[digit] = lid;
+  barrier();
+  if (lid < nvalid) {
+    uint pos = offsets[digit * uint(nblocks) + block] + lid - s_first[digit];
+    keys_out[pos] = key;
+    values_out[pos] = value;
+  }
+}
@@ -0,0 +1,40 @@
+#version 430
+
+// Reduce blocks of 512 values (op: 0 sum, 1 min, 2 max) to one value each
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint data_in[]; };
+layout(std430, binding = 1) writeonly buffer Output { uint data_out[]; };
+
+uniform int n;
+uniform int op;
+
+shared uint temp[256];
+
+uint Combine (uint a, uint b)
+{
+  if (op == 1)
+    return min(a, b);
+  if (op == 2)
+    return max(a, b);
+  return a + b;
+}
+
+void main ()
+{
+  uint lid = gl_LocalInvocationID.x;
+  uint a = gl_WorkGroupID.x * 512u + lid;
+  uint b = a + 256u;
+  uint identity = op == 1 ? 0xFFFFFFFFu : 0u;
+  uint va = a < uint(n) ? data_in[a] : identity;
+  uint vb = b < uint(n) ? data_in[b] : identity;
+  temp[lid] = Combine(va, vb);
+  for (uint d = 128u; d > 0u; d >>= 1) {
+    barrier();
+    if (lid < d)
+      temp[lid] = Combine(temp[lid], temp[lid + d]);
+  }
+  if (lid == 0u)
+    data_out[gl_WorkGroupID.x] = temp[0];
+}
@@ -0,0 +1,17 @@
+#version 430
+
+// Add the scanned block sums to each block of 512 scanned values
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 1) buffer Output { uint data_out[]; };
+layout(std430, binding = 2) readonly buffer Sums { uint sums[]; };
+
+uniform int n;
+
+void main ()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if (i < uint(n))
+    data_out[i] += sums[i / 512u];
+}
@@ -0,0 +1,64 @@
+#version 430
+
+// Work-efficient (Blelloch) exclusive scan of blocks of 512 values;
+// the total of each block goes to sums, to be scanned and added back
+// by scan_add.glsl; with predicate set, each input counts as 1 if
+// non-zero (the flags of a compaction)
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) buffer Input { uint data_in[]; };
+layout(std430, binding = 1) buffer Output { uint data_out[]; };
+layout(std430, binding = 2) buffer Sums { uint sums[]; };
+
+uniform int n;
+uniform int predicate;
+
+shared uint temp[512];
+
+void main ()
+{
+  uint lid = gl_LocalInvocationID.x;
+  uint a = gl_WorkGroupID.x * 512u + lid;
+  uint b = a + 256u;
+  temp[lid] = a < uint(n) ? data_in[a] : 0u;
+  temp[lid + 256u] = b < uint(n) ? data_in[b] : 0u;
+  if (predicate != 0) {
+    temp[lid] = temp[lid] != 0u ? 1u : 0u;
+    temp[lid + 256u] = temp[lid + 256u] != 0u ? 1u : 0u;
+  }
+
+  // up-sweep: partial sums in place
+  uint offset = 1u;
+  for (uint d = 256u; d > 0u; d >>= 1) {
+    barrier();
+    if (lid < d) {
+      uint ai = offset * (2u * lid + 1u) - 1u;
+      uint bi = offset * (2u * lid + 2u) - 1u;
+      temp[bi] += temp[ai];
+    }
+    offset <<= 1;
+  }
+  barrier();
+  if (lid == 0u) {
+    sums[gl_WorkGroupID.x] = temp[511];
+    temp[511] = 0u;
+  }
+  // down-sweep
+  for (uint d = 1u; d < 512u; d <<= 1) {
+    offset >>= 1;
+    barrier();
+    if (lid < d) {
+      uint ai = offset * (2u * lid + 1u) - 1u;
+      uint bi = offset * (2u * lid + 2u) - 1u;
+      uint t = temp[ai];
+      temp[ai] = temp[bi];
+      temp[bi] += t;
+    }
+  }
+  barrier();
+  if (a < uint(n))
+    data_out[a] = temp[lid];
+  if (b < uint(n))
+    data_out[b] = temp[lid + 256u];
+}
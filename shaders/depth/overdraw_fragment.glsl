@@ -0,0 +1,11 @@
+#version 410
+
+// Overdraw view: every shaded fragment adds a step, blended additively
+// over black, so a pixel brightens with the number of times it was shaded
+
+out vec4 fcolor;
+
+void main (void)
+{
+  fcolor = vec4(0.25f,0.125f,0.0625f,1.0f);
+}
@@ -0,0 +1,19 @@
+#version 410
+
+// Depth only: positions are the single attribute fetched. The main pass
+// shaders compare equal against this depth, so the position is invariant.
+
+layout(location = 0) in vec4 coord;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+invariant gl_Position;
+
+void main (void)
+{
+  gl_Position = Mvp*coord;
+}
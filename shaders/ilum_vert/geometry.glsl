@@ -5,20 +5,29 @@ layout(triangle_strip, max_vertices = 3) out;
 
 const float shrink_factor = 0.7;
 
-uniform mat4 Mv; 
-uniform mat4 Mn; 
-uniform mat4 Mvp;
-
-uniform vec4 lpos;
-uniform vec4 lamb;
-uniform vec4 ldif;
-uniform vec4 lspe;
-
-uniform vec4 mamb;
-uniform vec4 mdif;
-uniform vec4 mspe;
-uniform float mshi;
-uniform float mopacity;
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
 
 in VertexData {
     vec3 position;
@@ -3,9 +3,11 @@
 layout(location = 0) in vec4 coord;
 layout(location = 1) in vec3 normal;
 
-uniform mat4 Mv; 
-uniform mat4 Mn; 
-uniform mat4 Mvp;
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
 
 out VertexData {
     vec3 position;
@@ -4,19 +4,32 @@ layout(location = 0) in vec4 coord;
 layout(location = 1) in vec3 normal;
 layout(location = 3) in vec2 texcoord;
 
-uniform mat4 Mv; 
-uniform mat4 Mn; 
-uniform mat4 Mvp;
-
-uniform vec4 lpos;  // light pos in eye space
-uniform vec4 lamb;
-uniform vec4 ldif;
-uniform vec4 lspe;
-
-uniform vec4 mamb;
-uniform vec4 mdif;
-uniform vec4 mspe;
-uniform float mshi;
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;  // light pos in lighting space
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+// same depth as the OpaquePass pre-pass
+invariant gl_Position;
 
 out data {
   vec4 color;
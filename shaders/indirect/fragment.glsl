@@ -0,0 +1,36 @@
+#version 430
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+in VertexData {
+    vec3 veye;
+    vec3 neye;
+    flat vec4 color;
+} f_in;
+
+out vec4 fcolor;
+
+void main(void)
+{
+    vec3 light;
+    if (lpos.w == 0.0)
+        light = normalize(vec3(lpos));
+    else
+        light = normalize(vec3(lpos) - f_in.veye);
+    vec3 neye = normalize(f_in.neye);
+    float ndotl = dot(neye, light);
+    vec4 color = f_in.color * (lamb + ldif * max(0.0, ndotl));
+    if (ndotl > 0.0) {
+        vec3 refl = normalize(reflect(-light, neye));
+        color += lspe * pow(max(0.0, dot(refl, normalize(-f_in.veye))), 32.0);
+    }
+    fcolor = vec4(color.rgb, f_in.color.a);
+}
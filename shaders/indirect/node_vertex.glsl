@@ -0,0 +1,38 @@
+#version 430
+
+// Same shading as vertex.glsl for shapes drawn one by one by the scene
+// graph (comparison path of the GPU-driven benchmark)
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+// depth tested equal against a pre-pass
+invariant gl_Position;
+
+out VertexData {
+    vec3 veye;
+    vec3 neye;
+    flat vec4 color;
+} v_out;
+
+void main(void)
+{
+    v_out.veye = vec3(Mv * coord);
+    v_out.neye = vec3(Mn * vec4(normal, 0.0));
+    v_out.color = mdif;
+    gl_Position = Mvp * coord;
+}
@@ -0,0 +1,44 @@
+#version 430
+
+// Objects drawn by IndirectRenderer: the model matrix and color come from
+// the object storage buffer
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+layout(location = 4) in uint object;
+
+struct Object {
+  mat4 model;
+  vec4 bmin;
+  vec4 bmax;
+  vec4 color;
+  uvec4 mesh;
+};
+
+layout(std430, binding = 5) readonly buffer Objects { Object objects[]; };
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+out VertexData {
+    vec3 veye;
+    vec3 neye;
+    flat vec4 color;
+} v_out;
+
+void main(void)
+{
+    // normals assume uniform scales
+    mat4 mv = View * objects[object].model;
+    v_out.veye = vec3(mv * coord);
+    v_out.neye = mat3(mv) * normal;
+    v_out.color = objects[object].color;
+    gl_Position = Proj * vec4(v_out.veye, 1.0);
+}
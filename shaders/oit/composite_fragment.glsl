@@ -0,0 +1,29 @@
+#version 410
+
+// Composite of a TransparencyPass: the average translucent color over the
+// opaque image, covered by 1-revealage; the opaque depth is written along
+
+uniform sampler2D opaque;
+uniform sampler2D accum;
+uniform sampler2D reveal;
+uniform sampler2D depth;
+uniform vec4 viewport;   // x0, y0, w, h
+
+out vec4 fcolor;
+
+void main (void)
+{
+  ivec2 texel = ivec2(gl_FragCoord.xy - viewport.xy);
+  vec3 background = texelFetch(opaque,texel,0).rgb;
+  float revealage = texelFetch(reveal,texel,0).r;
+  gl_FragDepth = texelFetch(depth,texel,0).r;
+  if (revealage >= 1.0f) {   // nothing translucent here
+    fcolor = vec4(background,1.0f);
+    return;
+  }
+  vec4 sum = texelFetch(accum,texel,0);
+  if (isinf(max(max(abs(sum.r),abs(sum.g)),abs(sum.b))))
+    sum.rgb = vec3(sum.a);  // overflow: keep it bright
+  vec3 average = sum.rgb / max(sum.a,1e-5f);
+  fcolor = vec4(mix(average,background,revealage),1.0f);
+}
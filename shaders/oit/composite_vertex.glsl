@@ -0,0 +1,9 @@
+#version 410
+
+// Full screen triangle, with no vertex attributes
+
+void main (void)
+{
+  vec2 pos = vec2(float((gl_VertexID & 1) << 2) - 1.0f,float((gl_VertexID & 2) << 1) - 1.0f);
+  gl_Position = vec4(pos,0.0f,1.0f);
+}
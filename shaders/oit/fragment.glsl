@@ -0,0 +1,21 @@
+#version 410
+
+// Translucent surface of a weighted blended OIT pass (TransparencyPass):
+// premultiplied color, weighted by coverage and depth, is added to the
+// accumulation target; the revealage target is multiplied by 1-alpha
+// (McGuire and Bavoil, "Weighted Blended Order-Independent Transparency")
+
+in vec4 color;
+
+layout(location = 0) out vec4 accum;
+layout(location = 1) out float reveal;
+
+void main (void)
+{
+  float alpha = color.a;
+  float z = gl_FragCoord.z;
+  float weight = clamp(pow(min(1.0f,alpha*10.0f)+0.01f,3.0f) * 1e8f * pow(1.0f-z*0.9f,3.0f),
+                       1e-2f,3e3f);
+  accum = vec4(color.rgb*alpha,alpha) * weight;
+  reveal = alpha;
+}
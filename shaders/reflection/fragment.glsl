@@ -0,0 +1,25 @@
+#version 410
+
+// Reflector: its own color over the mirrored image of a PlanarReflection,
+// weighted by the material opacity
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+uniform sampler2D reflection;
+uniform vec4 viewport;   // x0, y0, w, h
+
+in vec4 color;
+out vec4 fcolor;
+
+void main (void)
+{
+  vec2 texcoord = (gl_FragCoord.xy - viewport.xy) / viewport.zw;
+  vec3 mirrored = texture(reflection,texcoord).rgb;
+  fcolor = vec4(mix(mirrored,color.rgb,mopacity),1.0f);
+}
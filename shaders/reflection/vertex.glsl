@@ -0,0 +1,50 @@
+#version 410
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;  // light pos in lighting space
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+invariant gl_Position;
+
+out vec4 color;
+
+void main (void)
+{
+  vec3 veye = vec3(Mv*coord);
+  vec3 light;
+  if (lpos.w == 0)
+    light = normalize(vec3(lpos));
+  else
+    light = normalize(vec3(lpos)-veye);
+  vec3 neye = normalize(vec3(Mn*vec4(normal,0.0f)));
+  float ndotl = dot(neye,light);
+  color = mamb*lamb + mdif * ldif * max(0,ndotl);
+  if (ndotl > 0) {
+    vec3 refl = normalize(reflect(-light,neye));
+    color += mspe * lspe * pow(max(0,dot(refl,normalize(vec3(cpos)-veye))),mshi);
+  }
+  gl_Position = Mvp*coord;
+}
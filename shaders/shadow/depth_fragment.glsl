@@ -0,0 +1,7 @@
+#version 410
+
+// depth only: nothing to write
+
+void main (void)
+{
+}
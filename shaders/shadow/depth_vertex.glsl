@@ -0,0 +1,14 @@
+#version 410
+
+layout(location = 0) in vec4 coord;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+void main (void)
+{
+  gl_Position = Mvp*coord;
+}
@@ -0,0 +1,85 @@
+#version 410
+
+// Per fragment lighting with the shadows of a ShadowMap
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;  // light pos in lighting space
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+uniform sampler2DShadow shadowmap;   // cascades side by side
+uniform samplerCubeShadow shadowcube;
+uniform int shadow_point;
+uniform int shadow_ncascades;
+uniform mat4 shadow_mats[4];         // lighting space to atlas coordinates
+uniform mat4 shadow_toworld;         // lighting space to world (point light)
+uniform vec3 shadow_lpos;            // point light in world space
+uniform vec4 shadow_range;           // point light near, far
+
+in data {
+  vec3 veye;
+  vec3 neye;
+} f;
+
+out vec4 color;
+
+float CascadeShadow (vec3 pos)
+{
+  vec2 texel = 1.0f / vec2(textureSize(shadowmap,0));
+  float width = 1.0f / shadow_ncascades;
+  // first cascade covering the fragment, keeping the filter inside it
+  for (int c=0; c<shadow_ncascades; ++c) {
+    vec4 p = shadow_mats[c]*vec4(pos,1.0f);
+    if (p.x < c*width + 1.5f*texel.x || p.x > (c+1)*width - 1.5f*texel.x ||
+        p.y < 1.5f*texel.y || p.y > 1.0f - 1.5f*texel.y || p.z > 1.0f)
+      continue;
+    float lit = 0.0f;
+    for (int i=-1; i<=1; ++i)
+      for (int j=-1; j<=1; ++j)
+        lit += texture(shadowmap,vec3(p.xy + vec2(i,j)*texel,p.z));
+    return lit / 9.0f;
+  }
+  return 1.0f;
+}
+
+float CubeShadow (vec3 pos)
+{
+  vec3 d = vec3(shadow_toworld*vec4(pos,1.0f)) - shadow_lpos;
+  float z = max(abs(d.x),max(abs(d.y),abs(d.z)));
+  float n = shadow_range.x, fr = shadow_range.y;
+  if (z > fr)
+    return 1.0f;
+  float depth = 0.5f*((fr+n)/(fr-n) - 2.0f*fr*n/((fr-n)*z)) + 0.5f;
+  return texture(shadowcube,vec4(d,depth));
+}
+
+void main (void)
+{
+  vec3 light;
+  if (lpos.w == 0)
+    light = normalize(vec3(lpos));
+  else
+    light = normalize(vec3(lpos)-f.veye);
+  vec3 neye = normalize(f.neye);
+  float ndotl = dot(neye,light);
+  float lit = shadow_point == 1 ? CubeShadow(f.veye) : CascadeShadow(f.veye);
+  color = mamb*lamb + lit * mdif * ldif * max(0,ndotl);
+  if (ndotl > 0) {
+    vec3 refl = normalize(reflect(-light,neye));
+    color += lit * mspe * lspe * pow(max(0,dot(refl,normalize(vec3(cpos)-f.veye))),mshi);
+  }
+  color.a = mopacity;
+}
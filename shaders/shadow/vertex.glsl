@@ -0,0 +1,22 @@
+#version 410
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+out data {
+  vec3 veye;   // position in lighting space
+  vec3 neye;
+} v;
+
+void main (void)
+{
+  v.veye = vec3(Mv*coord);
+  v.neye = vec3(Mn*vec4(normal,0.0f));
+  gl_Position = Mvp*coord;
+}
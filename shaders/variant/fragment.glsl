@@ -0,0 +1,31 @@
+#version 410
+
+// see vertex.glsl for the variants
+
+in data {
+  vec4 color;
+  vec2 texcoord;
+  float dist;
+} f;
+
+out vec4 fcolor;
+
+#ifdef TEXTURE
+uniform sampler2D decal;
+#endif
+#ifdef FOG
+uniform vec4 fog_color = vec4(1.0, 1.0, 1.0, 1.0);
+uniform vec2 fog_range = vec2(5.0, 20.0);   // start, end
+#endif
+
+void main (void)
+{
+  fcolor = f.color;
+#ifdef TEXTURE
+  fcolor *= texture(decal, f.texcoord);
+#endif
+#ifdef FOG
+  float fog = clamp((f.dist - fog_range.x) / (fog_range.y - fog_range.x), 0.0, 1.0);
+  fcolor.rgb = mix(fcolor.rgb, fog_color.rgb, fog);
+#endif
+}
@@ -0,0 +1,75 @@
+#version 410
+
+// SHRINK variants (see vertex.glsl): lighting of the shrunk triangles
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+const float shrink_factor = 0.7;
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+in VertexData {
+  vec3 position;
+  vec3 normal;
+  vec2 texcoord;
+} v_in[];
+
+out data {
+  vec4 color;
+  vec2 texcoord;
+  float dist;
+} v;
+
+void main (void)
+{
+  vec3 center = (v_in[0].position + v_in[1].position + v_in[2].position) / 3.0;
+  for (int i = 0; i < 3; i++) {
+    vec3 shrunk_pos = center + shrink_factor * (v_in[i].position - center);
+    vec3 veye = vec3(Mv * vec4(shrunk_pos, 1.0));
+    vec3 light;
+    if (lpos.w == 0)
+      light = normalize(vec3(lpos));
+    else
+      light = normalize(vec3(lpos) - veye);
+    vec3 neye = normalize(vec3(Mn * vec4(v_in[i].normal, 0.0)));
+#ifdef TWO_SIDED
+    if (dot(neye, light) < 0)
+      neye = -neye;
+#endif
+    float ndotl = dot(neye, light);
+    v.color = mamb * lamb + mdif * ldif * max(0.0, ndotl);
+    if (ndotl > 0) {
+      vec3 refl = normalize(reflect(-light, neye));
+      v.color += mspe * lspe * pow(max(0.0, dot(refl, normalize(-veye))), mshi);
+    }
+    v.color.a = mopacity;
+    v.texcoord = v_in[i].texcoord;
+    v.dist = distance(veye, vec3(cpos));
+    gl_Position = Mvp * vec4(shrunk_pos, 1.0);
+    EmitVertex();
+  }
+  EndPrimitive();
+}
@@ -0,0 +1,99 @@
+#version 410
+
+// Variants of the ilum_vert shaders (see ShaderVariants), by defines:
+//   TEXTURE    color modulated by the decal texture
+//   TWO_SIDED  normals turned to the light, both faces lit alike
+//   SHRINK     triangles shrunk by geometry.glsl, which then lights them
+//   FOG        color faded to the fog color with the distance to the eye
+
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 normal;
+#ifdef TEXTURE
+layout(location = 3) in vec2 texcoord;
+#endif
+
+layout(std140) uniform DrawBlock {
+  mat4 Mvp;
+  mat4 Mv;
+  mat4 Mn;
+};
+
+#ifdef SHRINK
+
+out VertexData {
+  vec3 position;
+  vec3 normal;
+  vec2 texcoord;
+} v_out;
+
+void main (void)
+{
+  v_out.position = vec3(coord);
+  v_out.normal = normal;
+#ifdef TEXTURE
+  v_out.texcoord = texcoord;
+#else
+  v_out.texcoord = vec2(0.0);
+#endif
+  gl_Position = Mvp*coord;
+}
+
+#else
+
+layout(std140) uniform FrameBlock {
+  mat4 View;
+  mat4 Proj;
+  vec4 cpos;
+  vec4 lpos;  // light pos in lighting space
+  vec4 lamb;
+  vec4 ldif;
+  vec4 lspe;
+};
+
+layout(std140) uniform MaterialBlock {
+  vec4 mamb;
+  vec4 mdif;
+  vec4 mspe;
+  float mshi;
+  float mopacity;
+};
+
+// same depth as the OpaquePass pre-pass
+invariant gl_Position;
+
+out data {
+  vec4 color;
+  vec2 texcoord;
+  float dist;   // to the eye
+} v;
+
+void main (void)
+{
+  vec3 veye = vec3(Mv*coord);
+  vec3 light;
+  if (lpos.w == 0)
+    light = normalize(vec3(lpos));
+  else
+    light = normalize(vec3(lpos)-veye);
+  vec3 neye = normalize(vec3(Mn*vec4(normal,0.0f)));
+#ifdef TWO_SIDED
+  if (dot(neye,light) < 0)
+    neye = -neye;
+#endif
+  float ndotl = dot(neye,light);
+  v.color = mamb*lamb + mdif*ldif*max(0,ndotl);
+  if (ndotl > 0) {
+    vec3 refl = normalize(reflect(-light,neye));
+    v.color += mspe*lspe*pow(max(0,dot(refl,normalize(-veye))),mshi);
+  }
+  v.color.a = mopacity;
+#ifdef TEXTURE
+  v.texcoord = texcoord;
+#else
+  v.texcoord = vec2(0.0);
+#endif
+  v.dist = distance(veye,vec3(cpos));
+  gl_Position = Mvp*coord;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "allocation.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static std::atomic<int> s_policy(Allocation::HEAP);
+static thread_local ArenaPtr t_arena;
+
+// Free list of blocks of one size, carved from 64KB chunks (never returned)
+struct Pool {
+  std::mutex mutex;
+  void* free = nullptr;
+  std::vector<char*> chunks;
+};
+
+static const size_t GRANULE = 16;
+static const size_t CHUNK = 64*1024;
+
+static Pool& GetPool (size_t size)
+{
+  static Pool pools[Allocation::MAX_POOLED/GRANULE];
+  return pools[(size-1)/GRANULE];
+}
+
+void Allocation::SetPolicy (POLICY policy)
+{
+  s_policy = policy;
+}
+
+Allocation::POLICY Allocation::GetPolicy ()
+{
+  return POLICY(s_policy.load());
+}
+
+Allocation::ArenaScope::ArenaScope (ArenaPtr arena)
+: m_previous(t_arena)
+{
+  t_arena = arena;
+}
+
+Allocation::ArenaScope::~ArenaScope ()
+{
+  t_arena = m_previous;
+}
+
+ArenaPtr Allocation::GetArena ()
+{
+  return t_arena;
+}
+
+void* Allocation::PoolAllocate (size_t size)
+{
+  if (size == 0 || size > MAX_POOLED)
+    return ::operator new(size);
+  Pool& pool = GetPool(size);
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  if (!pool.free) {
+    // thread the new chunk's blocks into the free list, first block on top
+    size_t block = ((size-1)/GRANULE+1) * GRANULE;
+    char* chunk = (char*)::operator new(CHUNK);
+    pool.chunks.push_back(chunk);
+    for (size_t off=(CHUNK/block-1)*block; ; off-=block) {
+      *(void**)(chunk+off) = pool.free;
+      pool.free = chunk+off;
+      if (off == 0)
+        break;
+    }
+  }
+  void* ptr = pool.free;
+  pool.free = *(void**)ptr;
+  return ptr;
+}
+
+void Allocation::PoolFree (void* ptr, size_t size)
+{
+  if (size == 0 || size > MAX_POOLED) {
+    ::operator delete(ptr);
+    return;
+  }
+  Pool& pool = GetPool(size);
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  *(void**)ptr = pool.free;
+  pool.free = ptr;
+}
@@ -0,0 +1,55 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+ArenaPtr Arena::Make (size_t chunk_size)
+{
+  return ArenaPtr(new Arena(chunk_size));
+}
+
+Arena::Arena (size_t chunk_size)
+: m_chunk_size(chunk_size),
+  m_ptr(nullptr),
+  m_left(0),
+  m_used(0),
+  m_reserved(0)
+{
+}
+
+Arena::~Arena ()
+{
+  for (char* chunk : m_chunks)
+    ::operator delete(chunk);
+}
+
+void* Arena::Allocate (size_t size, size_t align)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t pad = (align - uintptr_t(m_ptr) % align) % align;
+  if (!m_ptr || pad + size > m_left) {
+    // large requests get a chunk of their own
+    size_t chunk = std::max(m_chunk_size,size+align);
+    m_ptr = (char*)::operator new(chunk);
+    m_left = chunk;
+    m_chunks.push_back(m_ptr);
+    m_reserved += chunk;
+    pad = (align - uintptr_t(m_ptr) % align) % align;
+  }
+  void* p = m_ptr + pad;
+  m_ptr += pad + size;
+  m_left -= pad + size;
+  m_used += size;
+  return p;
+}
+
+size_t Arena::GetUsed () const
+{
+  return m_used;
+}
+
+size_t Arena::GetReserved () const
+{
+  return m_reserved;
+}
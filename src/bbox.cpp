@@ -0,0 +1,67 @@
+#include "bbox.h"
+
+#include <cmath>
+#include <cfloat>
+
+BBox::BBox ()
+: m_min(FLT_MAX), m_max(-FLT_MAX)
+{
+}
+
+BBox::BBox (const glm::vec3& min, const glm::vec3& max)
+: m_min(min), m_max(max)
+{
+}
+
+bool BBox::IsEmpty () const
+{
+  return m_min.x > m_max.x || m_min.y > m_max.y || m_min.z > m_max.z;
+}
+
+const glm::vec3& BBox::GetMin () const
+{
+  return m_min;
+}
+
+const glm::vec3& BBox::GetMax () const
+{
+  return m_max;
+}
+
+glm::vec3 BBox::GetCenter () const
+{
+  return 0.5f * (m_min + m_max);
+}
+
+glm::vec3 BBox::GetExtent () const
+{
+  return 0.5f * (m_max - m_min);
+}
+
+void BBox::Extend (const glm::vec3& p)
+{
+  m_min = glm::min(m_min,p);
+  m_max = glm::max(m_max,p);
+}
+
+void BBox::Extend (const BBox& box)
+{
+  if (box.IsEmpty())
+    return;
+  m_min = glm::min(m_min,box.m_min);
+  m_max = glm::max(m_max,box.m_max);
+}
+
+BBox BBox::Transform (const glm::mat4& mat) const
+{
+  if (IsEmpty())
+    return BBox();
+  // center/extent form: the new extent is |M| times the old one
+  glm::vec3 c = glm::vec3(mat * glm::vec4(GetCenter(),1.0f));
+  glm::vec3 e = GetExtent();
+  glm::vec3 ext(0.0f);
+  for (int i=0; i<3; ++i)
+    for (int j=0; j<3; ++j)
+      ext[i] += std::fabs(mat[j][i]) * e[j];
+  return BBox(c-ext,c+ext);
+}
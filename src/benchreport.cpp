@@ -0,0 +1,188 @@
+#include "benchreport.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// reader of the subset of JSON written by Save (objects, strings, numbers)
+class Parser {
+  const std::string& m_text;
+  size_t m_pos;
+public:
+  Parser (const std::string& text)
+  : m_text(text), m_pos(0)
+  {
+  }
+  bool Expect (char c)
+  {
+    Skip();
+    if (m_pos >= m_text.size() || m_text[m_pos] != c)
+      return false;
+    m_pos++;
+    return true;
+  }
+  bool Peek (char c)
+  {
+    Skip();
+    return m_pos < m_text.size() && m_text[m_pos] == c;
+  }
+  bool String (std::string& str)
+  {
+    if (!Expect('"'))
+      return false;
+    str.clear();
+    while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+      if (m_text[m_pos] == '\\' && m_pos+1 < m_text.size())
+        m_pos++;
+      str += m_text[m_pos++];
+    }
+    return Expect('"');
+  }
+  bool Number (double& value)
+  {
+    Skip();
+    const char* begin = m_text.c_str() + m_pos;
+    char* end = nullptr;
+    value = strtod(begin,&end);
+    if (end == begin)
+      return false;
+    m_pos += end - begin;
+    return true;
+  }
+  // members of an object, each read by f(key)
+  template <class F>
+  bool Object (F f)
+  {
+    if (!Expect('{'))
+      return false;
+    if (Expect('}'))
+      return true;
+    do {
+      std::string key;
+      if (!String(key) || !Expect(':') || !f(key))
+        return false;
+    } while (Expect(','));
+    return Expect('}');
+  }
+private:
+  void Skip ()
+  {
+    while (m_pos < m_text.size() && isspace((unsigned char)m_text[m_pos]))
+      m_pos++;
+  }
+};
+
+bool IsTime (const std::string& metric)
+{
+  return metric.size() > 3 && metric.compare(metric.size()-3,3,"_ms") == 0;
+}
+
+}
+
+BenchReport::BenchReport ()
+{
+}
+
+BenchReportPtr BenchReport::Make ()
+{
+  return BenchReportPtr(new BenchReport());
+}
+
+BenchReportPtr BenchReport::Load (const std::string& filename)
+{
+  std::ifstream in(filename);
+  if (!in)
+    return nullptr;
+  std::stringstream text;
+  text << in.rdbuf();
+  std::string str = text.str();
+  Parser parser(str);
+  BenchReportPtr report = Make();
+  bool ok = parser.Object([&](const std::string& key) {
+    if (key != "scenes") {
+      double ignored;
+      std::string value;
+      return parser.Peek('"') ? parser.String(value) : parser.Number(ignored);
+    }
+    return parser.Object([&](const std::string& scene) {
+      return parser.Object([&](const std::string& metric) {
+        double value;
+        if (!parser.Number(value))
+          return false;
+        report->Set(scene,metric,value);
+        return true;
+      });
+    });
+  });
+  return ok ? report : nullptr;
+}
+
+BenchReport::~BenchReport ()
+{
+}
+
+void BenchReport::Set (const std::string& scene, const std::string& metric, double value)
+{
+  m_scenes[scene][metric] = value;
+}
+
+bool BenchReport::Get (const std::string& scene, const std::string& metric, double& value) const
+{
+  auto it = m_scenes.find(scene);
+  if (it == m_scenes.end())
+    return false;
+  auto jt = it->second.find(metric);
+  if (jt == it->second.end())
+    return false;
+  value = jt->second;
+  return true;
+}
+
+const std::map<std::string,std::map<std::string,double>>& BenchReport::GetScenes () const
+{
+  return m_scenes;
+}
+
+bool BenchReport::Save (const std::string& filename) const
+{
+  FILE* fp = fopen(filename.c_str(),"w");
+  if (!fp)
+    return false;
+  fprintf(fp,"{\n  \"scenes\": {");
+  const char* sep = "\n";
+  for (const auto& scene : m_scenes) {
+    fprintf(fp,"%s    \"%s\": {",sep,scene.first.c_str());
+    const char* msep = "\n";
+    for (const auto& metric : scene.second) {
+      double v = std::isfinite(metric.second) ? metric.second : 0.0;
+      fprintf(fp,"%s      \"%s\": %.6g",msep,metric.first.c_str(),v);
+      msep = ",\n";
+    }
+    fprintf(fp,"\n    }");
+    sep = ",\n";
+  }
+  fprintf(fp,"\n  }\n}\n");
+  return fclose(fp) == 0;
+}
+
+std::vector<BenchReport::Regression> BenchReport::Compare (const BenchReport& base,
+                                                           const BenchReport& current,
+                                                           double threshold, double min_ms)
+{
+  std::vector<Regression> regressions;
+  for (const auto& scene : base.m_scenes) {
+    for (const auto& metric : scene.second) {
+      double value;
+      if (!IsTime(metric.first) || !current.Get(scene.first,metric.first,value))
+        continue;
+      if (value > metric.second * (1.0 + threshold) && value - metric.second > min_ms)
+        regressions.push_back({scene.first,metric.first,metric.second,value});
+    }
+  }
+  return regressions;
+}
@@ -19,6 +19,7 @@ Camera3DPtr Camera3D::Make (float x, float y, float z)
 Camera3D::Camera3D (float x, float y, float z)
 : m_ortho(false),
   m_fovy(45.0f), m_znear(0.1f), m_zfar(1000.0f),
+  m_aspect(0.0f),
   m_center(0.0f,0.0f,0.0f),
   m_eye(x,y,z),
   m_up(0.0f,1.0f,0.0f),
@@ -68,6 +69,11 @@ void Camera3D::SetOrtho (bool ortho)
   m_ortho = ortho;
 }
 
+void Camera3D::SetAspect (float ratio)
+{
+  m_aspect = ratio;
+}
+
 ArcballPtr Camera3D::CreateArcball ()
 {
   float distance = glm::distance(m_eye,m_center);
@@ -87,16 +93,19 @@ void Camera3D::SetReference (NodePtr reference)
 
 glm::mat4 Camera3D::GetProjMatrix () const
 {
-  int viewport[4];  // viewport dimension: {x0, y0, w, h} 
-  glGetIntegerv(GL_VIEWPORT,viewport);  
+  float ratio = m_aspect;
+  if (ratio <= 0.0f) {
+    int viewport[4];  // viewport dimension: {x0, y0, w, h} 
+    glGetIntegerv(GL_VIEWPORT,viewport);  
+    ratio = (float) viewport[2] / viewport[3];
+  }
   if (!m_ortho) {
-    float ratio = (float) viewport[2] / viewport[3];
     return glm::perspective(glm::radians(m_fovy),ratio,m_znear,m_zfar);
   }
   else {
     float distance = glm::distance(m_eye,m_center);
     float height = distance * tan(glm::radians(m_fovy)/2.0f);
-    float width = height / viewport[3] * viewport[2];
+    float width = height * ratio;
     return glm::ortho(-width,width,-height,height,m_znear,m_zfar);
   }
 }
@@ -1,4 +1,5 @@
 #include "color.h"
+#include "allocation.h"
 #include "shader.h"
 #include "state.h"
 
@@ -6,7 +7,7 @@
 
 ColorPtr Color::Make (float r, float g, float b, float a)
 {
-  return ColorPtr(new Color(r,g,b,a));
+  return Allocation::Make<Color>(r,g,b,a);
 }
 
 Color::Color (float r, float g, float b, float a)
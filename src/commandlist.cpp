@@ -0,0 +1,148 @@
+#include "commandlist.h"
+#include "appearance.h"
+#include "error.h"
+#include "shader.h"
+#include "shape.h"
+#include "state.h"
+#include "transform.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+
+CommandListPtr CommandList::Make ()
+{
+  return CommandListPtr(new CommandList());
+}
+
+CommandList::CommandList ()
+: m_view(1.0f), m_proj(1.0f),
+  m_cull(false),
+  m_camera(FixedCamera::Make(glm::mat4(1.0f),glm::mat4(1.0f))),
+  m_draws(0), m_culled(0),
+  m_record_time(0.0)
+{
+}
+
+CommandList::~CommandList ()
+{
+}
+
+void CommandList::Begin (CameraPtr camera)
+{
+  m_commands.clear();
+  m_matrices.clear();
+  m_draws = 0;
+  m_culled = 0;
+  m_record_time = 0.0;
+  m_view = camera->GetViewMatrix();
+  m_proj = camera->GetProjMatrix();
+  m_frustum = Frustum(m_proj * m_view);
+}
+
+void CommandList::Clear (unsigned int mask)
+{
+  m_commands.push_back({CLEAR,nullptr,int(mask)});
+}
+
+void CommandList::Record (NodePtr root, bool cull)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  m_cull = cull;
+  m_camera_space.clear();
+  RecordNode(root.get(),glm::mat4(1.0f));
+  m_record_time += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// Same order of loads and draws as Node::Render
+void CommandList::RecordNode (const Node* node, const glm::mat4& parent)
+{
+  Shader* shader = node->GetShader().get();
+  if (shader) {
+    m_camera_space.push_back(shader->GetLightingSpace() == "camera");
+    m_commands.push_back({LOAD_SHADER,shader,int(m_matrices.size())});
+    m_matrices.push_back(parent);
+  }
+  const TransformPtr& trf = node->GetTransform();
+  glm::mat4 model = trf ? parent * trf->GetMatrix() : parent;
+  for (const AppearancePtr& app : node->GetAppearances())
+    m_commands.push_back({LOAD_APPEARANCE,app.get(),-1});
+  if (!node->GetShapes().empty()) {
+    glm::mat4 vm = m_view * model;
+    glm::mat4 mvp = m_proj * vm;
+    glm::mat4 mv = !m_camera_space.empty() && m_camera_space.back() ? vm : model;
+    glm::mat4 mn = glm::transpose(glm::inverse(mv));
+    for (const ShapePtr& shp : node->GetShapes()) {
+      if (m_cull && !m_frustum.Intersects(shp->GetBounds().Transform(model))) {
+        m_culled++;
+        continue;
+      }
+      m_commands.push_back({DRAW,shp.get(),int(m_matrices.size())});
+      m_matrices.push_back(model);
+      m_matrices.push_back(mvp);
+      m_matrices.push_back(mv);
+      m_matrices.push_back(mn);
+      m_draws++;
+    }
+  }
+  for (const NodePtr& child : node->GetNodes())
+    RecordNode(child.get(),model);
+  for (const AppearancePtr& app : node->GetAppearances())
+    m_commands.push_back({UNLOAD_APPEARANCE,app.get(),-1});
+  if (shader) {
+    m_commands.push_back({UNLOAD_SHADER,shader,-1});
+    m_camera_space.pop_back();
+  }
+}
+
+void CommandList::Execute ()
+{
+  m_camera->SetMatrices(m_view,m_proj);
+  StatePtr st = State::Make(m_camera);
+  for (const Command& cmd : m_commands) {
+    switch (cmd.op) {
+      case CLEAR:
+        glClear(GLbitfield(cmd.index));
+        break;
+      case LOAD_SHADER:
+        st->LoadMatrix(m_matrices[cmd.index]);
+        static_cast<Shader*>(cmd.object)->Load(st);
+        break;
+      case UNLOAD_SHADER:
+        static_cast<Shader*>(cmd.object)->Unload(st);
+        break;
+      case LOAD_APPEARANCE:
+        static_cast<Appearance*>(cmd.object)->Load(st);
+        break;
+      case UNLOAD_APPEARANCE:
+        static_cast<Appearance*>(cmd.object)->Unload(st);
+        break;
+      case DRAW:
+        st->LoadMatrix(m_matrices[cmd.index]);
+        st->LoadMatrices(m_matrices[cmd.index+1],m_matrices[cmd.index+2],m_matrices[cmd.index+3]);
+        static_cast<Shape*>(cmd.object)->Draw(st);
+        break;
+    }
+  }
+  Error::Check("end command list");
+}
+
+int CommandList::GetCommandCount () const
+{
+  return int(m_commands.size());
+}
+
+int CommandList::GetDrawCount () const
+{
+  return m_draws;
+}
+
+int CommandList::GetCulledCount () const
+{
+  return m_culled;
+}
+
+double CommandList::GetRecordTime () const
+{
+  return m_record_time;
+}
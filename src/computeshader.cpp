@@ -3,11 +3,11 @@
 #include <iostream>
 
 #include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
 
 ComputeShader::ComputeShader(const std::string& filename)
-  : m_pid(0), m_texbuffers()
+  : m_shader(Shader::CreateShader(GL_COMPUTE_SHADER, filename)), m_filename(filename), m_texbuffers()
 {
-  m_sid = Shader::CreateShader(GL_COMPUTE_SHADER, filename);
 }
 
 ComputeShaderPtr ComputeShader::Make(const std::string& filename)
@@ -23,22 +23,108 @@ void ComputeShader::AttachTexBuffer(TexBufferPtr texbuf)
   m_texbuffers.push_back(texbuf);
 }
 
-void ComputeShader::Dispatch(int nx, int ny, int nz)
+void ComputeShader::AttachStorageBuffer(int binding, StorageBufferPtr buf)
+{
+  // a binding point holds one buffer: replace the previous one
+  for (auto& storage : m_storages) {
+    if (storage.first == binding) {
+      storage.second = buf;
+      return;
+    }
+  }
+  m_storages.push_back(std::make_pair(binding, buf));
+}
+
+void ComputeShader::UseProgram()
 {
-  // Lazily create program on first dispatch 
-  if (m_pid == 0) {
-    m_pid = glCreateProgram();
-    glAttachShader(m_pid,m_sid);
-    Shader::LinkProgram(m_pid);
+  // Lazily create program on first use 
+  if (!m_program) {
+    m_program.Create();
+    glAttachShader(m_program.Get(), m_shader.Get());
+    Shader::LinkProgram(m_program.Get());
+    m_uniforms.clear();
   }
+  glUseProgram(m_program.Get());
+}
 
-  glUseProgram(m_pid);
+int ComputeShader::GetUniformLocation(const std::string& varname) const
+{
+  auto it = m_uniforms.find(varname);
+  if (it != m_uniforms.end())
+    return it->second;
+  GLint loc = glGetUniformLocation(m_program.Get(), varname.c_str());
+  m_uniforms[varname] = loc;
+  return loc;
+}
+
+void ComputeShader::SetUniform(const std::string& varname, int x)
+{
+  glUniform1i(GetUniformLocation(varname), x);
+}
+
+void ComputeShader::SetUniform(const std::string& varname, float x)
+{
+  glUniform1f(GetUniformLocation(varname), x);
+}
+
+void ComputeShader::SetUniform(const std::string& varname, const glm::vec4& vet)
+{
+  glUniform4fv(GetUniformLocation(varname), 1, glm::value_ptr(vet));
+}
+
+void ComputeShader::SetUniform(const std::string& varname, const glm::mat4& mat)
+{
+  glUniformMatrix4fv(GetUniformLocation(varname), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+bool ComputeShader::Reload(const std::unordered_map<std::string,std::string>& changed)
+{
+  auto it = changed.find(m_filename);
+  if (it == changed.end())
+    return false;
+  m_pending_program.Reset();
+  m_pending_shader.Reset(Shader::CompileSource(GL_COMPUTE_SHADER, m_filename, it->second));
+  if (!m_pending_shader)
+    return false;
+  m_pending_program.Create();
+  glAttachShader(m_pending_program.Get(), m_pending_shader.Get());
+  glLinkProgram(m_pending_program.Get());
+  return true;
+}
+
+bool ComputeShader::PollReload()
+{
+  if (!m_pending_program || Shader::IsCompletionPending(m_pending_program.Get()))
+    return false;
+  bool ok = Shader::CheckShader(m_pending_shader.Get(), m_filename) &&
+            Shader::CheckProgram(m_pending_program.Get());
+  if (!ok) {
+    std::cerr << "Compute shader reload failed: keeping the previous program" << std::endl;
+    m_pending_program.Reset();
+    m_pending_shader.Reset();
+  }
+  else {
+    m_program = std::move(m_pending_program);
+    m_shader = std::move(m_pending_shader);
+    m_uniforms.clear();
+  }
+  return ok;
+}
+
+const std::string& ComputeShader::GetSourceFile() const
+{
+  return m_filename;
+}
+
+void ComputeShader::Dispatch(int nx, int ny, int nz)
+{
+  UseProgram();
 
   // Bind each texture as an image 
   for (GLuint i = 0; i < m_texbuffers.size(); ++i) {
     TexBufferPtr buf = m_texbuffers[i];
     // Uniform location
-    GLint loc = glGetUniformLocation(m_pid, buf->GetName().c_str());
+    GLint loc = GetUniformLocation(buf->GetName());
     glUniform1i(loc, i); // bind unit index
 
     // Bind as image (read-write, layer=0, level=0)
@@ -50,15 +136,37 @@ void ComputeShader::Dispatch(int nx, int ny, int nz)
       GL_FALSE,               // layered
       0,                      // layer
       GL_READ_WRITE,          // access
-      GL_R32F                 // format (e.g., GL_R32F, GL_RGBA32F)
+      buf->GetInternalFormat() // format (e.g., GL_R32F, GL_RGBA32F)
     );
   }
 
+  for (const auto& storage : m_storages)
+    storage.second->Bind(storage.first);
+
   // Dispatch
   glDispatchCompute(nx, ny, nz);
 
-  // Memory barriers (mirroring Python)
-  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT |
-                  GL_TEXTURE_FETCH_BARRIER_BIT  |
-                  GL_BUFFER_UPDATE_BARRIER_BIT);
+  // Memory barriers (only the configured scope)
+  if (m_barrier)
+    Barrier(m_barrier);
+}
+
+void ComputeShader::SetBarrier(int scope)
+{
+  m_barrier = scope;
+}
+
+void ComputeShader::Barrier(int scope)
+{
+  GLbitfield bits = 0;
+  if (scope & STORAGE) bits |= GL_SHADER_STORAGE_BARRIER_BIT;
+  if (scope & TEXTURE_FETCH) bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+  if (scope & BUFFER_UPDATE) bits |= GL_BUFFER_UPDATE_BARRIER_BIT;
+  if (scope & IMAGE_ACCESS) bits |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+  if (scope & VERTEX_ATTRIB) bits |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+  if (scope & ELEMENT_ARRAY) bits |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+  if (scope & INDIRECT) bits |= GL_COMMAND_BARRIER_BIT;
+  if (scope & UNIFORM) bits |= GL_UNIFORM_BARRIER_BIT;
+  if (bits)
+    glMemoryBarrier(bits);
 }
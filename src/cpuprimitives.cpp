@@ -0,0 +1,152 @@
+#include "cpuprimitives.h"
+
+#include <algorithm>
+#include <thread>
+
+static int s_nthreads = 0;
+
+void CPUPrimitives::SetThreadCount (int n)
+{
+  s_nthreads = n;
+}
+
+int CPUPrimitives::GetThreadCount ()
+{
+  if (s_nthreads > 0)
+    return s_nthreads;
+  return std::max(1,int(std::thread::hardware_concurrency()));
+}
+
+// Run f(t, begin, end) on one chunk of [0,n) per thread
+template <class F>
+static void Parallel (int nthreads, size_t n, F f)
+{
+  std::vector<std::thread> threads;
+  size_t chunk = (n + nthreads - 1) / nthreads;
+  for (int t=1; t<nthreads; ++t)
+    threads.push_back(std::thread(f,t,std::min(n,t*chunk),std::min(n,(t+1)*chunk)));
+  f(0,size_t(0),std::min(n,chunk));
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+// Few elements per thread are not worth the thread start
+static int ThreadsFor (size_t n)
+{
+  return int(std::max(size_t(1),std::min(size_t(CPUPrimitives::GetThreadCount()),n/16384)));
+}
+
+void CPUPrimitives::ExclusiveScan (const std::vector<unsigned int>& in, std::vector<unsigned int>& out)
+{
+  int nthreads = ThreadsFor(in.size());
+  std::vector<unsigned int> sums(nthreads+1,0);
+  out.resize(in.size());
+  // chunk totals, then scan of the chunks seeded with the totals before them
+  Parallel(nthreads,in.size(),[&](int t, size_t b, size_t e) {
+    unsigned int s = 0;
+    for (size_t i=b; i<e; ++i)
+      s += in[i];
+    sums[t+1] = s;
+  });
+  for (int t=0; t<nthreads; ++t)
+    sums[t+1] += sums[t];
+  Parallel(nthreads,in.size(),[&](int t, size_t b, size_t e) {
+    unsigned int s = sums[t];
+    for (size_t i=b; i<e; ++i) {
+      unsigned int v = in[i];
+      out[i] = s;
+      s += v;
+    }
+  });
+}
+
+static unsigned int Combine (CPUPrimitives::OP op, unsigned int a, unsigned int b)
+{
+  switch (op) {
+  case CPUPrimitives::MIN: return std::min(a,b);
+  case CPUPrimitives::MAX: return std::max(a,b);
+  default: return a + b;
+  }
+}
+
+unsigned int CPUPrimitives::Reduce (const std::vector<unsigned int>& in, OP op)
+{
+  unsigned int identity = op == MIN ? 0xFFFFFFFFu : 0u;
+  int nthreads = ThreadsFor(in.size());
+  std::vector<unsigned int> partial(nthreads,identity);
+  Parallel(nthreads,in.size(),[&](int t, size_t b, size_t e) {
+    unsigned int r = identity;
+    for (size_t i=b; i<e; ++i)
+      r = Combine(op,r,in[i]);
+    partial[t] = r;
+  });
+  unsigned int r = identity;
+  for (unsigned int p : partial)
+    r = Combine(op,r,p);
+  return r;
+}
+
+int CPUPrimitives::Compact (const std::vector<unsigned int>& in, const std::vector<unsigned int>& flags,
+                            std::vector<unsigned int>& out)
+{
+  int nthreads = ThreadsFor(in.size());
+  std::vector<size_t> offsets(nthreads+1,0);
+  Parallel(nthreads,in.size(),[&](int t, size_t b, size_t e) {
+    size_t count = 0;
+    for (size_t i=b; i<e; ++i)
+      count += flags[i] != 0;
+    offsets[t+1] = count;
+  });
+  for (int t=0; t<nthreads; ++t)
+    offsets[t+1] += offsets[t];
+  out.resize(offsets[nthreads]);
+  Parallel(nthreads,in.size(),[&](int t, size_t b, size_t e) {
+    size_t k = offsets[t];
+    for (size_t i=b; i<e; ++i)
+      if (flags[i] != 0)
+        out[k++] = in[i];
+  });
+  return int(offsets[nthreads]);
+}
+
+// 8-bit digits: 4 passes, ping-ponging back into keys/values
+void CPUPrimitives::SortPairs (std::vector<unsigned int>& keys, std::vector<unsigned int>& values)
+{
+  const int RADIX = 256;
+  size_t n = keys.size();
+  int nthreads = ThreadsFor(n);
+  std::vector<unsigned int> tkeys(n), tvalues(n);
+  std::vector<size_t> hist(size_t(nthreads)*RADIX);
+  std::vector<unsigned int>* src[2] = {&keys,&values};
+  std::vector<unsigned int>* dst[2] = {&tkeys,&tvalues};
+  for (int shift=0; shift<32; shift+=8) {
+    const std::vector<unsigned int>& skeys = *src[0];
+    const std::vector<unsigned int>& svalues = *src[1];
+    std::vector<unsigned int>& dkeys = *dst[0];
+    std::vector<unsigned int>& dvalues = *dst[1];
+    Parallel(nthreads,n,[&](int t, size_t b, size_t e) {
+      size_t* h = &hist[size_t(t)*RADIX];
+      std::fill(h,h+RADIX,size_t(0));
+      for (size_t i=b; i<e; ++i)
+        h[(skeys[i] >> shift) & (RADIX-1)]++;
+    });
+    // digit major, thread minor: keeps the sort stable
+    size_t sum = 0;
+    for (int d=0; d<RADIX; ++d) {
+      for (int t=0; t<nthreads; ++t) {
+        size_t c = hist[size_t(t)*RADIX+d];
+        hist[size_t(t)*RADIX+d] = sum;
+        sum += c;
+      }
+    }
+    Parallel(nthreads,n,[&](int t, size_t b, size_t e) {
+      size_t* h = &hist[size_t(t)*RADIX];
+      for (size_t i=b; i<e; ++i) {
+        size_t pos = h[(skeys[i] >> shift) & (RADIX-1)]++;
+        dkeys[pos] = skeys[i];
+        dvalues[pos] = svalues[i];
+      }
+    });
+    std::swap(src,dst);
+  }
+}
@@ -1,43 +1,49 @@
 #include "disk.h"
+#include "allocation.h"
+#include "geometrycache.h"
 
 #include <cmath>
 #include <glad/glad.h>
+#include <string>
 #include <vector>
 
 DiskPtr Disk::Make(int nslice) {
-  return DiskPtr(new Disk(nslice));
+  return Allocation::Make<Disk>(nslice);
 }
 
-Disk::Disk(int nslice) {
+static VertexArrayPtr Build(int nslice) {
   float radius = 1.0f;
   std::vector<float> coords;
-  m_nslice = nslice;
-
   for (int i = 0; i < nslice; i++) {
     float angle = 2.0f * M_PI * i / nslice;
     float x = radius * cos(angle);
     float y = radius * sin(angle);
-
     coords.push_back(x);
     coords.push_back(y);
   }
+  VertexArrayPtr array = VertexArray::Make();
+  array->SetAttribute(Shape::COORD, array->AddBuffer(int(coords.size()), coords.data()), 2);
+  array->SetMode(GL_TRIANGLE_FAN, nslice);
+  return array;
+}
 
-  glGenVertexArrays(1, &m_vao);
-  glBindVertexArray(m_vao);
+Disk::Disk(int nslice)
+    : m_array(GeometryCache::Get("disk/" + std::to_string(nslice),
+                                 [nslice]() { return Build(nslice); })) {}
 
-  GLuint ids[1];
-  glGenBuffers(1, ids);
+Disk::~Disk() {}
 
-  glBindBuffer(GL_ARRAY_BUFFER, ids[0]);
-  glBufferData(GL_ARRAY_BUFFER, coords.size() * sizeof(float), coords.data(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
-  glEnableVertexAttribArray(0);
+void Disk::Draw(StatePtr) {
+  m_array->Draw();
 }
 
-Disk::~Disk() {}
+BBox Disk::GetBounds() const {
+  return BBox(glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+}
 
-void Disk::Draw(StatePtr) {
-  glBindVertexArray(m_vao);
-  glDrawArrays(GL_TRIANGLE_FAN, 0, m_nslice);
+bool Disk::GetMeshData(MeshData& data) const {
+  if (!m_array->Read(data))
+    return false;
+  data.Complete(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+  return true;
 }
@@ -0,0 +1,246 @@
+#include "entitystore.h"
+#include "error.h"
+#include "state.h"
+
+#include <algorithm>
+
+EntityStorePtr EntityStore::Make ()
+{
+  return EntityStorePtr(new EntityStore());
+}
+
+EntityStorePtr EntityStore::Make (ScenePtr scene)
+{
+  EntityStorePtr store = Make();
+  store->Import(scene->GetRoot());
+  store->UpdateTransforms();
+  return store;
+}
+
+EntityStore::EntityStore ()
+: m_alive(0),
+  m_order_dirty(false),
+  m_draws_dirty(false)
+{
+}
+
+EntityStore::~EntityStore ()
+{
+}
+
+Entity EntityStore::Create ()
+{
+  uint32_t index;
+  if (!m_free.empty()) {
+    index = m_free.back();
+    m_free.pop_back();
+  }
+  else {
+    index = uint32_t(m_generations.size());
+    m_generations.push_back(0);
+  }
+  m_alive++;
+  return {index,m_generations[index]};
+}
+
+void EntityStore::Destroy (Entity e)
+{
+  if (!IsAlive(e))
+    return;
+  if (m_transforms.Remove(e.index) | m_hierarchy.Remove(e.index))
+    m_order_dirty = true;
+  if (m_shapes.Remove(e.index) | m_materials.Remove(e.index) | m_shaders.Remove(e.index))
+    m_draws_dirty = true;
+  m_generations[e.index]++;
+  m_free.push_back(e.index);
+  m_alive--;
+}
+
+bool EntityStore::IsAlive (Entity e) const
+{
+  return e.index < m_generations.size() && m_generations[e.index] == e.generation;
+}
+
+int EntityStore::GetEntityCount () const
+{
+  return m_alive;
+}
+
+int EntityStore::GetDrawCount () const
+{
+  return int(m_draws.size());
+}
+
+int EntityStore::AddAppearanceSet (const std::vector<AppearancePtr>& apps)
+{
+  std::vector<Appearance*> set;
+  set.reserve(apps.size());
+  for (const AppearancePtr& app : apps)
+    set.push_back(Keep(app));
+  auto it = m_set_ids.find(set);
+  if (it != m_set_ids.end())
+    return it->second;
+  int id = int(m_sets.size());
+  m_sets.push_back(set);
+  m_set_ids[set] = id;
+  return id;
+}
+
+Entity EntityStore::Import (NodePtr node, Entity parent)
+{
+  // inherit what the ancestors of node would load
+  ShaderPtr shader = nullptr;
+  std::vector<AppearancePtr> apps;
+  std::vector<NodePtr> path;
+  for (NodePtr p=node->GetParent(); p; p=p->GetParent())
+    path.push_back(p);
+  for (auto it=path.rbegin(); it!=path.rend(); ++it) {
+    if ((*it)->GetShader())
+      shader = (*it)->GetShader();
+    apps.insert(apps.end(),(*it)->GetAppearances().begin(),(*it)->GetAppearances().end());
+  }
+  return Import(node,parent,shader,apps);
+}
+
+Entity EntityStore::Import (NodePtr node, Entity parent, ShaderPtr shader, std::vector<AppearancePtr>& apps)
+{
+  Entity e = Create();
+  TransformPtr trf = node->GetTransform();
+  Add<TransformComponent>(e,{trf ? trf->GetMatrix() : glm::mat4(1.0f),glm::mat4(1.0f),Keep(trf),-1});
+  if (IsAlive(parent))
+    Add<HierarchyComponent>(e,{parent});
+  if (node->GetShader())
+    shader = node->GetShader();
+  size_t napps = apps.size();
+  apps.insert(apps.end(),node->GetAppearances().begin(),node->GetAppearances().end());
+  if (!node->GetShapes().empty()) {
+    int set = AddAppearanceSet(apps);
+    for (const ShapePtr& shp : node->GetShapes()) {
+      Entity s = Create();
+      Add<ShapeComponent>(s,{Keep(shp),e});
+      Add<MaterialComponent>(s,{set});
+      if (shader)
+        Add<ShaderComponent>(s,{Keep(shader)});
+    }
+  }
+  for (const NodePtr& child : node->GetNodes())
+    Import(child,e,shader,apps);
+  apps.resize(napps);
+  return e;
+}
+
+// Stable sort of the transforms by hierarchy depth, then cache the dense
+// index of each parent (the nearest ancestor with a transform)
+void EntityStore::SortTransforms ()
+{
+  int n = m_transforms.Size();
+  std::vector<int> depth(n);
+  for (int i=0; i<n; ++i) {
+    int d = 0;
+    HierarchyComponent* h = m_hierarchy.Get(m_transforms.EntityAt(i));
+    while (h && IsAlive(h->parent)) {
+      d++;
+      h = m_hierarchy.Get(h->parent.index);
+    }
+    depth[i] = d;
+  }
+  std::vector<int> order(n);
+  for (int i=0; i<n; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(),order.end(),[&depth](int a, int b) {
+    return depth[a] < depth[b];
+  });
+  m_transforms.Reorder(order);
+  for (int i=0; i<n; ++i) {
+    int parent = -1;
+    HierarchyComponent* h = m_hierarchy.Get(m_transforms.EntityAt(i));
+    while (parent < 0 && h && IsAlive(h->parent)) {
+      parent = m_transforms.IndexOf(h->parent.index);
+      h = m_hierarchy.Get(h->parent.index);
+    }
+    m_transforms[i].parent = parent;
+  }
+  m_order_dirty = false;
+}
+
+void EntityStore::UpdateTransforms ()
+{
+  if (m_order_dirty)
+    SortTransforms();
+  int n = m_transforms.Size();
+  for (int i=0; i<n; ++i) {
+    TransformComponent& t = m_transforms[i];
+    if (t.source)
+      t.local = t.source->GetMatrix();
+    t.world = t.parent < 0 ? t.local : m_transforms[t.parent].world * t.local;
+  }
+}
+
+void EntityStore::BuildDraws ()
+{
+  m_draws.clear();
+  m_draws.reserve(m_shapes.Size());
+  for (int i=0; i<m_shapes.Size(); ++i) {
+    uint32_t e = m_shapes.EntityAt(i);
+    ShaderComponent* shd = m_shaders.Get(e);
+    if (!shd || !shd->shader)
+      continue;   // nothing to draw with
+    MaterialComponent* mat = m_materials.Get(e);
+    m_draws.push_back({shd->shader,mat ? mat->set : -1,i});
+  }
+  std::stable_sort(m_draws.begin(),m_draws.end(),[](const Draw& a, const Draw& b) {
+    if (a.shader != b.shader)
+      return std::less<Shader*>()(a.shader,b.shader);
+    return a.set < b.set;
+  });
+  m_draws_dirty = false;
+}
+
+void EntityStore::Render (CameraPtr camera)
+{
+  Render(State::Make(camera));
+}
+
+void EntityStore::Render (StatePtr st)
+{
+  if (m_order_dirty)
+    SortTransforms();
+  if (m_draws_dirty)
+    BuildDraws();
+  Shader* shader = nullptr;
+  int set = -1;
+  st->PushMatrix();
+  for (const Draw& draw : m_draws) {
+    if (draw.shader != shader || draw.set != set) {
+      // unload in reverse order
+      if (set >= 0)
+        for (auto it=m_sets[set].rbegin(); it!=m_sets[set].rend(); ++it)
+          (*it)->Unload(st);
+      if (draw.shader != shader) {
+        if (shader)
+          shader->Unload(st);
+        st->LoadMatrix(glm::mat4(1.0f));
+        shader = draw.shader;
+        shader->Load(st);
+      }
+      set = draw.set;
+      if (set >= 0)
+        for (Appearance* app : m_sets[set])
+          app->Load(st);
+    }
+    const ShapeComponent& s = m_shapes[draw.shape];
+    TransformComponent* t = m_transforms.Get(s.node.index);
+    st->LoadMatrix(t && IsAlive(s.node) ? t->world : glm::mat4(1.0f));
+    if (st->IsVisible(s.shape->GetBounds())) {
+      st->LoadMatrices();
+      s.shape->Draw(st);
+    }
+  }
+  if (set >= 0)
+    for (auto it=m_sets[set].rbegin(); it!=m_sets[set].rend(); ++it)
+      (*it)->Unload(st);
+  if (shader)
+    shader->Unload(st);
+  st->PopMatrix();
+  Error::Check("end entity store render");
+}
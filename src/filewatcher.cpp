@@ -0,0 +1,163 @@
+#include "filewatcher.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Read the whole file; empty string if it cannot be read (e.g. during save)
+static std::string ReadContent (const std::string& filename)
+{
+  std::ifstream fp(filename);
+  if (!fp.is_open())
+    return std::string();
+  std::stringstream str;
+  str << fp.rdbuf();
+  return str.str();
+}
+
+static long long ModificationTime (const std::string& filename)
+{
+  std::error_code ec;
+  auto t = std::filesystem::last_write_time(filename,ec);
+  if (ec)
+    return 0;
+  return (long long)t.time_since_epoch().count();
+}
+
+FileWatcherPtr FileWatcher::Make ()
+{
+  return FileWatcherPtr(new FileWatcher());
+}
+
+FileWatcher::FileWatcher ()
+: m_fd(-1),
+  m_running(true)
+{
+#ifdef __linux__
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0)
+    std::cerr << "inotify not available: polling watched files" << std::endl;
+#endif
+  m_thread = std::thread(&FileWatcher::Run,this);
+}
+
+FileWatcher::~FileWatcher ()
+{
+  m_running = false;
+  if (m_thread.joinable())
+    m_thread.join();
+#ifdef __linux__
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+}
+
+void FileWatcher::Watch (const std::string& filename)
+{
+  std::filesystem::path path(filename);
+  std::string dir = path.parent_path().string();
+  if (dir.empty())
+    dir = ".";
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const Entry& e : m_entries)
+    if (e.filename == filename)
+      return;
+  m_entries.push_back({filename,dir,path.filename().string(),ModificationTime(filename)});
+#ifdef __linux__
+  if (m_fd >= 0) {
+    // watch the directory: editors usually save by renaming a new file
+    int wd = inotify_add_watch(m_fd,dir.c_str(),IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+      std::cerr << "Could not watch directory: " << dir << std::endl;
+    else
+      m_dirs[wd] = dir;
+  }
+#endif
+}
+
+std::unordered_map<std::string,std::string> FileWatcher::TakeChanges ()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::unordered_map<std::string,std::string> changes;
+  changes.swap(m_changes);
+  return changes;
+}
+
+void FileWatcher::Notify (const std::string& dir, const std::string& name)
+{
+  std::vector<std::string> files;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Entry& e : m_entries)
+      if (e.dir == dir && e.name == name)
+        files.push_back(e.filename);
+  }
+  for (const std::string& filename : files) {
+    // read outside the lock: this is the work kept off the render thread
+    std::string content = ReadContent(filename);
+    if (content.empty())
+      continue;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_changes[filename] = content;
+  }
+}
+
+void FileWatcher::PollModificationTimes ()
+{
+  std::vector<Entry> changed;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Entry& e : m_entries) {
+      long long t = ModificationTime(e.filename);
+      if (t != 0 && t != e.mtime) {
+        e.mtime = t;
+        changed.push_back(e);
+      }
+    }
+  }
+  for (const Entry& e : changed)
+    Notify(e.dir,e.name);
+}
+
+void FileWatcher::Run ()
+{
+  while (m_running) {
+#ifdef __linux__
+    if (m_fd >= 0) {
+      struct pollfd pfd = {m_fd,POLLIN,0};
+      if (poll(&pfd,1,200) <= 0)
+        continue;
+      alignas(struct inotify_event) char buffer[4096];
+      ssize_t len;
+      while ((len = read(m_fd,buffer,sizeof(buffer))) > 0) {
+        for (char* ptr = buffer; ptr < buffer + len; ) {
+          const struct inotify_event* event = (const struct inotify_event*)ptr;
+          if (event->len > 0) {
+            std::string dir;
+            {
+              std::lock_guard<std::mutex> lock(m_mutex);
+              auto it = m_dirs.find(event->wd);
+              if (it != m_dirs.end())
+                dir = it->second;
+            }
+            if (!dir.empty())
+              Notify(dir,event->name);
+          }
+          ptr += sizeof(struct inotify_event) + event->len;
+        }
+      }
+      continue;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    PollModificationTimes();
+  }
+}
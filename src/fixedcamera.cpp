@@ -0,0 +1,42 @@
+#include "fixedcamera.h"
+#include "state.h"
+#include "shader.h"
+
+FixedCameraPtr FixedCamera::Make (const glm::mat4& view, const glm::mat4& proj)
+{
+  return FixedCameraPtr(new FixedCamera(view,proj));
+}
+
+FixedCamera::FixedCamera (const glm::mat4& view, const glm::mat4& proj)
+: m_view(view), m_proj(proj)
+{
+}
+
+FixedCamera::~FixedCamera ()
+{
+}
+
+void FixedCamera::SetMatrices (const glm::mat4& view, const glm::mat4& proj)
+{
+  m_view = view;
+  m_proj = proj;
+}
+
+glm::mat4 FixedCamera::GetProjMatrix () const
+{
+  return m_proj;
+}
+
+glm::mat4 FixedCamera::GetViewMatrix () const
+{
+  return m_view;
+}
+
+void FixedCamera::Load (StatePtr st) const
+{
+  ShaderPtr shd = st->GetShader();
+  glm::vec4 cpos(0.0f,0.0f,0.0f,1.0f);  // in camera space
+  if (shd->GetLightingSpace() == "world")
+    cpos = glm::inverse(m_view) * cpos;
+  shd->SetUniform("cpos",cpos);
+}
@@ -7,8 +7,8 @@
 Framebuffer::Framebuffer (TexDepthPtr depth, std::initializer_list<TexturePtr> colors)
 : m_depth(depth), m_colors(colors)
 {
-  glGenFramebuffers(1,&m_fbo);
-  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  m_fbo.Create();
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo.Get());
   if (m_depth != nullptr)
     glFramebufferTexture(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,m_depth->GetTexId(),0);
   for (int i=0; i<m_colors.size(); ++i) {
@@ -41,9 +41,21 @@ TexturePtr Framebuffer::GetColorTexture (int i) const
   return m_colors[i];
 }
 
+unsigned int Framebuffer::GetId () const
+{
+  return m_fbo.Get();
+}
+
+void Framebuffer::SetDepthFace (int face)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo.Get());
+  glFramebufferTexture2D(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,GL_TEXTURE_CUBE_MAP_POSITIVE_X+face,
+                         m_depth->GetTexId(),0);
+}
+
 void Framebuffer::Bind ()
 {
-  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo.Get());
   if (m_colors.empty()) {
     glDrawBuffer(GL_NONE);
   }
@@ -0,0 +1,43 @@
+#include "frustum.h"
+
+#include <cmath>
+
+Frustum::Frustum (const glm::mat4& m, bool use_near)
+{
+  // Gribb-Hartmann: planes are sums/differences of the matrix rows
+  glm::vec4 row[4];
+  for (int i=0; i<4; ++i)
+    row[i] = glm::vec4(m[0][i],m[1][i],m[2][i],m[3][i]);
+  m_planes[0] = row[3] + row[0];
+  m_planes[1] = row[3] - row[0];
+  m_planes[2] = row[3] + row[1];
+  m_planes[3] = row[3] - row[1];
+  m_planes[4] = row[3] - row[2];  // far
+  m_planes[5] = row[3] + row[2];  // near
+  m_nplanes = use_near ? 6 : 5;
+  for (int i=0; i<6; ++i)
+    m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+}
+
+bool Frustum::Intersects (const BBox& box) const
+{
+  if (box.IsEmpty())
+    return true;
+  glm::vec3 c = box.GetCenter();
+  glm::vec3 e = box.GetExtent();
+  for (int i=0; i<m_nplanes; ++i) {
+    const glm::vec4& p = m_planes[i];
+    float r = e.x*std::fabs(p.x) + e.y*std::fabs(p.y) + e.z*std::fabs(p.z);
+    if (glm::dot(glm::vec3(p),c) + p.w < -r)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::Contains (const glm::vec3& p) const
+{
+  for (int i=0; i<m_nplanes; ++i)
+    if (glm::dot(glm::vec3(m_planes[i]),p) + m_planes[i].w < 0.0f)
+      return false;
+  return true;
+}
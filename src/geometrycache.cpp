@@ -0,0 +1,68 @@
+#include "geometrycache.h"
+
+#include <map>
+
+// trivially destructible counters: arrays may be released at exit, after
+// the map is gone
+static long s_bytes = 0;
+static long s_hits = 0;
+static long s_misses = 0;
+static bool s_enabled = true;
+static std::map<std::string,std::weak_ptr<VertexArray>> s_arrays;
+
+VertexArrayPtr GeometryCache::Get (const std::string& key, const std::function<VertexArrayPtr()>& build)
+{
+  if (!s_enabled) {
+    s_misses++;
+    return build();
+  }
+  std::weak_ptr<VertexArray>& entry = s_arrays[key];
+  VertexArrayPtr array = entry.lock();
+  if (array) {
+    s_hits++;
+    return array;
+  }
+  s_misses++;
+  array = build();
+  entry = array;
+  return array;
+}
+
+void GeometryCache::SetEnabled (bool enabled)
+{
+  s_enabled = enabled;
+}
+
+bool GeometryCache::IsEnabled ()
+{
+  return s_enabled;
+}
+
+GeometryCache::Stats GeometryCache::GetStats ()
+{
+  Stats stats = {0,0,s_bytes,0,s_hits,s_misses};
+  for (auto it=s_arrays.begin(); it!=s_arrays.end(); ) {
+    long users = it->second.use_count();
+    if (users == 0) {
+      it = s_arrays.erase(it);
+      continue;
+    }
+    VertexArrayPtr array = it->second.lock();
+    stats.arrays++;
+    stats.users += int(users);
+    stats.saved += (users-1) * array->GetBytes();
+    ++it;
+  }
+  return stats;
+}
+
+void GeometryCache::ResetStats ()
+{
+  s_hits = 0;
+  s_misses = 0;
+}
+
+void GeometryCache::Account (long bytes)
+{
+  s_bytes += bytes;
+}
@@ -0,0 +1,105 @@
+#include "geometrypool.h"
+#include "shape.h"
+
+#include <glad/glad.h>
+
+GeometryPoolPtr GeometryPool::Make ()
+{
+  return GeometryPoolPtr(new GeometryPool());
+}
+
+GeometryPool::GeometryPool ()
+: m_dirty(false)
+{
+  m_vao.Create();
+  for (GLBuffer& buffer : m_buffers)
+    buffer.Create();
+  glBindVertexArray(m_vao.Get());
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[0].Get());
+  glVertexAttribPointer(Shape::COORD,3,GL_FLOAT,GL_FALSE,0,0);
+  glEnableVertexAttribArray(Shape::COORD);
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[1].Get());
+  glVertexAttribPointer(Shape::NORMAL,3,GL_FLOAT,GL_FALSE,0,0);
+  glEnableVertexAttribArray(Shape::NORMAL);
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[2].Get());
+  glVertexAttribPointer(Shape::TEXCOORD,2,GL_FLOAT,GL_FALSE,0,0);
+  glEnableVertexAttribArray(Shape::TEXCOORD);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_buffers[3].Get());
+  glBindVertexArray(0);
+}
+
+GeometryPool::~GeometryPool ()
+{
+}
+
+int GeometryPool::AddMesh (int nverts, const float* coords, const float* normals,
+                           const float* texcoords, int nind, const unsigned int* indices)
+{
+  Range range;
+  range.first = int(m_indices.size());
+  range.count = nind;
+  range.base_vertex = GetVertexCount();
+  for (int i=0; i<nverts; ++i) {
+    glm::vec3 p(coords[3*i],coords[3*i+1],coords[3*i+2]);
+    range.bounds.Extend(p);
+  }
+  m_coords.insert(m_coords.end(),coords,coords+3*nverts);
+  if (normals)
+    m_normals.insert(m_normals.end(),normals,normals+3*nverts);
+  else
+    m_normals.resize(m_normals.size()+3*nverts,0.0f);
+  if (texcoords)
+    m_texcoords.insert(m_texcoords.end(),texcoords,texcoords+2*nverts);
+  else
+    m_texcoords.resize(m_texcoords.size()+2*nverts,0.0f);
+  m_indices.insert(m_indices.end(),indices,indices+nind);
+  m_ranges.push_back(range);
+  m_dirty = true;
+  return int(m_ranges.size()) - 1;
+}
+
+int GeometryPool::GetMeshCount () const
+{
+  return int(m_ranges.size());
+}
+
+const GeometryPool::Range& GeometryPool::GetMesh (int id) const
+{
+  return m_ranges[id];
+}
+
+int GeometryPool::GetVertexCount () const
+{
+  return int(m_coords.size() / 3);
+}
+
+int GeometryPool::GetIndexCount () const
+{
+  return int(m_indices.size());
+}
+
+void GeometryPool::Upload ()
+{
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[0].Get());
+  glBufferData(GL_ARRAY_BUFFER,m_coords.size()*sizeof(float),m_coords.data(),GL_STATIC_DRAW);
+  m_buffers[0].SetBytes(long(m_coords.size()*sizeof(float)));
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[1].Get());
+  glBufferData(GL_ARRAY_BUFFER,m_normals.size()*sizeof(float),m_normals.data(),GL_STATIC_DRAW);
+  m_buffers[1].SetBytes(long(m_normals.size()*sizeof(float)));
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[2].Get());
+  glBufferData(GL_ARRAY_BUFFER,m_texcoords.size()*sizeof(float),m_texcoords.data(),GL_STATIC_DRAW);
+  m_buffers[2].SetBytes(long(m_texcoords.size()*sizeof(float)));
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+  glBindVertexArray(m_vao.Get());
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_indices.size()*sizeof(unsigned int),m_indices.data(),
+               GL_STATIC_DRAW);
+  m_buffers[3].SetBytes(long(m_indices.size()*sizeof(unsigned int)));
+  m_dirty = false;
+}
+
+void GeometryPool::Bind ()
+{
+  if (m_dirty)
+    Upload();
+  glBindVertexArray(m_vao.Get());
+}
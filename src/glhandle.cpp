@@ -0,0 +1,86 @@
+#include "glhandle.h"
+
+#include <glad/glad.h>
+
+// trivially destructible counters: handles may be released at exit
+static GLObjects::Stats s_stats[GLObjects::NKINDS];
+
+unsigned int GLObjects::Create (KIND kind)
+{
+  GLuint id = 0;
+  switch (kind) {
+    case BUFFER: glGenBuffers(1,&id); break;
+    case VERTEX_ARRAY: glGenVertexArrays(1,&id); break;
+    case TEXTURE: glGenTextures(1,&id); break;
+    case FRAMEBUFFER: glGenFramebuffers(1,&id); break;
+    case PROGRAM: id = glCreateProgram(); break;
+    case QUERY: glGenQueries(1,&id); break;
+    default: return 0;
+  }
+  if (id)
+    Track(kind,1);
+  return id;
+}
+
+void GLObjects::Delete (KIND kind, unsigned int id)
+{
+  switch (kind) {
+    case BUFFER: glDeleteBuffers(1,&id); break;
+    case VERTEX_ARRAY: glDeleteVertexArrays(1,&id); break;
+    case TEXTURE: glDeleteTextures(1,&id); break;
+    case FRAMEBUFFER: glDeleteFramebuffers(1,&id); break;
+    case PROGRAM: glDeleteProgram(id); break;
+    case SHADER: glDeleteShader(id); break;
+    case QUERY: glDeleteQueries(1,&id); break;
+    default: return;
+  }
+  s_stats[kind].live--;
+  s_stats[kind].deleted++;
+}
+
+void GLObjects::Track (KIND kind, long count)
+{
+  s_stats[kind].live += count;
+  s_stats[kind].created += count;
+}
+
+void GLObjects::Account (KIND kind, long bytes)
+{
+  s_stats[kind].bytes += bytes;
+}
+
+GLObjects::Stats GLObjects::GetStats (KIND kind)
+{
+  return s_stats[kind];
+}
+
+long GLObjects::GetLive ()
+{
+  long live = 0;
+  for (int k=0; k<NKINDS; ++k)
+    live += s_stats[k].live;
+  return live;
+}
+
+long GLObjects::GetBytes ()
+{
+  long bytes = 0;
+  for (int k=0; k<NKINDS; ++k)
+    bytes += s_stats[k].bytes;
+  return bytes;
+}
+
+void GLObjects::ResetStats ()
+{
+  for (int k=0; k<NKINDS; ++k) {
+    s_stats[k].created = 0;
+    s_stats[k].deleted = 0;
+  }
+}
+
+const char* GLObjects::GetKindName (KIND kind)
+{
+  static const char* names[] = {"buffer","vertex array","texture","framebuffer","program","shader",
+                                "query"};
+  return kind >= 0 && kind < NKINDS ? names[kind] : "?";
+}
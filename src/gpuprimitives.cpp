@@ -0,0 +1,175 @@
+#include "gpuprimitives.h"
+
+#include <algorithm>
+#include <iostream>
+
+static const int BLOCK = 256;      // invocations per work group
+static const int SCAN_BLOCK = 512; // values per scan/reduce work group
+static const int RADIX_BITS = 4;
+static const int RADIX = 1 << RADIX_BITS;
+
+static int Groups (int n, int size)
+{
+  return (n + size - 1) / size;
+}
+
+static void CheckCount (int n)
+{
+  if (n > GPUPrimitives::MAX_COUNT) {
+    std::cerr << "GPUPrimitives: " << n << " values exceed the limit of "
+              << GPUPrimitives::MAX_COUNT << std::endl;
+    exit(1);
+  }
+}
+
+GPUPrimitivesPtr GPUPrimitives::Make (const std::string& dir)
+{
+  return GPUPrimitivesPtr(new GPUPrimitives(dir));
+}
+
+GPUPrimitives::GPUPrimitives (const std::string& dir)
+: m_scan_block(ComputeShader::Make(dir + "scan_block.glsl")),
+  m_scan_add(ComputeShader::Make(dir + "scan_add.glsl")),
+  m_reduce(ComputeShader::Make(dir + "reduce.glsl")),
+  m_compact(ComputeShader::Make(dir + "compact_scatter.glsl")),
+  m_radix_count(ComputeShader::Make(dir + "radix_count.glsl")),
+  m_radix_scatter(ComputeShader::Make(dir + "radix_scatter.glsl")),
+  m_offsets(StorageBuffer::Make(16)),
+  m_count(StorageBuffer::Make(16)),
+  m_hist(StorageBuffer::Make(16)),
+  m_tkeys(StorageBuffer::Make(16)),
+  m_tvalues(StorageBuffer::Make(16))
+{
+  m_partial[0] = StorageBuffer::Make(16);
+  m_partial[1] = StorageBuffer::Make(16);
+}
+
+GPUPrimitives::~GPUPrimitives ()
+{
+}
+
+void GPUPrimitives::ExclusiveScan (StorageBufferPtr in, StorageBufferPtr out, int n)
+{
+  if (n <= 0)
+    return;
+  CheckCount(n);
+  Scan(in,out,n,0,false);
+}
+
+// Scan each block, scan the block sums (recursively), add them back;
+// with predicate, the input values are read as 0 or 1 (non-zero)
+void GPUPrimitives::Scan (StorageBufferPtr in, StorageBufferPtr out, int n, int level,
+                          bool predicate)
+{
+  int nblocks = Groups(n,SCAN_BLOCK);
+  if (int(m_sums.size()) <= level)
+    m_sums.push_back(StorageBuffer::Make(16));
+  StorageBufferPtr sums = m_sums[level];
+  sums->Reserve(nblocks*int(sizeof(unsigned int)));
+  m_scan_block->AttachStorageBuffer(0,in);
+  m_scan_block->AttachStorageBuffer(1,out);
+  m_scan_block->AttachStorageBuffer(2,sums);
+  m_scan_block->UseProgram();
+  m_scan_block->SetUniform("n",n);
+  m_scan_block->SetUniform("predicate",predicate ? 1 : 0);
+  m_scan_block->Dispatch(nblocks);
+  if (nblocks == 1)
+    return;
+  Scan(sums,sums,nblocks,level+1,false);
+  m_scan_add->AttachStorageBuffer(1,out);
+  m_scan_add->AttachStorageBuffer(2,sums);
+  m_scan_add->UseProgram();
+  m_scan_add->SetUniform("n",n);
+  m_scan_add->Dispatch(Groups(n,BLOCK));
+}
+
+ReadbackPtr GPUPrimitives::ReduceAsync (StorageBufferPtr in, int n, OP op)
+{
+  CheckCount(n);
+  // each pass reduces blocks of 512 values, until one is left
+  StorageBufferPtr src = in;
+  int k = 0;
+  m_reduce->UseProgram();
+  m_reduce->SetUniform("op",int(op));
+  do {
+    int nblocks = Groups(n,SCAN_BLOCK);
+    StorageBufferPtr dst = m_partial[k];
+    dst->Reserve(std::max(nblocks,1)*int(sizeof(unsigned int)));
+    m_reduce->AttachStorageBuffer(0,src);
+    m_reduce->AttachStorageBuffer(1,dst);
+    m_reduce->UseProgram();
+    m_reduce->SetUniform("n",n);
+    m_reduce->Dispatch(std::max(nblocks,1));
+    src = dst;
+    k = 1 - k;
+    n = nblocks;
+  } while (n > 1);
+  return src->GetDataAsync(int(sizeof(unsigned int)));
+}
+
+unsigned int GPUPrimitives::Reduce (StorageBufferPtr in, int n, OP op)
+{
+  return ReduceAsync(in,n,op)->GetData<unsigned int>()[0];
+}
+
+int GPUPrimitives::Compact (StorageBufferPtr in, StorageBufferPtr flags, StorageBufferPtr out, int n)
+{
+  if (n <= 0)
+    return 0;
+  CheckCount(n);
+  m_offsets->Reserve(n*int(sizeof(unsigned int)));
+  // any non-zero flag keeps its value, as in CPUPrimitives::Compact
+  Scan(flags,m_offsets,n,0,true);
+  m_compact->AttachStorageBuffer(0,in);
+  m_compact->AttachStorageBuffer(1,flags);
+  m_compact->AttachStorageBuffer(2,m_offsets);
+  m_compact->AttachStorageBuffer(3,out);
+  m_compact->AttachStorageBuffer(4,m_count);
+  m_compact->UseProgram();
+  m_compact->SetUniform("n",n);
+  m_compact->Dispatch(Groups(n,BLOCK));
+  unsigned int count;
+  m_count->GetData(&count,int(sizeof(count)));
+  return int(count);
+}
+
+StorageBufferPtr GPUPrimitives::GetCountBuffer () const
+{
+  return m_count;
+}
+
+void GPUPrimitives::SortPairs (StorageBufferPtr keys, StorageBufferPtr values, int n)
+{
+  if (n <= 1)
+    return;
+  CheckCount(n);
+  int nblocks = Groups(n,BLOCK);
+  int size = n*int(sizeof(unsigned int));
+  m_tkeys->Reserve(size);
+  m_tvalues->Reserve(size);
+  m_hist->Reserve(RADIX*nblocks*int(sizeof(unsigned int)));
+  StorageBufferPtr src[2] = {keys,values};
+  StorageBufferPtr dst[2] = {m_tkeys,m_tvalues};
+  // an even number of passes leaves the result in keys/values
+  for (int shift=0; shift<32; shift+=RADIX_BITS) {
+    m_radix_count->AttachStorageBuffer(0,src[0]);
+    m_radix_count->AttachStorageBuffer(4,m_hist);
+    m_radix_count->UseProgram();
+    m_radix_count->SetUniform("n",n);
+    m_radix_count->SetUniform("shift",shift);
+    m_radix_count->SetUniform("nblocks",nblocks);
+    m_radix_count->Dispatch(nblocks);
+    Scan(m_hist,m_hist,RADIX*nblocks,0,false);
+    m_radix_scatter->AttachStorageBuffer(0,src[0]);
+    m_radix_scatter->AttachStorageBuffer(1,src[1]);
+    m_radix_scatter->AttachStorageBuffer(2,dst[0]);
+    m_radix_scatter->AttachStorageBuffer(3,dst[1]);
+    m_radix_scatter->AttachStorageBuffer(4,m_hist);
+    m_radix_scatter->UseProgram();
+    m_radix_scatter->SetUniform("n",n);
+    m_radix_scatter->SetUniform("shift",shift);
+    m_radix_scatter->SetUniform("nblocks",nblocks);
+    m_radix_scatter->Dispatch(nblocks);
+    std::swap(src,dst);
+  }
+}
@@ -2,19 +2,27 @@
 
 #include <cassert>
 #include <iostream>
+#include <map>
 
 #define INDEX(i,j,nx) ((unsigned int)((j)*(nx+1)+(i)))
 
 GridPtr Grid::Make (int nx, int ny)
 {
-  return GridPtr(new Grid(nx,ny));
+  static std::map<std::pair<int,int>,std::weak_ptr<Grid>> grids;
+  std::weak_ptr<Grid>& entry = grids[std::make_pair(nx,ny)];
+  GridPtr grid = entry.lock();
+  if (!grid) {
+    grid = GridPtr(new Grid(nx,ny));
+    entry = grid;
+  }
+  return grid;
 }
 
 Grid::Grid (int nx, int ny)
 : m_nx(nx), m_ny(ny)
 {
   // allocate and fill coordinates
-  m_coords = new float[2*VertexCount()];
+  m_coords.resize(2*VertexCount());
   float dx = 1.0f / nx;
   float dy = 1.0f / ny;
   int nc = 0;
@@ -25,7 +33,7 @@ Grid::Grid (int nx, int ny)
     }
   }
   // allocate and fill indices
-  m_indices = new unsigned int[IndexCount()];
+  m_indices.resize(IndexCount());
   int ni = 0;
   for (int j=0; j<ny; ++j) {
     for (int i=0; i<nx; ++i) {
@@ -41,8 +49,6 @@ Grid::Grid (int nx, int ny)
 
 Grid::~Grid () 
 {
-  delete m_coords;
-  delete m_indices;
 }
 
 int Grid::GetNx ()
@@ -67,10 +73,10 @@ int Grid::IndexCount ()
 
 const float* Grid::GetCoords () const
 {
-  return m_coords;
+  return m_coords.data();
 }
 
 const unsigned int* Grid::GetIndices () const
 {
-  return m_indices;
+  return m_indices.data();
 }
@@ -0,0 +1,82 @@
+#include "hiz.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+HiZPtr HiZ::Make (const std::string& csfile)
+{
+  return HiZPtr(new HiZ(csfile));
+}
+
+HiZ::HiZ (const std::string& csfile)
+: m_width(0), m_height(0),
+  m_levels(0),
+  m_build(ComputeShader::Make(csfile))
+{
+  // each level reads the previous one through texelFetch
+  m_build->SetBarrier(ComputeShader::TEXTURE_FETCH);
+}
+
+HiZ::~HiZ ()
+{
+}
+
+void HiZ::Resize (int width, int height)
+{
+  m_width = width;
+  m_height = height;
+  m_levels = 1;
+  while ((std::max(width,height) >> m_levels) > 0)
+    m_levels++;
+  m_tex.Create();
+  glBindTexture(GL_TEXTURE_2D,m_tex.Get());
+  glTexStorage2D(GL_TEXTURE_2D,m_levels,GL_R32F,m_width,m_height);
+  // all levels: 4/3 of the base one
+  m_tex.SetBytes(long(m_width)*m_height*4*4/3);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D,0);
+}
+
+void HiZ::Build (TexDepthPtr depth)
+{
+  if (depth->GetWidth() != m_width || depth->GetHeight() != m_height)
+    Resize(depth->GetWidth(),depth->GetHeight());
+  m_build->UseProgram();
+  m_build->SetUniform("src",0);
+  glActiveTexture(GL_TEXTURE0);
+  for (int level=0; level<m_levels; ++level) {
+    // level 0 copies the depth texture, the others reduce the level below
+    glBindTexture(GL_TEXTURE_2D,level == 0 ? depth->GetTexId() : m_tex.Get());
+    glBindImageTexture(0,m_tex.Get(),level,GL_FALSE,0,GL_WRITE_ONLY,GL_R32F);
+    int w = std::max(1,m_width >> level);
+    int h = std::max(1,m_height >> level);
+    m_build->UseProgram();
+    m_build->SetUniform("level",level);
+    m_build->Dispatch((w+7)/8,(h+7)/8);
+  }
+  glBindTexture(GL_TEXTURE_2D,0);
+}
+
+unsigned int HiZ::GetTexId () const
+{
+  return m_tex.Get();
+}
+
+int HiZ::GetWidth () const
+{
+  return m_width;
+}
+
+int HiZ::GetHeight () const
+{
+  return m_height;
+}
+
+int HiZ::GetLevelCount () const
+{
+  return m_levels;
+}
@@ -0,0 +1,117 @@
+#include "imagediff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// sRGB to CIELAB (D65 white)
+static void Lab (const unsigned char* rgb, float lab[3])
+{
+  float c[3];
+  for (int i=0; i<3; ++i) {
+    float v = rgb[i] / 255.0f;
+    c[i] = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f,2.4f);
+  }
+  float xyz[3] = {
+    (0.4124f*c[0] + 0.3576f*c[1] + 0.1805f*c[2]) / 0.95047f,
+    (0.2126f*c[0] + 0.7152f*c[1] + 0.0722f*c[2]),
+    (0.0193f*c[0] + 0.1192f*c[1] + 0.9505f*c[2]) / 1.08883f
+  };
+  for (int i=0; i<3; ++i)
+    xyz[i] = xyz[i] > 0.008856f ? cbrtf(xyz[i]) : 7.787f*xyz[i] + 16.0f/116.0f;
+  lab[0] = 116.0f*xyz[1] - 16.0f;
+  lab[1] = 500.0f*(xyz[0] - xyz[1]);
+  lab[2] = 200.0f*(xyz[1] - xyz[2]);
+}
+
+// skip blanks and comments of a PPM header
+static void SkipBlanks (FILE* fp)
+{
+  int c;
+  while ((c = fgetc(fp)) != EOF) {
+    if (c == '#')
+      while ((c = fgetc(fp)) != EOF && c != '\n')
+        ;
+    else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      ungetc(c,fp);
+      return;
+    }
+  }
+}
+
+bool ImageDiff::Read (const std::string& filename, Pixels& image)
+{
+  FILE* fp = fopen(filename.c_str(),"rb");
+  if (!fp)
+    return false;
+  char magic[3] = {0,0,0};
+  int maxval = 0;
+  bool ok = fread(magic,1,2,fp) == 2 && magic[0] == 'P' && magic[1] == '6';
+  if (ok) {
+    SkipBlanks(fp);
+    ok = fscanf(fp,"%d",&image.width) == 1;
+    SkipBlanks(fp);
+    ok = ok && fscanf(fp,"%d",&image.height) == 1;
+    SkipBlanks(fp);
+    ok = ok && fscanf(fp,"%d",&maxval) == 1 && maxval == 255 && fgetc(fp) != EOF;
+  }
+  if (ok && image.width > 0 && image.height > 0) {
+    image.rgb.resize(size_t(image.width) * image.height * 3);
+    ok = fread(image.rgb.data(),1,image.rgb.size(),fp) == image.rgb.size();
+  }
+  fclose(fp);
+  return ok;
+}
+
+bool ImageDiff::Write (const std::string& filename, const Pixels& image)
+{
+  FILE* fp = fopen(filename.c_str(),"wb");
+  if (!fp)
+    return false;
+  fprintf(fp,"P6\n%d %d\n255\n",image.width,image.height);
+  bool ok = fwrite(image.rgb.data(),1,image.rgb.size(),fp) == image.rgb.size();
+  return fclose(fp) == 0 && ok;
+}
+
+ImageDiff::Result ImageDiff::Compare (const Pixels& golden, const Pixels& image, float threshold,
+                                      int radius)
+{
+  Result result = {false,0.0,0.0,1.0};
+  if (golden.width != image.width || golden.height != image.height ||
+      golden.rgb.size() != image.rgb.size())
+    return result;
+  result.same_size = true;
+  int w = golden.width, h = golden.height;
+  std::vector<float> lab(size_t(w) * h * 3);
+  for (size_t i=0; i<size_t(w)*h; ++i)
+    Lab(&golden.rgb[3*i],&lab[3*i]);
+  double sum = 0.0;
+  long bad = 0;
+  for (int y=0; y<h; ++y) {
+    for (int x=0; x<w; ++x) {
+      float c[3];
+      Lab(&image.rgb[3*(size_t(y)*w+x)],c);
+      float best = 1e30f;
+      for (int j=std::max(0,y-radius); j<=std::min(h-1,y+radius); ++j) {
+        for (int i=std::max(0,x-radius); i<=std::min(w-1,x+radius); ++i) {
+          const float* g = &lab[3*(size_t(j)*w+i)];
+          float d = (c[0]-g[0])*(c[0]-g[0]) + (c[1]-g[1])*(c[1]-g[1]) + (c[2]-g[2])*(c[2]-g[2]);
+          best = std::min(best,d);
+        }
+      }
+      float de = sqrtf(best);
+      sum += de;
+      result.max = std::max(result.max,double(de));
+      if (de > threshold)
+        bad++;
+    }
+  }
+  result.mean = sum / (double(w) * h);
+  result.bad = double(bad) / (double(w) * h);
+  return result;
+}
+
+bool ImageDiff::Pass (const Result& result, double max_bad)
+{
+  return result.same_size && result.bad <= max_bad;
+}
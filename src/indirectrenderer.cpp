@@ -0,0 +1,191 @@
+#include "indirectrenderer.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// DrawElementsIndirectCommand
+struct Command {
+  unsigned int count;
+  unsigned int instances;
+  unsigned int first;
+  unsigned int base_vertex;
+  unsigned int base_instance;
+};
+
+IndirectRendererPtr IndirectRenderer::Make (GeometryPoolPtr pool, const std::string& csfile)
+{
+  return IndirectRendererPtr(new IndirectRenderer(pool,csfile));
+}
+
+IndirectRenderer::IndirectRenderer (GeometryPoolPtr pool, const std::string& csfile)
+: m_pool(pool),
+  m_dirty_begin(0), m_dirty_end(0),
+  m_csfile(csfile),
+  m_cull(nullptr),
+  m_ncommands(0),
+  m_hiz(nullptr),
+  m_hiz_viewproj(1.0f)
+{
+}
+
+IndirectRenderer::~IndirectRenderer ()
+{
+}
+
+int IndirectRenderer::AddObject (int mesh, const glm::mat4& model, const glm::vec4& color)
+{
+  const GeometryPool::Range& range = m_pool->GetMesh(mesh);
+  ObjectData obj;
+  obj.model = model;
+  obj.bmin = glm::vec4(range.bounds.GetMin(),1.0f);
+  obj.bmax = glm::vec4(range.bounds.GetMax(),1.0f);
+  obj.color = color;
+  obj.mesh[0] = (unsigned int)range.count;
+  obj.mesh[1] = (unsigned int)range.first;
+  obj.mesh[2] = (unsigned int)range.base_vertex;
+  obj.mesh[3] = 0;
+  m_objects.push_back(obj);
+  int id = int(m_objects.size()) - 1;
+  m_dirty_begin = std::min(m_dirty_begin,id);
+  m_dirty_end = id + 1;
+  return id;
+}
+
+void IndirectRenderer::SetTransform (int id, const glm::mat4& model)
+{
+  m_objects[id].model = model;
+  m_dirty_begin = std::min(m_dirty_begin,id);
+  m_dirty_end = std::max(m_dirty_end,id+1);
+}
+
+void IndirectRenderer::SetColor (int id, const glm::vec4& color)
+{
+  m_objects[id].color = color;
+  m_dirty_begin = std::min(m_dirty_begin,id);
+  m_dirty_end = std::max(m_dirty_end,id+1);
+}
+
+int IndirectRenderer::GetObjectCount () const
+{
+  return int(m_objects.size());
+}
+
+void IndirectRenderer::SetOcclusion (HiZPtr hiz, const glm::mat4& viewproj)
+{
+  m_hiz = hiz;
+  m_hiz_viewproj = viewproj;
+}
+
+// Upload the changed objects; buffers grow with the object count
+void IndirectRenderer::Upload ()
+{
+  int n = GetObjectCount();
+  int stride = int(sizeof(ObjectData));
+  if (m_object_buf->GetSize() < n*stride) {
+    m_object_buf->SetData(m_objects.data(),n*stride);
+    m_command_buf->Reserve(n*int(sizeof(Command)));
+    // object ids 0..n-1, read per instance from the base instance on
+    std::vector<unsigned int> ids(n);
+    for (int i=0; i<n; ++i)
+      ids[i] = (unsigned int)i;
+    glBindBuffer(GL_ARRAY_BUFFER,m_ids.Get());
+    glBufferData(GL_ARRAY_BUFFER,n*sizeof(unsigned int),ids.data(),GL_STATIC_DRAW);
+    m_ids.SetBytes(long(n*sizeof(unsigned int)));
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+  }
+  else if (m_dirty_end > m_dirty_begin)
+    m_object_buf->SetData(&m_objects[m_dirty_begin],(m_dirty_end-m_dirty_begin)*stride,
+                          m_dirty_begin*stride);
+  m_dirty_begin = n;
+  m_dirty_end = 0;
+}
+
+void IndirectRenderer::Cull (const glm::mat4& view, const glm::mat4& proj)
+{
+  if (!m_cull) {
+    m_cull = ComputeShader::Make(m_csfile);
+    // commands are read by the draw, the count by the draw or a readback
+    m_cull->SetBarrier(ComputeShader::INDIRECT | ComputeShader::BUFFER_UPDATE);
+    m_object_buf = StorageBuffer::Make(16);
+    m_command_buf = StorageBuffer::Make(16);
+    m_count_buf = StorageBuffer::Make(16);
+    m_ids.Create();
+    m_cull->AttachStorageBuffer(0,m_object_buf);
+    m_cull->AttachStorageBuffer(1,m_command_buf);
+    m_cull->AttachStorageBuffer(2,m_count_buf);
+  }
+  Upload();
+  m_ncommands = GetObjectCount();
+  if (m_ncommands == 0)
+    return;
+  // survivors are appended: reset the count and, without draw count
+  // support, zero the commands so that the tail draws nothing
+  unsigned int zero = 0;
+  m_count_buf->SetData(&zero,sizeof(zero));
+  if (!GLAD_GL_VERSION_4_6) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_command_buf->GetId());
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_UNSIGNED_INT,&zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+  }
+  m_cull->UseProgram();
+  m_cull->SetUniform("viewproj",proj*view);
+  m_cull->SetUniform("nobjects",m_ncommands);
+  m_cull->SetUniform("occlusion",m_hiz ? 1 : 0);
+  if (m_hiz) {
+    m_cull->SetUniform("hiz_viewproj",m_hiz_viewproj);
+    m_cull->SetUniform("hiz_size",glm::vec4(float(m_hiz->GetWidth()),float(m_hiz->GetHeight()),
+                                            float(m_hiz->GetLevelCount()),0.0f));
+    m_cull->SetUniform("hiz",0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,m_hiz->GetTexId());
+  }
+  m_cull->Dispatch((m_ncommands+63)/64);
+}
+
+void IndirectRenderer::Cull (CameraPtr camera)
+{
+  Cull(camera->GetViewMatrix(),camera->GetProjMatrix());
+}
+
+int IndirectRenderer::GetVisibleCount () const
+{
+  if (!m_count_buf)
+    return 0;
+  unsigned int count;
+  m_count_buf->GetData(&count,sizeof(count));
+  return int(count);
+}
+
+void IndirectRenderer::Draw (StatePtr )
+{
+  if (!m_cull) {
+    std::cerr << "IndirectRenderer: Cull must be called before rendering" << std::endl;
+    exit(1);
+  }
+  if (m_ncommands == 0)
+    return;
+  m_pool->Bind();
+  glBindBuffer(GL_ARRAY_BUFFER,m_ids.Get());
+  glVertexAttribIPointer(Shape::OBJECT,1,GL_UNSIGNED_INT,0,0);
+  glVertexAttribDivisor(Shape::OBJECT,1);
+  glEnableVertexAttribArray(Shape::OBJECT);
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+  m_object_buf->Bind(OBJECTS);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER,m_command_buf->GetId());
+  if (GLAD_GL_VERSION_4_6) {
+    glBindBuffer(GL_PARAMETER_BUFFER,m_count_buf->GetId());
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES,GL_UNSIGNED_INT,0,0,m_ncommands,0);
+    glBindBuffer(GL_PARAMETER_BUFFER,0);
+  }
+  else
+    glMultiDrawElementsIndirect(GL_TRIANGLES,GL_UNSIGNED_INT,0,m_ncommands,0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER,0);
+}
+
+BBox IndirectRenderer::GetBounds () const
+{
+  return BBox();
+}
@@ -0,0 +1,216 @@
+#include "jobsystem.h"
+
+#include <algorithm>
+
+// slot of the current thread, if it is a worker of t_system
+static thread_local const JobSystem* t_system = nullptr;
+static thread_local int t_slot = -1;
+
+int TaskGraph::Add (const std::function<void()>& job)
+{
+  m_tasks.push_back({job,{},0});
+  return int(m_tasks.size()) - 1;
+}
+
+void TaskGraph::Depend (int task, int before)
+{
+  m_tasks[before].successors.push_back(task);
+  m_tasks[task].ndeps++;
+}
+
+int TaskGraph::GetTaskCount () const
+{
+  return int(m_tasks.size());
+}
+
+void TaskGraph::Clear ()
+{
+  m_tasks.clear();
+}
+
+JobSystemPtr JobSystem::Make (int nthreads)
+{
+  if (nthreads <= 0)
+    nthreads = std::max(1,int(std::thread::hardware_concurrency())-1);
+  return JobSystemPtr(new JobSystem(nthreads));
+}
+
+JobSystemPtr JobSystem::GetDefault ()
+{
+  static JobSystemPtr jobs = Make();
+  return jobs;
+}
+
+JobSystem::JobSystem (int nthreads)
+: m_queued(0),
+  m_stop(false)
+{
+  for (int i=0; i<=nthreads; ++i)
+    m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+  ResetStats();
+  for (int i=0; i<nthreads; ++i)
+    m_threads.push_back(std::thread(&JobSystem::WorkerLoop,this,i));
+}
+
+JobSystem::~JobSystem ()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread& thread : m_threads)
+    thread.join();
+}
+
+int JobSystem::GetWorkerCount () const
+{
+  return int(m_threads.size());
+}
+
+int JobSystem::GetSlot () const
+{
+  return t_system == this ? t_slot : int(m_workers.size()) - 1;
+}
+
+void JobSystem::Submit (const Job& job)
+{
+  Worker& worker = *m_workers[GetSlot()];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(job);
+  }
+  m_queued++;
+  // taking the lock orders this with a worker about to sleep
+  { std::lock_guard<std::mutex> lock(m_sleep_mutex); }
+  m_wake.notify_one();
+}
+
+// Pop the newest job of slot, or steal the oldest of another one
+bool JobSystem::RunOne (int slot)
+{
+  Job job;
+  bool stolen = false;
+  {
+    Worker& own = *m_workers[slot];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+    }
+  }
+  int n = int(m_workers.size());
+  for (int k=1; !job && k<n; ++k) {
+    Worker& victim = *m_workers[(slot+k)%n];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      stolen = true;
+    }
+  }
+  if (!job)
+    return false;
+  m_queued--;
+  auto t0 = std::chrono::steady_clock::now();
+  job();
+  Worker& own = *m_workers[slot];
+  own.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now()-t0).count();
+  own.executed++;
+  if (stolen)
+    own.steals++;
+  return true;
+}
+
+void JobSystem::WorkerLoop (int slot)
+{
+  t_system = this;
+  t_slot = slot;
+  while (!m_stop) {
+    if (RunOne(slot))
+      continue;
+    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+    m_wake.wait(lock,[this]() { return m_stop || m_queued > 0; });
+  }
+}
+
+void JobSystem::Wait (const std::atomic<int>& counter)
+{
+  int slot = GetSlot();
+  while (counter > 0)
+    if (!RunOne(slot))
+      std::this_thread::yield();
+}
+
+void JobSystem::ParallelFor (int begin, int end, int grain, const std::function<void(int,int)>& f)
+{
+  grain = std::max(1,grain);
+  int nchunks = (end - begin + grain - 1) / grain;
+  if (nchunks <= 1) {
+    if (end > begin)
+      f(begin,end);
+    return;
+  }
+  std::atomic<int> remaining(nchunks);
+  for (int b=begin; b<end; b+=grain) {
+    int e = std::min(end,b+grain);
+    Submit([&f,&remaining,b,e]() {
+      f(b,e);
+      remaining--;
+    });
+  }
+  Wait(remaining);
+}
+
+void JobSystem::Run (const TaskGraph& graph)
+{
+  int n = graph.GetTaskCount();
+  if (n == 0)
+    return;
+  std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[n]);
+  for (int i=0; i<n; ++i)
+    pending[i] = graph.m_tasks[i].ndeps;
+  std::atomic<int> remaining(n);
+  // a finished task launches the successors it was the last dependency of
+  std::function<void(int)> launch = [&](int i) {
+    Submit([&,i]() {
+      const TaskGraph::Task& task = graph.m_tasks[i];
+      task.job();
+      for (int s : task.successors)
+        if (--pending[s] == 0)
+          launch(s);
+      remaining--;
+    });
+  };
+  for (int i=0; i<n; ++i)
+    if (graph.m_tasks[i].ndeps == 0)
+      launch(i);
+  Wait(remaining);
+}
+
+std::vector<JobSystem::Stats> JobSystem::GetStats () const
+{
+  double elapsed = std::chrono::duration<double,std::milli>(
+                     std::chrono::steady_clock::now()-m_stats_start).count();
+  std::vector<Stats> stats;
+  for (const std::unique_ptr<Worker>& worker : m_workers) {
+    Stats s;
+    s.jobs = worker->executed;
+    s.steals = worker->steals;
+    s.busy = worker->busy * 1e-6;
+    s.utilisation = elapsed > 0.0 ? s.busy / elapsed : 0.0;
+    stats.push_back(s);
+  }
+  return stats;
+}
+
+void JobSystem::ResetStats ()
+{
+  for (std::unique_ptr<Worker>& worker : m_workers) {
+    worker->executed = 0;
+    worker->steals = 0;
+    worker->busy = 0;
+  }
+  m_stats_start = std::chrono::steady_clock::now();
+}
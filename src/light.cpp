@@ -6,6 +6,8 @@
 
 #include <glad/glad.h>
 
+#include <cstring>
+
 LightPtr Light::Make (float x, float y, float z, float w, const std::string& space)
 {
   return LightPtr(new Light(x,y,z,w,space));
@@ -17,7 +19,9 @@ Light::Light (float x, float y, float z, float w, const std::string& space)
   m_dif{0.7f,0.7f,0.7f,1.0f},
   m_spe{1.0f,1.0f,1.0f,1.0f},
   m_pos{x,y,z,w},
-  m_reference(nullptr)
+  m_reference(nullptr),
+  m_ubo(nullptr),
+  m_uploaded{false,false}
 {
 }
 
@@ -56,6 +60,21 @@ NodePtr Light::GetReference () const
   return m_reference;
 }
 
+const glm::vec4& Light::GetAmbient () const
+{
+  return m_amb;
+}
+
+const glm::vec4& Light::GetDiffuse () const
+{
+  return m_dif;
+}
+
+const glm::vec4& Light::GetSpecular () const
+{
+  return m_spe;
+}
+
 void Light::SetPosition (float x, float y, float z, float w)
 {
   m_pos[0] = x;
@@ -64,24 +83,60 @@ void Light::SetPosition (float x, float y, float z, float w)
   m_pos[3] = w;
 }
 
+glm::vec4 Light::GetWorldPosition (const glm::mat4& view) const
+{
+  glm::mat4 M(1.0f);
+  if (m_space == "camera")
+    M = glm::inverse(view);
+  if (GetReference())
+    M = M * GetReference()->GetModelMatrix();
+  return M * m_pos;
+}
+
 void Light::Load (StatePtr st) const
 {
   ShaderPtr shd = st->GetShader();
-  shd->SetUniform("lamb",m_amb);
-  shd->SetUniform("ldif",m_dif);
-  shd->SetUniform("lspe",m_spe);
+  const glm::mat4& view = st->GetViewMatrix();
 
   // Set position in the lighting space
   glm::mat4 M(1.0f);
   if (m_space == "world" && shd->GetLightingSpace() == "camera") {
-    M = st->GetCamera()->GetViewMatrix();
+    M = view;
   }
   else if (m_space == "camera" && shd->GetLightingSpace() == "world") {
-    M = glm::inverse(st->GetCamera()->GetViewMatrix());
+    M = glm::inverse(view);
   }
   if (GetReference()) {
     M = M * GetReference()->GetModelMatrix();
   }
   glm::vec4 pos = M * m_pos;
-  shd -> SetUniform ("lpos",pos);
+
+  if (!shd->HasUniformBlock(UniformBuffer::FRAME)) {
+    shd->SetUniform("lamb",m_amb);
+    shd->SetUniform("ldif",m_dif);
+    shd->SetUniform("lspe",m_spe);
+    shd -> SetUniform ("lpos",pos);
+    return;
+  }
+  int space = shd->GetLightingSpace() == "world" ? 1 : 0;
+  FrameData data;
+  data.view = view;
+  data.proj = st->GetProjMatrix();
+  data.cpos = glm::vec4(0.0f,0.0f,0.0f,1.0f);  // in camera space
+  if (space == 1)
+    data.cpos = glm::inverse(view) * data.cpos;
+  data.lpos = pos;
+  data.lamb = m_amb;
+  data.ldif = m_dif;
+  data.lspe = m_spe;
+  int align = UniformBuffer::GetOffsetAlignment();
+  int stride = (int(sizeof(FrameData)) + align - 1) / align * align;
+  if (!m_ubo)
+    m_ubo = UniformBuffer::Make(2*stride);
+  if (!m_uploaded[space] || memcmp(&data,&m_frame[space],sizeof(FrameData))) {
+    m_ubo->SetData(&data,sizeof(FrameData),space*stride);
+    m_frame[space] = data;
+    m_uploaded[space] = true;
+  }
+  m_ubo->BindRange(UniformBuffer::FRAME,space*stride,sizeof(FrameData));
 }
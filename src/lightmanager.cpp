@@ -0,0 +1,253 @@
+#include "lightmanager.h"
+#include "state.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+LightManagerPtr LightManager::Make (int nx, int ny, int nz, int max_per_cluster,
+                                    const std::string& csfile)
+{
+  return LightManagerPtr(new LightManager(nx,ny,nz,max_per_cluster,csfile));
+}
+
+LightManager::LightManager (int nx, int ny, int nz, int max_per_cluster, const std::string& csfile)
+: m_nx(nx), m_ny(ny), m_nz(nz),
+  m_max(max_per_cluster),
+  m_dirty(true),
+  m_proj(0.0f),
+  m_znear(0.0f), m_zfar(0.0f),
+  m_bounds_dirty(true),
+  m_csfile(csfile),
+  m_cull(nullptr)
+{
+  // GL objects are created on the first Cull, so the CPU reference
+  // can run without a context
+}
+
+LightManager::~LightManager ()
+{
+}
+
+int LightManager::AddPointLight (const glm::vec3& pos, float range, const glm::vec3& color)
+{
+  LightData light;
+  light.position = glm::vec4(pos,range);
+  light.color = glm::vec4(color,float(POINT));
+  light.direction = glm::vec4(0.0f,0.0f,-1.0f,-1.0f);
+  m_lights.push_back(light);
+  m_dirty = true;
+  return int(m_lights.size()) - 1;
+}
+
+int LightManager::AddSpotLight (const glm::vec3& pos, const glm::vec3& dir, float range,
+                                float angle, const glm::vec3& color)
+{
+  LightData light;
+  light.position = glm::vec4(pos,range);
+  light.color = glm::vec4(color,float(SPOT));
+  light.direction = glm::vec4(glm::normalize(dir),cosf(glm::radians(angle)));
+  m_lights.push_back(light);
+  m_dirty = true;
+  return int(m_lights.size()) - 1;
+}
+
+void LightManager::SetLight (int id, const LightData& light)
+{
+  m_lights[id] = light;
+  m_dirty = true;
+}
+
+const LightManager::LightData& LightManager::GetLight (int id) const
+{
+  return m_lights[id];
+}
+
+int LightManager::GetLightCount () const
+{
+  return int(m_lights.size());
+}
+
+int LightManager::GetClusterCount () const
+{
+  return m_nx * m_ny * m_nz;
+}
+
+int LightManager::GetMaxLightsPerCluster () const
+{
+  return m_max;
+}
+
+void LightManager::Clear ()
+{
+  m_lights.clear();
+  m_dirty = true;
+}
+
+// Cluster c = i + nx*(j + ny*k), k indexing exponential depth slices
+void LightManager::UpdateClusterBounds (const glm::mat4& proj)
+{
+  if (!m_bounds.empty() && proj == m_proj)
+    return;
+  m_proj = proj;
+  m_znear = proj[3][2] / (proj[2][2] - 1.0f);
+  m_zfar = proj[3][2] / (proj[2][2] + 1.0f);
+  glm::mat4 inv = glm::inverse(proj);
+  // tile corners on the near plane
+  std::vector<glm::vec3> corners((m_nx+1)*(m_ny+1));
+  for (int j=0; j<=m_ny; ++j) {
+    for (int i=0; i<=m_nx; ++i) {
+      glm::vec4 p = inv * glm::vec4(-1.0f + 2.0f*i/m_nx,-1.0f + 2.0f*j/m_ny,-1.0f,1.0f);
+      corners[j*(m_nx+1)+i] = glm::vec3(p) / p.w;
+    }
+  }
+  m_bounds.resize(2*GetClusterCount());
+  for (int k=0; k<m_nz; ++k) {
+    float d[2] = {
+      m_znear * powf(m_zfar/m_znear,float(k)/m_nz),
+      m_znear * powf(m_zfar/m_znear,float(k+1)/m_nz)
+    };
+    for (int j=0; j<m_ny; ++j) {
+      for (int i=0; i<m_nx; ++i) {
+        glm::vec3 bmin(1e30f), bmax(-1e30f);
+        for (int c=0; c<4; ++c) {
+          const glm::vec3& p = corners[(j+c/2)*(m_nx+1)+i+c%2];
+          for (int s=0; s<2; ++s) {
+            glm::vec3 q = p * (d[s] / -p.z);
+            bmin = glm::min(bmin,q);
+            bmax = glm::max(bmax,q);
+          }
+        }
+        int id = i + m_nx*(j + m_ny*k);
+        m_bounds[2*id+0] = glm::vec4(bmin,0.0f);
+        m_bounds[2*id+1] = glm::vec4(bmax,0.0f);
+      }
+    }
+  }
+  m_bounds_dirty = true;
+}
+
+// Bounding sphere of the light volume in view space (mirrors the shader)
+static glm::vec4 LightSphere (const LightManager::LightData& light, const glm::mat4& view)
+{
+  glm::vec3 pos = glm::vec3(view * glm::vec4(glm::vec3(light.position),1.0f));
+  float range = light.position.w;
+  if (int(light.color.w) != LightManager::SPOT)
+    return glm::vec4(pos,range);
+  glm::vec3 dir = glm::normalize(glm::vec3(view * glm::vec4(glm::vec3(light.direction),0.0f)));
+  float c = light.direction.w;
+  if (c < 0.70710678f)
+    return glm::vec4(pos + dir*(range*c),range*sqrtf(1.0f-c*c));
+  float r = range / (2.0f*c);
+  return glm::vec4(pos + dir*r,r);
+}
+
+static bool Intersect (const glm::vec4& sphere, const glm::vec4& bmin, const glm::vec4& bmax)
+{
+  float dist = 0.0f;
+  for (int i=0; i<3; ++i) {
+    float q = std::min(std::max(sphere[i],bmin[i]),bmax[i]);
+    dist += (q-sphere[i])*(q-sphere[i]);
+  }
+  return dist <= sphere.w*sphere.w;
+}
+
+void LightManager::CullCPU (const glm::mat4& view, const glm::mat4& proj)
+{
+  UpdateClusterBounds(proj);
+  int nc = GetClusterCount();
+  std::vector<glm::vec4> spheres(m_lights.size());
+  for (size_t i=0; i<m_lights.size(); ++i)
+    spheres[i] = LightSphere(m_lights[i],view);
+  m_cpu_counts.assign(nc,0);
+  m_cpu_indices.assign(size_t(nc)*m_max,0);
+  for (int c=0; c<nc; ++c) {
+    unsigned int n = 0;
+    for (size_t i=0; i<spheres.size() && n<(unsigned int)m_max; ++i)
+      if (Intersect(spheres[i],m_bounds[2*c],m_bounds[2*c+1]))
+        m_cpu_indices[size_t(c)*m_max + n++] = (unsigned int)i;
+    m_cpu_counts[c] = n;
+  }
+}
+
+const std::vector<unsigned int>& LightManager::GetCPUClusterCounts () const
+{
+  return m_cpu_counts;
+}
+
+const std::vector<unsigned int>& LightManager::GetCPUClusterIndices () const
+{
+  return m_cpu_indices;
+}
+
+void LightManager::Cull (const glm::mat4& view, const glm::mat4& proj)
+{
+  UpdateClusterBounds(proj);
+  int nc = GetClusterCount();
+  int nlights = GetLightCount();
+  if (!m_cull) {
+    m_cull = ComputeShader::Make(m_csfile);
+    for (int i=0; i<5; ++i) {
+      m_buffers[i] = StorageBuffer::Make(16);
+      m_cull->AttachStorageBuffer(i,m_buffers[i]);
+    }
+  }
+  if (m_dirty) {
+    int size = nlights*int(sizeof(LightData));
+    if (size > 0)
+      m_buffers[LIGHTS]->SetData(m_lights.data(),size);
+    m_buffers[VIEW_LIGHTS]->Reserve(size);
+    m_dirty = false;
+  }
+  if (m_bounds_dirty) {
+    m_buffers[CLUSTERS]->SetData(m_bounds.data(),int(m_bounds.size()*sizeof(glm::vec4)));
+    m_buffers[COUNTS]->Reserve(nc*int(sizeof(unsigned int)));
+    m_buffers[INDICES]->Reserve(nc*m_max*int(sizeof(unsigned int)));
+    m_bounds_dirty = false;
+  }
+  m_cull->UseProgram();
+  m_cull->SetUniform("view",view);
+  m_cull->SetUniform("nlights",nlights);
+  m_cull->SetUniform("nclusters",nc);
+  m_cull->SetUniform("maxlights",m_max);
+  // each invocation culls a cluster and transforms a light to view space
+  m_cull->Dispatch((std::max(nc,nlights)+63)/64);
+}
+
+void LightManager::Cull (CameraPtr camera)
+{
+  Cull(camera->GetViewMatrix(),camera->GetProjMatrix());
+}
+
+void LightManager::GetClusterCounts (std::vector<unsigned int>& counts) const
+{
+  counts.resize(GetClusterCount());
+  m_buffers[COUNTS]->GetData(counts.data(),int(counts.size()*sizeof(unsigned int)));
+}
+
+void LightManager::GetClusterIndices (std::vector<unsigned int>& indices) const
+{
+  indices.resize(size_t(GetClusterCount())*m_max);
+  m_buffers[INDICES]->GetData(indices.data(),int(indices.size()*sizeof(unsigned int)));
+}
+
+void LightManager::Load (StatePtr st)
+{
+  if (!m_cull) {
+    std::cerr << "LightManager: Cull must be called before rendering" << std::endl;
+    exit(1);
+  }
+  ShaderPtr shd = st->GetShader();
+  int vp[4];  // viewport dimension: {x0, y0, w, h}
+  glGetIntegerv(GL_VIEWPORT,vp);
+  float scale = m_nz / logf(m_zfar/m_znear);
+  shd->SetUniform("cdims",glm::vec4(float(m_nx),float(m_ny),float(m_nz),float(m_max)));
+  shd->SetUniform("czparams",glm::vec4(m_znear,m_zfar,scale,logf(m_znear)*scale));
+  shd->SetUniform("viewport",glm::vec4(float(vp[0]),float(vp[1]),float(vp[2]),float(vp[3])));
+  m_buffers[COUNTS]->Bind(COUNTS);
+  m_buffers[INDICES]->Bind(INDICES);
+  m_buffers[VIEW_LIGHTS]->Bind(VIEW_LIGHTS);
+}
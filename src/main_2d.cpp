@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "scene.h"
+#include "simulation.h"
 #include "state.h"
 #include "camera2d.h"
 #include "color.h"
@@ -13,11 +14,14 @@
 #include "triangle.h"
 #include "disk.h"
 
+#include <cassert>
+#include <cstdio>
 #include <initializer_list>
 #include <iostream>
 #include <ostream>
 
 static ScenePtr scene;
+static SimulationPtr simulation;
 static CameraPtr camera;
 
 class Orbit;
@@ -30,6 +34,7 @@ protected:
   Orbit (TransformPtr trf, float speed) 
   : m_trf(trf), m_speed(speed) 
   {
+    Writes(trf);
   }
 public:
   static OrbitPtr Make (TransformPtr trf, float speed)
@@ -87,19 +92,23 @@ static void initialize (void)
   scene = Scene::Make(root);
   scene->AddEngine(Orbit::Make(trf_earth_orbit_disk, 1.0f));
   scene->AddEngine(Orbit::Make(trf_moon_orbit_disk, 13.37f));
+  // engines run at a fixed rate on their own thread
+  simulation = Simulation::Make(scene, 1.0f/60.0f);
+  simulation->Start();
 }
 
 static void display (GLFWwindow* win)
 { 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear window 
   Error::Check("before render");
-  scene->Render(camera);
+  simulation->Render(camera);
   Error::Check("after render");
 }
 
 static void error (int code, const char* msg)
 {
   printf("GLFW error %d: %s\n", code, msg);
+  State::ReleaseDrawStream();
   glfwTerminate();
   exit(0);
 }
@@ -115,11 +124,6 @@ static void resize (GLFWwindow* win, int width, int height)
   glViewport(0,0,width,height);
 }
 
-static void update (float dt)
-{
-  scene->Update(dt);
-}
-
 int main ()
 {
   glfwInit();
@@ -144,15 +148,17 @@ int main ()
 
   initialize();
 
-  float t0 = float(glfwGetTime());
   while(!glfwWindowShouldClose(win)) {
-    float t = float(glfwGetTime());
-    update(t-t0);
-    t0 = t;
     display(win);
     glfwSwapBuffers(win);
     glfwPollEvents();
   }
+  simulation->Stop();
+  Simulation::Stats stats = simulation->GetStats();
+  printf("%ld steps (%ld dropped), %.3f ms per update; %ld frames, %.3f ms per render\n",
+         stats.steps, stats.dropped, stats.update, stats.frames, stats.render);
+  simulation.reset();
+  State::ReleaseDrawStream();
   glfwTerminate();
   return 0;
 }
@@ -17,6 +17,11 @@
 #include "light.h"
 #include "light.h"
 #include "polyoffset.h"
+#include "shaderreloader.h"
+#include "shadervariants.h"
+#include "planarreflection.h"
+#include "transparencypass.h"
+#include "opaquepass.h"
 
 #include "obj_loader.h"
 #include "model_shape.h"
@@ -28,8 +33,14 @@ static float viewer_pos[3] = {2.0f, 3.5f, 4.0f};
 
 static ScenePtr scene;
 static ScenePtr reflector;
+static ScenePtr glass;
 static Camera3DPtr camera;
 static ArcballPtr arcball;
+static ShaderReloaderPtr reloader;
+static ShaderVariantsPtr variants;
+static PlanarReflectionPtr reflection;
+static TransparencyPassPtr transparency;
+static OpaquePassPtr opaque;
 
 ImportedModel* modeloTeste = nullptr; 
 
@@ -70,7 +81,7 @@ static void initialize(void)
   floor_transform->Translate(-0.5f, -0.5f, 0.0f);
   TransformPtr sphere_transform = Transform::Make();
   sphere_transform->Scale(0.5f, 0.5f, 0.5f);
-  sphere_transform->Translate(0.0f, 1.0f, 0.0f);
+  sphere_transform->Translate(-3.0f, 1.0f, -2.0f);
 
   Error::Check("before shps");
   ShapePtr cube = Cube::Make();
@@ -78,66 +89,94 @@ static void initialize(void)
   ShapePtr sphere = Sphere::Make();
   Error::Check("after shps");
 
-  // create shader
-  ShaderPtr shader = Shader::Make(light, "world");
-  shader->AttachVertexShader("shaders/ilum_vert/vertex.glsl");
-  shader->AttachFragmentShader("shaders/ilum_vert/fragment.glsl");
-  shader->AttachGeometryShader("shaders/ilum_vert/geometry.glsl");
-  shader->Link();
-
-  // Define a different shader for texture mapping
-  // An alternative would be to use only this shader with a "white" texture for untextured objects
-  ShaderPtr shd_tex = Shader::Make(light, "world");
-  shd_tex->AttachVertexShader("shaders/ilum_vert/vertex_texture.glsl");
-  shd_tex->AttachFragmentShader("shaders/ilum_vert/fragment_texture.glsl");
-  shd_tex->Link();
-
+  // lit shaders: one source, compiled per feature set asked by the nodes
+  variants = ShaderVariants::Make(light, "world");
+  unsigned int shrink = variants->AddFeature("SHRINK");
+  unsigned int texture = variants->AddFeature("TEXTURE");
+  unsigned int two_sided = variants->AddFeature("TWO_SIDED");
+  unsigned int fog = variants->AddFeature("FOG");
+  variants->AttachStage(ShaderVariants::VERTEX, "shaders/variant/vertex.glsl");
+  variants->AttachStage(ShaderVariants::FRAGMENT, "shaders/variant/fragment.glsl");
+  variants->AttachStage(ShaderVariants::GEOMETRY, "shaders/variant/geometry.glsl", shrink);
+
+  // the floor mixes its color with the mirrored scene
+  ShaderPtr shd_refl = Shader::Make(light, "world");
+  shd_refl->AttachVertexShader("shaders/reflection/vertex.glsl");
+  shd_refl->AttachFragmentShader("shaders/reflection/fragment.glsl");
+  shd_refl->Link();
+
+  // translucent objects: weighted blended into the OIT targets, unsorted
+  ShaderPtr shd_oit = Shader::Make(light, "world");
+  shd_oit->AttachVertexShader("shaders/oit/vertex.glsl");
+  shd_oit->AttachFragmentShader("shaders/oit/fragment.glsl");
+  shd_oit->Link();
+
+  // edits to the shader files are picked up while running
+  reloader = ShaderReloader::Make();
+  reloader->AddShader(shd_refl);
+  reloader->AddShader(shd_oit);
+
+  // the model is shrunk and textured; the sphere is lit per vertex, on
+  // both sides, in fog
   NodePtr sphere_node = Node::Make(sphere_transform, {white}, {sphere});
-  NodePtr root = Node::Make(shader, {object_node});
+  object_node->AddAppearance(Texture::Make("decal", glm::vec3(0.6f, 0.9f, 0.5f)));
+  object_node->SetFeatures(shrink | texture);
+  sphere_node->SetFeatures(two_sided | fog);
+  NodePtr root = Node::Make({object_node, sphere_node});
+  variants->Precompile({shrink | texture, two_sided | fog});
+  variants->Apply(root);
+  for (const ShaderPtr& shd : variants->GetShaders())
+    reloader->AddShader(shd);
   scene = Scene::Make(root);
 
-  NodePtr floor_node = Node::Make(floor_transform, {floor_appearance}, {quad});
-  reflector = Scene::Make(Node::Make(shader, {floor_node}));
+  // floor on the y=0 plane, reflecting the scene at half resolution
+  reflection = PlanarReflection::Make(root, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), 0.5f);
+  NodePtr floor_node = Node::Make(floor_transform, {floor_appearance, reflection}, {quad});
+  reflector = Scene::Make(Node::Make(shd_refl, {floor_node}));
+
+  // overlapping glass spheres above the floor
+  NodePtr glass_root = Node::Make(shd_oit);
+  const float glass_colors[][3] = {{0.2f, 0.4f, 1.0f}, {0.2f, 1.0f, 0.4f}, {1.0f, 0.8f, 0.2f}};
+  for (int i = 0; i < 3; ++i) {
+    TransformPtr trf = Transform::Make();
+    trf->Translate(-0.6f + 0.6f * i, 0.6f, 0.3f * (i % 2));
+    trf->Scale(0.4f, 0.4f, 0.4f);
+    AppearancePtr mat = Material::Make(glass_colors[i][0], glass_colors[i][1], glass_colors[i][2], 0.4f);
+    glass_root->AddNode(Node::Make(trf, {mat}, {sphere}));
+  }
+  glass = Scene::Make(glass_root);
+  transparency = TransparencyPass::Make();
+  // opaque draws: depth pre-pass, front to back
+  opaque = OpaquePass::Make();
 }
 
 static void display(GLFWwindow *win)
 {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // clear window
   Error::Check("before render");
 
-  // desenha refletor no stencil
-  glEnable(GL_STENCIL_TEST);
-  glStencilFunc(GL_NEVER, 1, 0xFFFF);
-  glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
-  reflector->Render(camera);
-
-  // desenha cena refletida
-  glStencilFunc(GL_EQUAL, 1, 0xFFFF);
-  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-  NodePtr root = scene->GetRoot();
-  TransformPtr trf = Transform::Make();
-  trf->Scale(1.0f, -1.0f, 1.0f);
-  root->SetTransform(trf);
-  glFrontFace(GL_CW);
-  scene->Render(camera);
-  glFrontFace(GL_CCW);
-  root->SetTransform(nullptr);
-  glDisable(GL_STENCIL_TEST);
-
-  // desenha cena
-  scene->Render(camera);
-
-  // desenha refletor
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  reflector->Render(camera);
-  glDisable(GL_BLEND);
+  // cena refletida: renderizada fora da tela, so quando algo mudou
+  reflection->Update(camera);
+
+  // opaco fora da tela (limpo pelo passo)
+  transparency->BeginOpaque();
+
+  // desenha cena e refletor (pre-passo de profundidade, frente para tras)
+  opaque->Begin(camera);
+  opaque->Record(scene->GetRoot());
+  opaque->Record(reflector->GetRoot());
+  opaque->Execute();
+
+  // translucidos, em qualquer ordem, compostos sobre o opaco
+  transparency->BeginTranslucent();
+  glass->Render(camera);
+  transparency->Composite();
   Error::Check("after render");
 }
 
 static void error(int code, const char *msg)
 {
   printf("GLFW error %d: %s\n", code, msg);
+  State::ReleaseDrawStream();
   glfwTerminate();
   exit(0);
 }
@@ -146,6 +185,13 @@ static void keyboard(GLFWwindow *window, int key, int scancode, int action, int
 {
   if (key == GLFW_KEY_Q && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, GLFW_TRUE);
+  // opaque pass modes: depth pre-pass, sort, overdraw view
+  if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    opaque->SetPrepass(!opaque->GetPrepass());
+  if (key == GLFW_KEY_S && action == GLFW_PRESS)
+    opaque->SetSort(!opaque->GetSort());
+  if (key == GLFW_KEY_O && action == GLFW_PRESS)
+    opaque->SetShowOverdraw(!opaque->GetShowOverdraw());
 }
 
 static void resize(GLFWwindow *win, int width, int height)
@@ -220,10 +266,12 @@ int main()
 
   while (!glfwWindowShouldClose(win))
   {
+    reloader->Update();
     display(win);
     glfwSwapBuffers(win);
     glfwPollEvents();
   }
+  State::ReleaseDrawStream();
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,140 @@
+#include "allocation.h"
+#include "arena.h"
+#include "material.h"
+#include "node.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Scene graph allocation benchmark: builds a graph of 1M leaf nodes (each
+// with its transform and material) under each allocation policy, and times
+// construction, traversal (Node::Collect, with the cache misses it causes
+// where perf counters are available) and teardown.
+// usage: alloc [groups] [leaves per group]
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// Hardware cache miss counter of this thread (-1 if not available)
+class CacheMisses {
+  int m_fd;
+public:
+  CacheMisses ()
+  : m_fd(-1)
+  {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = int(syscall(__NR_perf_event_open,&attr,0,-1,-1,0));
+#endif
+  }
+  ~CacheMisses ()
+  {
+#ifdef __linux__
+    if (m_fd >= 0)
+      close(m_fd);
+#endif
+  }
+  void Start ()
+  {
+#ifdef __linux__
+    if (m_fd >= 0) {
+      ioctl(m_fd,PERF_EVENT_IOC_RESET,0);
+      ioctl(m_fd,PERF_EVENT_IOC_ENABLE,0);
+    }
+#endif
+  }
+  long long Stop ()
+  {
+    long long count = -1;
+#ifdef __linux__
+    if (m_fd >= 0) {
+      ioctl(m_fd,PERF_EVENT_IOC_DISABLE,0);
+      if (read(m_fd,&count,sizeof(count)) != sizeof(count))
+        count = -1;
+    }
+#endif
+    return count;
+  }
+};
+
+static NodePtr Build (int ngroups, int nleaves)
+{
+  NodePtr root = Node::Make(Transform::Make());
+  root->ReserveNodes(ngroups);
+  for (int g=0; g<ngroups; ++g) {
+    TransformPtr trf = Transform::Make();
+    trf->Translate(float(g),0.0f,0.0f);
+    NodePtr group = Node::Make(trf);
+    group->ReserveNodes(nleaves);
+    for (int l=0; l<nleaves; ++l) {
+      TransformPtr leaf_trf = Transform::Make();
+      leaf_trf->Translate(0.0f,float(l),0.0f);
+      float c = float(l % 256) / 255.0f;
+      group->AddNode(Node::Make(leaf_trf,{Material::Make(c,c,c)}));
+    }
+    root->AddNode(group);
+  }
+  return root;
+}
+
+int main (int argc, char* argv[])
+{
+  int ngroups = argc > 1 ? atoi(argv[1]) : 1000;
+  int nleaves = argc > 2 ? atoi(argv[2]) : 1000;
+  const int REPEAT = 5;
+  const char* names[] = {"heap","shared","pool","arena"};
+  printf("%d nodes\n",ngroups*(nleaves+1)+1);
+  printf("%-8s %12s %12s %14s %12s\n","policy","build (ms)","walk (ms)","misses/node","free (ms)");
+  CacheMisses misses;
+  for (int policy=Allocation::HEAP; policy<=Allocation::ARENA; ++policy) {
+    Allocation::SetPolicy(Allocation::POLICY(policy));
+    ArenaPtr arena = policy == Allocation::ARENA ? Arena::Make(16<<20) : nullptr;
+    auto t0 = std::chrono::steady_clock::now();
+    NodePtr root;
+    {
+      Allocation::ArenaScope scope(arena);
+      root = Build(ngroups,nleaves);
+    }
+    double build = Elapsed(t0);
+
+    std::vector<RenderItem> items;
+    root->Collect(items);   // warm up
+    t0 = std::chrono::steady_clock::now();
+    misses.Start();
+    for (int r=0; r<REPEAT; ++r)
+      root->Collect(items);
+    long long count = misses.Stop();
+    double walk = Elapsed(t0) / REPEAT;
+
+    t0 = std::chrono::steady_clock::now();
+    root.reset();
+    arena.reset();
+    double teardown = Elapsed(t0);
+    if (count >= 0)
+      printf("%-8s %12.1f %12.2f %14.3f %12.1f\n",names[policy],build,walk,
+             double(count)/REPEAT/(double(ngroups)*nleaves),teardown);
+    else
+      printf("%-8s %12.1f %12.2f %14s %12.1f\n",names[policy],build,walk,"-",teardown);
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "camera3d.h"
+#include "cube.h"
+#include "frustum.h"
+#include "light.h"
+#include "material.h"
+#include "node.h"
+#include "quad.h"
+#include "shader.h"
+#include "state.h"
+#include "staticbatch.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Static batching benchmark: a floor of quad tiles and a grid of boxes in
+// a few colors (20k shapes by default), all static, drawn as a graph of
+// one node per shape and after StaticBatch replaced the subtree, with
+// several batch sizes and chunk sizes. The camera orbits close to the
+// floor, so chunked batches are partly culled.
+// usage: batch [shapes] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int NCOLORS = 4;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// half floor tiles, half boxes on them
+static NodePtr Scene (int nshapes, MaterialPtr materials[], float& extent)
+{
+  int side = int(ceilf(sqrtf(float(nshapes/2))));
+  extent = float(side);
+  QuadPtr quad = Quad::Make();
+  CubePtr cube = Cube::Make();
+  NodePtr scene = Node::Make();
+  scene->ReserveNodes(nshapes);
+  for (int i=0; i<nshapes; ++i) {
+    int cell = i / 2;
+    float x = cell%side - side*0.5f;
+    float z = cell/side - side*0.5f;
+    TransformPtr trf = Transform::Make();
+    if (i % 2 == 0) {
+      trf->Translate(x,0.0f,z+1.0f);
+      trf->Rotate(-90.0f,1.0f,0.0f,0.0f);
+      scene->AddNode(Node::Make(trf,{materials[0]},{quad}));
+    }
+    else {
+      trf->Translate(x+0.5f,0.0f,z+0.5f);
+      trf->Scale(0.4f,Random(0.2f,1.5f),0.4f);
+      scene->AddNode(Node::Make(trf,{materials[1+rand()%(NCOLORS-1)]},{cube}));
+    }
+  }
+  scene->SetStatic(true);
+  return scene;
+}
+
+static void run (GLFWwindow* win, int nshapes, int frames)
+{
+  srand(1);
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  MaterialPtr materials[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    materials[i] = Material::Make(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+
+  float extent = 0.0f;
+  Camera3DPtr camera = Camera3D::Make(0.0f,2.0f,extent);
+  camera->SetAspect(float(WIDTH)/HEIGHT);
+  glViewport(0,0,WIDTH,HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  struct Config {
+    const char* name;
+    bool batched;
+    int max_vertices;
+    float chunk;
+  };
+  Config configs[] = {
+    {"per shape",false,0,0.0f},
+    {"batched",true,1<<30,0.0f},
+    {"batched 64k",true,65536,0.0f},
+    {"batched 64k/16",true,65536,16.0f},
+    {"batched 64k/8",true,65536,8.0f},
+  };
+  printf("%d static shapes, %d frames of %dx%d\n",nshapes,frames,WIDTH,HEIGHT);
+  printf("%-16s %9s %10s %10s %11s\n","path","build (ms)","batches","draws","frame (ms)");
+  for (const Config& config : configs) {
+    NodePtr root = Node::Make(shd,{Scene(nshapes,materials,extent)});
+    camera->SetZPlanes(0.1f,4.0f*extent);
+    auto t0 = std::chrono::steady_clock::now();
+    StaticBatch::Stats stats = {0,0,0,0,0,0};
+    if (config.batched)
+      stats = StaticBatch::Apply(root,config.max_vertices,config.chunk);
+    double build = Elapsed(t0);
+    glFinish();
+    t0 = std::chrono::steady_clock::now();
+    for (int f=0; f<frames; ++f) {
+      float t = 6.28f * f / frames;
+      camera->SetEye(extent*0.4f*sinf(t),2.0f,extent*0.4f*cosf(t));
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      StatePtr st = State::Make(camera);
+      st->SetCullFrustum(Frustum(camera->GetProjMatrix()*camera->GetViewMatrix()));
+      root->Render(st);
+      glfwSwapBuffers(win);
+    }
+    glFinish();
+    int draws = config.batched ? stats.batches + stats.kept : nshapes;
+    printf("%-16s %9.1f %10d %10d %11.3f\n",config.name,build,stats.batches,draws,
+           Elapsed(t0)/frames);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int nshapes = argc > 1 ? atoi(argv[1]) : 20000;
+  int frames = argc > 2 ? atoi(argv[2]) : 200;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(WIDTH,HEIGHT,"Static batching",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(win,nshapes,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
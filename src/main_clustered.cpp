@@ -0,0 +1,118 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "lightmanager.h"
+#include "state.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Clustered light culling benchmark: sweeps the number of lights, timing the
+// CPU reference and the compute pass, and checks that both agree.
+// Without an OpenGL 4.3 context, only the CPU reference is timed.
+
+static const int REPEAT = 10;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static void FillLights (LightManagerPtr lights, int n)
+{
+  srand(1);
+  lights->Clear();
+  for (int i=0; i<n; ++i) {
+    glm::vec3 pos(Random(-50.0f,50.0f),Random(0.0f,10.0f),Random(-50.0f,50.0f));
+    glm::vec3 color(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+    float range = Random(1.0f,6.0f);
+    if (i % 4 == 3) {
+      glm::vec3 dir(Random(-1.0f,1.0f),-1.0f,Random(-1.0f,1.0f));
+      lights->AddSpotLight(pos,dir,range*2.0f,Random(10.0f,60.0f),color);
+    }
+    else
+      lights->AddPointLight(pos,range,color);
+  }
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static void run (bool gpu)
+{
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f,5.0f,30.0f),glm::vec3(0.0f,2.0f,0.0f),glm::vec3(0.0f,1.0f,0.0f));
+  glm::mat4 proj = glm::perspective(glm::radians(60.0f),16.0f/9.0f,0.1f,200.0f);
+  LightManagerPtr lights = LightManager::Make();
+  printf("%8s %12s %12s %12s\n","lights","cpu (ms)","gpu (ms)","mismatches");
+  for (int n=256; n<=16384; n*=2) {
+    FillLights(lights,n);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r=0; r<REPEAT; ++r)
+      lights->CullCPU(view,proj);
+    double cpu = Elapsed(t0) / REPEAT;
+    if (!gpu) {
+      printf("%8d %12.3f %12s %12s\n",n,cpu,"-","-");
+      continue;
+    }
+    lights->Cull(view,proj);   // upload lights and warm up
+    glFinish();
+    t0 = std::chrono::steady_clock::now();
+    for (int r=0; r<REPEAT; ++r)
+      lights->Cull(view,proj);
+    glFinish();
+    double gpu_time = Elapsed(t0) / REPEAT;
+    // compare the clusters with the CPU reference
+    std::vector<unsigned int> counts, indices;
+    lights->GetClusterCounts(counts);
+    lights->GetClusterIndices(indices);
+    const std::vector<unsigned int>& ccounts = lights->GetCPUClusterCounts();
+    const std::vector<unsigned int>& cindices = lights->GetCPUClusterIndices();
+    int max = lights->GetMaxLightsPerCluster();
+    int mismatches = 0;
+    for (int c=0; c<lights->GetClusterCount(); ++c) {
+      bool equal = counts[c] == ccounts[c];
+      for (unsigned int i=0; equal && i<counts[c]; ++i)
+        equal = indices[c*max+i] == cindices[c*max+i];
+      if (!equal)
+        mismatches++;
+    }
+    printf("%8d %12.3f %12.3f %12d\n",n,cpu,gpu_time,mismatches);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main ()
+{
+  glfwSetErrorCallback(error);
+  GLFWwindow* win = nullptr;
+  if (glfwInit()) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+    win = glfwCreateWindow(64,64,"Clustered lights",nullptr,nullptr);
+  }
+  if (win) {
+    glfwMakeContextCurrent(win);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      printf("GLAD: could not load OpenGL\n");
+      win = nullptr;
+    }
+  }
+  if (!win)
+    printf("No OpenGL 4.3 context: timing the CPU reference only\n");
+  run(win != nullptr);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "cube.h"
+#include "entitystore.h"
+#include "fixedcamera.h"
+#include "framebuffer.h"
+#include "light.h"
+#include "material.h"
+#include "node.h"
+#include "scene.h"
+#include "shader.h"
+#include "state.h"
+#include "texdepth.h"
+#include "texture.h"
+#include "transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Entity store benchmark: a grid of groups of boxes (100k by default), the
+// group transforms animated every frame, drawn from the scene graph and from
+// an EntityStore built from it. Reports the time spent updating world
+// matrices (Node::Collect against EntityStore::UpdateTransforms), the CPU
+// time spent submitting the draws and the whole frame time.
+// usage: ecs [groups] [boxes per group] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int NCOLORS = 8;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static void run (int ngroups, int nboxes, int frames)
+{
+  srand(1);
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  MaterialPtr materials[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    materials[i] = Material::Make(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+  CubePtr cube = Cube::Make();
+
+  int side = int(ceilf(sqrtf(float(ngroups))));
+  int bside = int(ceilf(sqrtf(float(nboxes))));
+  float extent = side * (bside + 2) * 1.5f;
+  NodePtr root = Node::Make(shd,std::initializer_list<NodePtr>());
+  root->ReserveNodes(ngroups);
+  std::vector<TransformPtr> spins;
+  for (int g=0; g<ngroups; ++g) {
+    TransformPtr trf = Transform::Make();
+    NodePtr group = Node::Make(trf);
+    group->ReserveNodes(nboxes);
+    for (int b=0; b<nboxes; ++b) {
+      TransformPtr box = Transform::Make();
+      box->Translate((b%bside - bside*0.5f)*1.5f,0.5f,(b/bside - bside*0.5f)*1.5f);
+      box->Scale(0.5f,0.5f,0.5f);
+      group->AddNode(Node::Make(box,{materials[rand()%NCOLORS]},{cube}));
+    }
+    root->AddNode(group);
+    spins.push_back(trf);
+  }
+  ScenePtr scene = Scene::Make(root);
+
+  auto t0 = std::chrono::steady_clock::now();
+  EntityStorePtr store = EntityStore::Make(scene);
+  double build = Elapsed(t0);
+
+  TexDepthPtr depth = TexDepth::Make("depth",WIDTH,HEIGHT);
+  FramebufferPtr fbo = Framebuffer::Make(depth,{Texture::Make("color",WIDTH,HEIGHT)});
+  glm::mat4 proj = glm::perspective(glm::radians(60.0f),float(WIDTH)/HEIGHT,0.1f,4.0f*extent);
+  FixedCameraPtr camera = FixedCamera::Make(glm::mat4(1.0f),proj);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  printf("%d boxes in %d groups, %d frames of %dx%d\n",ngroups*nboxes,ngroups,frames,WIDTH,HEIGHT);
+  printf("%d entities, %d draws, built in %.1f ms\n",store->GetEntityCount(),store->GetDrawCount(),build);
+  printf("%-14s %14s %12s %12s\n","path","update (ms)","submit (ms)","frame (ms)");
+  const char* names[] = {"scene graph","entity store"};
+  std::vector<RenderItem> items;
+  for (int mode=0; mode<2; ++mode) {
+    double update = 0.0, submit = 0.0, frame = 0.0;
+    for (int f=0; f<frames; ++f) {
+      // animate the groups, as an engine would
+      for (int g=0; g<ngroups; ++g) {
+        spins[g]->LoadIdentity();
+        spins[g]->Translate((g%side - side*0.5f)*(bside+2)*1.5f,0.0f,
+                            (g/side - side*0.5f)*(bside+2)*1.5f);
+        spins[g]->Rotate(360.0f*f/frames,0.0f,1.0f,0.0f);
+      }
+      glm::mat4 view = glm::lookAt(glm::vec3(0.0f,extent*0.5f,extent*0.7f),
+                                   glm::vec3(0.0f),glm::vec3(0.0f,1.0f,0.0f));
+      camera->SetMatrices(view,proj);
+      fbo->Bind();
+      glViewport(0,0,WIDTH,HEIGHT);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      auto t1 = std::chrono::steady_clock::now();
+      if (mode == 0) {
+        items.clear();
+        root->Collect(items);
+      }
+      else
+        store->UpdateTransforms();
+      update += Elapsed(t1);
+      t1 = std::chrono::steady_clock::now();
+      if (mode == 0)
+        scene->Render(camera);
+      else
+        store->Render(camera);
+      submit += Elapsed(t1);
+      fbo->Unbind();
+      glFinish();
+      frame += Elapsed(t1);
+    }
+    printf("%-14s %14.3f %12.3f %12.3f\n",names[mode],update/frames,submit/frames,frame/frames);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int ngroups = argc > 1 ? atoi(argv[1]) : 400;
+  int nboxes = argc > 2 ? atoi(argv[2]) : 250;
+  int frames = argc > 3 ? atoi(argv[3]) : 50;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(64,64,"Entity store",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(ngroups,nboxes,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
@@ -5,21 +5,59 @@
 #include "computeshader.h"
 #include "texbuffer.h"
 
-#include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <iostream>
 #include <vector>
 
 
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
 static void initialize (void)
 {
-    std::vector<float> vet = { 1, 2, 3, 4 };
+    const int n = 1 << 16;
+    std::vector<float> vet(n);
+    for (int i = 0; i < n; ++i)
+      vet[i] = float(i % 1000);
     auto buf = TexBuffer::Make("data", vet);
     auto cs = ComputeShader::Make("../shaders/cs/compute_shader.glsl");
     cs->AttachTexBuffer(buf);
-    cs->Dispatch(1);
-    vet = buf->GetData();
-    for (auto x: vet)
-      std::cout << x << std::endl;
+    cs->Dispatch(n / 4);
+    // read back without draining the GPU: the CPU reference is computed,
+    // a chunk at a time, while the copy is not ready
+    auto t0 = std::chrono::steady_clock::now();
+    auto result = buf->GetDataAsync();
+    std::vector<float> ref(n);
+    const int chunk = 4096;
+    int done = 0;
+    double overlap = -1.0;
+    while (done < n) {
+      int end = std::min(done + chunk, n);
+      for (int i = done; i < end; ++i)
+        ref[i] = vet[i] + 1.0f;
+      done = end;
+      if (overlap < 0.0 && result->IsReady())
+        overlap = Elapsed(t0);
+    }
+    double work = Elapsed(t0);
+    if (overlap < 0.0)
+      overlap = work;
+    result->Wait();
+    double wait = Elapsed(t0) - work;
+    vet = result->GetData<float>();
+    int wrong = 0;
+    for (int i = 0; i < n; ++i)
+      if (vet[i] != ref[i])
+        wrong++;
+    std::cout << "CPU work overlapped with the GPU: " << overlap << " ms of " << work
+              << " ms, then waited " << wait << " ms" << std::endl;
+    std::cout << n << " values, " << wrong << " differ from the CPU reference" << std::endl;
+    for (int i = 0; i < 4; ++i)
+      std::cout << vet[i] << std::endl;
 }
 
 static void error (int code, const char* msg)
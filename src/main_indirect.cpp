@@ -0,0 +1,279 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "fixedcamera.h"
+#include "framebuffer.h"
+#include "frustum.h"
+#include "geometrypool.h"
+#include "grid.h"
+#include "hiz.h"
+#include "indirectrenderer.h"
+#include "light.h"
+#include "material.h"
+#include "mesh.h"
+#include "node.h"
+#include "shader.h"
+#include "state.h"
+#include "texdepth.h"
+#include "texture.h"
+#include "transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// GPU-driven rendering benchmark: a field of boxes and spheres crossed by
+// walls (100k objects by default), seen by an orbiting camera, drawn by
+// the scene graph (one draw per visible node, CPU frustum culling) and by
+// IndirectRenderer (GPU frustum culling, then also HiZ occlusion culling;
+// one multi-draw call). Reports the CPU time spent submitting each frame
+// and the whole frame time.
+// usage: indirect [objects] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int NCOLORS = 8;
+
+struct Object {
+  int mesh;          // 0: box, 1: sphere
+  glm::mat4 model;
+  int color;
+};
+
+struct Geometry {
+  std::vector<float> coords, normals, texcoords;
+  std::vector<unsigned int> indices;
+};
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// Unit box standing on y=0, as Cube
+static Geometry MakeBox ()
+{
+  Geometry g;
+  for (int a=0; a<3; ++a) {
+    for (int s=-1; s<=1; s+=2) {
+      glm::vec3 n(0.0f), u(0.0f), v(0.0f);
+      n[a] = float(s);
+      u[(a+1)%3] = 1.0f;
+      v[(a+2)%3] = 1.0f;
+      if (s < 0)
+        std::swap(u,v);
+      unsigned int base = (unsigned int)(g.coords.size()/3);
+      const float corners[4][2] = {{-0.5f,-0.5f},{0.5f,-0.5f},{0.5f,0.5f},{-0.5f,0.5f}};
+      for (int c=0; c<4; ++c) {
+        glm::vec3 p = 0.5f*n + corners[c][0]*u + corners[c][1]*v + glm::vec3(0.0f,0.5f,0.0f);
+        for (int k=0; k<3; ++k) {
+          g.coords.push_back(p[k]);
+          g.normals.push_back(n[k]);
+        }
+        g.texcoords.push_back(corners[c][0]+0.5f);
+        g.texcoords.push_back(corners[c][1]+0.5f);
+      }
+      unsigned int quad[] = {0,1,2,0,2,3};
+      for (unsigned int i : quad)
+        g.indices.push_back(base+i);
+    }
+  }
+  return g;
+}
+
+// Unit sphere, as Sphere (with fewer stacks and slices)
+static Geometry MakeSphere (int nstack, int nslice)
+{
+  Geometry g;
+  GridPtr grid = Grid::Make(nstack,nslice);
+  const float* texcoord = grid->GetCoords();
+  for (int i=0; i<grid->VertexCount(); ++i) {
+    float theta = texcoord[2*i+0]*2.0f*3.14159265f;
+    float phi = texcoord[2*i+1]*3.14159265f;
+    glm::vec3 p(sinf(theta)*sinf(phi),-cosf(phi),cosf(theta)*sinf(phi));
+    for (int k=0; k<3; ++k) {
+      g.coords.push_back(p[k]);
+      g.normals.push_back(p[k]);
+    }
+    g.texcoords.push_back(texcoord[2*i+0]);
+    g.texcoords.push_back(texcoord[2*i+1]);
+  }
+  g.indices.assign(grid->GetIndices(),grid->GetIndices()+grid->IndexCount());
+  return g;
+}
+
+static std::vector<Object> MakeScene (int n, float& extent)
+{
+  srand(1);
+  std::vector<Object> objects;
+  int side = int(ceilf(sqrtf(float(n))));
+  float spacing = 3.0f;
+  extent = side * spacing;
+  for (int i=0; i<n; ++i) {
+    glm::vec3 pos((i%side - side*0.5f)*spacing,0.0f,(i/side - side*0.5f)*spacing);
+    float s = Random(0.5f,1.5f);
+    Object obj;
+    obj.mesh = rand() % 2;
+    obj.model = glm::translate(glm::mat4(1.0f),pos + glm::vec3(0.0f,obj.mesh == 1 ? s : 0.0f,0.0f));
+    obj.model = glm::rotate(obj.model,Random(0.0f,6.28f),glm::vec3(0.0f,1.0f,0.0f));
+    obj.model = glm::scale(obj.model,glm::vec3(s));
+    obj.color = rand() % NCOLORS;
+    objects.push_back(obj);
+  }
+  // walls across the field: occluders
+  for (float z=-extent*0.5f; z<extent*0.5f; z+=40.0f) {
+    Object wall;
+    wall.mesh = 0;
+    wall.model = glm::translate(glm::mat4(1.0f),glm::vec3(0.0f,0.0f,z+spacing*0.5f));
+    wall.model = glm::scale(wall.model,glm::vec3(extent,12.0f,0.5f));
+    wall.color = 0;
+    objects.push_back(wall);
+  }
+  return objects;
+}
+
+static void run (int n, int frames)
+{
+  float extent;
+  std::vector<Object> objects = MakeScene(n,extent);
+  Geometry geometry[2] = {MakeBox(),MakeSphere(12,16)};
+  glm::vec4 palette[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    palette[i] = glm::vec4(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f),1.0f);
+
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd_indirect = Shader::Make(light,"camera");
+  shd_indirect->AttachVertexShader("shaders/indirect/vertex.glsl");
+  shd_indirect->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd_indirect->Link();
+  ShaderPtr shd_node = Shader::Make(light,"camera");
+  shd_node->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd_node->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd_node->Link();
+
+  // scene graph version: one node per object
+  MeshPtr meshes[2];
+  for (int m=0; m<2; ++m) {
+    const Geometry& g = geometry[m];
+    meshes[m] = Mesh::Make();
+    meshes[m]->SetCoordBuffer(int(g.coords.size()),g.coords.data(),3,0);
+    meshes[m]->SetNormalBuffer(int(g.normals.size()),g.normals.data(),3,0);
+    meshes[m]->SetIndexBuffer(int(g.indices.size()),g.indices.data());
+  }
+  MaterialPtr materials[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    materials[i] = Material::Make(palette[i].x,palette[i].y,palette[i].z);
+  NodePtr graph = Node::Make(shd_node,std::initializer_list<NodePtr>());
+  for (const Object& obj : objects) {
+    TransformPtr trf = Transform::Make();
+    trf->MultMatrix(obj.model);
+    graph->AddNode(Node::Make(trf,{materials[obj.color]},{meshes[obj.mesh]}));
+  }
+
+  // GPU-driven version: one shape for everything
+  GeometryPoolPtr pool = GeometryPool::Make();
+  for (const Geometry& g : geometry)
+    pool->AddMesh(int(g.coords.size()/3),g.coords.data(),g.normals.data(),g.texcoords.data(),
+                  int(g.indices.size()),g.indices.data());
+  IndirectRendererPtr renderer = IndirectRenderer::Make(pool);
+  for (const Object& obj : objects)
+    renderer->AddObject(obj.mesh,obj.model,palette[obj.color]);
+  NodePtr indirect = Node::Make(shd_indirect,{renderer});
+  HiZPtr hiz = HiZ::Make();
+
+  TexDepthPtr depth = TexDepth::Make("depth",WIDTH,HEIGHT);
+  FramebufferPtr fbo = Framebuffer::Make(depth,{Texture::Make("color",WIDTH,HEIGHT)});
+  glm::mat4 proj = glm::perspective(glm::radians(60.0f),float(WIDTH)/HEIGHT,0.1f,1000.0f);
+  FixedCameraPtr camera = FixedCamera::Make(glm::mat4(1.0f),proj);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  printf("%d objects, %d frames of %dx%d\n",int(objects.size()),frames,WIDTH,HEIGHT);
+  printf("%-22s %12s %12s %10s\n","path","submit (ms)","frame (ms)","drawn");
+  const char* names[] = {"scene graph","indirect, frustum","indirect, frustum+hiz"};
+  for (int mode=0; mode<3; ++mode) {
+    renderer->SetOcclusion(nullptr,glm::mat4(1.0f));
+    double submit = 0.0, frame = 0.0;
+    for (int f=0; f<frames; ++f) {
+      float t = 6.28f * f / frames;
+      float r = extent * 0.3f;
+      glm::mat4 view = glm::lookAt(glm::vec3(r*cosf(t),4.0f,r*sinf(t)),
+                                   glm::vec3(0.0f,2.0f,0.0f),glm::vec3(0.0f,1.0f,0.0f));
+      camera->SetMatrices(view,proj);
+      fbo->Bind();
+      glViewport(0,0,WIDTH,HEIGHT);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      auto t0 = std::chrono::steady_clock::now();
+      StatePtr st = State::Make(camera);
+      if (mode == 0) {
+        st->SetCullFrustum(Frustum(proj*view));
+        graph->Render(st);
+      }
+      else {
+        renderer->Cull(view,proj);
+        indirect->Render(st);
+      }
+      submit += Elapsed(t0);
+      if (mode == 2) {
+        // next frame is culled against this one's depth
+        hiz->Build(depth);
+        renderer->SetOcclusion(hiz,proj*view);
+      }
+      fbo->Unbind();
+      glFinish();
+      frame += Elapsed(t0);
+    }
+    if (mode == 0)
+      printf("%-22s %12.3f %12.3f %10s\n",names[mode],submit/frames,frame/frames,"-");
+    else
+      printf("%-22s %12.3f %12.3f %10d\n",names[mode],submit/frames,frame/frames,
+             renderer->GetVisibleCount());
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  int frames = argc > 2 ? atoi(argv[2]) : 100;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(64,64,"GPU-driven rendering",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(n,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
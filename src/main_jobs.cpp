@@ -0,0 +1,113 @@
+#include "scene.h"
+#include "engine.h"
+#include "jobsystem.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Scene::Update benchmark: thousands of engines, each spinning its own
+// transform, some also following another engine's transform (so they must
+// run after it), updated serially and through the job system. Checks that
+// both give the same transforms and prints the per-worker statistics.
+// usage: jobs [engines] [work per engine] [frames]
+
+class Spinner;
+using SpinnerPtr = std::shared_ptr<Spinner>;
+class Spinner : public Engine
+{
+  TransformPtr m_trf;
+  TransformPtr m_leader;   // read, may be null
+  int m_work;
+protected:
+  Spinner (TransformPtr trf, TransformPtr leader, int work)
+  : m_trf(trf), m_leader(leader), m_work(work)
+  {
+    Writes(trf);
+    if (leader)
+      Reads(leader);
+  }
+public:
+  static SpinnerPtr Make (TransformPtr trf, TransformPtr leader, int work)
+  {
+    return SpinnerPtr(new Spinner(trf,leader,work));
+  }
+  virtual void Update (float dt)
+  {
+    // stand-in for a simulation step
+    float angle = 0.0f;
+    for (int i=0; i<m_work; ++i)
+      angle += sinf(i*dt) * 1e-4f;
+    m_trf->Rotate(angle,0.0f,1.0f,0.0f);
+    if (m_leader) {
+      const glm::mat4& m = m_leader->GetMatrix();
+      m_trf->Translate(m[3][0]*0.01f,0.0f,m[0][0]*0.01f);
+    }
+  }
+};
+
+static ScenePtr MakeScene (int n, int work, std::vector<TransformPtr>& trfs)
+{
+  srand(1);
+  ScenePtr scene = Scene::Make(nullptr);
+  trfs.clear();
+  for (int i=0; i<n; ++i) {
+    trfs.push_back(Transform::Make());
+    // one in four follows an earlier engine's transform
+    TransformPtr leader = i > 0 && rand()%4 == 0 ? trfs[rand()%i] : nullptr;
+    scene->AddEngine(Spinner::Make(trfs[i],leader,work));
+  }
+  return scene;
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+int main (int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 4096;
+  int work = argc > 2 ? atoi(argv[2]) : 2000;
+  int frames = argc > 3 ? atoi(argv[3]) : 60;
+  std::vector<TransformPtr> serial_trfs, parallel_trfs;
+  ScenePtr serial = MakeScene(n,work,serial_trfs);
+  ScenePtr parallel = MakeScene(n,work,parallel_trfs);
+  JobSystemPtr jobs = JobSystem::GetDefault();
+  parallel->SetJobSystem(jobs);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int f=0; f<frames; ++f)
+    serial->Update(1.0f/60.0f);
+  double serial_time = Elapsed(t0) / frames;
+  parallel->Update(1.0f/60.0f);   // builds the task graph
+  jobs->ResetStats();
+  t0 = std::chrono::steady_clock::now();
+  for (int f=1; f<frames; ++f)
+    parallel->Update(1.0f/60.0f);
+  double parallel_time = Elapsed(t0) / (frames-1);
+
+  int mismatches = 0;
+  for (int i=0; i<n; ++i)
+    if (serial_trfs[i]->GetMatrix() != parallel_trfs[i]->GetMatrix())
+      mismatches++;
+  printf("%d engines, %d frames, %d workers\n",n,frames,jobs->GetWorkerCount());
+  printf("serial:   %10.3f ms/frame\n",serial_time);
+  printf("parallel: %10.3f ms/frame (x%.2f)\n",parallel_time,serial_time/parallel_time);
+  printf("transforms differing from the serial update: %d\n",mismatches);
+  printf("%8s %10s %10s %12s %12s\n","worker","jobs","steals","busy (ms)","utilisation");
+  std::vector<JobSystem::Stats> stats = jobs->GetStats();
+  for (size_t i=0; i<stats.size(); ++i) {
+    char name[16];
+    if (i+1 == stats.size())
+      snprintf(name,sizeof(name),"caller");
+    else
+      snprintf(name,sizeof(name),"%d",int(i));
+    printf("%8s %10d %10d %12.1f %11.1f%%\n",name,stats[i].jobs,stats[i].steals,stats[i].busy,
+           100.0*stats[i].utilisation);
+  }
+  return mismatches == 0 ? 0 : 1;
+}
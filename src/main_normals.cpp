@@ -0,0 +1,67 @@
+#include "jobsystem.h"
+#include "meshtools.h"
+#include "sphere.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Normal and tangent generation benchmark, with no GL context: a finely
+// tessellated sphere (and a crease-split copy) stripped of its normals and
+// tangents, regenerated with 1, 2, 4... workers. Results must be the same
+// whatever the number of workers.
+// usage: normals [stacks]
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static bool Same (const MeshData& a, const MeshData& b)
+{
+  if (a.indices != b.indices || a.normals.size() != b.normals.size() ||
+      a.tangents.size() != b.tangents.size())
+    return false;
+  for (size_t i=0; i<a.normals.size(); ++i)
+    if (a.normals[i] != b.normals[i])
+      return false;
+  for (size_t i=0; i<a.tangents.size(); ++i)
+    if (a.tangents[i] != b.tangents[i])
+      return false;
+  return true;
+}
+
+int main (int argc, char* argv[])
+{
+  int nstack = argc > 1 ? atoi(argv[1]) : 512;
+  MeshData source = Sphere::Geometry(nstack,nstack);
+  source.normals.clear();
+  source.tangents.clear();
+  int nthreads = int(std::thread::hardware_concurrency());
+  printf("%d vertices, %d triangles, %d hardware threads\n",source.GetVertexCount(),
+         source.GetTriangleCount(),nthreads);
+  printf("%8s %8s %12s %12s %10s %6s\n","crease","workers","normals (ms)","tangents (ms)",
+         "vertices","same");
+  for (float crease : {180.0f,30.0f}) {
+    MeshData reference;
+    for (int n=1; ; n*=2) {
+      n = n > nthreads ? nthreads : n;
+      JobSystemPtr jobs = JobSystem::Make(n);
+      MeshData mesh = source;
+      auto t0 = std::chrono::steady_clock::now();
+      MeshTools::ComputeNormals(mesh,crease,MeshTools::ANGLE,jobs);
+      double normals = Elapsed(t0);
+      t0 = std::chrono::steady_clock::now();
+      MeshTools::ComputeTangents(mesh,jobs);
+      double tangents = Elapsed(t0);
+      if (n == 1)
+        reference = mesh;
+      printf("%8.0f %8d %12.2f %12.2f %10d %6s\n",crease,n,normals,tangents,
+             mesh.GetVertexCount(),Same(mesh,reference) ? "yes" : "NO");
+      if (n >= nthreads)
+        break;
+    }
+  }
+  return 0;
+}
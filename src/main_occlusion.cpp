@@ -0,0 +1,184 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "camera3d.h"
+#include "cube.h"
+#include "frustum.h"
+#include "light.h"
+#include "material.h"
+#include "node.h"
+#include "occlusionculler.h"
+#include "shader.h"
+#include "sphere.h"
+#include "state.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Software occlusion culling benchmark: a town of walls (occluders) with
+// small objects scattered between them (20k by default), seen from street
+// level by a camera walking around. Frames are drawn with frustum culling
+// only and with an OcclusionCuller of a few resolutions; the occluder
+// raster time and the fraction of shapes culled are reported.
+// usage: occlusion [objects] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int BLOCKS = 12;       // blocks per side
+static const float SPACING = 10.0f;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static NodePtr Town (ShaderPtr shd, int nobjects)
+{
+  MaterialPtr wall = Material::Make(0.8f,0.8f,0.7f);
+  MaterialPtr thing = Material::Make(0.9f,0.3f,0.2f);
+  ShapePtr cube = Cube::Make();
+  ShapePtr sphere = Sphere::Make(16,16);
+  NodePtr walls = Node::Make();
+  walls->AddAppearance(wall);
+  walls->SetOccluder(true);
+  float half = BLOCKS * SPACING * 0.5f;
+  for (int i=0; i<BLOCKS; ++i) {
+    for (int j=0; j<BLOCKS; ++j) {
+      // a block: four walls around its center
+      float x = i*SPACING - half + SPACING*0.5f;
+      float z = j*SPACING - half + SPACING*0.5f;
+      for (int k=0; k<4; ++k) {
+        TransformPtr trf = Transform::Make();
+        float dx = k == 0 ? -3.0f : (k == 1 ? 3.0f : 0.0f);
+        float dz = k == 2 ? -3.0f : (k == 3 ? 3.0f : 0.0f);
+        trf->Translate(x+dx,2.0f,z+dz);
+        if (k < 2)
+          trf->Scale(0.2f,4.0f,6.2f);
+        else
+          trf->Scale(6.2f,4.0f,0.2f);
+        walls->AddNode(Node::Make(trf,{cube}));
+      }
+    }
+  }
+  NodePtr things = Node::Make();
+  things->AddAppearance(thing);
+  things->ReserveNodes(nobjects);
+  for (int i=0; i<nobjects; ++i) {
+    TransformPtr trf = Transform::Make();
+    trf->Translate(Random(-half,half),Random(0.2f,1.5f),Random(-half,half));
+    trf->Scale(0.2f,0.2f,0.2f);
+    things->AddNode(Node::Make(trf,{sphere}));
+  }
+  return Node::Make(shd,{walls,things});
+}
+
+static void run (GLFWwindow* win, int nobjects, int frames)
+{
+  srand(1);
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  NodePtr root = Town(shd,nobjects);
+
+  Camera3DPtr camera = Camera3D::Make(0.0f,1.7f,0.0f);
+  camera->SetAspect(float(WIDTH)/HEIGHT);
+  camera->SetZPlanes(0.1f,BLOCKS*SPACING*1.5f);
+  glViewport(0,0,WIDTH,HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  struct Config {
+    const char* name;
+    int width, height;
+  };
+  Config configs[] = {
+    {"frustum only",0,0},
+    {"occlusion 128",128,64},
+    {"occlusion 256",256,128},
+    {"occlusion 512",512,256},
+  };
+  printf("%d objects, %d walls, %d frames of %dx%d\n",nobjects,4*BLOCKS*BLOCKS,frames,WIDTH,HEIGHT);
+  printf("%-14s %10s %12s %10s %9s %11s\n","path","occluders","raster (ms)","tested","culled","frame (ms)");
+  for (const Config& config : configs) {
+    OcclusionCullerPtr culler;
+    if (config.width > 0)
+      culler = OcclusionCuller::Make(config.width,config.height);
+    double raster = 0.0;
+    long tested = 0, culled = 0, occluders = 0;
+    glFinish();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f=0; f<frames; ++f) {
+      // walk down the street at x=0, looking around
+      float t = float(f) / frames;
+      float z = (t - 0.5f) * BLOCKS * SPACING * 0.9f;
+      camera->SetEye(0.0f,1.7f,z);
+      camera->SetCenter(10.0f*sinf(6.28f*t),1.7f,z+10.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      StatePtr st = State::Make(camera);
+      st->SetCullFrustum(Frustum(camera->GetProjMatrix()*camera->GetViewMatrix()));
+      if (culler) {
+        culler->Build(camera,root);
+        st->SetOcclusionCuller(culler);
+      }
+      root->Render(st);
+      if (culler) {
+        const OcclusionCuller::Stats& stats = culler->GetStats();
+        raster += stats.raster_time;
+        tested += stats.tested;
+        culled += stats.culled;
+        occluders += stats.occluders;
+      }
+      glfwSwapBuffers(win);
+    }
+    glFinish();
+    printf("%-14s %10ld %12.3f %10ld %8.1f%% %11.3f\n",config.name,occluders/frames,raster/frames,
+           tested/frames,tested > 0 ? 100.0*culled/tested : 0.0,Elapsed(t0)/frames);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int nobjects = argc > 1 ? atoi(argv[1]) : 20000;
+  int frames = argc > 2 ? atoi(argv[2]) : 200;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(WIDTH,HEIGHT,"Occlusion culling",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(win,nobjects,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
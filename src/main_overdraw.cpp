@@ -0,0 +1,142 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "camera3d.h"
+#include "cube.h"
+#include "light.h"
+#include "material.h"
+#include "node.h"
+#include "opaquepass.h"
+#include "shader.h"
+#include "sphere.h"
+#include "state.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Overdraw benchmark: a dense block of boxes and spheres in random graph
+// order (8k shapes by default), seen from the front so most of them are
+// hidden, drawn by an OpaquePass in graph order, front to back, with a
+// depth pre-pass and with both. Fragments per pixel are those shaded by
+// the main pass.
+// usage: overdraw [shapes] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int NCOLORS = 8;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static NodePtr Scene (ShaderPtr shd, int nshapes)
+{
+  MaterialPtr materials[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    materials[i] = Material::Make(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+  ShapePtr shapes[2] = {Cube::Make(),Sphere::Make(32,32)};
+  NodePtr root = Node::Make(shd);
+  root->ReserveNodes(nshapes);
+  for (int i=0; i<nshapes; ++i) {
+    TransformPtr trf = Transform::Make();
+    trf->Translate(Random(-8.0f,8.0f),Random(-4.5f,4.5f),Random(-40.0f,0.0f));
+    trf->Scale(0.5f,0.5f,0.5f);
+    root->AddNode(Node::Make(trf,{materials[rand()%NCOLORS]},{shapes[rand()%2]}));
+  }
+  return root;
+}
+
+static void run (GLFWwindow* win, int nshapes, int frames)
+{
+  srand(1);
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  NodePtr root = Scene(shd,nshapes);
+  OpaquePassPtr pass = OpaquePass::Make();
+
+  Camera3DPtr camera = Camera3D::Make(0.0f,0.0f,12.0f);
+  camera->SetAspect(float(WIDTH)/HEIGHT);
+  camera->SetZPlanes(0.1f,60.0f);
+  glViewport(0,0,WIDTH,HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  struct Config {
+    const char* name;
+    bool sort;
+    bool prepass;
+  };
+  Config configs[] = {
+    {"graph order",false,false},
+    {"front to back",true,false},
+    {"pre-pass",false,true},
+    {"pre-pass sorted",true,true},
+  };
+  printf("%d shapes, %d frames of %dx%d\n",nshapes,frames,WIDTH,HEIGHT);
+  printf("%-16s %10s %10s %13s %11s\n","path","draws","switches","fragments/px","frame (ms)");
+  for (const Config& config : configs) {
+    pass->SetSort(config.sort);
+    pass->SetPrepass(config.prepass);
+    glFinish();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f=0; f<frames; ++f) {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      pass->Begin(camera);
+      pass->Record(root);
+      pass->Execute();
+      glfwSwapBuffers(win);
+    }
+    glFinish();
+    const OpaquePass::Stats& stats = pass->GetStats();
+    printf("%-16s %10d %10d %13.2f %11.3f\n",config.name,stats.draws,stats.switches,
+           stats.overdraw,Elapsed(t0)/frames);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int nshapes = argc > 1 ? atoi(argv[1]) : 8000;
+  int frames = argc > 2 ? atoi(argv[2]) : 200;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(WIDTH,HEIGHT,"Overdraw",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(win,nshapes,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
@@ -0,0 +1,173 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "cpuprimitives.h"
+#include "gpuprimitives.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+// Parallel primitives benchmark: sweeps the input size, timing the
+// multithreaded CPU reference and the compute version of scan, reduce,
+// compaction and radix sort, and checks that both agree (throughput in
+// millions of values per second). Without an OpenGL 4.3 context, only the
+// CPU reference is timed.
+
+static const int REPEAT = 5;
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// mean time of f, in ms
+static double Time (const std::function<void()>& f, bool gpu)
+{
+  f();   // warm up
+  if (gpu)
+    glFinish();
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r=0; r<REPEAT; ++r)
+    f();
+  if (gpu)
+    glFinish();
+  return Elapsed(t0) / REPEAT;
+}
+
+static void Report (const char* name, int n, double cpu, double gpu, bool ok, bool has_gpu)
+{
+  if (!has_gpu) {
+    printf("%-8s %10d %12.1f %12s %6s\n",name,n,n/(cpu*1e3),"-","-");
+    return;
+  }
+  printf("%-8s %10d %12.1f %12.1f %6s\n",name,n,n/(cpu*1e3),n/(gpu*1e3),ok ? "ok" : "FAIL");
+}
+
+static std::vector<unsigned int> Random (int n, unsigned int mask)
+{
+  std::vector<unsigned int> v(n);
+  for (int i=0; i<n; ++i)
+    v[i] = ((unsigned int)rand() << 16 ^ (unsigned int)rand()) & mask;
+  return v;
+}
+
+static void run (bool gpu)
+{
+  GPUPrimitivesPtr prims = gpu ? GPUPrimitives::Make() : nullptr;
+  printf("%d CPU threads\n",CPUPrimitives::GetThreadCount());
+  printf("%-8s %10s %12s %12s %6s\n","","values","cpu (M/s)","gpu (M/s)","check");
+  bool all = true;
+  for (int n=1000; n<=GPUPrimitives::MAX_COUNT; n*=4) {
+    srand(n);
+    std::vector<unsigned int> data = Random(n,0xFFFF);
+    // any non-zero flag keeps its value, not only 1
+    std::vector<unsigned int> flags = Random(n,3);
+    for (unsigned int& f : flags)
+      if (f == 3u)
+        f = 0xFFFFFFFFu;
+    std::vector<unsigned int> keys = Random(n,0xFFFFFFFF);
+    std::vector<unsigned int> values(n);
+    for (int i=0; i<n; ++i)
+      values[i] = i;
+    StorageArrayPtr<unsigned int> gdata, gflags, gout, gkeys, gvalues;
+    if (gpu) {
+      gdata = StorageArray<unsigned int>::Make(data);
+      gflags = StorageArray<unsigned int>::Make(flags);
+      gout = StorageArray<unsigned int>::Make(n);
+      gkeys = StorageArray<unsigned int>::Make(keys);
+      gvalues = StorageArray<unsigned int>::Make(values);
+    }
+
+    // scan
+    std::vector<unsigned int> ref;
+    double cpu = Time([&]() { CPUPrimitives::ExclusiveScan(data,ref); },false);
+    double gpu_time = 0.0;
+    bool ok = true;
+    if (gpu) {
+      gpu_time = Time([&]() { prims->ExclusiveScan(gdata,gout,n); },true);
+      ok = gout->GetData() == ref;
+    }
+    Report("scan",n,cpu,gpu_time,ok,gpu);
+    all = all && ok;
+
+    // reductions
+    const char* names[] = {"sum","min","max"};
+    for (int op=0; op<3; ++op) {
+      unsigned int r = 0;
+      cpu = Time([&]() { r = CPUPrimitives::Reduce(data,CPUPrimitives::OP(op)); },false);
+      if (gpu) {
+        unsigned int g = 0;
+        gpu_time = Time([&]() { g = prims->Reduce(gdata,n,GPUPrimitives::OP(op)); },true);
+        ok = g == r;
+      }
+      Report(names[op],n,cpu,gpu_time,ok,gpu);
+      all = all && ok;
+    }
+
+    // compaction
+    int count = 0;
+    cpu = Time([&]() { count = CPUPrimitives::Compact(data,flags,ref); },false);
+    if (gpu) {
+      int gcount = 0;
+      gpu_time = Time([&]() { gcount = prims->Compact(gdata,gflags,gout,n); },true);
+      std::vector<unsigned int> out = gout->GetData();
+      out.resize(gcount);
+      ok = gcount == count && out == ref;
+    }
+    Report("compact",n,cpu,gpu_time,ok,gpu);
+    all = all && ok;
+
+    // radix sort: each run sorts a fresh copy
+    std::vector<unsigned int> skeys, svalues;
+    cpu = Time([&]() {
+      skeys = keys;
+      svalues = values;
+      CPUPrimitives::SortPairs(skeys,svalues);
+    },false);
+    if (gpu) {
+      gpu_time = Time([&]() {
+        gkeys->SetData(keys);
+        gvalues->SetData(values);
+        prims->SortPairs(gkeys,gvalues,n);
+      },true);
+      ok = gkeys->GetData() == skeys && gvalues->GetData() == svalues;
+    }
+    Report("sort",n,cpu,gpu_time,ok,gpu);
+    all = all && ok;
+  }
+  if (gpu)
+    printf(all ? "All results match the CPU reference\n" : "MISMATCHES found\n");
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main ()
+{
+  glfwSetErrorCallback(error);
+  GLFWwindow* win = nullptr;
+  if (glfwInit()) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+    win = glfwCreateWindow(64,64,"Parallel primitives",nullptr,nullptr);
+  }
+  if (win) {
+    glfwMakeContextCurrent(win);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      printf("GLAD: could not load OpenGL\n");
+      win = nullptr;
+    }
+  }
+  if (!win)
+    printf("No OpenGL 4.3 context: timing the CPU reference only\n");
+  run(win != nullptr);
+  glfwTerminate();
+  return 0;
+}
@@ -0,0 +1,699 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "benchreport.h"
+#include "camera2d.h"
+#include "camera3d.h"
+#include "color.h"
+#include "cube.h"
+#include "disk.h"
+#include "imagediff.h"
+#include "light.h"
+#include "lightmanager.h"
+#include "material.h"
+#include "model_shape.h"
+#include "obj_loader.h"
+#include "opaquepass.h"
+#include "planarreflection.h"
+#include "quad.h"
+#include "resourcemanager.h"
+#include "scene.h"
+#include "shader.h"
+#include "shadowmap.h"
+#include "sphere.h"
+#include "state.h"
+#include "texture.h"
+#include "transform.h"
+#include "transparencypass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Golden image and performance regression suite: renders the sample
+// scenes offscreen (hidden window) for a fixed number of fixed timesteps,
+// so the last frame is the same on every run, and compares it with the
+// golden image of the scene (ImageDiff, perceptual tolerance). Frame times
+// go to a JSON report (BenchReport), with the draw ring stalls, the
+// resources each scene loaded and shared, and the opaque pass counters;
+// compare flags the times of a report that regressed from a base one.
+// usage: regress run [report.json] [golden dir] [--update]
+//        regress compare base.json current.json [threshold]
+// run exits with 1 if an image differs from its golden one (--update
+// rewrites them instead); compare exits with 1 if a time regressed.
+// Golden images depend on the GPU and driver, so none are shipped: the
+// first run on a machine is "regress run --update", which creates the
+// golden directory, and the images it writes are checked by later runs.
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int WARMUP = 10;
+static const int FRAMES = 240;
+static const float DT = 1.0f/60.0f;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// spins a transform about an axis, at degrees per second
+class Spin : public Engine {
+  TransformPtr m_trf;
+  float m_speed;
+  glm::vec3 m_axis;
+protected:
+  Spin (TransformPtr trf, float speed, const glm::vec3& axis)
+  : m_trf(trf), m_speed(speed), m_axis(axis)
+  {
+    Writes(trf);
+  }
+public:
+  static EnginePtr Make (TransformPtr trf, float speed, const glm::vec3& axis)
+  {
+    return EnginePtr(new Spin(trf,speed,axis));
+  }
+  virtual void Update (float dt)
+  {
+    m_trf->Rotate(m_speed*dt,m_axis.x,m_axis.y,m_axis.z);
+  }
+};
+
+// a canonical scene: t is the simulated time, advanced by DT per frame
+class Case {
+public:
+  virtual ~Case () {}
+  virtual void Update (float dt, float t) = 0;
+  virtual void Draw () = 0;
+  // counters of the passes of the scene, after the last frame
+  virtual void Report (BenchReportPtr , const std::string& ) {}
+};
+
+// main_2d: sun, earth and moon, orbits driven by engines
+class SolarSystem : public Case {
+  ScenePtr m_scene;
+  CameraPtr m_camera;
+public:
+  SolarSystem ()
+  {
+    m_camera = Camera2D::Make(0,10,0,10);
+    TransformPtr trf_moon_orbit = Transform::Make();
+    TransformPtr trf_moon = Transform::Make();
+    trf_moon->Translate(2.5f,0.0f,0.0f);
+    trf_moon->Scale(0.5f,0.5f,1.0f);
+    TransformPtr trf_earth = Transform::Make();
+    trf_earth->Translate(4.5f,0.0f,1.0f);
+    trf_earth->Scale(0.4f,0.4f,1.0f);
+    NodePtr earth = Node::Make(trf_earth,{Color::Make(0,0,1)},{Disk::Make()});
+    earth->AddNode(Node::Make(trf_moon_orbit,{Node::Make(trf_moon,{Color::Make(190,190,190)},
+                                                          {Disk::Make()})}));
+    TransformPtr trf_earth_orbit = Transform::Make();
+    trf_earth_orbit->Translate(5.0f,5.0f,0.0f);
+    TransformPtr trf_sun = Transform::Make();
+    trf_sun->Translate(5.0f,5.0f,0.5f);
+    trf_sun->Scale(2.0f,2.0f,1.0f);
+    NodePtr sun = Node::Make(trf_sun,{Color::Make(1,1,0)},{Disk::Make()});
+    ShaderPtr shader = Shader::Make();
+    shader->AttachVertexShader("shaders/2d/vertex.glsl");
+    shader->AttachFragmentShader("shaders/2d/fragment.glsl");
+    shader->Link();
+    m_scene = Scene::Make(Node::Make(shader,{sun,Node::Make(trf_earth_orbit,{earth})}));
+    m_scene->AddEngine(Spin::Make(trf_earth_orbit,-6.0f,glm::vec3(0.0f,0.0f,1.0f)));
+    m_scene->AddEngine(Spin::Make(trf_moon_orbit,-80.0f,glm::vec3(0.0f,0.0f,1.0f)));
+    glClearColor(0.0f,0.0f,0.0f,1.0f);
+  }
+  virtual void Update (float dt, float )
+  {
+    m_scene->Update(dt);
+  }
+  virtual void Draw ()
+  {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_scene->Render(m_camera);
+  }
+};
+
+// main_3d: OBJ model over a reflecting floor, glass spheres, drawn through
+// the opaque and transparency passes; the camera orbits
+class Reflection : public Case {
+  ImportedModel* m_model;
+  ScenePtr m_scene, m_reflector, m_glass;
+  Camera3DPtr m_camera;
+  PlanarReflectionPtr m_reflection;
+  TransparencyPassPtr m_transparency;
+  OpaquePassPtr m_opaque;
+public:
+  Reflection ()
+  {
+    m_camera = Camera3D::Make(2.0f,3.5f,4.0f);
+    m_camera->SetAspect(float(WIDTH)/HEIGHT);
+    m_model = new ImportedModel("./models/planta.obj");
+    TransformPtr trf_object = Transform::Make();
+    trf_object->Scale(0.05f,0.05f,0.05f);
+    trf_object->Translate(1.0f,0.0f,-1.0f);
+    NodePtr object = Node::Make(trf_object,{Material::Make(1.0f,0.7f,0.7f)},
+                                {ModelShape::Make(m_model)});
+    LightPtr light = Light::Make(0.0f,0.0f,0.0f,1.0f,"camera");
+    ShaderPtr shader = Shader::Make(light,"world");
+    shader->AttachVertexShader("shaders/ilum_vert/vertex.glsl");
+    shader->AttachFragmentShader("shaders/ilum_vert/fragment.glsl");
+    shader->AttachGeometryShader("shaders/ilum_vert/geometry.glsl");
+    shader->Link();
+    ShaderPtr shd_refl = Shader::Make(light,"world");
+    shd_refl->AttachVertexShader("shaders/reflection/vertex.glsl");
+    shd_refl->AttachFragmentShader("shaders/reflection/fragment.glsl");
+    shd_refl->Link();
+    ShaderPtr shd_oit = Shader::Make(light,"world");
+    shd_oit->AttachVertexShader("shaders/oit/vertex.glsl");
+    shd_oit->AttachFragmentShader("shaders/oit/fragment.glsl");
+    shd_oit->Link();
+    NodePtr root = Node::Make(shader,{object});
+    m_scene = Scene::Make(root);
+    TransformPtr trf_floor = Transform::Make();
+    trf_floor->Scale(3.0f,3.0f,3.0f);
+    trf_floor->Rotate(-90,1.0f,0.0f,0.0f);
+    trf_floor->Translate(-0.5f,-0.5f,0.0f);
+    m_reflection = PlanarReflection::Make(root,glm::vec4(0.0f,1.0f,0.0f,0.0f),0.5f);
+    m_reflector = Scene::Make(Node::Make(shd_refl,{Node::Make(trf_floor,
+      {Material::Make(1.0f,0.0f,0.0f,0.5f),m_reflection},{Quad::Make()})}));
+    NodePtr glass = Node::Make(shd_oit);
+    const float colors[][3] = {{0.2f,0.4f,1.0f},{0.2f,1.0f,0.4f},{1.0f,0.8f,0.2f}};
+    ShapePtr sphere = Sphere::Make();
+    for (int i=0; i<3; ++i) {
+      TransformPtr trf = Transform::Make();
+      trf->Translate(-0.6f+0.6f*i,0.6f,0.3f*(i%2));
+      trf->Scale(0.4f,0.4f,0.4f);
+      glass->AddNode(Node::Make(trf,{Material::Make(colors[i][0],colors[i][1],colors[i][2],0.4f)},
+                                {sphere}));
+    }
+    m_glass = Scene::Make(glass);
+    m_transparency = TransparencyPass::Make();
+    m_opaque = OpaquePass::Make();
+    glClearColor(1.0f,1.0f,1.0f,1.0f);
+  }
+  virtual ~Reflection ()
+  {
+    delete m_model;
+  }
+  virtual void Update (float dt, float t)
+  {
+    m_scene->Update(dt);
+    m_camera->SetEye(4.5f*sinf(0.5f*t),3.5f,4.5f*cosf(0.5f*t));
+  }
+  virtual void Draw ()
+  {
+    m_reflection->Update(m_camera);
+    m_transparency->BeginOpaque();
+    m_opaque->Begin(m_camera);
+    m_opaque->Record(m_scene->GetRoot());
+    m_opaque->Record(m_reflector->GetRoot());
+    m_opaque->Execute();
+    m_transparency->BeginTranslucent();
+    m_glass->Render(m_camera);
+    m_transparency->Composite();
+  }
+  virtual void Report (BenchReportPtr report, const std::string& name)
+  {
+    const OpaquePass::Stats& stats = m_opaque->GetStats();
+    report->Set(name,"opaque_draws",stats.draws);
+    report->Set(name,"opaque_switches",stats.switches);
+    report->Set(name,"opaque_overdraw",stats.overdraw);
+  }
+};
+
+// boxes and an orbiting sphere over a floor, lit by a directional light
+// (cascaded shadows) and a point light (cube shadows), one additive pass
+// per light; the boxes and floor are static casters, the sphere is not
+class Shadows : public Case {
+  ScenePtr m_sun, m_lamp;
+  NodePtr m_casters;
+  Camera3DPtr m_camera;
+  ShadowMapPtr m_sun_shadow, m_lamp_shadow;
+public:
+  Shadows ()
+  {
+    m_camera = Camera3D::Make(0.0f,5.0f,9.0f);
+    m_camera->SetAspect(float(WIDTH)/HEIGHT);
+    m_camera->SetZPlanes(0.1f,60.0f);
+    LightPtr sun = Light::Make(0.4f,1.0f,0.3f,0.0f,"world");
+    LightPtr lamp = Light::Make(-1.5f,2.5f,1.0f,1.0f,"world");
+    lamp->SetAmbient(0.0f,0.0f,0.0f);
+    lamp->SetDiffuse(0.6f,0.5f,0.3f);
+    m_sun_shadow = ShadowMap::Make(sun,1024,3);
+    m_sun_shadow->SetMaxDistance(30.0f);
+    m_lamp_shadow = ShadowMap::Make(lamp,512);
+    m_lamp_shadow->SetPointRange(0.1f,20.0f);
+
+    TransformPtr trf_floor = Transform::Make();
+    trf_floor->Scale(20.0f,20.0f,20.0f);
+    trf_floor->Rotate(-90,1.0f,0.0f,0.0f);
+    trf_floor->Translate(-0.5f,-0.5f,0.0f);
+    NodePtr fixed = Node::Make(trf_floor,{Material::Make(0.8f,0.8f,0.8f)},{Quad::Make(8,8)});
+    ShapePtr cube = Cube::Make();
+    NodePtr boxes = Node::Make({Material::Make(0.9f,0.4f,0.2f)},{fixed});
+    for (int i=0; i<4; ++i) {
+      TransformPtr trf = Transform::Make();
+      trf->Translate(-3.0f+2.0f*i,0.0f,-1.0f+(i%2));
+      trf->Scale(0.5f,0.6f+0.4f*i,0.5f);
+      boxes->AddNode(Node::Make(trf,{cube}));
+    }
+    boxes->SetStatic(true);
+    TransformPtr trf_orbit = Transform::Make();
+    TransformPtr trf_ball = Transform::Make();
+    trf_ball->Translate(2.5f,1.0f,0.0f);
+    trf_ball->Scale(0.5f,0.5f,0.5f);
+    NodePtr ball = Node::Make(trf_orbit,{Node::Make(trf_ball,{Material::Make(0.2f,0.5f,1.0f)},
+                                                       {Sphere::Make(32,32)})});
+    m_casters = Node::Make({boxes,ball});
+
+    ShaderPtr shd_sun = Shader::Make(sun,"world");
+    ShaderPtr shd_lamp = Shader::Make(lamp,"world");
+    for (const ShaderPtr& shd : {shd_sun,shd_lamp}) {
+      shd->AttachVertexShader("shaders/shadow/vertex.glsl");
+      shd->AttachFragmentShader("shaders/shadow/fragment.glsl");
+      shd->Link();
+    }
+    m_sun = Scene::Make(Node::Make(shd_sun,{m_sun_shadow},{m_casters}));
+    m_sun->AddEngine(Spin::Make(trf_orbit,40.0f,glm::vec3(0.0f,1.0f,0.0f)));
+    m_lamp = Scene::Make(Node::Make(shd_lamp,{m_lamp_shadow},{m_casters}));
+    glClearColor(0.6f,0.7f,0.9f,1.0f);
+  }
+  virtual void Update (float dt, float t)
+  {
+    m_sun->Update(dt);
+    m_camera->SetEye(9.0f*sinf(0.3f*t),5.0f,9.0f*cosf(0.3f*t));
+  }
+  virtual void Draw ()
+  {
+    m_sun_shadow->Update(m_casters,m_camera);
+    m_lamp_shadow->Update(m_casters,m_camera);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_sun->Render(m_camera);
+    // the point light adds its diffuse and specular terms
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE,GL_ONE);
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    m_lamp->Render(m_camera);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_BLEND);
+  }
+};
+
+// many lit nodes (one shape each) in a few materials, spinning in groups
+class StressNodes : public Case {
+  ScenePtr m_scene;
+  Camera3DPtr m_camera;
+public:
+  StressNodes (int n)
+  {
+    srand(1);
+    m_camera = Camera3D::Make(0.0f,20.0f,40.0f);
+    m_camera->SetAspect(float(WIDTH)/HEIGHT);
+    m_camera->SetZPlanes(0.5f,200.0f);
+    ShaderPtr shader = Shader::Make(Light::Make(0.3f,1.0f,0.5f,0.0f,"world"),"camera");
+    shader->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+    shader->AttachFragmentShader("shaders/indirect/fragment.glsl");
+    shader->Link();
+    MaterialPtr materials[8];
+    for (int i=0; i<8; ++i)
+      materials[i] = Material::Make(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+    ShapePtr shapes[2] = {Cube::Make(),Sphere::Make(16,16)};
+    NodePtr root = Node::Make(shader);
+    m_scene = Scene::Make(root);
+    const int ngroups = 16;
+    NodePtr groups[ngroups];
+    for (int g=0; g<ngroups; ++g) {
+      TransformPtr trf = Transform::Make();
+      groups[g] = Node::Make(trf);
+      root->AddNode(groups[g]);
+      m_scene->AddEngine(Spin::Make(trf,Random(-30.0f,30.0f),glm::vec3(0.0f,1.0f,0.0f)));
+    }
+    for (int i=0; i<n; ++i) {
+      TransformPtr trf = Transform::Make();
+      trf->Translate(Random(-25.0f,25.0f),Random(0.0f,5.0f),Random(-25.0f,25.0f));
+      trf->Scale(0.3f,0.3f,0.3f);
+      groups[i%ngroups]->AddNode(Node::Make(trf,{materials[i%8]},{shapes[i%2]}));
+    }
+    glClearColor(1.0f,1.0f,1.0f,1.0f);
+  }
+  virtual void Update (float dt, float )
+  {
+    m_scene->Update(dt);
+  }
+  virtual void Draw ()
+  {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_scene->Render(m_camera);
+  }
+};
+
+// many point and spot lights, culled in clusters, over a grid of spheres
+class StressLights : public Case {
+  ScenePtr m_scene;
+  Camera3DPtr m_camera;
+  LightManagerPtr m_lights;
+public:
+  StressLights (int n)
+  {
+    srand(2);
+    m_camera = Camera3D::Make(0.0f,8.0f,30.0f);
+    m_camera->SetAspect(float(WIDTH)/HEIGHT);
+    m_camera->SetZPlanes(0.5f,150.0f);
+    m_lights = LightManager::Make();
+    for (int i=0; i<n; ++i) {
+      glm::vec3 pos(Random(-30.0f,30.0f),Random(0.5f,4.0f),Random(-30.0f,30.0f));
+      glm::vec3 color(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+      if (i % 4 == 3)
+        m_lights->AddSpotLight(pos,glm::vec3(0.0f,-1.0f,0.0f),8.0f,40.0f,color);
+      else
+        m_lights->AddPointLight(pos,Random(2.0f,5.0f),color);
+    }
+    ShaderPtr shader = Shader::Make();
+    shader->AttachVertexShader("shaders/clustered/vertex.glsl");
+    shader->AttachFragmentShader("shaders/clustered/fragment.glsl");
+    shader->Link();
+    NodePtr root = Node::Make(shader,{m_lights,Material::Make(0.8f,0.8f,0.8f)});
+    TransformPtr trf_floor = Transform::Make();
+    trf_floor->Scale(60.0f,60.0f,60.0f);
+    trf_floor->Rotate(-90,1.0f,0.0f,0.0f);
+    trf_floor->Translate(-0.5f,-0.5f,0.0f);
+    root->AddNode(Node::Make(trf_floor,{Quad::Make(32,32)}));
+    ShapePtr sphere = Sphere::Make(16,16);
+    for (int i=0; i<400; ++i) {
+      TransformPtr trf = Transform::Make();
+      trf->Translate(-28.5f+3.0f*(i%20),0.5f,-28.5f+3.0f*(i/20));
+      trf->Scale(0.5f,0.5f,0.5f);
+      root->AddNode(Node::Make(trf,{sphere}));
+    }
+    m_scene = Scene::Make(root);
+    glClearColor(0.0f,0.0f,0.0f,1.0f);
+  }
+  virtual void Update (float dt, float t)
+  {
+    m_scene->Update(dt);
+    m_camera->SetEye(30.0f*sinf(0.2f*t),8.0f,30.0f*cosf(0.2f*t));
+  }
+  virtual void Draw ()
+  {
+    m_lights->Cull(m_camera);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_scene->Render(m_camera);
+  }
+};
+
+// many textured quads, each with its own texture
+class StressTextures : public Case {
+  ScenePtr m_scene;
+  Camera3DPtr m_camera;
+public:
+  StressTextures (int n)
+  {
+    srand(3);
+    m_camera = Camera3D::Make(0.0f,0.0f,30.0f);
+    m_camera->SetAspect(float(WIDTH)/HEIGHT);
+    m_camera->SetZPlanes(0.5f,100.0f);
+    ShaderPtr shader = Shader::Make(Light::Make(0.0f,0.0f,1.0f,0.0f,"world"),"world");
+    shader->AttachVertexShader("shaders/ilum_vert/vertex_texture.glsl");
+    shader->AttachFragmentShader("shaders/ilum_vert/fragment_texture.glsl");
+    shader->Link();
+    NodePtr root = Node::Make(shader,{Material::Make(1.0f,1.0f,1.0f)});
+    TransformPtr trf_all = Transform::Make();
+    NodePtr all = Node::Make(trf_all);
+    root->AddNode(all);
+    ShapePtr quad = Quad::Make();
+    int side = int(ceilf(sqrtf(float(n))));
+    for (int i=0; i<n; ++i) {
+      TransformPtr trf = Transform::Make();
+      trf->Translate(-side*0.5f+i%side,-side*0.5f+i/side,0.0f);
+      trf->Scale(0.9f,0.9f,0.9f);
+      glm::vec3 texel(Random(0.0f,1.0f),Random(0.0f,1.0f),Random(0.0f,1.0f));
+      all->AddNode(Node::Make(trf,{Texture::Make("decal",texel)},{quad}));
+    }
+    m_scene = Scene::Make(root);
+    m_scene->AddEngine(Spin::Make(trf_all,10.0f,glm::vec3(0.0f,0.0f,1.0f)));
+    glClearColor(1.0f,1.0f,1.0f,1.0f);
+  }
+  virtual void Update (float dt, float )
+  {
+    m_scene->Update(dt);
+  }
+  virtual void Draw ()
+  {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_scene->Render(m_camera);
+  }
+};
+
+static Case* MakeCase (const std::string& name)
+{
+  if (name == "solar")
+    return new SolarSystem();
+  if (name == "reflection")
+    return new Reflection();
+  if (name == "shadows")
+    return new Shadows();
+  if (name == "nodes_10k")
+    return new StressNodes(10000);
+  if (name == "lights_2k")
+    return new StressLights(2048);
+  if (name == "textures_1k")
+    return new StressTextures(1024);
+  return nullptr;
+}
+
+static const char* CASES[] = {"solar","reflection","shadows","nodes_10k","lights_2k","textures_1k"};
+
+// back buffer, top row first
+static ImageDiff::Pixels ReadBack ()
+{
+  ImageDiff::Pixels image;
+  image.width = WIDTH;
+  image.height = HEIGHT;
+  image.rgb.resize(size_t(WIDTH) * HEIGHT * 3);
+  std::vector<unsigned char> rows(image.rgb.size());
+  glPixelStorei(GL_PACK_ALIGNMENT,1);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0,0,WIDTH,HEIGHT,GL_RGB,GL_UNSIGNED_BYTE,rows.data());
+  for (int y=0; y<HEIGHT; ++y)
+    memcpy(&image.rgb[size_t(y)*WIDTH*3],&rows[size_t(HEIGHT-1-y)*WIDTH*3],size_t(WIDTH)*3);
+  return image;
+}
+
+static int run (GLFWwindow* win, const std::string& report_file, const std::string& golden,
+                bool update)
+{
+  BenchReportPtr report = BenchReport::Make();
+  int failures = 0;
+  int missing = 0;
+  if (update) {
+    std::error_code ec;
+    std::filesystem::create_directories(golden,ec);
+  }
+  printf("%d frames of %dx%d at %.4f s steps\n",FRAMES,WIDTH,HEIGHT,DT);
+  printf("%-12s %10s %10s %10s %10s %9s %9s %8s\n","scene","update","render","frame","p95",
+         "mean dE","bad (%)","image");
+  for (const char* name : CASES) {
+    Case* c = MakeCase(name);
+    glViewport(0,0,WIDTH,HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    float t = 0.0f;
+    for (int f=0; f<WARMUP; ++f) {
+      c->Update(DT,t);
+      c->Draw();
+      t += DT;
+    }
+    // the timed frames restart the animation: the last one is deterministic
+    delete c;
+    ResourceManager::ResetStats();
+    c = MakeCase(name);
+    StreamBufferPtr stream = State::GetDrawStream();
+    stream->ResetStats();
+    t = 0.0f;
+    std::vector<double> frames(FRAMES);
+    double update = 0.0, render = 0.0;
+    glFinish();
+    for (int f=0; f<FRAMES; ++f) {
+      auto t0 = std::chrono::steady_clock::now();
+      c->Update(DT,t);
+      double u = Elapsed(t0);
+      c->Draw();
+      double r = Elapsed(t0) - u;
+      glFinish();
+      frames[f] = Elapsed(t0);
+      update += u;
+      render += r;
+      t += DT;
+      if (f < FRAMES-1)
+        glfwSwapBuffers(win);
+    }
+    ImageDiff::Pixels image = ReadBack();
+    glfwSwapBuffers(win);
+    c->Report(report,name);
+    delete c;
+
+    std::vector<double> sorted = frames;
+    std::sort(sorted.begin(),sorted.end());
+    double mean = 0.0;
+    for (double ms : frames)
+      mean += ms;
+    mean /= FRAMES;
+    report->Set(name,"update_ms",update/FRAMES);
+    report->Set(name,"render_ms",render/FRAMES);
+    report->Set(name,"frame_ms",mean);
+    report->Set(name,"frame_p50_ms",sorted[FRAMES/2]);
+    report->Set(name,"frame_p95_ms",sorted[FRAMES*95/100]);
+    // draw ring waits on the GPU, resources loaded and shared by the scene
+    report->Set(name,"stream_stalls",stream->GetStallCount());
+    report->Set(name,"stream_stall_ms",stream->GetStallTime()/FRAMES);
+    for (int type=0; type<ResourceManager::NTYPES; ++type) {
+      ResourceManager::Stats stats = ResourceManager::GetStats(ResourceManager::TYPE(type));
+      std::string prefix = ResourceManager::GetTypeName(ResourceManager::TYPE(type));
+      report->Set(name,prefix+"_loaded",stats.misses);
+      report->Set(name,prefix+"_shared",stats.hits);
+      report->Set(name,prefix+"_gpu_kb",stats.gpu_bytes/1024.0);
+    }
+
+    std::string file = golden + "/" + name + ".ppm";
+    ImageDiff::Pixels reference;
+    const char* status;
+    ImageDiff::Result diff = {false,0.0,0.0,1.0};
+    if (update) {
+      status = ImageDiff::Write(file,image) ? "updated" : "unwritable";
+      diff = {true,0.0,0.0,0.0};
+    }
+    else if (!ImageDiff::Read(file,reference)) {
+      status = "missing";
+      failures++;
+      missing++;
+    }
+    else {
+      diff = ImageDiff::Compare(reference,image);
+      status = ImageDiff::Pass(diff) ? "ok" : "DIFFERS";
+      if (!ImageDiff::Pass(diff)) {
+        ImageDiff::Write(report_file + "." + name + ".ppm",image);
+        failures++;
+      }
+    }
+    report->Set(name,"image_mean_delta",diff.mean);
+    report->Set(name,"image_max_delta",diff.max);
+    report->Set(name,"image_bad",diff.bad);
+    printf("%-12s %10.3f %10.3f %10.3f %10.3f %9.3f %9.3f %8s\n",name,update/FRAMES,
+           render/FRAMES,mean,sorted[FRAMES*95/100],diff.mean,100.0*diff.bad,status);
+  }
+  if (!report->Save(report_file)) {
+    printf("Could not write %s\n",report_file.c_str());
+    return 1;
+  }
+  printf("report written to %s\n",report_file.c_str());
+  if (missing)
+    printf("%d golden image(s) missing in %s: record them with regress run --update\n",
+           missing,golden.c_str());
+  if (failures > missing)
+    printf("%d scene(s) differ from their golden image (see %s.<scene>.ppm)\n",failures-missing,
+           report_file.c_str());
+  return failures ? 1 : 0;
+}
+
+static int compare (const std::string& base_file, const std::string& current_file,
+                    double threshold)
+{
+  BenchReportPtr base = BenchReport::Load(base_file);
+  BenchReportPtr current = BenchReport::Load(current_file);
+  if (!base || !current) {
+    printf("Could not read %s\n",!base ? base_file.c_str() : current_file.c_str());
+    return 1;
+  }
+  printf("%-12s %-14s %10s %10s %8s\n","scene","metric","base","current","change");
+  for (const auto& scene : base->GetScenes()) {
+    for (const auto& metric : scene.second) {
+      double value;
+      if (metric.first.find("_ms") == std::string::npos ||
+          !current->Get(scene.first,metric.first,value))
+        continue;
+      printf("%-12s %-14s %10.3f %10.3f %+7.1f%%\n",scene.first.c_str(),metric.first.c_str(),
+             metric.second,value,metric.second > 0.0 ? 100.0*(value/metric.second-1.0) : 0.0);
+    }
+  }
+  std::vector<BenchReport::Regression> regressions =
+    BenchReport::Compare(*base,*current,threshold);
+  for (const BenchReport::Regression& r : regressions)
+    printf("REGRESSION %s %s: %.3f -> %.3f ms\n",r.scene.c_str(),r.metric.c_str(),r.base,
+           r.current);
+  printf("%zu regression(s) above %.0f%%\n",regressions.size(),100.0*threshold);
+  return regressions.empty() ? 0 : 1;
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+static int usage ()
+{
+  printf("usage: regress run [report.json] [golden dir] [--update]\n"
+         "       regress compare base.json current.json [threshold]\n"
+         "golden images are per machine: record them first with regress run --update\n");
+  return 1;
+}
+
+int main (int argc, char* argv[])
+{
+  if (argc < 2)
+    return usage();
+  std::string mode = argv[1];
+  if (mode == "compare") {
+    if (argc < 4)
+      return usage();
+    return compare(argv[2],argv[3],argc > 4 ? atof(argv[4]) : 0.1);
+  }
+  if (mode != "run")
+    return usage();
+  std::vector<std::string> args;
+  bool update = false;
+  for (int i=2; i<argc; ++i) {
+    if (strcmp(argv[i],"--update") == 0)
+      update = true;
+    else
+      args.push_back(argv[i]);
+  }
+  std::string report = args.size() > 0 ? args[0] : "regress.json";
+  std::string golden = args.size() > 1 ? args[1] : "golden";
+
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(WIDTH,HEIGHT,"Regression",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  int status = run(win,report,golden,update);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return status;
+}
@@ -0,0 +1,110 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "light.h"
+#include "shader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Shader hot reload check: edits the stages of a program through
+// Shader::Reload as ShaderReloader would, without touching the files, and
+// checks the program swapped in by PollReload holds the edits. The second
+// case edits a stage while the reload of another one is still compiling.
+// Exits with 1 if an edit is lost.
+// usage: reload
+
+static const double TIMEOUT = 10000.0;   // ms
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// poll until the pending program is swapped in (or dropped)
+static bool Swap (ShaderPtr shd)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  bool swapped = false;
+  while (shd->IsReloadPending() && Elapsed(t0) < TIMEOUT) {
+    swapped = shd->PollReload();
+    if (!swapped)
+      std::this_thread::yield();
+  }
+  return swapped;
+}
+
+static bool Check (const char* name, bool ok)
+{
+  printf("%-32s %s\n",name,ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static int run ()
+{
+  ShaderPtr shd = Shader::Make(Light::Make(0.3f,1.0f,0.5f,0.0f,"world"),"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  std::vector<std::string> files = shd->GetSourceFiles();
+  const std::string& vert = files[0];
+  const std::string& frag = files[1];
+  bool ok = true;
+
+  // one stage edited
+  std::string a = shd->GetSource(vert) + "\n// edit 1\n";
+  shd->Reload({{vert,a}});
+  ok = Check("single edit",Swap(shd) && shd->GetSource(vert) == a) && ok;
+
+  // two stages edited back to back: the second reload starts while the
+  // first one compiles, and must keep its edit
+  a = shd->GetSource(vert) + "\n// edit 2\n";
+  std::string b = shd->GetSource(frag) + "\n// edit 2\n";
+  shd->Reload({{vert,a}});
+  shd->Reload({{frag,b}});
+  ok = Check("edit during a pending reload",
+             Swap(shd) && shd->GetSource(vert) == a && shd->GetSource(frag) == b) && ok;
+
+  // the same stage edited twice: the last edit wins
+  a = shd->GetSource(vert) + "\n// edit 3\n";
+  std::string c = a + "\n// edit 4\n";
+  shd->Reload({{vert,a}});
+  shd->Reload({{vert,c}});
+  ok = Check("stage edited twice",Swap(shd) && shd->GetSource(vert) == c) && ok;
+  return ok ? 0 : 1;
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main ()
+{
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(64,64,"Reload",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  int status = run();
+  glfwTerminate();
+  return status;
+}
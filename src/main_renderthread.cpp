@@ -0,0 +1,176 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "camera3d.h"
+#include "commandlist.h"
+#include "cube.h"
+#include "frustum.h"
+#include "light.h"
+#include "material.h"
+#include "node.h"
+#include "renderthread.h"
+#include "shader.h"
+#include "state.h"
+#include "transform.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Render thread benchmark: a grid of groups of boxes (50k by default), the
+// group transforms animated every frame, drawn by traversing the graph on
+// the thread owning the context, then recorded into command lists executed
+// by a RenderThread with 1 to 3 frames in flight. Reports the frame time,
+// the time spent recording and executing a frame, and the latency from
+// submit to present.
+// usage: renderthread [groups] [boxes per group] [frames]
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int NCOLORS = 8;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static void run (GLFWwindow* win, int ngroups, int nboxes, int frames)
+{
+  srand(1);
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+  MaterialPtr materials[NCOLORS];
+  for (int i=0; i<NCOLORS; ++i)
+    materials[i] = Material::Make(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f));
+  CubePtr cube = Cube::Make();
+
+  int side = int(ceilf(sqrtf(float(ngroups))));
+  int bside = int(ceilf(sqrtf(float(nboxes))));
+  float spacing = (bside + 2) * 1.5f;
+  float extent = side * spacing;
+  NodePtr root = Node::Make(shd,std::initializer_list<NodePtr>());
+  root->ReserveNodes(ngroups);
+  std::vector<TransformPtr> spins;
+  for (int g=0; g<ngroups; ++g) {
+    NodePtr group = Node::Make(Transform::Make());
+    group->ReserveNodes(nboxes);
+    for (int b=0; b<nboxes; ++b) {
+      TransformPtr box = Transform::Make();
+      box->Translate((b%bside - bside*0.5f)*1.5f,0.5f,(b/bside - bside*0.5f)*1.5f);
+      box->Scale(0.5f,0.5f,0.5f);
+      group->AddNode(Node::Make(box,{materials[rand()%NCOLORS]},{cube}));
+    }
+    root->AddNode(group);
+    spins.push_back(group->GetTransform());
+  }
+  // the projection must not query GL on the recording thread
+  Camera3DPtr camera = Camera3D::Make(0.0f,extent*0.5f,extent*0.7f);
+  camera->SetAspect(float(WIDTH)/HEIGHT);
+  camera->SetZPlanes(0.1f,4.0f*extent);
+  auto animate = [&](int f) {
+    for (int g=0; g<ngroups; ++g) {
+      spins[g]->LoadIdentity();
+      spins[g]->Translate((g%side - side*0.5f)*spacing,0.0f,(g/side - side*0.5f)*spacing);
+      spins[g]->Rotate(360.0f*f/frames,0.0f,1.0f,0.0f);
+    }
+    float t = 6.28f * f / frames;
+    camera->SetEye(extent*0.7f*sinf(t),extent*0.5f,extent*0.7f*cosf(t));
+  };
+  glViewport(0,0,WIDTH,HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+
+  printf("%d boxes in %d groups, %d frames of %dx%d\n",ngroups*nboxes,ngroups,frames,WIDTH,HEIGHT);
+  printf("%-18s %11s %12s %13s %13s %10s\n","path","frame (ms)","record (ms)","execute (ms)",
+         "latency (ms)","stall (ms)");
+
+  // everything on the context thread
+  auto t0 = std::chrono::steady_clock::now();
+  for (int f=0; f<frames; ++f) {
+    animate(f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    StatePtr st = State::Make(camera);
+    st->SetCullFrustum(Frustum(camera->GetProjMatrix()*camera->GetViewMatrix()));
+    root->Render(st);
+    glfwSwapBuffers(win);
+  }
+  glFinish();
+  printf("%-18s %11.3f %12s %13s %13s %10s\n","single thread",Elapsed(t0)/frames,"-","-","-","-");
+
+  // the render thread takes the context over
+  glfwMakeContextCurrent(nullptr);
+  for (int inflight=1; inflight<=3; ++inflight) {
+    RenderThreadPtr renderer = RenderThread::Make(
+      [win](bool attach) { glfwMakeContextCurrent(attach ? win : nullptr); },
+      [win]() { glfwSwapBuffers(win); },
+      inflight);
+    t0 = std::chrono::steady_clock::now();
+    for (int f=0; f<frames; ++f) {
+      animate(f);
+      CommandListPtr list = renderer->Acquire();
+      list->Begin(camera);
+      list->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      list->Record(root);
+      renderer->Submit(list);
+    }
+    renderer->Post([]() { glFinish(); });
+    renderer->Finish();
+    double frame = Elapsed(t0) / frames;
+    RenderThread::Stats stats = renderer->GetStats();
+    renderer->Stop();
+    char name[32];
+    snprintf(name,sizeof(name),"%d in flight",inflight);
+    printf("%-18s %11.3f %12.3f %13.3f %13.3f %10.3f\n",name,frame,stats.record,stats.execute,
+           stats.latency,stats.stall);
+  }
+  // destroy the GL objects where the context is
+  glfwMakeContextCurrent(win);
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int ngroups = argc > 1 ? atoi(argv[1]) : 200;
+  int nboxes = argc > 2 ? atoi(argv[2]) : 250;
+  int frames = argc > 3 ? atoi(argv[3]) : 100;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(WIDTH,HEIGHT,"Render thread",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  glfwSwapInterval(0);
+  run(win,ngroups,nboxes,frames);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
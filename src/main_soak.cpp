@@ -0,0 +1,181 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "camera3d.h"
+#include "cube.h"
+#include "framebuffer.h"
+#include "glhandle.h"
+#include "light.h"
+#include "material.h"
+#include "mesh.h"
+#include "node.h"
+#include "quad.h"
+#include "resourcemanager.h"
+#include "shader.h"
+#include "sphere.h"
+#include "state.h"
+#include "storagebuffer.h"
+#include "texdepth.h"
+#include "texture.h"
+#include "transform.h"
+#include "triangle.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// GPU object soak test: builds a scene (program, shapes, meshes, textures,
+// a framebuffer and a storage buffer), renders a frame of it offscreen and
+// drops it, over and over (10k times by default). The GL objects alive and
+// their memory estimate (see GLObjects) must come back to the same values
+// after every rebuild; the process resident memory is reported along.
+// The shader stages shared through the resource registry must be released
+// with the last program using them. Exits with 1 if objects leak.
+// usage: soak [iterations]
+
+static const int SIZE = 256;
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// resident set size, in KB (0 if unknown)
+static long Resident ()
+{
+  long pages = 0, resident = 0;
+  FILE* fp = fopen("/proc/self/statm","r");
+  if (!fp)
+    return 0;
+  if (fscanf(fp,"%ld %ld",&pages,&resident) != 2)
+    resident = 0;
+  fclose(fp);
+  return resident * 4;
+}
+
+static void build (int it)
+{
+  LightPtr light = Light::Make(0.3f,1.0f,0.5f,0.0f,"world");
+  ShaderPtr shd = Shader::Make(light,"camera");
+  shd->AttachVertexShader("shaders/indirect/node_vertex.glsl");
+  shd->AttachFragmentShader("shaders/indirect/fragment.glsl");
+  shd->Link();
+
+  // shapes of varying sizes: some shared through the geometry cache
+  MeshPtr mesh = Mesh::Make();
+  std::vector<float> coords;
+  std::vector<unsigned int> indices;
+  for (int i=0; i<64+it%16; ++i) {
+    coords.insert(coords.end(),{float(i%8),float(i/8),0.0f});
+    indices.push_back((unsigned int)i);
+  }
+  mesh->SetCoordBuffer(int(coords.size()),coords.data(),3,0);
+  mesh->SetNormalBuffer(int(coords.size()),coords.data(),3,0);
+  mesh->SetIndexBuffer(int(indices.size())/3*3,indices.data());
+  NodePtr root = Node::Make(shd,{
+    Node::Make(Transform::Make(),{Material::Make(1.0f,0.0f,0.0f)},{Cube::Make()}),
+    Node::Make(Transform::Make(),{Material::Make(0.0f,1.0f,0.0f)},{Sphere::Make(8+it%8,8)}),
+    Node::Make(Transform::Make(),{Material::Make(0.0f,0.0f,1.0f)},{Quad::Make(1+it%4,1)}),
+    Node::Make(Transform::Make(),{Material::Make(1.0f,1.0f,0.0f)},{Triangle::Make(),mesh}),
+  });
+  TexturePtr color = Texture::Make("decal",SIZE,SIZE);
+  TexturePtr texel = Texture::Make("decal",glm::vec3(0.5f,0.5f,0.5f));
+  FramebufferPtr fbo = Framebuffer::Make(TexDepth::Make("shadowMap",SIZE,SIZE),{color});
+  StorageBufferPtr storage = StorageBuffer::Make(4096+it%1024);
+
+  Camera3DPtr camera = Camera3D::Make(0.0f,2.0f,6.0f);
+  camera->SetAspect(1.0f);
+  fbo->Bind();
+  glViewport(0,0,SIZE,SIZE);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  root->Render(State::Make(camera));
+  fbo->Unbind();
+}
+
+static void run (int iterations)
+{
+  glEnable(GL_DEPTH_TEST);
+  glClearColor(1.0f,1.0f,1.0f,1.0f);
+  // the first build creates what lives on (uniform buffers)
+  build(0);
+  glFinish();
+  long live = GLObjects::GetLive();
+  long bytes = GLObjects::GetBytes();
+  long resident = Resident();
+  GLObjects::ResetStats();
+  printf("%d rebuilds: %ld GL objects (%ld KB) alive after the first one\n",iterations,live,
+         bytes/1024);
+  printf("%10s %8s %10s %12s %12s %13s %10s\n","iteration","objects","GL (KB)","created",
+         "deleted","resident (KB)","ms/build");
+  auto t0 = std::chrono::steady_clock::now();
+  int step = iterations >= 10 ? iterations/10 : 1;
+  for (int it=1; it<=iterations; ++it) {
+    build(it);
+    if (it % step == 0 || it == iterations) {
+      glFinish();
+      long created = 0, deleted = 0;
+      for (int k=0; k<GLObjects::NKINDS; ++k) {
+        GLObjects::Stats stats = GLObjects::GetStats(GLObjects::KIND(k));
+        created += stats.created;
+        deleted += stats.deleted;
+      }
+      printf("%10d %8ld %10ld %12ld %12ld %13ld %10.3f\n",it,GLObjects::GetLive(),
+             GLObjects::GetBytes()/1024,created,deleted,Resident(),Elapsed(t0)/step);
+      t0 = std::chrono::steady_clock::now();
+    }
+  }
+  for (int k=0; k<GLObjects::NKINDS; ++k) {
+    GLObjects::Stats stats = GLObjects::GetStats(GLObjects::KIND(k));
+    printf("  %-14s %6ld alive %10ld bytes %10ld created %10ld deleted\n",
+           GLObjects::GetKindName(GLObjects::KIND(k)),stats.live,stats.bytes,stats.created,
+           stats.deleted);
+  }
+  printf("resident memory grew by %ld KB\n",Resident()-resident);
+  ResourceManager::Stats stages = ResourceManager::GetStats(ResourceManager::SHADER);
+  printf("shader stages: %d held, %ld loaded, %ld shared\n",stages.count,stages.misses,
+         stages.hits);
+  if (stages.count != 0) {
+    printf("LEAK: %d shader stages held after their programs were dropped\n",stages.count);
+    exit(1);
+  }
+  if (GLObjects::GetLive() != live || GLObjects::GetBytes() != bytes) {
+    printf("LEAK: %ld objects, %ld bytes more than after the first build\n",
+           GLObjects::GetLive()-live,GLObjects::GetBytes()-bytes);
+    exit(1);
+  }
+}
+
+static void error (int code, const char* msg)
+{
+  printf("GLFW error %d: %s\n", code, msg);
+}
+
+int main (int argc, char* argv[])
+{
+  int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+  glfwSetErrorCallback(error);
+  if (glfwInit() != GLFW_TRUE) {
+    printf("Could not initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+  GLFWwindow* win = glfwCreateWindow(SIZE,SIZE,"Soak",nullptr,nullptr);
+  if (!win) {
+    printf("No OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(win);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    printf("GLAD: could not load OpenGL\n");
+    return 1;
+  }
+  run(iterations);
+  State::ReleaseDrawStream();
+  glfwTerminate();
+  return 0;
+}
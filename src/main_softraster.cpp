@@ -0,0 +1,141 @@
+#include "camera3d.h"
+#include "cube.h"
+#include "jobsystem.h"
+#include "quad.h"
+#include "softrenderer.h"
+#include "sphere.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Software rasterizer benchmark, with no GL context: a floor, a grid of
+// lit boxes and spheres and a row of translucent spheres (blended, no
+// depth writes), drawn by SoftRenderer at several resolutions, with one
+// worker and with all of them. Reports ms per frame, setup and raster
+// times and the fill rate; the last frame can be saved as a PPM.
+// usage: softraster [frames] [image.ppm]
+
+static const int NOBJECTS = 200;
+
+static float Random (float a, float b)
+{
+  return a + (b-a) * float(rand()) / float(RAND_MAX);
+}
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+struct Object {
+  const MeshData* mesh;
+  glm::mat4 model;
+  SoftRenderer::Surface surface;
+};
+
+static SoftRenderer::Surface Color (float r, float g, float b, float opacity=1.0f)
+{
+  SoftRenderer::Surface surface;
+  surface.amb = glm::vec4(r,g,b,1.0f);
+  surface.dif = glm::vec4(r,g,b,1.0f);
+  surface.spe = glm::vec4(1.0f);
+  surface.shi = 32.0f;
+  surface.opacity = opacity;
+  return surface;
+}
+
+static void frame (SoftRendererPtr sr, Camera3DPtr camera, const std::vector<Object>& opaque,
+                   const std::vector<Object>& translucent)
+{
+  sr->Begin(camera);
+  sr->Clear(glm::vec4(1.0f));
+  sr->SetLight(glm::vec4(0.3f,1.0f,0.5f,0.0f),glm::vec4(0.2f),glm::vec4(0.8f),glm::vec4(1.0f));
+  SoftRenderer::DrawState state;
+  state.cull_back = true;
+  for (const Object& obj : opaque)
+    sr->Draw(*obj.mesh,obj.model,obj.surface,state);
+  state.depth_write = false;
+  state.blend = true;
+  for (const Object& obj : translucent)
+    sr->Draw(*obj.mesh,obj.model,obj.surface,state);
+  sr->Finish();
+}
+
+int main (int argc, char* argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : 20;
+  const char* image = argc > 2 ? argv[2] : nullptr;
+  srand(1);
+  MeshData floor = Quad::Geometry(32,32);
+  MeshData cube = Cube::Geometry();
+  MeshData sphere = Sphere::Geometry(32,32);
+  std::vector<Object> opaque, translucent;
+  glm::mat4 model = glm::rotate(glm::mat4(1.0f),glm::radians(-90.0f),glm::vec3(1.0f,0.0f,0.0f));
+  opaque.push_back({&floor,glm::scale(model,glm::vec3(20.0f)),Color(0.8f,0.8f,0.8f)});
+  for (int i=0; i<NOBJECTS; ++i) {
+    glm::vec3 pos(Random(-9.0f,9.0f),0.0f,Random(-9.0f,9.0f));
+    float size = Random(0.2f,0.6f);
+    model = glm::translate(glm::mat4(1.0f),pos + glm::vec3(0.0f,size,0.0f));
+    model = glm::scale(model,glm::vec3(size));
+    opaque.push_back({i%2 ? &cube : &sphere,model,
+                      Color(Random(0.2f,1.0f),Random(0.2f,1.0f),Random(0.2f,1.0f))});
+  }
+  for (int i=0; i<8; ++i) {
+    model = glm::translate(glm::mat4(1.0f),glm::vec3(-7.0f+2.0f*i,1.5f,0.0f));
+    translucent.push_back({&sphere,model,Color(0.3f,0.5f,1.0f,0.4f)});
+  }
+
+  struct Config {
+    int width, height;
+  };
+  Config configs[] = {{320,240},{640,480},{1280,720},{1920,1080}};
+  int nthreads = int(std::thread::hardware_concurrency());
+  JobSystemPtr jobs[] = {JobSystem::Make(1),JobSystem::GetDefault()};
+  printf("%d frames, %zu opaque and %zu translucent objects, %d hardware threads\n",frames,
+         opaque.size(),translucent.size(),nthreads);
+  printf("%-10s %8s %10s %10s %11s %12s %10s %10s\n","size","workers","setup (ms)",
+         "raster (ms)","frame (ms)","triangles","Mfrag/s","Mtri/s");
+  Camera3DPtr camera = Camera3D::Make(0.0f,6.0f,14.0f);
+  camera->SetZPlanes(0.5f,100.0f);
+  SoftRendererPtr last;
+  for (const Config& config : configs) {
+    camera->SetAspect(float(config.width)/config.height);
+    for (int j=0; j<2; ++j) {
+      SoftRendererPtr sr = SoftRenderer::Make(config.width,config.height,jobs[j]);
+      frame(sr,camera,opaque,translucent);    // warm up
+      double setup = 0.0, raster = 0.0;
+      long triangles = 0, fragments = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (int f=0; f<frames; ++f) {
+        float t = 6.28f * f / frames;
+        camera->SetEye(14.0f*sinf(t),6.0f,14.0f*cosf(t));
+        frame(sr,camera,opaque,translucent);
+        const SoftRenderer::Stats& stats = sr->GetStats();
+        setup += stats.setup_time;
+        raster += stats.raster_time;
+        triangles += stats.rasterized;
+        fragments += stats.fragments;
+      }
+      double total = Elapsed(t0);
+      char size[32];
+      snprintf(size,sizeof(size),"%dx%d",config.width,config.height);
+      printf("%-10s %8d %10.2f %11.2f %11.2f %12ld %10.1f %10.2f\n",size,
+             j == 0 ? 1 : nthreads,setup/frames,raster/frames,total/frames,triangles/frames,
+             fragments/(total*1e3),triangles/(total*1e3));
+      last = sr;
+    }
+  }
+  if (image) {
+    if (last->Save(image))
+      printf("last frame saved to %s\n",image);
+    else
+      printf("could not write %s\n",image);
+  }
+  return 0;
+}
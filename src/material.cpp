@@ -1,4 +1,5 @@
 #include "material.h"
+#include "allocation.h"
 #include "shader.h"
 #include "state.h"
 
@@ -6,7 +7,7 @@
 
 MaterialPtr Material::Make (float r, float g, float b, float opacity)
 {
-  return MaterialPtr(new Material(r,g,b,opacity));
+  return Allocation::Make<Material>(r,g,b,opacity);
 }
 
 Material::Material (float r, float g, float b, float opacity)
@@ -14,7 +15,9 @@ Material::Material (float r, float g, float b, float opacity)
   m_dif(r,g,b,1.0f), 
   m_spe(1.0f,1.0f,1.0f,1.0f), 
   m_shi(32.0f),
-  m_opacity(opacity)
+  m_opacity(opacity),
+  m_ubo(nullptr),
+  m_dirty(true)
 {
 }
 Material::~Material ()
@@ -25,12 +28,14 @@ void Material::SetAmbient (float r, float g, float b)
   m_amb[0] = r;
   m_amb[1] = g;
   m_amb[2] = b;
+  m_dirty = true;
 }
 void Material::SetDiffuse (float r, float g, float b)
 {
   m_dif[0] = r;
   m_dif[1] = g;
   m_dif[2] = b;
+  m_dirty = true;
 }
 void Material::SetSpecular (float r, float g, float b)
 {
@@ -38,18 +43,68 @@ void Material::SetSpecular (float r, float g, float b)
   m_spe[1] = g;
   m_spe[2] = b;
   m_spe[3] = 0.0f;
+  m_dirty = true;
 }
 void Material::SetShininess (float shi)
 {
   m_shi = shi;
+  m_dirty = true;
 }
 void Material::SetOpacity (float opacity)
 {
   m_opacity = opacity;
+  m_dirty = true;
+}
+const glm::vec4& Material::GetAmbient () const
+{
+  return m_amb;
+}
+const glm::vec4& Material::GetDiffuse () const
+{
+  return m_dif;
+}
+const glm::vec4& Material::GetSpecular () const
+{
+  return m_spe;
+}
+float Material::GetShininess () const
+{
+  return m_shi;
+}
+float Material::GetOpacity () const
+{
+  return m_opacity;
+}
+size_t Material::AddToHash (size_t h) const
+{
+  h = Hash::Value(h,m_amb);
+  h = Hash::Value(h,m_dif);
+  h = Hash::Value(h,m_spe);
+  h = Hash::Value(h,m_shi);
+  return Hash::Value(h,m_opacity);
 }
 void Material::Load (StatePtr st)
 {
   ShaderPtr shd = st->GetShader();
+  if (shd->HasUniformBlock(UniformBuffer::MATERIAL)) {
+    if (m_dirty) {
+      // std140 layout of MaterialBlock
+      float block[16] = {0.0f};
+      for (int i=0; i<4; ++i) {
+        block[i] = m_amb[i];
+        block[4+i] = m_dif[i];
+        block[8+i] = m_spe[i];
+      }
+      block[12] = m_shi;
+      block[13] = m_opacity;
+      if (!m_ubo)
+        m_ubo = UniformBuffer::Make(sizeof(block));
+      m_ubo->SetData(block,sizeof(block));
+      m_dirty = false;
+    }
+    m_ubo->Bind(UniformBuffer::MATERIAL);
+    return;
+  }
   shd->SetUniform("mamb",m_amb);
   shd->SetUniform("mdif",m_dif);
   shd->SetUniform("mspe",m_spe);
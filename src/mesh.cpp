@@ -1,4 +1,7 @@
 #include "mesh.h"
+#include "allocation.h"
+#include "meshtools.h"
+#include "resourcemanager.h"
 
 #include <glad/glad.h>
 
@@ -9,16 +12,22 @@
 
 MeshPtr Mesh::Make (const std::string& filename)
 {
-  return MeshPtr(new Mesh(filename));
+  return ResourceManager::Get<Mesh>(ResourceManager::MESH,filename,[&filename]() {
+    // on the heap: shared beyond any arena scope
+    MeshPtr mesh(new Mesh(filename));
+    return ResourceManager::Resource{mesh,long(sizeof(Mesh)),mesh->GetBytes()};
+  });
 }
 
 MeshPtr Mesh::Make ()
 {
-  return MeshPtr(new Mesh());
+  return Allocation::Make<Mesh>();
 }
 
 Mesh::Mesh (const std::string& filename)
-: m_nind(0)
+: m_nind(0),
+  m_index(-1),
+  m_bytes(0)
 {
   std::vector<float> coords;
   std::vector<float> normals;
@@ -57,84 +66,128 @@ Mesh::Mesh (const std::string& filename)
     }
   }
   fp.close();
+  if (!coords.empty() && !indices.empty()) {
+    // missing (no N lines) or null normals: smooth, split at creases; the
+    // normals given are kept
+    MeshData data;
+    data.SetAttribute(COORD,coords.data(),int(coords.size()),3);
+    if (normals.size() == coords.size())
+      data.SetAttribute(NORMAL,normals.data(),int(normals.size()),3);
+    data.indices = indices;
+    MeshTools::Complete(data);
+    coords.assign(&data.coords[0].x,&data.coords[0].x+3*data.coords.size());
+    normals.assign(&data.normals[0].x,&data.normals[0].x+3*data.normals.size());
+    indices = data.indices;
+  }
   m_nind = (unsigned int)(indices.size());
 
   // create VAO
-  glGenVertexArrays(1,&m_vao);
+  m_vao.Create();
   SetCoordBuffer(int(coords.size()),coords.data(),3,0);
   SetNormalBuffer(int(normals.size()),normals.data(),3,0);
   SetIndexBuffer(int(indices.size()),indices.data());
 }
 
 Mesh::Mesh () 
+: m_nind(0),
+  m_index(-1),
+  m_bytes(0)
 {
-  glGenVertexArrays(1,&m_vao);
+  m_vao.Create();
 }
 
 Mesh::~Mesh () 
 {
 }
 
+void Mesh::AddAttribute (int loc, int size, const float* data, int ncomp, int stride)
+{
+  glBindVertexArray(m_vao.Get());
+  AddBuffer(GL_ARRAY_BUFFER,long(size*sizeof(float)),data);
+  glVertexAttribPointer(loc,ncomp,GL_FLOAT,GL_FALSE,stride,0);
+  glEnableVertexAttribArray(loc);
+  m_attributes.push_back({loc,int(m_buffers.size())-1,ncomp,stride});
+}
+
+void Mesh::AddBuffer (unsigned int target, long bytes, const void* data)
+{
+  GLBuffer buffer;
+  buffer.Create();
+  glBindBuffer(target,buffer.Get());
+  glBufferData(target,bytes,data,GL_STATIC_DRAW);
+  buffer.SetBytes(bytes);
+  m_buffers.push_back(std::move(buffer));
+  m_bytes += bytes;
+}
+
 void Mesh::SetCoordBuffer (int size, const float* data, int ncomp, int stride)
 {
-  glBindVertexArray(m_vao);
-  // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
-  glBufferData(GL_ARRAY_BUFFER,size*sizeof(float),(void*)data,GL_STATIC_DRAW);
-  glVertexAttribPointer(0,ncomp,GL_FLOAT,GL_FALSE,stride,0);
-  glEnableVertexAttribArray(0);
+  AddAttribute(0,size,data,ncomp,stride);
+  // keep bounds for culling
+  int step = stride ? stride/int(sizeof(float)) : ncomp;
+  m_bounds = BBox();
+  for (int i=0; i+ncomp<=size; i+=step) {
+    glm::vec3 p(0.0f);
+    for (int j=0; j<ncomp && j<3; ++j)
+      p[j] = data[i+j];
+    m_bounds.Extend(p);
+  }
 }
 
 void Mesh::SetNormalBuffer (int size, const float* data, int ncomp, int stride)
 {
-  glBindVertexArray(m_vao);
-  // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
-  glBufferData(GL_ARRAY_BUFFER,size*sizeof(float),(void*)data,GL_STATIC_DRAW);
-  glVertexAttribPointer(1,ncomp,GL_FLOAT,GL_FALSE,stride,0);
-  glEnableVertexAttribArray(1);
+  AddAttribute(1,size,data,ncomp,stride);
 }
 
 void Mesh::SetTangentBuffer (int size, const float* data, int ncomp, int stride)
 {
-  glBindVertexArray(m_vao);
-  // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
-  glBufferData(GL_ARRAY_BUFFER,size*sizeof(float),(void*)data,GL_STATIC_DRAW);
-  glVertexAttribPointer(2,ncomp,GL_FLOAT,GL_FALSE,stride,0);
-  glEnableVertexAttribArray(2);
+  AddAttribute(2,size,data,ncomp,stride);
 }
 
 void Mesh::SetTexCoordBuffer (int size, const float* data, int ncomp, int stride)
 {
-  glBindVertexArray(m_vao);
-  // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
-  glBufferData(GL_ARRAY_BUFFER,size*sizeof(float),(void*)data,GL_STATIC_DRAW);
-  glVertexAttribPointer(3,ncomp,GL_FLOAT,GL_FALSE,stride,0);
-  glEnableVertexAttribArray(3);
+  AddAttribute(3,size,data,ncomp,stride);
 }
 
 void Mesh::SetIndexBuffer (int size, const unsigned int* data)
 {
-  glBindVertexArray(m_vao);
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,id);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,size*sizeof(unsigned int),(void*)data,GL_STATIC_DRAW);
+  glBindVertexArray(m_vao.Get());
+  AddBuffer(GL_ELEMENT_ARRAY_BUFFER,long(size*sizeof(unsigned int)),data);
+  m_index = int(m_buffers.size()) - 1;
   m_nind = size;
 }
 
 void Mesh::Draw (StatePtr )
 {
-  glBindVertexArray(m_vao);
+  glBindVertexArray(m_vao.Get());
   glDrawElements(GL_TRIANGLES,m_nind,GL_UNSIGNED_INT,0);
 }
+
+long Mesh::GetBytes () const
+{
+  return m_bytes;
+}
+
+bool Mesh::GetMeshData (MeshData& data) const
+{
+  data.Clear();
+  for (const Attribute& attrib : m_attributes) {
+    const GLBuffer& buffer = m_buffers[attrib.buffer];
+    std::vector<float> values(buffer.GetBytes()/sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER,buffer.Get());
+    glGetBufferSubData(GL_ARRAY_BUFFER,0,buffer.GetBytes(),values.data());
+    data.SetAttribute(attrib.loc,values.data(),int(values.size()),attrib.ncomp,attrib.stride);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+  if (m_index < 0)
+    return false;
+  std::vector<unsigned int> indices(m_nind);
+  glBindVertexArray(m_vao.Get());
+  glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER,0,m_nind*sizeof(unsigned int),indices.data());
+  return data.SetPrimitives(GL_TRIANGLES,int(m_nind),indices.data());
+}
+
+BBox Mesh::GetBounds () const
+{
+  return m_bounds;
+}
@@ -0,0 +1,138 @@
+#include "meshdata.h"
+#include "shape.h"
+
+#include <glad/glad.h>
+
+#include <utility>
+
+int MeshData::GetVertexCount () const
+{
+  return int(coords.size());
+}
+
+int MeshData::GetTriangleCount () const
+{
+  return int(indices.size()) / 3;
+}
+
+bool MeshData::IsEmpty () const
+{
+  return indices.empty();
+}
+
+void MeshData::Clear ()
+{
+  coords.clear();
+  normals.clear();
+  tangents.clear();
+  texcoords.clear();
+  indices.clear();
+}
+
+void MeshData::SetAttribute (int loc, const float* data, int n, int ncomp, int stride)
+{
+  int step = stride ? stride/int(sizeof(float)) : ncomp;
+  int nverts = n >= ncomp && step > 0 ? (n-ncomp)/step + 1 : 0;
+  auto read = [&](int v, int c) { return c < ncomp ? data[v*step+c] : 0.0f; };
+  if (loc == Shape::TEXCOORD) {
+    texcoords.resize(nverts);
+    for (int v=0; v<nverts; ++v)
+      texcoords[v] = glm::vec2(read(v,0),read(v,1));
+    return;
+  }
+  if (loc == Shape::TANGENT) {
+    tangents.resize(nverts);
+    for (int v=0; v<nverts; ++v)
+      tangents[v] = glm::vec4(read(v,0),read(v,1),read(v,2),ncomp > 3 ? read(v,3) : 1.0f);
+    return;
+  }
+  std::vector<glm::vec3>* target = nullptr;
+  switch (loc) {
+    case Shape::COORD: target = &coords; break;
+    case Shape::NORMAL: target = &normals; break;
+    default: return;
+  }
+  target->resize(nverts);
+  for (int v=0; v<nverts; ++v)
+    (*target)[v] = glm::vec3(read(v,0),read(v,1),read(v,2));
+}
+
+bool MeshData::SetPrimitives (unsigned int mode, int count, const unsigned int* ids)
+{
+  auto id = [ids](int i) { return ids ? ids[i] : (unsigned int)i; };
+  indices.clear();
+  switch (mode) {
+    case GL_TRIANGLES:
+      for (int i=0; i+2<count; i+=3)
+        indices.insert(indices.end(),{id(i),id(i+1),id(i+2)});
+      return true;
+    case GL_TRIANGLE_STRIP:
+      // every other triangle is reversed to keep the strip's winding
+      for (int i=0; i+2<count; ++i) {
+        if (i % 2 == 0)
+          indices.insert(indices.end(),{id(i),id(i+1),id(i+2)});
+        else
+          indices.insert(indices.end(),{id(i+1),id(i),id(i+2)});
+      }
+      return true;
+    case GL_TRIANGLE_FAN:
+      for (int i=1; i+1<count; ++i)
+        indices.insert(indices.end(),{id(0),id(i),id(i+1)});
+      return true;
+  }
+  return false;
+}
+
+void MeshData::Complete (const glm::vec3& normal, const glm::vec3& tangent)
+{
+  size_t n = coords.size();
+  if (normals.size() != n)
+    normals.assign(n,normal);
+  if (tangents.size() != n)
+    tangents.assign(n,glm::vec4(tangent,1.0f));
+  if (texcoords.size() != n)
+    texcoords.assign(n,glm::vec2(0.0f));
+}
+
+void MeshData::Transform (const glm::mat4& mat)
+{
+  glm::mat3 linear(mat);
+  glm::mat3 normal = glm::transpose(glm::inverse(linear));
+  for (glm::vec3& p : coords)
+    p = glm::vec3(mat * glm::vec4(p,1.0f));
+  for (glm::vec3& n : normals)
+    n = glm::normalize(normal * n);
+  float sign = glm::determinant(linear) < 0.0f ? -1.0f : 1.0f;
+  for (glm::vec4& t : tangents)
+    t = glm::vec4(glm::normalize(linear * glm::vec3(t)),sign * t.w);
+  if (sign < 0.0f)
+    for (size_t i=0; i+2<indices.size(); i+=3)
+      std::swap(indices[i+1],indices[i+2]);
+}
+
+void MeshData::Append (const MeshData& data)
+{
+  unsigned int base = (unsigned int)coords.size();
+  coords.insert(coords.end(),data.coords.begin(),data.coords.end());
+  normals.insert(normals.end(),data.normals.begin(),data.normals.end());
+  tangents.insert(tangents.end(),data.tangents.begin(),data.tangents.end());
+  texcoords.insert(texcoords.end(),data.texcoords.begin(),data.texcoords.end());
+  indices.reserve(indices.size()+data.indices.size());
+  for (unsigned int i : data.indices)
+    indices.push_back(base+i);
+}
+
+BBox MeshData::GetBounds () const
+{
+  BBox box;
+  for (const glm::vec3& p : coords)
+    box.Extend(p);
+  return box;
+}
+
+long MeshData::GetBytes () const
+{
+  return long(coords.size()*sizeof(glm::vec3) + normals.size()*sizeof(glm::vec3) +
+              tangents.size()*sizeof(glm::vec4) + texcoords.size()*sizeof(glm::vec2) +
+              indices.size()*sizeof(unsigned int));
+}
@@ -0,0 +1,287 @@
+#include "meshtools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace {
+
+const int GRAIN = 4096;
+
+float CornerAngle (const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+{
+  glm::vec3 u = a - p;
+  glm::vec3 v = b - p;
+  float lu = glm::length(u), lv = glm::length(v);
+  if (lu == 0.0f || lv == 0.0f)
+    return 0.0f;
+  return acosf(std::max(-1.0f,std::min(1.0f,glm::dot(u,v)/(lu*lv))));
+}
+
+// v normalized, or fallback if v is null
+glm::vec3 Direction (const glm::vec3& v, const glm::vec3& fallback)
+{
+  float len = glm::length(v);
+  return len > 1e-20f ? v / len : fallback;
+}
+
+// any unit vector orthogonal to n
+glm::vec3 Orthogonal (const glm::vec3& n)
+{
+  glm::vec3 axis = fabsf(n.x) < 0.9f ? glm::vec3(1.0f,0.0f,0.0f) : glm::vec3(0.0f,1.0f,0.0f);
+  return glm::normalize(axis - n * glm::dot(n,axis));
+}
+
+// corners (3*triangle+k) grouped by key, in corner order:
+// corners[start[key]..start[key+1])
+void Group (const std::vector<unsigned int>& keys, int nkeys, std::vector<int>& start,
+            std::vector<int>& corners)
+{
+  start.assign(nkeys+1,0);
+  for (unsigned int key : keys)
+    start[key+1]++;
+  for (int i=0; i<nkeys; ++i)
+    start[i+1] += start[i];
+  corners.resize(keys.size());
+  std::vector<int> next(start.begin(),start.end()-1);
+  for (size_t c=0; c<keys.size(); ++c)
+    corners[next[keys[c]]++] = int(c);
+}
+
+unsigned int CopyVertex (MeshData& mesh, unsigned int v)
+{
+  size_t n = mesh.coords.size();
+  mesh.coords.push_back(mesh.coords[v]);
+  if (mesh.normals.size() == n)
+    mesh.normals.push_back(mesh.normals[v]);
+  if (mesh.tangents.size() == n)
+    mesh.tangents.push_back(mesh.tangents[v]);
+  if (mesh.texcoords.size() == n)
+    mesh.texcoords.push_back(mesh.texcoords[v]);
+  return (unsigned int)n;
+}
+
+// give each set of corners of a vertex that are the same (same(c,d)) a
+// vertex of its own; rep[v]: a corner of each vertex after the split
+void Split (MeshData& mesh, const std::function<bool(int,int)>& same, std::vector<int>& rep)
+{
+  int nv = mesh.GetVertexCount();
+  std::vector<int> start, corners;
+  Group(mesh.indices,nv,start,corners);
+  rep.assign(nv,-1);
+  std::vector<unsigned int> copies;
+  for (int v=0; v<nv; ++v) {
+    copies.clear();
+    for (int i=start[v]; i<start[v+1]; ++i) {
+      int c = corners[i];
+      unsigned int target = 0;
+      bool found = false;
+      for (unsigned int copy : copies)
+        if (same(c,rep[copy])) {
+          target = copy;
+          found = true;
+          break;
+        }
+      if (!found) {
+        target = copies.empty() ? (unsigned int)v : CopyVertex(mesh,v);
+        if (target >= rep.size())
+          rep.resize(target+1,-1);
+        rep[target] = c;
+        copies.push_back(target);
+      }
+      mesh.indices[c] = target;
+    }
+  }
+}
+
+}
+
+void MeshTools::ComputeNormals (MeshData& mesh, float crease_angle, WEIGHT weight,
+                                JobSystemPtr jobs)
+{
+  Normals(mesh,crease_angle,weight,jobs,false);
+}
+
+void MeshTools::FillNormals (MeshData& mesh, float crease_angle, WEIGHT weight, JobSystemPtr jobs)
+{
+  Normals(mesh,crease_angle,weight,jobs,true);
+}
+
+void MeshTools::Normals (MeshData& mesh, float crease_angle, WEIGHT weight, JobSystemPtr jobs,
+                         bool keep)
+{
+  int nv = mesh.GetVertexCount();
+  int nt = mesh.GetTriangleCount();
+  if (nv == 0 || nt == 0)
+    return;
+  if (!jobs)
+    jobs = JobSystem::GetDefault();
+  const std::vector<glm::vec3>& p = mesh.coords;
+  const std::vector<unsigned int>& ids = mesh.indices;
+
+  // unit face normals and corner weights
+  std::vector<glm::vec3> face(nt);
+  std::vector<float> weights(3*size_t(nt));
+  jobs->ParallelFor(0,nt,GRAIN,[&](int b, int e) {
+    for (int t=b; t<e; ++t) {
+      const glm::vec3* v[3] = {&p[ids[3*t]],&p[ids[3*t+1]],&p[ids[3*t+2]]};
+      glm::vec3 n = glm::cross(*v[1]-*v[0],*v[2]-*v[0]);
+      float area = glm::length(n);
+      face[t] = area > 0.0f ? n / area : glm::vec3(0.0f);
+      for (int k=0; k<3; ++k) {
+        float angle = CornerAngle(*v[k],*v[(k+1)%3],*v[(k+2)%3]);
+        weights[3*t+k] = weight == AREA ? area : weight == ANGLE ? angle : angle * area;
+      }
+    }
+  });
+
+  // vertices at the same position, numbered in position order
+  std::vector<unsigned int> order(nv);
+  std::iota(order.begin(),order.end(),0u);
+  std::sort(order.begin(),order.end(),[&p](unsigned int a, unsigned int b) {
+    if (p[a].x != p[b].x) return p[a].x < p[b].x;
+    if (p[a].y != p[b].y) return p[a].y < p[b].y;
+    if (p[a].z != p[b].z) return p[a].z < p[b].z;
+    return a < b;
+  });
+  std::vector<unsigned int> position(nv);
+  int npos = 0;
+  for (int i=0; i<nv; ++i) {
+    if (i > 0 && p[order[i]] != p[order[i-1]])
+      npos++;
+    position[order[i]] = (unsigned int)npos;
+  }
+  npos++;
+  std::vector<unsigned int> keys(ids.size());
+  for (size_t c=0; c<ids.size(); ++c)
+    keys[c] = position[ids[c]];
+  std::vector<int> start, corners;
+  Group(keys,npos,start,corners);
+
+  // normal of each corner, from the faces around its position within the
+  // crease angle of its own face
+  bool smooth = crease_angle >= 180.0f;
+  float cosine = cosf(crease_angle * float(M_PI) / 180.0f);
+  std::vector<glm::vec3> normal(ids.size());
+  jobs->ParallelFor(0,npos,GRAIN/4,[&](int b, int e) {
+    for (int q=b; q<e; ++q) {
+      glm::vec3 all(0.0f);
+      if (smooth)
+        for (int j=start[q]; j<start[q+1]; ++j)
+          all += face[corners[j]/3] * weights[corners[j]];
+      for (int i=start[q]; i<start[q+1]; ++i) {
+        int c = corners[i];
+        const glm::vec3& own = face[c/3];
+        glm::vec3 n = all;
+        if (!smooth) {
+          for (int j=start[q]; j<start[q+1]; ++j) {
+            const glm::vec3& other = face[corners[j]/3];
+            if (glm::dot(own,other) >= cosine)
+              n += other * weights[corners[j]];
+          }
+        }
+        float len = glm::length(n);
+        normal[c] = len > 0.0f ? n / len : own;
+      }
+    }
+  });
+
+  // vertices given a normal keep it on all their corners
+  if (keep && int(mesh.normals.size()) == nv)
+    for (size_t c=0; c<ids.size(); ++c)
+      normal[c] = Direction(mesh.normals[ids[c]],normal[c]);
+
+  // corners of a vertex with different normals get vertices of their own
+  std::vector<int> rep;
+  Split(mesh,[&normal](int a, int b) {
+    return glm::dot(normal[a],normal[b]) >= 0.99999f;
+  },rep);
+  int n = mesh.GetVertexCount();
+  mesh.normals.resize(n);
+  for (int v=0; v<n; ++v)
+    mesh.normals[v] = rep[v] >= 0 ? normal[rep[v]] : glm::vec3(0.0f,0.0f,1.0f);
+}
+
+bool MeshTools::ComputeTangents (MeshData& mesh, JobSystemPtr jobs)
+{
+  int nv = mesh.GetVertexCount();
+  int nt = mesh.GetTriangleCount();
+  if (nv == 0 || nt == 0 || int(mesh.normals.size()) != nv || int(mesh.texcoords.size()) != nv)
+    return false;
+  if (!jobs)
+    jobs = JobSystem::GetDefault();
+  const std::vector<glm::vec3>& p = mesh.coords;
+  const std::vector<glm::vec2>& uv = mesh.texcoords;
+  const std::vector<unsigned int>& ids = mesh.indices;
+
+  // per corner: tangent of the face projected on the vertex normal, times
+  // the corner angle, and the handedness of the mapping
+  std::vector<glm::vec3> tangent(ids.size());
+  std::vector<char> flip(ids.size());
+  jobs->ParallelFor(0,nt,GRAIN,[&](int b, int e) {
+    for (int t=b; t<e; ++t) {
+      unsigned int v[3] = {ids[3*t],ids[3*t+1],ids[3*t+2]};
+      glm::vec3 e1 = p[v[1]] - p[v[0]];
+      glm::vec3 e2 = p[v[2]] - p[v[0]];
+      glm::vec3 fn = Direction(glm::cross(e1,e2),glm::vec3(0.0f,0.0f,1.0f));
+      glm::vec2 d1 = uv[v[1]] - uv[v[0]];
+      glm::vec2 d2 = uv[v[2]] - uv[v[0]];
+      float det = d1.x*d2.y - d2.x*d1.y;
+      glm::vec3 ft(0.0f), fb(0.0f);
+      if (fabsf(det) > 1e-20f) {
+        ft = (e1*d2.y - e2*d1.y) / det;
+        fb = (e2*d1.x - e1*d2.x) / det;
+      }
+      for (int k=0; k<3; ++k) {
+        int c = 3*t+k;
+        glm::vec3 n = Direction(mesh.normals[v[k]],fn);
+        glm::vec3 tk = ft - n * glm::dot(n,ft);
+        float len = glm::length(tk);
+        float angle = CornerAngle(p[v[k]],p[v[(k+1)%3]],p[v[(k+2)%3]]);
+        tangent[c] = len > 0.0f ? tk * (angle / len) : glm::vec3(0.0f);
+        flip[c] = glm::dot(glm::cross(n,tk),fb) < 0.0f;
+      }
+    }
+  });
+
+  // mirrored corners of a vertex get a vertex of their own
+  std::vector<int> rep;
+  Split(mesh,[&flip](int a, int b) {
+    return flip[a] == flip[b];
+  },rep);
+  int n = mesh.GetVertexCount();
+  std::vector<int> start, corners;
+  Group(mesh.indices,n,start,corners);
+  mesh.tangents.resize(n);
+  jobs->ParallelFor(0,n,GRAIN,[&](int b, int e) {
+    for (int v=b; v<e; ++v) {
+      glm::vec3 t(0.0f), area(0.0f);
+      for (int i=start[v]; i<start[v+1]; ++i) {
+        int c = corners[i];
+        t += tangent[c];
+        const unsigned int* f = &mesh.indices[c - c%3];
+        area += glm::cross(p[f[1]]-p[f[0]],p[f[2]]-p[f[0]]);
+      }
+      // a null normal falls back to the faces around the vertex
+      glm::vec3 nrm = Direction(mesh.normals[v],Direction(area,glm::vec3(0.0f,0.0f,1.0f)));
+      t -= nrm * glm::dot(nrm,t);
+      float len = glm::length(t);
+      // the corners of a vertex share their handedness after the split
+      float w = start[v] < start[v+1] && flip[corners[start[v]]] ? -1.0f : 1.0f;
+      mesh.tangents[v] = glm::vec4(len > 1e-12f ? t / len : Orthogonal(nrm),w);
+    }
+  });
+  return true;
+}
+
+void MeshTools::Complete (MeshData& mesh, float crease_angle, JobSystemPtr jobs)
+{
+  bool missing = mesh.normals.size() != mesh.coords.size();
+  for (size_t i=0; !missing && i<mesh.normals.size(); ++i)
+    missing = mesh.normals[i] == glm::vec3(0.0f);
+  if (missing)
+    FillNormals(mesh,crease_angle,ANGLE,jobs);
+  if (mesh.texcoords.size() == mesh.coords.size())
+    ComputeTangents(mesh,jobs);
+}
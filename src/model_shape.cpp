@@ -1,4 +1,5 @@
 #include "model_shape.h"
+#include "allocation.h"
 #include "shape.h"
 #include "error.h"
 #include "grid.h"
@@ -9,7 +10,7 @@
 
 ShapePtr ModelShape::Make (ImportedModel* model)
 {
-  return std::make_shared<ModelShape>(model);
+  return Allocation::Make<ModelShape>(model);
 }
 
 ModelShape::ModelShape (ImportedModel* model) : m_model_ptr(model)
@@ -28,4 +29,9 @@ void ModelShape::Draw (StatePtr )
 {
 
     m_model_ptr->Draw(); 
-}
\ No newline at end of file
+}
+
+BBox ModelShape::GetBounds () const
+{
+  return BBox(m_model_ptr->getBoundsMin(),m_model_ptr->getBoundsMax());
+}
@@ -4,10 +4,16 @@
 #include "shape.h"
 #include "state.h"
 #include "error.h"
+#include "allocation.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glad/glad.h>
+#include <algorithm>
 #include <iostream>
 
+// empty lists, for the factories to forward
+static const std::initializer_list<AppearancePtr> no_apps;
+static const std::initializer_list<ShapePtr> no_shps;
+
 Node::Node (ShaderPtr shader, TransformPtr trf, 
             std::initializer_list<AppearancePtr> apps,
             std::initializer_list<ShapePtr> shps
@@ -17,7 +23,10 @@ Node::Node (ShaderPtr shader, TransformPtr trf,
   m_trf(trf),
   m_apps(apps),
   m_shps(shps),
-  m_nodes()
+  m_nodes(),
+  m_static(false),
+  m_occluder(false),
+  m_features(0)
 {
 }
 NodePtr Node::Make (ShaderPtr shader, 
@@ -27,7 +36,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,trf,apps,shps));
+  NodePtr ptr = Allocation::Make<Node>(shader,trf,apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -38,7 +48,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,trf,apps,{}));
+  NodePtr ptr = Allocation::Make<Node>(shader,trf,apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -48,7 +59,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,trf,{},{}));
+  NodePtr ptr = Allocation::Make<Node>(shader,trf,no_apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -57,7 +69,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,nullptr,{},{}));
+  NodePtr ptr = Allocation::Make<Node>(shader,nullptr,no_apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -68,7 +81,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,nullptr,apps,shps));
+  NodePtr ptr = Allocation::Make<Node>(shader,nullptr,apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -78,7 +92,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,nullptr,apps,{}));
+  NodePtr ptr = Allocation::Make<Node>(shader,nullptr,apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -88,7 +103,8 @@ NodePtr Node::Make (ShaderPtr shader,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,nullptr,{},shps));
+  NodePtr ptr = Allocation::Make<Node>(shader,nullptr,no_apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -98,7 +114,8 @@ NodePtr Node::Make (ShaderPtr shader, TransformPtr trf,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(shader,trf,{},shps));
+  NodePtr ptr = Allocation::Make<Node>(shader,trf,no_apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -109,7 +126,8 @@ NodePtr Node::Make (TransformPtr trf,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,trf,apps,shps));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,trf,apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -119,14 +137,16 @@ NodePtr Node::Make (TransformPtr trf,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,trf,apps,{}));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,trf,apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
 }
 NodePtr Node::Make (std::initializer_list<NodePtr> nodes)
 {
-  NodePtr ptr(new Node(nullptr,nullptr,{},{}));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,nullptr,no_apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -136,7 +156,8 @@ NodePtr Node::Make (std::initializer_list<AppearancePtr> apps,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,nullptr,apps,shps));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,nullptr,apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -145,7 +166,8 @@ NodePtr Node::Make (std::initializer_list<AppearancePtr> apps,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,nullptr,apps,{}));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,nullptr,apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -154,7 +176,8 @@ NodePtr Node::Make (std::initializer_list<ShapePtr> shps,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,nullptr,{},shps));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,nullptr,no_apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -164,7 +187,8 @@ NodePtr Node::Make (TransformPtr trf,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,trf,{},shps));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,trf,no_apps,shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -174,7 +198,8 @@ NodePtr Node::Make (TransformPtr trf,
                     std::initializer_list<NodePtr> nodes
                    )
 {
-  NodePtr ptr(new Node(nullptr,trf,{},{}));
+  NodePtr ptr = Allocation::Make<Node>(nullptr,trf,no_apps,no_shps);
+  ptr->m_nodes.reserve(nodes.size());
   for (auto node : nodes)
     ptr->AddNode(node);
   return ptr;
@@ -205,6 +230,20 @@ void Node::AddNode (NodePtr node)
   m_nodes.push_back(node);
   node->SetParent(shared_from_this());
 }
+void Node::ReplaceNode (NodePtr old, NodePtr node)
+{
+  for (NodePtr& child : m_nodes)
+    if (child == old) {
+      old->SetParent(nullptr);
+      child = node;
+      node->SetParent(shared_from_this());
+      return;
+    }
+}
+void Node::ReserveNodes (int n)
+{
+  m_nodes.reserve(n);
+}
 void Node::SetParent (NodePtr parent)
 {
   m_parent = parent;
@@ -213,6 +252,54 @@ NodePtr Node::GetParent () const
 {
   return m_parent.lock();
 }
+void Node::SetStatic (bool flag)
+{
+  m_static = flag;
+}
+bool Node::IsStatic () const
+{
+  return m_static;
+}
+void Node::SetOccluder (bool flag)
+{
+  m_occluder = flag;
+}
+bool Node::IsOccluder () const
+{
+  return m_occluder;
+}
+void Node::SetFeatures (unsigned int features)
+{
+  m_features = features;
+}
+unsigned int Node::GetFeatures () const
+{
+  return m_features;
+}
+void Node::SortNodes (const std::function<bool(const NodePtr&, const NodePtr&)>& less)
+{
+  std::stable_sort(m_nodes.begin(),m_nodes.end(),less);
+}
+const ShaderPtr& Node::GetShader () const
+{
+  return m_shader;
+}
+const TransformPtr& Node::GetTransform () const
+{
+  return m_trf;
+}
+const Node::Array<AppearancePtr>& Node::GetAppearances () const
+{
+  return m_apps;
+}
+const Node::Array<ShapePtr>& Node::GetShapes () const
+{
+  return m_shps;
+}
+const Node::Array<NodePtr>& Node::GetNodes () const
+{
+  return m_nodes;
+}
 glm::mat4 Node::GetMatrix () const
 {
   return m_trf ? m_trf->GetMatrix() : glm::mat4(1.0f);
@@ -234,18 +321,19 @@ void Node::Render (StatePtr st)
     m_shader->Load(st);
   if (m_trf) 
     m_trf->Load(st);
-  for (AppearancePtr app : m_apps)
+  for (const AppearancePtr& app : m_apps)
     app->Load(st);
   // draw
   if (!m_shps.empty()) {
     st->LoadMatrices();
-    for (ShapePtr shp : m_shps)
-      shp->Draw(st);
+    for (const ShapePtr& shp : m_shps)
+      if (st->IsVisible(shp->GetBounds()))
+        shp->Draw(st);
   }
-  for (NodePtr node : m_nodes)
+  for (const NodePtr& node : m_nodes)
     node->Render(st);
   // unload in reverse order
-  for (AppearancePtr app : m_apps)
+  for (const AppearancePtr& app : m_apps)
     app->Unload(st);
   if (m_trf)
     m_trf->Unload(st);
@@ -253,3 +341,12 @@ void Node::Render (StatePtr st)
     m_shader->Unload(st);
   Error::Check("end node render");
 }
+void Node::Collect (std::vector<RenderItem>& items, const glm::mat4& parent, bool is_static) const
+{
+  glm::mat4 model = m_trf ? parent * m_trf->GetMatrix() : parent;
+  is_static = is_static || m_static;
+  for (const ShapePtr& shp : m_shps)
+    items.push_back({shp,model,shp->GetBounds().Transform(model),is_static});
+  for (const NodePtr& node : m_nodes)
+    node->Collect(items,model,is_static);
+}
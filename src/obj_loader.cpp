@@ -1,4 +1,5 @@
 #include "obj_loader.h"
+#include "meshtools.h"
 
 #include <fstream>
 #include <sstream>
@@ -15,6 +16,7 @@ ImportedModel::ImportedModel(const char* path)
 ImportedModel::~ImportedModel()
 {
     if (EBO) glDeleteBuffers(1, &EBO);
+    if (TBO) glDeleteBuffers(1, &TBO);
     if (VBO) glDeleteBuffers(1, &VBO);
     if (VAO) glDeleteVertexArrays(1, &VAO);
 }
@@ -54,6 +56,7 @@ void ImportedModel::loadOBJ(const char* path)
     std::vector<unsigned int> finalIndices;
 
     std::unordered_map<VertexKey, unsigned int, VertexKeyHash> vertexMap;
+    bool missingNormals = false;
 
     std::string line;
     while (std::getline(file, line)) {
@@ -67,6 +70,12 @@ void ImportedModel::loadOBJ(const char* path)
         if (tag == "v") {
             glm::vec3 p;
             ss >> p.x >> p.y >> p.z;
+            if (positions.empty()) {
+                boundsMin = p;
+                boundsMax = p;
+            }
+            boundsMin = glm::min(boundsMin, p);
+            boundsMax = glm::max(boundsMax, p);
             positions.push_back(p);
         }
         else if (tag == "vt") {
@@ -144,6 +153,8 @@ void ImportedModel::loadOBJ(const char* path)
                     pn = -1;
                 }
 
+                if (pn == -1) missingNormals = true;
+
                 VertexKey key{ pv, pt, pn };
 
                 auto it = vertexMap.find(key);
@@ -183,6 +194,28 @@ void ImportedModel::loadOBJ(const char* path)
         return;
     }
 
+    // corners without vn get smooth normals (split at creases), the
+    // others keep theirs; textured models get tangents
+    std::vector<glm::vec4> tangents;
+    if (missingNormals || !uvs.empty()) {
+        MeshData mesh;
+        for (const VertexData& vd : finalVertices) {
+            mesh.coords.push_back(vd.position);
+            mesh.normals.push_back(vd.normal);
+            mesh.texcoords.push_back(vd.uv);
+        }
+        mesh.indices = finalIndices;
+        if (missingNormals)
+            MeshTools::FillNormals(mesh);
+        if (!uvs.empty())
+            MeshTools::ComputeTangents(mesh);
+        finalVertices.resize(mesh.coords.size());
+        for (size_t i = 0; i < finalVertices.size(); ++i)
+            finalVertices[i] = VertexData{ mesh.coords[i], mesh.texcoords[i], mesh.normals[i] };
+        finalIndices = mesh.indices;
+        tangents = mesh.tangents;
+    }
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -201,7 +234,7 @@ void ImportedModel::loadOBJ(const char* path)
                  finalIndices.data(),
                  GL_STATIC_DRAW);
 
-    // layout: position (0), uv (1), normal (2)
+    // layout: position (0), normal (1), tangent (2), uv (3)
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(
         0, 3, GL_FLOAT, GL_FALSE,
@@ -220,6 +253,18 @@ void ImportedModel::loadOBJ(const char* path)
         sizeof(VertexData),
         (void*)offsetof(VertexData, uv));
 
+    if (!tangents.empty()) {
+        glGenBuffers(1, &TBO);
+        glBindBuffer(GL_ARRAY_BUFFER, TBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     tangents.size() * sizeof(glm::vec4),
+                     tangents.data(),
+                     GL_STATIC_DRAW);
+        glEnableVertexAttribArray(2);
+        // w: handedness of the texture mapping
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    }
+
     glBindVertexArray(0);
 
     if (finalIndices.empty() || finalVertices.empty()) {
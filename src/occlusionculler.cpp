@@ -0,0 +1,320 @@
+#include "occlusionculler.h"
+#include "shape.h"
+#include "transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+OcclusionCullerPtr OcclusionCuller::Make (int width, int height, JobSystemPtr jobs)
+{
+  return OcclusionCullerPtr(new OcclusionCuller(width,height,jobs));
+}
+
+OcclusionCuller::OcclusionCuller (int width, int height, JobSystemPtr jobs)
+: m_width((std::max(4,width) + 3) & ~3),
+  m_height(std::max(1,height)),
+  m_jobs(jobs),
+  m_viewproj(1.0f),
+  m_stats({0,0,0.0,0,0})
+{
+  m_tiles_x = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+  m_tiles_y = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+  m_bins.resize(size_t(m_tiles_x) * m_tiles_y);
+  int w = m_width, h = m_height;
+  m_levels.push_back(std::vector<float>(size_t(w)*h,1.0f));
+  while (w > 1 || h > 1) {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+    m_levels.push_back(std::vector<float>(size_t(w)*h,1.0f));
+  }
+}
+
+OcclusionCuller::~OcclusionCuller ()
+{
+}
+
+int OcclusionCuller::GetWidth () const
+{
+  return m_width;
+}
+
+int OcclusionCuller::GetHeight () const
+{
+  return m_height;
+}
+
+const std::vector<float>& OcclusionCuller::GetDepth (int level) const
+{
+  return m_levels[level];
+}
+
+int OcclusionCuller::GetLevelCount () const
+{
+  return int(m_levels.size());
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::GetStats () const
+{
+  return m_stats;
+}
+
+void OcclusionCuller::ClearCache ()
+{
+  m_meshes.clear();
+}
+
+void OcclusionCuller::Build (CameraPtr camera, NodePtr root)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  m_viewproj = camera->GetProjMatrix() * camera->GetViewMatrix();
+  m_frustum = Frustum(m_viewproj);
+  m_triangles.clear();
+  m_stats.occluders = 0;
+  Collect(root.get(),glm::mat4(1.0f),false);
+  m_stats.triangles = int(m_triangles.size());
+
+  // bin by tile: each tile is then filled by one worker, with no sharing
+  for (std::vector<int>& bin : m_bins)
+    bin.clear();
+  for (int i=0; i<int(m_triangles.size()); ++i) {
+    const Triangle& tri = m_triangles[i];
+    for (int ty=tri.ymin/TILE_SIZE; ty<=tri.ymax/TILE_SIZE; ++ty)
+      for (int tx=tri.xmin/TILE_SIZE; tx<=tri.xmax/TILE_SIZE; ++tx)
+        m_bins[ty*m_tiles_x+tx].push_back(i);
+  }
+  std::fill(m_levels[0].begin(),m_levels[0].end(),1.0f);
+  JobSystemPtr jobs = m_jobs ? m_jobs : JobSystem::GetDefault();
+  jobs->ParallelFor(0,int(m_bins.size()),1,[this](int b, int e) {
+    for (int t=b; t<e; ++t)
+      RasterTile(t);
+  });
+  BuildPyramid();
+
+  m_stats.raster_time = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+  m_stats.tested = 0;
+  m_stats.culled = 0;
+}
+
+void OcclusionCuller::Collect (const Node* node, const glm::mat4& parent, bool occluder)
+{
+  const TransformPtr& trf = node->GetTransform();
+  glm::mat4 model = trf ? parent * trf->GetMatrix() : parent;
+  occluder = occluder || node->IsOccluder();
+  if (occluder) {
+    glm::mat4 mvp = m_viewproj * model;
+    for (const ShapePtr& shp : node->GetShapes()) {
+      BBox bounds = shp->GetBounds();
+      if (!bounds.IsEmpty() && !m_frustum.Intersects(bounds.Transform(model)))
+        continue;
+      auto it = m_meshes.find(shp.get());
+      if (it == m_meshes.end()) {
+        MeshData data;
+        if (!shp->GetMeshData(data))
+          data.Clear();
+        it = m_meshes.emplace(shp.get(),std::move(data)).first;
+      }
+      const MeshData& data = it->second;
+      if (data.IsEmpty())
+        continue;
+      m_stats.occluders++;
+      std::vector<glm::vec4> clip(data.coords.size());
+      for (size_t i=0; i<clip.size(); ++i)
+        clip[i] = mvp * glm::vec4(data.coords[i],1.0f);
+      for (size_t i=0; i+2<data.indices.size(); i+=3) {
+        // clip by the near plane (z >= -w): one or two triangles
+        glm::vec4 in[3] = {clip[data.indices[i]],clip[data.indices[i+1]],clip[data.indices[i+2]]};
+        glm::vec4 out[4];
+        int n = 0;
+        for (int k=0; k<3; ++k) {
+          const glm::vec4& a = in[k];
+          const glm::vec4& b = in[(k+1)%3];
+          float da = a.z + a.w;
+          float db = b.z + b.w;
+          if (da >= 0.0f)
+            out[n++] = a;
+          if ((da >= 0.0f) != (db >= 0.0f))
+            out[n++] = a + (b - a) * (da / (da - db));
+        }
+        for (int k=2; k<n; ++k)
+          AddTriangle(out[0],out[k-1],out[k]);
+      }
+    }
+  }
+  for (const NodePtr& child : node->GetNodes())
+    Collect(child.get(),model,occluder);
+}
+
+void OcclusionCuller::AddTriangle (const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2)
+{
+  const glm::vec4* p[3] = {&p0,&p1,&p2};
+  float x[3], y[3], z[3];
+  for (int k=0; k<3; ++k) {
+    if (p[k]->w <= 1e-6f)
+      return;
+    float inv = 1.0f / p[k]->w;
+    x[k] = (p[k]->x * inv * 0.5f + 0.5f) * m_width;
+    y[k] = (p[k]->y * inv * 0.5f + 0.5f) * m_height;
+    z[k] = p[k]->z * inv * 0.5f + 0.5f;
+  }
+  float area = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+  if (std::fabs(area) < 1e-8f)
+    return;
+  if (area < 0.0f) {    // both faces occlude: make it counterclockwise
+    std::swap(x[1],x[2]);
+    std::swap(y[1],y[2]);
+    std::swap(z[1],z[2]);
+    area = -area;
+  }
+  Triangle tri;
+  tri.xmin = std::max(0,int(std::floor(std::min({x[0],x[1],x[2]}))));
+  tri.ymin = std::max(0,int(std::floor(std::min({y[0],y[1],y[2]}))));
+  tri.xmax = std::min(m_width-1,int(std::ceil(std::max({x[0],x[1],x[2]}))));
+  tri.ymax = std::min(m_height-1,int(std::ceil(std::max({y[0],y[1],y[2]}))));
+  if (tri.xmin > tri.xmax || tri.ymin > tri.ymax)
+    return;
+  for (int k=0; k<3; ++k) {
+    int j = (k+1) % 3;
+    tri.edge[k][0] = y[k] - y[j];
+    tri.edge[k][1] = x[j] - x[k];
+    tri.edge[k][2] = (y[j] - y[k]) * x[k] - (x[j] - x[k]) * y[k];
+  }
+  float dz1 = z[1] - z[0];
+  float dz2 = z[2] - z[0];
+  tri.depth[0] = (dz1*(y[2]-y[0]) - dz2*(y[1]-y[0])) / area;
+  tri.depth[1] = (dz2*(x[1]-x[0]) - dz1*(x[2]-x[0])) / area;
+  tri.depth[2] = z[0] - tri.depth[0]*x[0] - tri.depth[1]*y[0];
+  m_triangles.push_back(tri);
+}
+
+// Fill the pixels of a tile whose centers are inside its triangles with
+// the nearest depth, 4 pixels at a time (the width is a multiple of 4)
+void OcclusionCuller::RasterTile (int tile)
+{
+  int x0 = (tile % m_tiles_x) * TILE_SIZE;
+  int y0 = (tile / m_tiles_x) * TILE_SIZE;
+  int x1 = std::min(m_width,x0+TILE_SIZE) - 1;
+  int y1 = std::min(m_height,y0+TILE_SIZE) - 1;
+  float* depth = m_levels[0].data();
+  for (int i : m_bins[tile]) {
+    const Triangle& tri = m_triangles[i];
+    int xb = std::max(tri.xmin,x0) & ~3;
+    int xe = std::min(tri.xmax,x1);
+    int yb = std::max(tri.ymin,y0);
+    int ye = std::min(tri.ymax,y1);
+#if defined(__SSE2__)
+    const __m128 offset = _mm_setr_ps(0.5f,1.5f,2.5f,3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 ea[3], za = _mm_set1_ps(tri.depth[0]);
+    for (int k=0; k<3; ++k)
+      ea[k] = _mm_set1_ps(tri.edge[k][0]);
+    for (int y=yb; y<=ye; ++y) {
+      float py = y + 0.5f;
+      __m128 erow[3], zrow = _mm_set1_ps(tri.depth[1]*py + tri.depth[2]);
+      for (int k=0; k<3; ++k)
+        erow[k] = _mm_set1_ps(tri.edge[k][1]*py + tri.edge[k][2]);
+      float* row = depth + size_t(y)*m_width;
+      for (int x=xb; x<=xe; x+=4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps(float(x)),offset);
+        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea[0],px),erow[0]),zero);
+        inside = _mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea[1],px),erow[1]),zero));
+        inside = _mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea[2],px),erow[2]),zero));
+        __m128 z = _mm_add_ps(_mm_mul_ps(za,px),zrow);
+        __m128 cur = _mm_loadu_ps(row+x);
+        __m128 nearest = _mm_min_ps(cur,z);
+        _mm_storeu_ps(row+x,_mm_or_ps(_mm_and_ps(inside,nearest),_mm_andnot_ps(inside,cur)));
+      }
+    }
+#else
+    for (int y=yb; y<=ye; ++y) {
+      float py = y + 0.5f;
+      float* row = depth + size_t(y)*m_width;
+      for (int x=xb; x<=xe; x+=4) {
+        for (int l=0; l<4; ++l) {
+          float px = x + l + 0.5f;
+          bool inside = true;
+          for (int k=0; k<3; ++k)
+            inside = inside && tri.edge[k][0]*px + tri.edge[k][1]*py + tri.edge[k][2] >= 0.0f;
+          float z = tri.depth[0]*px + tri.depth[1]*py + tri.depth[2];
+          if (inside && z < row[x+l])
+            row[x+l] = z;
+        }
+      }
+    }
+#endif
+  }
+}
+
+void OcclusionCuller::BuildPyramid ()
+{
+  int w = m_width, h = m_height;
+  for (size_t l=1; l<m_levels.size(); ++l) {
+    const std::vector<float>& src = m_levels[l-1];
+    std::vector<float>& dst = m_levels[l];
+    int dw = (w + 1) / 2, dh = (h + 1) / 2;
+    for (int y=0; y<dh; ++y) {
+      int sy0 = 2*y, sy1 = std::min(2*y+1,h-1);
+      for (int x=0; x<dw; ++x) {
+        int sx0 = 2*x, sx1 = std::min(2*x+1,w-1);
+        dst[size_t(y)*dw+x] = std::max(std::max(src[size_t(sy0)*w+sx0],src[size_t(sy0)*w+sx1]),
+                                       std::max(src[size_t(sy1)*w+sx0],src[size_t(sy1)*w+sx1]));
+      }
+    }
+    w = dw;
+    h = dh;
+  }
+}
+
+bool OcclusionCuller::IsVisible (const BBox& bounds) const
+{
+  m_stats.tested++;
+  if (bounds.IsEmpty())
+    return true;
+  // screen rectangle and nearest depth of the corners
+  const glm::vec3& lo = bounds.GetMin();
+  const glm::vec3& hi = bounds.GetMax();
+  float xmin = 1e30f, ymin = 1e30f, xmax = -1e30f, ymax = -1e30f, zmin = 1e30f;
+  for (int i=0; i<8; ++i) {
+    glm::vec4 p = m_viewproj * glm::vec4(i&1 ? hi.x : lo.x,i&2 ? hi.y : lo.y,i&4 ? hi.z : lo.z,1.0f);
+    if (p.w <= 1e-6f || p.z < -p.w)
+      return true;    // crosses the near plane
+    float inv = 1.0f / p.w;
+    float x = (p.x * inv * 0.5f + 0.5f) * m_width;
+    float y = (p.y * inv * 0.5f + 0.5f) * m_height;
+    xmin = std::min(xmin,x);
+    xmax = std::max(xmax,x);
+    ymin = std::min(ymin,y);
+    ymax = std::max(ymax,y);
+    zmin = std::min(zmin,p.z * inv * 0.5f + 0.5f);
+  }
+  if (xmax < 0.0f || ymax < 0.0f || xmin >= m_width || ymin >= m_height)
+    return true;      // outside the view: left to frustum culling
+  int px0 = std::max(0,int(std::floor(xmin)));
+  int py0 = std::max(0,int(std::floor(ymin)));
+  int px1 = std::min(m_width-1,int(std::floor(xmax)));
+  int py1 = std::min(m_height-1,int(std::floor(ymax)));
+  // level at which the rectangle covers at most 2x2 texels
+  int level = 0;
+  while (level+1 < int(m_levels.size()) &&
+         ((px1 >> level) - (px0 >> level) > 1 || (py1 >> level) - (py0 >> level) > 1))
+    level++;
+  int w = m_width, h = m_height;
+  for (int l=0; l<level; ++l) {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+  const std::vector<float>& depth = m_levels[level];
+  float farthest = 0.0f;
+  for (int y=py0>>level; y<=std::min(py1>>level,h-1); ++y)
+    for (int x=px0>>level; x<=std::min(px1>>level,w-1); ++x)
+      farthest = std::max(farthest,depth[size_t(y)*w+x]);
+  if (zmin > farthest) {
+    m_stats.culled++;
+    return false;
+  }
+  return true;
+}
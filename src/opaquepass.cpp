@@ -0,0 +1,293 @@
+#include "opaquepass.h"
+#include "appearance.h"
+#include "cpuprimitives.h"
+#include "error.h"
+#include "shape.h"
+#include "state.h"
+#include "transform.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+// Switch targets other than recorded states
+static const int NONE = -1;
+static const int DEPTH = -2;
+static const int OVERDRAW = -3;
+
+// Depth buckets of the sort key; the state index takes the low bits
+static const int BUCKET_BITS = 12;
+static const int STATE_BITS = 32 - BUCKET_BITS;
+
+OpaquePassPtr OpaquePass::Make (const std::string& vertex, const std::string& fragment,
+                                const std::string& overdraw)
+{
+  return OpaquePassPtr(new OpaquePass(vertex,fragment,overdraw));
+}
+
+OpaquePass::OpaquePass (const std::string& vertex, const std::string& fragment,
+                        const std::string& overdraw)
+: m_depth(Shader::Make()),
+  m_overdraw(Shader::Make()),
+  m_prepass(true),
+  m_sort(true),
+  m_show_overdraw(false),
+  m_view(1.0f), m_proj(1.0f),
+  m_cull(false),
+  m_camera(nullptr),
+  m_frame(0),
+  m_stats({0,0,0,0,0,0.0f})
+{
+  m_depth->AttachVertexShader(vertex);
+  m_depth->AttachFragmentShader(fragment);
+  m_depth->Link();
+  m_overdraw->AttachVertexShader(vertex);
+  m_overdraw->AttachFragmentShader(overdraw);
+  m_overdraw->Link();
+  for (int i=0; i<2; ++i) {
+    m_queries[i].Create();
+    m_pixels[i] = 0;
+    m_pending[i] = false;
+  }
+}
+
+OpaquePass::~OpaquePass ()
+{
+}
+
+void OpaquePass::SetPrepass (bool flag)
+{
+  m_prepass = flag;
+}
+
+void OpaquePass::SetSort (bool flag)
+{
+  m_sort = flag;
+}
+
+void OpaquePass::SetShowOverdraw (bool flag)
+{
+  m_show_overdraw = flag;
+}
+
+bool OpaquePass::GetPrepass () const
+{
+  return m_prepass;
+}
+
+bool OpaquePass::GetSort () const
+{
+  return m_sort;
+}
+
+bool OpaquePass::GetShowOverdraw () const
+{
+  return m_show_overdraw;
+}
+
+const OpaquePass::Stats& OpaquePass::GetStats () const
+{
+  return m_stats;
+}
+
+void OpaquePass::Begin (CameraPtr camera)
+{
+  m_states.clear();
+  m_state_ids.clear();
+  m_draws.clear();
+  m_matrices.clear();
+  m_camera = camera;
+  m_view = camera->GetViewMatrix();
+  m_proj = camera->GetProjMatrix();
+  m_frustum = Frustum(m_proj * m_view);
+  m_stats.draws = 0;
+  m_stats.culled = 0;
+  m_stats.switches = 0;
+  m_stats.own_depth = 0;
+}
+
+void OpaquePass::Record (NodePtr root, bool cull)
+{
+  m_cull = cull;
+  std::vector<Appearance*> apps;
+  RecordNode(root.get(),glm::mat4(1.0f),nullptr,glm::mat4(1.0f),apps);
+}
+
+void OpaquePass::RecordNode (const Node* node, const glm::mat4& parent, const Node* shader_node,
+                             const glm::mat4& shader_model, std::vector<Appearance*>& apps)
+{
+  glm::mat4 smodel = shader_model;
+  if (node->GetShader()) {
+    shader_node = node;
+    smodel = parent;   // shaders load before the node transform
+  }
+  const TransformPtr& trf = node->GetTransform();
+  glm::mat4 model = trf ? parent * trf->GetMatrix() : parent;
+  size_t napps = apps.size();
+  for (const AppearancePtr& app : node->GetAppearances())
+    apps.push_back(app.get());
+  if (shader_node && !node->GetShapes().empty()) {
+    int state = FindState(shader_node,smodel,apps);
+    glm::mat4 vm = m_view * model;
+    glm::mat4 mvp = m_proj * vm;
+    glm::mat4 mv = m_states[state].shader->GetLightingSpace() == "camera" ? vm : model;
+    glm::mat4 mn = glm::transpose(glm::inverse(mv));
+    int matrix = -1;
+    for (const ShapePtr& shp : node->GetShapes()) {
+      BBox bounds = shp->GetBounds().Transform(model);
+      if (m_cull && !m_frustum.Intersects(bounds)) {
+        m_stats.culled++;
+        continue;
+      }
+      if (matrix < 0) {
+        matrix = int(m_matrices.size());
+        m_matrices.insert(m_matrices.end(),{model,mvp,mv,mn});
+      }
+      glm::vec3 center = bounds.IsEmpty() ? glm::vec3(model[3]) : bounds.GetCenter();
+      float depth = -(m_view * glm::vec4(center,1.0f)).z;
+      m_draws.push_back({shp.get(),state,matrix,depth});
+    }
+  }
+  for (const NodePtr& child : node->GetNodes())
+    RecordNode(child.get(),model,shader_node,smodel,apps);
+  apps.resize(napps);
+}
+
+int OpaquePass::FindState (const Node* shader_node, const glm::mat4& shader_model,
+                           const std::vector<Appearance*>& apps)
+{
+  std::vector<const void*> key = {shader_node};
+  key.insert(key.end(),apps.begin(),apps.end());
+  auto it = m_state_ids.find(key);
+  if (it != m_state_ids.end())
+    return it->second;
+  Shader* shader = shader_node->GetShader().get();
+  bool own = shader->HasStage(GL_GEOMETRY_SHADER) || shader->HasStage(GL_TESS_EVALUATION_SHADER);
+  int id = int(m_states.size());
+  m_states.push_back({shader,int(m_matrices.size()),apps,own});
+  m_matrices.push_back(shader_model);
+  m_state_ids.emplace(std::move(key),id);
+  return id;
+}
+
+// Unload what from loaded, load what to needs; as in Node::Render,
+// appearances load after the shader and unload before it
+void OpaquePass::Switch (const StatePtr& st, int from, int to)
+{
+  if (from == to)
+    return;
+  if (from == DEPTH)
+    m_depth->Unload(st);
+  else if (from == OVERDRAW)
+    m_overdraw->Unload(st);
+  else if (from >= 0) {
+    const DrawState& state = m_states[from];
+    // unload in reverse order
+    for (auto it=state.apps.rbegin(); it!=state.apps.rend(); ++it)
+      (*it)->Unload(st);
+    state.shader->Unload(st);
+  }
+  if (to == DEPTH)
+    m_depth->Load(st);
+  else if (to == OVERDRAW)
+    m_overdraw->Load(st);
+  else if (to >= 0) {
+    const DrawState& state = m_states[to];
+    st->LoadMatrix(m_matrices[state.matrix]);
+    state.shader->Load(st);
+    for (Appearance* app : state.apps)
+      app->Load(st);
+    m_stats.switches++;
+  }
+}
+
+void OpaquePass::DrawItem (const StatePtr& st, const Draw& draw)
+{
+  st->LoadMatrix(m_matrices[draw.matrix]);
+  st->LoadMatrices(m_matrices[draw.matrix+1],m_matrices[draw.matrix+2],
+                   m_matrices[draw.matrix+3]);
+  draw.shape->Draw(st);
+}
+
+void OpaquePass::Execute ()
+{
+  int n = int(m_draws.size());
+  m_stats.draws = n;
+  m_order.resize(n);
+  for (int i=0; i<n; ++i)
+    m_order[i] = (unsigned int)i;
+  if (m_sort && n > 1 && int(m_states.size()) < (1 << STATE_BITS)) {
+    float zmin = m_draws[0].depth, zmax = m_draws[0].depth;
+    for (const Draw& draw : m_draws) {
+      zmin = std::min(zmin,draw.depth);
+      zmax = std::max(zmax,draw.depth);
+    }
+    float scale = zmax > zmin ? ((1 << BUCKET_BITS) - 1) / (zmax - zmin) : 0.0f;
+    m_keys.resize(n);
+    for (int i=0; i<n; ++i) {
+      unsigned int bucket = (unsigned int)((m_draws[i].depth - zmin) * scale);
+      m_keys[i] = (bucket << STATE_BITS) | (unsigned int)m_draws[i].state;
+    }
+    CPUPrimitives::SortPairs(m_keys,m_order);
+  }
+
+  StatePtr st = State::Make(m_camera);
+  int loaded = NONE;
+  if (m_prepass) {
+    glColorMask(GL_FALSE,GL_FALSE,GL_FALSE,GL_FALSE);
+    for (unsigned int i : m_order) {
+      const Draw& draw = m_draws[i];
+      bool own = m_states[draw.state].own_depth;
+      Switch(st,loaded,own ? draw.state : DEPTH);
+      loaded = own ? draw.state : DEPTH;
+      m_stats.own_depth += own ? 1 : 0;
+      DrawItem(st,draw);
+    }
+    glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+  }
+  if (m_show_overdraw) {
+    static const float black[4] = {0.0f,0.0f,0.0f,1.0f};
+    glClearBufferfv(GL_COLOR,0,black);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE,GL_ONE);
+  }
+
+  int slot = m_frame & 1;
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT,viewport);
+  m_pixels[slot] = long(viewport[2]) * viewport[3];
+  glBeginQuery(GL_SAMPLES_PASSED,m_queries[slot].Get());
+  for (unsigned int i : m_order) {
+    const Draw& draw = m_draws[i];
+    int target = m_show_overdraw ? OVERDRAW : draw.state;
+    Switch(st,loaded,target);
+    loaded = target;
+    DrawItem(st,draw);
+  }
+  glEndQuery(GL_SAMPLES_PASSED);
+  Switch(st,loaded,NONE);
+  m_pending[slot] = true;
+
+  if (m_show_overdraw) {
+    glBlendFunc(GL_ONE,GL_ZERO);
+    glDisable(GL_BLEND);
+  }
+  if (m_prepass) {
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+  }
+
+  // the previous frame's count, most likely available by now
+  int prev = slot ^ 1;
+  if (m_pending[prev]) {
+    GLuint samples = 0;
+    glGetQueryObjectuiv(m_queries[prev].Get(),GL_QUERY_RESULT,&samples);
+    m_stats.fragments = long(samples);
+    m_stats.overdraw = m_pixels[prev] > 0 ? float(samples) / m_pixels[prev] : 0.0f;
+    m_pending[prev] = false;
+  }
+  m_frame++;
+  Error::Check("end opaque pass");
+}
@@ -0,0 +1,175 @@
+#include "planarreflection.h"
+#include "frustum.h"
+#include "hash.h"
+#include "shader.h"
+#include "state.h"
+#include "texdepth.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+// programs, lights and appearances of the subtree of node
+static size_t HashState (size_t h, const Node* node, const glm::mat4& view)
+{
+  if (const ShaderPtr& shader = node->GetShader()) {
+    h = Hash::Value(h,shader.get());
+    if (LightPtr light = shader->GetLight()) {
+      h = Hash::Value(h,light->GetWorldPosition(view));
+      h = Hash::Value(h,light->GetAmbient());
+      h = Hash::Value(h,light->GetDiffuse());
+      h = Hash::Value(h,light->GetSpecular());
+    }
+  }
+  for (const AppearancePtr& app : node->GetAppearances())
+    h = app->AddToHash(h);
+  for (const NodePtr& child : node->GetNodes())
+    h = HashState(h,child.get(),view);
+  return h;
+}
+
+static float Sign (float x)
+{
+  return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f);
+}
+
+PlanarReflectionPtr PlanarReflection::Make (NodePtr root, const glm::vec4& plane, float scale,
+                                            const std::string& varname)
+{
+  return PlanarReflectionPtr(new PlanarReflection(root,plane,scale,varname));
+}
+
+PlanarReflection::PlanarReflection (NodePtr root, const glm::vec4& plane, float scale,
+                                    const std::string& varname)
+: m_root(root),
+  m_scale(scale),
+  m_varname(varname),
+  m_width(0), m_height(0),
+  m_color(nullptr),
+  m_fbo(nullptr),
+  m_camera(FixedCamera::Make(glm::mat4(1.0f),glm::mat4(1.0f))),
+  m_hash(0),
+  m_valid(false),
+  m_rendered(0)
+{
+  SetPlane(plane);
+}
+
+PlanarReflection::~PlanarReflection ()
+{
+}
+
+void PlanarReflection::SetPlane (const glm::vec4& plane)
+{
+  m_plane = plane / glm::length(glm::vec3(plane));
+  m_valid = false;
+}
+
+void PlanarReflection::SetScale (float scale)
+{
+  m_scale = scale;
+  m_valid = false;
+}
+
+void PlanarReflection::Invalidate ()
+{
+  m_valid = false;
+}
+
+int PlanarReflection::GetRenderCount () const
+{
+  return m_rendered;
+}
+
+TexturePtr PlanarReflection::GetTexture () const
+{
+  return m_color;
+}
+
+void PlanarReflection::Update (CameraPtr camera)
+{
+  int viewport[4];  // viewport dimension: {x0, y0, w, h}
+  glGetIntegerv(GL_VIEWPORT,viewport);
+  int width = std::max(1,int(viewport[2]*m_scale));
+  int height = std::max(1,int(viewport[3]*m_scale));
+  if (width != m_width || height != m_height) {
+    m_width = width;
+    m_height = height;
+    m_color = Texture::Make(m_varname,m_width,m_height);
+    m_fbo = Framebuffer::Make(TexDepth::Make("depth",m_width,m_height),{m_color});
+    m_valid = false;
+  }
+  glm::mat4 view = camera->GetViewMatrix();
+  glm::mat4 proj = camera->GetProjMatrix();
+
+  // skip the render if neither the camera nor the scene changed: shapes
+  // and their placement, programs, lights and appearances
+  std::vector<RenderItem> items;
+  m_root->Collect(items);
+  size_t h = Hash::Value(Hash::SEED,view);
+  h = Hash::Value(h,proj);
+  for (const RenderItem& item : items) {
+    h = Hash::Value(h,item.shape.get());
+    h = Hash::Value(h,item.model);
+  }
+  h = HashState(h,m_root.get(),view);
+  if (m_valid && h == m_hash)
+    return;
+
+  // mirror about the plane
+  glm::vec3 n(m_plane);
+  glm::mat4 mirror(1.0f);
+  for (int j=0; j<3; ++j)
+    for (int i=0; i<3; ++i)
+      mirror[j][i] -= 2.0f * n[i] * n[j];
+  mirror[3] = glm::vec4(-2.0f * m_plane.w * n,1.0f);
+  glm::mat4 rview = view * mirror;
+
+  // oblique near plane on the mirror: nothing behind it is reflected
+  // (Lengyel, "Oblique View Frustum Depth Projection and Clipping")
+  glm::mat4 rproj = proj;
+  glm::vec4 clip = glm::transpose(glm::inverse(rview)) * (m_plane - glm::vec4(0.0f,0.0f,0.0f,0.001f));
+  if (clip.w < 0.0f) {  // camera is in front of the mirror
+    glm::vec4 q = glm::inverse(proj) * glm::vec4(Sign(clip.x),Sign(clip.y),1.0f,1.0f);
+    glm::vec4 c = clip * (2.0f / glm::dot(clip,q));
+    for (int i=0; i<4; ++i)
+      rproj[i][2] = c[i] - proj[i][3];
+  }
+  m_camera->SetMatrices(rview,rproj);
+
+  GLint fbo;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING,&fbo);
+  m_fbo->Bind();
+  glViewport(0,0,m_width,m_height);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glFrontFace(GL_CW);   // the mirror flips the winding
+  StatePtr st = State::Make(m_camera);
+  st->SetCullFrustum(Frustum(rproj * rview));
+  m_root->Render(st);
+  glFrontFace(GL_CCW);
+  m_fbo->Unbind();
+  glBindFramebuffer(GL_FRAMEBUFFER,fbo);
+  glViewport(viewport[0],viewport[1],viewport[2],viewport[3]);
+  m_hash = h;
+  m_valid = true;
+  m_rendered++;
+}
+
+void PlanarReflection::Load (StatePtr st)
+{
+  if (!m_color)
+    return;
+  ShaderPtr shd = st->GetShader();
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT,viewport);
+  shd->SetUniform("viewport",glm::vec4(float(viewport[0]),float(viewport[1]),
+                                       float(viewport[2]),float(viewport[3])));
+  m_color->Load(st);
+}
+
+void PlanarReflection::Unload (StatePtr st)
+{
+  if (m_color)
+    m_color->Unload(st);
+}
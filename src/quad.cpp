@@ -1,37 +1,33 @@
 #include "quad.h"
+#include "allocation.h"
 #include "error.h"
+#include "geometrycache.h"
 #include "grid.h"
 
-#include <iostream>
+#include <string>
 
 #include <glad/glad.h>
 
 QuadPtr Quad::Make (int nx, int ny)
 {
-  return QuadPtr(new Quad(nx,ny));
+  return Allocation::Make<Quad>(nx,ny);
 }
 
-Quad::Quad (int nx, int ny)
+static VertexArrayPtr Build (int nx, int ny)
 {
   GridPtr grid = Grid::Make(nx,ny);
-  m_nind = grid->IndexCount();
-  // create VAO
-  glGenVertexArrays(1,&m_vao);
-  glBindVertexArray(m_vao);
-  // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
-  glBufferData(GL_ARRAY_BUFFER,2*grid->VertexCount()*sizeof(float),grid->GetCoords(),GL_STATIC_DRAW);
-  glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,0);  // coord
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(3,2,GL_FLOAT,GL_FALSE,0,0);  // texcoord
-  glEnableVertexAttribArray(3);
-  // create index buffer
-  GLuint index;
-  glGenBuffers(1,&index);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,index);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_nind*sizeof(unsigned int),grid->GetIndices(),GL_STATIC_DRAW);
+  VertexArrayPtr array = VertexArray::Make();
+  int coords = array->AddBuffer(2*grid->VertexCount(),grid->GetCoords());
+  array->SetAttribute(Shape::COORD,coords,2);
+  array->SetAttribute(Shape::TEXCOORD,coords,2);
+  array->SetIndices(grid->IndexCount(),grid->GetIndices());
+  return array;
+}
+
+Quad::Quad (int nx, int ny)
+: m_array(GeometryCache::Get("quad/"+std::to_string(nx)+"/"+std::to_string(ny),
+                             [nx,ny]() { return Build(nx,ny); }))
+{
 }
 
 Quad::~Quad () 
@@ -40,8 +36,32 @@ Quad::~Quad ()
 
 void Quad::Draw (StatePtr )
 {
-  glBindVertexArray(m_vao);
   glVertexAttrib3f(1,0.0f,0.0f,1.0f); // constant for all vertices
   glVertexAttrib3f(2,1.0f,0.0f,0.0f); // constant for all vertices
-  glDrawElements(GL_TRIANGLES,m_nind,GL_UNSIGNED_INT,0);
+  m_array->Draw();
+}
+
+BBox Quad::GetBounds () const
+{
+  return BBox(glm::vec3(0.0f,0.0f,0.0f),glm::vec3(1.0f,1.0f,0.0f));
+}
+
+MeshData Quad::Geometry (int nx, int ny)
+{
+  GridPtr grid = Grid::Make(nx,ny);
+  MeshData data;
+  data.SetAttribute(COORD,grid->GetCoords(),2*grid->VertexCount(),2);
+  data.SetAttribute(TEXCOORD,grid->GetCoords(),2*grid->VertexCount(),2);
+  data.SetPrimitives(GL_TRIANGLES,grid->IndexCount(),grid->GetIndices());
+  data.Complete(glm::vec3(0.0f,0.0f,1.0f),glm::vec3(1.0f,0.0f,0.0f));
+  return data;
+}
+
+bool Quad::GetMeshData (MeshData& data) const
+{
+  if (!m_array->Read(data))
+    return false;
+  // normal and tangent are constant (see Draw)
+  data.Complete(glm::vec3(0.0f,0.0f,1.0f),glm::vec3(1.0f,0.0f,0.0f));
+  return true;
 }
@@ -0,0 +1,83 @@
+#include "readback.h"
+
+#include <glad/glad.h>
+
+ReadbackPtr Readback::Make (unsigned int buffer, int offset, int size)
+{
+  return ReadbackPtr(new Readback(buffer,offset,size));
+}
+
+Readback::Readback (unsigned int buffer, int offset, int size)
+: m_size(size),
+  m_fence(nullptr),
+  m_ptr(nullptr),
+  m_ready(false)
+{
+  m_buffer.Create();
+  m_buffer.SetBytes(size);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,m_buffer.Get());
+  if (GLAD_GL_VERSION_4_4) {
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER,size,0,flags);
+    m_ptr = (const unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER,0,size,flags);
+  }
+  else
+    glBufferData(GL_COPY_WRITE_BUFFER,size,0,GL_STREAM_READ);
+  glBindBuffer(GL_COPY_READ_BUFFER,buffer);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER,GL_COPY_WRITE_BUFFER,offset,0,size);
+  glBindBuffer(GL_COPY_READ_BUFFER,0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+  glFlush();  // make sure the fence reaches the GPU, so polling can succeed
+}
+
+Readback::~Readback ()
+{
+  if (m_fence)
+    glDeleteSync((GLsync)m_fence);
+  if (m_ptr) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER,m_buffer.Get());
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  }
+}
+
+int Readback::GetSize () const
+{
+  return m_size;
+}
+
+bool Readback::IsReady ()
+{
+  if (!m_ready && glClientWaitSync((GLsync)m_fence,0,0) != GL_TIMEOUT_EXPIRED)
+    Finish();
+  return m_ready;
+}
+
+void Readback::Wait ()
+{
+  while (!m_ready) {
+    if (glClientWaitSync((GLsync)m_fence,GL_SYNC_FLUSH_COMMANDS_BIT,1000000) != GL_TIMEOUT_EXPIRED)
+      Finish();
+  }
+}
+
+const void* Readback::GetData ()
+{
+  Wait();
+  return m_ptr ? (const void*)m_ptr : (const void*)m_data.data();
+}
+
+void Readback::Finish ()
+{
+  glDeleteSync((GLsync)m_fence);
+  m_fence = nullptr;
+  if (!m_ptr) {
+    // the copy is complete: this does not stall
+    m_data.resize(m_size);
+    glBindBuffer(GL_COPY_READ_BUFFER,m_buffer.Get());
+    glGetBufferSubData(GL_COPY_READ_BUFFER,0,m_size,m_data.data());
+    glBindBuffer(GL_COPY_READ_BUFFER,0);
+  }
+  m_ready = true;
+}
@@ -0,0 +1,150 @@
+#include "renderthread.h"
+
+#include <algorithm>
+
+static double Milliseconds (std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<double,std::milli>(d).count();
+}
+
+RenderThreadPtr RenderThread::Make (std::function<void(bool)> context, std::function<void()> present,
+                                    int frames_in_flight)
+{
+  return RenderThreadPtr(new RenderThread(context,present,frames_in_flight));
+}
+
+RenderThread::RenderThread (std::function<void(bool)> context, std::function<void()> present,
+                            int frames_in_flight)
+: m_context(context),
+  m_present(present),
+  m_frames_in_flight(std::max(1,frames_in_flight)),
+  m_pending(0),
+  m_busy(false),
+  m_stop(false),
+  m_acquired(0)
+{
+  ResetStats();
+  m_thread = std::thread(&RenderThread::Run,this);
+}
+
+RenderThread::~RenderThread ()
+{
+  Stop();
+}
+
+int RenderThread::GetFramesInFlight () const
+{
+  return m_frames_in_flight;
+}
+
+CommandListPtr RenderThread::Acquire ()
+{
+  Clock::time_point t0 = Clock::now();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock,[this]() { return m_pending < m_frames_in_flight; });
+  m_pending++;
+  m_acquired++;
+  m_stats.stall += Milliseconds(Clock::now() - t0);
+  if (m_free.empty())
+    return CommandList::Make();
+  CommandListPtr list = m_free.back();
+  m_free.pop_back();
+  return list;
+}
+
+void RenderThread::Submit (CommandListPtr list)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.record += list->GetRecordTime();
+  m_queue.push_back({list,Clock::now()});
+  m_work.notify_one();
+}
+
+void RenderThread::Post (const std::function<void()>& job)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_jobs.push_back(job);
+  m_work.notify_one();
+}
+
+void RenderThread::Finish ()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock,[this]() { return m_queue.empty() && m_jobs.empty() && !m_busy; });
+}
+
+void RenderThread::Stop ()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop)
+      return;
+    m_stop = true;
+    m_work.notify_one();
+  }
+  m_thread.join();
+}
+
+void RenderThread::Run ()
+{
+  if (m_context)
+    m_context(true);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_work.wait(lock,[this]() { return m_stop || !m_queue.empty() || !m_jobs.empty(); });
+    if (m_queue.empty() && m_jobs.empty())
+      break;   // stopped, with nothing left to run
+    std::vector<std::function<void()>> jobs;
+    jobs.swap(m_jobs);
+    Frame frame = {nullptr,Clock::time_point()};
+    if (!m_queue.empty()) {
+      frame = m_queue.front();
+      m_queue.pop_front();
+    }
+    m_busy = true;
+    lock.unlock();
+    for (const std::function<void()>& job : jobs)
+      job();
+    Clock::time_point t0 = Clock::now();
+    if (frame.list) {
+      frame.list->Execute();
+      if (m_present)
+        m_present();
+    }
+    Clock::time_point t1 = Clock::now();
+    lock.lock();
+    m_busy = false;
+    if (frame.list) {
+      m_free.push_back(frame.list);
+      m_pending--;
+      m_stats.frames++;
+      m_stats.execute += Milliseconds(t1 - t0);
+      m_stats.latency += Milliseconds(t1 - frame.submitted);
+    }
+    m_done.notify_all();
+  }
+  lock.unlock();
+  if (m_context)
+    m_context(false);
+}
+
+RenderThread::Stats RenderThread::GetStats ()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Stats stats = m_stats;
+  if (stats.frames > 0) {
+    stats.record /= stats.frames;
+    stats.execute /= stats.frames;
+    stats.latency /= stats.frames;
+  }
+  if (m_acquired > 0)
+    stats.stall /= m_acquired;
+  return stats;
+}
+
+void RenderThread::ResetStats ()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats = Stats{0,0.0,0.0,0.0,0.0};
+  m_acquired = 0;
+}
@@ -0,0 +1,200 @@
+#include "resourcemanager.h"
+#include "hash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Entry {
+  ResourceManager::TYPE type;
+  ResourceManager::Resource resource;
+  long last_used;
+  std::vector<std::string> keys;   // path and content keys naming it
+  std::weak_ptr<void> handle;      // shared by the users of the resource
+};
+using EntryPtr = std::shared_ptr<Entry>;
+
+struct Registry {
+  std::unordered_map<std::string,EntryPtr> entries;   // by key
+  std::vector<EntryPtr> held;
+  long budget = 0;
+  long clock = 0;
+  ResourceManager::Stats stats[ResourceManager::NTYPES] = {};
+};
+
+}
+
+// never destroyed: resources held at exit may outlive the GL context
+static Registry& GetRegistry ()
+{
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+static std::string ContentKey (ResourceManager::TYPE type, const std::string& content)
+{
+  std::ostringstream key;
+  key << int(type) << "#" << std::hex << Hash::String(content) << ":" << content.size();
+  return key.str();
+}
+
+static std::string PathKey (ResourceManager::TYPE type, const std::string& filename)
+{
+  std::error_code error;
+  std::filesystem::path path = std::filesystem::weakly_canonical(filename,error);
+  return std::to_string(int(type)) + "@" + (error ? filename : path.string());
+}
+
+// pointer handed to the users: it keeps the resource referenced, and the
+// registry trims when the last user drops it
+static std::shared_ptr<void> Handle (const EntryPtr& entry)
+{
+  std::shared_ptr<void> handle = entry->handle.lock();
+  if (handle || !entry->resource.object)
+    return handle ? handle : entry->resource.object;
+  std::shared_ptr<void> object = entry->resource.object;
+  handle = std::shared_ptr<void>(object.get(),[object](void*) mutable {
+    object.reset();
+    ResourceManager::Trim();
+  });
+  entry->handle = handle;
+  return handle;
+}
+
+static std::shared_ptr<void> Use (Registry& reg, const EntryPtr& entry, const std::string& key)
+{
+  entry->last_used = ++reg.clock;
+  if (reg.entries.emplace(key,entry).second)
+    entry->keys.push_back(key);
+  reg.stats[entry->type].hits++;
+  return Handle(entry);
+}
+
+static std::shared_ptr<void> Add (Registry& reg, ResourceManager::TYPE type,
+                                  const std::vector<std::string>& keys,
+                                  const std::function<ResourceManager::Resource()>& load)
+{
+  EntryPtr entry = std::make_shared<Entry>();
+  entry->type = type;
+  entry->resource = load();
+  entry->last_used = ++reg.clock;
+  for (const std::string& key : keys) {
+    reg.entries[key] = entry;
+    entry->keys.push_back(key);
+  }
+  reg.held.push_back(entry);
+  ResourceManager::Stats& stats = reg.stats[type];
+  stats.misses++;
+  stats.cpu_bytes += entry->resource.cpu_bytes;
+  stats.gpu_bytes += entry->resource.gpu_bytes;
+  // the new resource is referenced by the caller: not evicted
+  std::shared_ptr<void> object = Handle(entry);
+  ResourceManager::Trim();
+  return object;
+}
+
+std::shared_ptr<void> ResourceManager::Find (TYPE type, const std::string& filename,
+                                             const std::function<Resource()>& load)
+{
+  Registry& reg = GetRegistry();
+  std::string path_key = PathKey(type,filename);
+  auto it = reg.entries.find(path_key);
+  if (it != reg.entries.end())
+    return Use(reg,it->second,path_key);
+  // same content under another path
+  std::ifstream fp(filename,std::ios::binary);
+  if (!fp)
+    return Add(reg,type,{path_key},load);   // the loader reports the error
+  std::stringstream content;
+  content << fp.rdbuf();
+  std::string content_key = ContentKey(type,content.str());
+  it = reg.entries.find(content_key);
+  if (it != reg.entries.end())
+    return Use(reg,it->second,path_key);
+  return Add(reg,type,{path_key,content_key},load);
+}
+
+std::shared_ptr<void> ResourceManager::FindContent (TYPE type, const std::string& content,
+                                                    const std::function<Resource()>& load)
+{
+  Registry& reg = GetRegistry();
+  std::string key = ContentKey(type,content);
+  auto it = reg.entries.find(key);
+  if (it != reg.entries.end())
+    return Use(reg,it->second,key);
+  return Add(reg,type,{key},load);
+}
+
+void ResourceManager::SetBudget (long bytes)
+{
+  GetRegistry().budget = bytes;
+  Trim();
+}
+
+long ResourceManager::GetBudget ()
+{
+  return GetRegistry().budget;
+}
+
+void ResourceManager::Trim (bool force)
+{
+  Registry& reg = GetRegistry();
+  for (;;) {
+    long gpu = 0;
+    for (int t=0; t<NTYPES; ++t)
+      gpu += reg.stats[t].gpu_bytes;
+    if (!force && reg.budget > 0 && gpu <= reg.budget)
+      return;
+    // least recently used resource held by the registry only
+    int victim = -1;
+    for (int i=0; i<int(reg.held.size()); ++i)
+      if (reg.held[i]->resource.object.use_count() == 1 &&
+          (victim < 0 || reg.held[i]->last_used < reg.held[victim]->last_used))
+        victim = i;
+    if (victim < 0)
+      return;
+    EntryPtr entry = reg.held[victim];
+    reg.held.erase(reg.held.begin()+victim);
+    for (const std::string& key : entry->keys)
+      reg.entries.erase(key);
+    Stats& stats = reg.stats[entry->type];
+    stats.cpu_bytes -= entry->resource.cpu_bytes;
+    stats.gpu_bytes -= entry->resource.gpu_bytes;
+    stats.evictions++;
+  }
+}
+
+ResourceManager::Stats ResourceManager::GetStats (TYPE type)
+{
+  Registry& reg = GetRegistry();
+  Stats stats = reg.stats[type];
+  stats.count = 0;
+  stats.referenced = 0;
+  for (const EntryPtr& entry : reg.held)
+    if (entry->type == type) {
+      stats.count++;
+      if (entry->resource.object.use_count() > 1)
+        stats.referenced++;
+    }
+  return stats;
+}
+
+void ResourceManager::ResetStats ()
+{
+  Registry& reg = GetRegistry();
+  for (int t=0; t<NTYPES; ++t) {
+    reg.stats[t].hits = 0;
+    reg.stats[t].misses = 0;
+    reg.stats[t].evictions = 0;
+  }
+}
+
+const char* ResourceManager::GetTypeName (TYPE type)
+{
+  static const char* names[] = {"mesh","texture","texcube","shader"};
+  return type >= 0 && type < NTYPES ? names[type] : "?";
+}
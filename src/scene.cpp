@@ -3,8 +3,15 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <unordered_map>
+
 Scene::Scene (NodePtr root)
-: m_root(root)
+: m_root(root),
+  m_jobs(nullptr),
+  m_parallel(false),
+  m_graph_dirty(true),
+  m_dt(0.0f)
 {
 }
 
@@ -24,12 +31,84 @@ NodePtr Scene::GetRoot () const
 void Scene::AddEngine (EnginePtr engine)
 {
   m_engines.push_back(engine);
+  m_graph_dirty = true;
+}
+
+void Scene::SetJobSystem (JobSystemPtr jobs)
+{
+  m_jobs = jobs;
+  m_parallel = jobs != nullptr;
+}
+
+// Dependencies from the access sets, in engine order (as a serial update):
+// an access after a write waits for the writer, and a write waits for the
+// reads since the previous write. Engines with no declared set wait for
+// all previous ones, and all next ones wait for them.
+void Scene::BuildGraph () const
+{
+  struct Access {
+    int writer = -1;
+    std::vector<int> readers;
+  };
+  std::unordered_map<const Transform*,Access> access;
+  int barrier = -1;
+  std::vector<int> since_barrier;
+  m_graph.Clear();
+  for (const EnginePtr& e : m_engines) {
+    Engine* engine = e.get();
+    int id = m_graph.Add([this,engine]() { engine->Update(m_dt); });
+    if (!engine->HasAccessSet()) {
+      for (int t : since_barrier)
+        m_graph.Depend(id,t);
+      if (since_barrier.empty() && barrier >= 0)
+        m_graph.Depend(id,barrier);
+      barrier = id;
+      since_barrier.clear();
+      access.clear();
+      continue;
+    }
+    std::vector<int> deps;
+    if (barrier >= 0)
+      deps.push_back(barrier);
+    for (const Transform* trf : engine->GetReads()) {
+      Access& a = access[trf];
+      if (a.writer >= 0)
+        deps.push_back(a.writer);
+    }
+    for (const Transform* trf : engine->GetWrites()) {
+      Access& a = access[trf];
+      if (a.writer >= 0)
+        deps.push_back(a.writer);
+      deps.insert(deps.end(),a.readers.begin(),a.readers.end());
+    }
+    std::sort(deps.begin(),deps.end());
+    deps.erase(std::unique(deps.begin(),deps.end()),deps.end());
+    for (int d : deps)
+      if (d != id)
+        m_graph.Depend(id,d);
+    for (const Transform* trf : engine->GetWrites()) {
+      access[trf].writer = id;
+      access[trf].readers.clear();
+    }
+    for (const Transform* trf : engine->GetReads())
+      access[trf].readers.push_back(id);
+    since_barrier.push_back(id);
+  }
+  m_graph_dirty = false;
 }
 
 void Scene::Update (float dt) const
 {
-  for (auto e : m_engines)
-    e->Update(dt);
+  if (!m_parallel || m_engines.size() < 2) {
+    for (auto e : m_engines)
+      e->Update(dt);
+    return;
+  }
+  JobSystemPtr jobs = m_jobs;
+  if (m_graph_dirty)
+    BuildGraph();
+  m_dt = dt;
+  jobs->Run(m_graph);
 }
 
 void Scene::Render (CameraPtr camera)
@@ -1,13 +1,21 @@
 #include "shader.h"
+#include "resourcemanager.h"
 #include "state.h"
+#include "uniformbuffer.h"
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream> 
 #include <cstdlib>
+#include <cstring>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 
 ShaderPtr Shader::Make (LightPtr light, const std::string& space)
@@ -22,10 +30,11 @@ ShaderPtr Shader::Make (LightPtr light, const std::string& space)
 Shader::Shader (LightPtr light, const std::string& space)
 : m_texunit(0),
   m_light(light),
-  m_space(space)
+  m_space(space),
+  m_blocks(0)
 {
-  m_pid = glCreateProgram();
-  if (m_pid==0) {
+  m_program.Create();
+  if (!m_program) {
     std::cerr << "Could not create shader object";
     exit(1);
   }
@@ -35,34 +44,175 @@ Shader::~Shader ()
 {
 }
 
+void Shader::SetDefines (const std::string& defines)
+{
+  m_defines = defines;
+}
+
+const std::string& Shader::GetDefines () const
+{
+  return m_defines;
+}
+
+void Shader::AttachStage (unsigned int shadertype, const std::string& filename)
+{
+  std::string source = ReadSource(filename);
+  std::string compiled = InsertDefines(source,m_defines);
+  // programs with the same stage source share its compiled object
+  std::shared_ptr<GLShader> object = ResourceManager::GetByContent<GLShader>(
+    ResourceManager::SHADER,std::to_string(shadertype)+"\n"+compiled,[&]() {
+      GLuint sid = CompileSource(shadertype,filename,compiled);
+      if (!CheckShader(sid,filename))
+        exit(1);
+      return ResourceManager::Resource{std::make_shared<GLShader>(sid),long(source.size()),0};
+    });
+  glAttachShader(m_program.Get(),object->Get());
+  m_stages.push_back({shadertype,object->Get(),filename,source,object});
+}
+
 void Shader::AttachVertexShader (const std::string& filename)
 {
-  GLuint sid = CreateShader(GL_VERTEX_SHADER,filename);
-  glAttachShader(m_pid,sid);
+  AttachStage(GL_VERTEX_SHADER,filename);
 }
 void Shader::AttachFragmentShader (const std::string& filename)
 {
-  GLuint sid = CreateShader(GL_FRAGMENT_SHADER,filename);
-  glAttachShader(m_pid,sid);
+  AttachStage(GL_FRAGMENT_SHADER,filename);
 }
 void Shader::AttachGeometryShader (const std::string& filename)
 {
-  GLuint sid = CreateShader(GL_GEOMETRY_SHADER,filename);
-  glAttachShader(m_pid,sid);
+  AttachStage(GL_GEOMETRY_SHADER,filename);
 }
 void Shader::AttachTesselationShader (const std::string& control, const std::string& evaluation)
 {
-  GLuint cid = CreateShader(GL_TESS_CONTROL_SHADER,control);
-  glAttachShader(m_pid,cid);
-  GLuint eid = CreateShader(GL_TESS_EVALUATION_SHADER,evaluation);
-  glAttachShader(m_pid,eid);
+  AttachStage(GL_TESS_CONTROL_SHADER,control);
+  AttachStage(GL_TESS_EVALUATION_SHADER,evaluation);
 }
 
 void Shader::Link ()
 {
-  LinkProgram(m_pid);
+  LinkProgram(m_program.Get());
+  m_uniforms.clear();
+  BindUniformBlocks();
 }  
 
+void Shader::BindUniformBlocks ()
+{
+  m_blocks = 0;
+  for (int binding : {UniformBuffer::FRAME,UniformBuffer::DRAW,UniformBuffer::MATERIAL}) {
+    GLuint index = glGetUniformBlockIndex(m_program.Get(),UniformBuffer::GetBlockName(binding));
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(m_program.Get(),index,binding);
+      m_blocks |= 1u << binding;
+    }
+  }
+}
+
+bool Shader::HasUniformBlock (int binding) const
+{
+  return (m_blocks & (1u << binding)) != 0;
+}
+
+bool Shader::Reload (const std::unordered_map<std::string,std::string>& changed)
+{
+  bool affected = false;
+  for (const Stage& stage : m_stages)
+    if (changed.count(stage.filename))
+      affected = true;
+  if (!affected)
+    return false;
+  // a newer edit builds on the reload still in flight, whose stages hold
+  // edits the watcher will not report again; only changed stages are
+  // recompiled, the others reuse their objects
+  std::vector<Stage> stages = m_pending_program ? m_pending_stages : m_stages;
+  bool ok = true;
+  for (Stage& stage : stages) {
+    auto it = changed.find(stage.filename);
+    if (it != changed.end()) {
+      stage.source = it->second;
+      stage.sid = CompileSource(stage.type,stage.filename,InsertDefines(stage.source,m_defines));
+      stage.object = std::make_shared<GLShader>(stage.sid);
+      ok = ok && stage.sid != 0;
+    }
+  }
+  if (!ok)
+    return false;
+  // the superseded program goes; its stage objects live on in stages
+  m_pending_program.Reset();
+  // compile and link do not block with KHR_parallel_shader_compile
+  m_pending_program.Create();
+  for (const Stage& stage : stages)
+    glAttachShader(m_pending_program.Get(),stage.sid);
+  glLinkProgram(m_pending_program.Get());
+  m_pending_stages = stages;
+  return true;
+}
+
+bool Shader::PollReload ()
+{
+  if (!m_pending_program || IsCompletionPending(m_pending_program.Get()))
+    return false;
+  bool ok = true;
+  for (size_t i=0; i<m_stages.size(); ++i)
+    if (m_pending_stages[i].sid != m_stages[i].sid &&
+        !CheckShader(m_pending_stages[i].sid,m_pending_stages[i].filename))
+      ok = false;
+  ok = ok && CheckProgram(m_pending_program.Get());
+  if (!ok) {
+    std::cerr << "Shader reload failed: keeping the previous program" << std::endl;
+    m_pending_program.Reset();
+  }
+  else {
+    // deleting the old program detaches its stages; replaced ones go away
+    // with it (shared ones with their last user)
+    m_program = std::move(m_pending_program);
+    m_stages = m_pending_stages;
+    m_uniforms.clear();
+    BindUniformBlocks();
+  }
+  m_pending_stages.clear();
+  return ok;
+}
+
+bool Shader::IsReloadPending () const
+{
+  return bool(m_pending_program);
+}
+
+const std::string& Shader::GetSource (const std::string& filename) const
+{
+  static const std::string none;
+  for (const Stage& stage : m_stages)
+    if (stage.filename == filename)
+      return stage.source;
+  return none;
+}
+
+std::vector<std::string> Shader::GetSourceFiles () const
+{
+  std::vector<std::string> files;
+  for (const Stage& stage : m_stages)
+    files.push_back(stage.filename);
+  return files;
+}
+
+bool Shader::HasStage (unsigned int type) const
+{
+  for (const Stage& stage : m_stages)
+    if (stage.type == type)
+      return true;
+  return false;
+}
+
+int Shader::GetUniformLocation (const std::string& varname) const
+{
+  auto it = m_uniforms.find(varname);
+  if (it != m_uniforms.end())
+    return it->second;
+  GLint loc = glGetUniformLocation(m_program.Get(),varname.c_str());
+  m_uniforms[varname] = loc;
+  return loc;
+}
+
 LightPtr Shader::GetLight () const
 {
   return m_light;
@@ -75,67 +225,67 @@ const std::string& Shader::GetLightingSpace () const
 
 void Shader::UseProgram () const
 {
-  glUseProgram(m_pid);
+  glUseProgram(m_program.Get());
 }
 
 
 void Shader::SetUniform (const std::string& varname, int x) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform1i(loc,x);
 }
 
 void Shader::SetUniform (const std::string& varname, float x) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform1f(loc,x);
 }
 
 void Shader::SetUniform (const std::string& varname, const glm::vec3& vet) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform3fv(loc,1,glm::value_ptr(vet));
 }
 
 void Shader::SetUniform (const std::string& varname, const glm::vec4& vet) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform4fv(loc,1,glm::value_ptr(vet));
 }
 
 void Shader::SetUniform (const std::string& varname, const glm::mat4& mat) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniformMatrix4fv(loc,1,GL_FALSE,glm::value_ptr(mat));
 }
 
 void Shader::SetUniform (const std::string& varname, const std::vector<int>& x) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform1iv(loc,GLsizei(x.size()),x.data());
 }
 
 void Shader::SetUniform (const std::string& varname, const std::vector<float>& x) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform1fv(loc,GLsizei(x.size()),x.data());
 }
 
 void Shader::SetUniform (const std::string& varname, const std::vector<glm::vec3>& vet) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform3fv(loc,GLsizei(vet.size()),(float*)vet.data());
 }
 
 void Shader::SetUniform (const std::string& varname, const std::vector<glm::vec4>& vet) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniform4fv(loc,GLsizei(vet.size()),(float*)vet.data());
 }
 
 void Shader::SetUniform (const std::string& varname, const std::vector<glm::mat4>& mat) const
 {
-  GLint loc = glGetUniformLocation(m_pid,varname.c_str());
+  GLint loc = GetUniformLocation(varname);
   glUniformMatrix4fv(loc,GLsizei(mat.size()),GL_FALSE,(float*)mat.data());
 }
 
@@ -178,10 +328,31 @@ static std::string ReadFile (const std::string& filename)
   return strStream.str(); //str holds the content of the file
 }
 
-static void CompileShader (const std::string& filename, GLuint id)
+std::string Shader::ReadSource (const std::string& filename)
+{
+  return ReadFile(filename);
+}
+
+std::string Shader::InsertDefines (const std::string& source, const std::string& defines)
+{
+  if (defines.empty())
+    return source;
+  // #version must stay the first directive
+  size_t pos = source.find("#version");
+  if (pos == std::string::npos)
+    return defines + source;
+  pos = source.find('\n',pos);
+  if (pos == std::string::npos)
+    return source + "\n" + defines;
+  // compile errors keep the line numbers of the file
+  int line = 2 + int(std::count(source.begin(),source.begin()+pos,'\n'));
+  return source.substr(0,pos+1) + defines + "#line " + std::to_string(line) + "\n" +
+         source.substr(pos+1);
+}
+
+bool Shader::CheckShader (unsigned int id, const std::string& filename)
 {
   GLint status;
-  glCompileShader(id);
   glGetShaderiv(id, GL_COMPILE_STATUS, &status);
   if (!status) {
      GLint len;
@@ -190,28 +361,35 @@ static void CompileShader (const std::string& filename, GLuint id)
      glGetShaderInfoLog(id, len, 0, message);
      std::cerr << filename << ":" << std::endl << message << std::endl;
      delete [] message;
-     exit(1);
+     return false;
    }
+  return true;
 }
 
-unsigned int Shader::CreateShader (unsigned int shadertype, const std::string& filename)
+unsigned int Shader::CompileSource (unsigned int shadertype, const std::string& filename, const std::string& source)
 {
   GLuint id = glCreateShader((GLenum)shadertype);
   if (id==0) {
-    std::cerr << "Could not create shader object";
-    exit(1);
+    std::cerr << "Could not create shader object: " << filename << std::endl;
+    return 0;
   }
-  std::string source = ReadFile(filename);
   const char* csource = source.c_str();
   glShaderSource(id, 1, &csource, 0);
-  CompileShader(filename,id);
+  glCompileShader(id);
   return id;
 }
-  
-void Shader::LinkProgram (unsigned int pid)
+
+unsigned int Shader::CreateShader (unsigned int shadertype, const std::string& filename)
+{
+  GLuint id = CompileSource(shadertype,filename,ReadFile(filename));
+  if (id==0 || !CheckShader(id,filename))
+    exit(1);
+  return id;
+}
+
+bool Shader::CheckProgram (unsigned int pid)
 {
   GLint status;
-  glLinkProgram(pid);
   glGetProgramiv(pid, GL_LINK_STATUS, &status);
   if (!status) {
     GLint len;
@@ -220,8 +398,43 @@ void Shader::LinkProgram (unsigned int pid)
     glGetProgramInfoLog(pid, len, 0, message);
     std::cerr << message << std::endl;
     delete [] message;
+    return false;
+  }
+  return true;
+}
+  
+void Shader::LinkProgram (unsigned int pid)
+{
+  glLinkProgram(pid);
+  if (!CheckProgram(pid))
     exit(1);
+}
+
+// KHR/ARB_parallel_shader_compile let the driver compile on its own threads
+static bool HasParallelCompile ()
+{
+  static int supported = -1;
+  if (supported < 0) {
+    supported = 0;
+    GLint n = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS,&n);
+    for (GLint i=0; i<n; ++i) {
+      const char* ext = (const char*)glGetStringi(GL_EXTENSIONS,i);
+      if (ext && (!strcmp(ext,"GL_KHR_parallel_shader_compile") ||
+                  !strcmp(ext,"GL_ARB_parallel_shader_compile")))
+        supported = 1;
+    }
   }
+  return supported == 1;
+}
+
+bool Shader::IsCompletionPending (unsigned int pid)
+{
+  if (!HasParallelCompile())
+    return false;
+  GLint done = GL_TRUE;
+  glGetProgramiv(pid,GL_COMPLETION_STATUS_KHR,&done);
+  return done == GL_FALSE;
 }
 
 ////////////////////////////
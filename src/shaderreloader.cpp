@@ -0,0 +1,63 @@
+#include "shaderreloader.h"
+
+#include <iostream>
+
+ShaderReloaderPtr ShaderReloader::Make ()
+{
+  return ShaderReloaderPtr(new ShaderReloader());
+}
+
+ShaderReloader::ShaderReloader ()
+: m_watcher(FileWatcher::Make())
+{
+}
+
+ShaderReloader::~ShaderReloader ()
+{
+}
+
+void ShaderReloader::AddShader (ShaderPtr shd)
+{
+  m_shaders.push_back(shd);
+  for (const std::string& filename : shd->GetSourceFiles())
+    m_watcher->Watch(filename);
+}
+
+void ShaderReloader::AddComputeShader (ComputeShaderPtr cs)
+{
+  m_computes.push_back(cs);
+  m_watcher->Watch(cs->GetSourceFile());
+}
+
+int ShaderReloader::Update ()
+{
+  auto changed = m_watcher->TakeChanges();
+  for (const auto& file : changed)
+    std::cout << "Reloading shader source: " << file.first << std::endl;
+  int swapped = 0;
+  for (size_t i=0; i<m_shaders.size(); ) {
+    ShaderPtr shd = m_shaders[i].lock();
+    if (!shd) {
+      m_shaders.erase(m_shaders.begin()+i);
+      continue;
+    }
+    if (!changed.empty())
+      shd->Reload(changed);
+    if (shd->PollReload())
+      swapped++;
+    ++i;
+  }
+  for (size_t i=0; i<m_computes.size(); ) {
+    ComputeShaderPtr cs = m_computes[i].lock();
+    if (!cs) {
+      m_computes.erase(m_computes.begin()+i);
+      continue;
+    }
+    if (!changed.empty())
+      cs->Reload(changed);
+    if (cs->PollReload())
+      swapped++;
+    ++i;
+  }
+  return swapped;
+}
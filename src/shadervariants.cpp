@@ -0,0 +1,184 @@
+#include "shadervariants.h"
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+ShaderVariantsPtr ShaderVariants::Make (LightPtr light, const std::string& space)
+{
+  return ShaderVariantsPtr(new ShaderVariants(light,space));
+}
+
+ShaderVariants::ShaderVariants (LightPtr light, const std::string& space)
+: m_light(light),
+  m_space(space)
+{
+}
+
+ShaderVariants::~ShaderVariants ()
+{
+}
+
+unsigned int ShaderVariants::AddFeature (const std::string& name)
+{
+  if (m_features.size() >= 32) {
+    std::cerr << "Too many shader features: " << name << std::endl;
+    exit(1);
+  }
+  m_features.push_back(name);
+  return 1u << (m_features.size()-1);
+}
+
+unsigned int ShaderVariants::GetFeatures (const std::string& names) const
+{
+  unsigned int features = 0;
+  std::istringstream in(names);
+  std::string name;
+  while (in >> name) {
+    size_t i = 0;
+    while (i < m_features.size() && m_features[i] != name)
+      i++;
+    if (i == m_features.size()) {
+      std::cerr << "Unknown shader feature: " << name << std::endl;
+      exit(1);
+    }
+    features |= 1u << i;
+  }
+  return features;
+}
+
+void ShaderVariants::AttachStage (STAGE stage, const std::string& filename, unsigned int features)
+{
+  m_stages.push_back({stage,filename,features});
+}
+
+std::string ShaderVariants::GetDefines (unsigned int features) const
+{
+  std::string defines;
+  for (size_t i=0; i<m_features.size(); ++i)
+    if (features & (1u << i))
+      defines += "#define " + m_features[i] + "\n";
+  return defines;
+}
+
+ShaderPtr ShaderVariants::Get (unsigned int features)
+{
+  auto it = m_programs.find(features);
+  if (it != m_programs.end())
+    return it->second;
+  ShaderPtr shader = Shader::Make(m_light,m_space);
+  shader->SetDefines(GetDefines(features));
+  for (const StageFile& file : m_stages) {
+    if ((features & file.features) != file.features)
+      continue;
+    switch (file.stage) {
+    case VERTEX:
+      shader->AttachVertexShader(file.filename);
+      break;
+    case FRAGMENT:
+      shader->AttachFragmentShader(file.filename);
+      break;
+    case GEOMETRY:
+      shader->AttachGeometryShader(file.filename);
+      break;
+    }
+  }
+  shader->Link();
+  m_programs[features] = shader;
+  return shader;
+}
+
+void ShaderVariants::Precompile (const std::vector<unsigned int>& variants)
+{
+  for (unsigned int features : variants)
+    Get(features);
+}
+
+std::vector<ShaderPtr> ShaderVariants::GetShaders () const
+{
+  std::vector<ShaderPtr> shaders;
+  for (const auto& program : m_programs)
+    shaders.push_back(program.second);
+  return shaders;
+}
+
+bool ShaderVariants::IsVariant (const ShaderPtr& shader) const
+{
+  for (const auto& program : m_programs)
+    if (program.second == shader)
+      return true;
+  return false;
+}
+
+ShaderVariants::Stats ShaderVariants::Apply (NodePtr root, bool group)
+{
+  Stats stats = {0,0,0};
+  Used used;
+  Seen seen;
+  Collect(root.get(),0,used);
+  Assign(root,0,nullptr,used,seen,group,stats);
+  stats.variants = int(m_programs.size());
+  return stats;
+}
+
+// variants drawn in the subtree of node
+const std::set<unsigned int>& ShaderVariants::Collect (const Node* node, unsigned int inherited,
+                                                       Used& used)
+{
+  auto key = std::make_pair(node,inherited);
+  auto it = used.find(key);
+  if (it != used.end())
+    return it->second;       // shared node, already reached with these features
+  std::set<unsigned int>& variants = used[key];
+  if (node->GetShader() && !IsVariant(node->GetShader()))
+    return variants;
+  unsigned int features = inherited | node->GetFeatures();
+  if (!node->GetShapes().empty())
+    variants.insert(features);
+  for (const NodePtr& child : node->GetNodes()) {
+    const std::set<unsigned int>& below = Collect(child.get(),features,used);
+    variants.insert(below.begin(),below.end());
+  }
+  return variants;
+}
+
+void ShaderVariants::Assign (const NodePtr& node, unsigned int inherited, ShaderPtr current,
+                             Used& used, Seen& seen, bool group, Stats& stats)
+{
+  if (node->GetShader() && !IsVariant(node->GetShader()))
+    return;
+  auto it = seen.find(node.get());
+  bool shared = it != seen.end();
+  if (shared && it->second != inherited) {
+    std::cerr << "ShaderVariants: node shared by parents with different features" << std::endl;
+    exit(1);
+  }
+  seen[node.get()] = inherited;
+  stats.nodes++;
+  unsigned int features = inherited | node->GetFeatures();
+  const std::set<unsigned int>& variants = used[std::make_pair(node.get(),inherited)];
+  ShaderPtr shader = current;
+  if (variants.size() == 1)
+    shader = Get(*variants.begin());
+  else if (!node->GetShapes().empty())
+    shader = Get(features);
+  if (shader != current) {
+    node->SetShader(shader);
+    stats.bindings++;
+  }
+  else if (!shared)
+    node->SetShader(nullptr);   // a shared node keeps what another parent needs
+  if (group) {
+    // subtrees of one variant first, by variant; mixed ones last
+    auto key = [&used,features](const NodePtr& child) {
+      const std::set<unsigned int>& below = used[std::make_pair(child.get(),features)];
+      return below.size() == 1 ? *below.begin() : UINT_MAX;
+    };
+    node->SortNodes([&key](const NodePtr& a, const NodePtr& b) {
+      return key(a) < key(b);
+    });
+  }
+  for (const NodePtr& child : node->GetNodes())
+    Assign(child,features,shader,used,seen,group,stats);
+}
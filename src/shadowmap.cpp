@@ -0,0 +1,313 @@
+#include "shadowmap.h"
+#include "fixedcamera.h"
+#include "frustum.h"
+#include "hash.h"
+#include "state.h"
+
+#include <glad/glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ShadowMapPtr ShadowMap::Make (LightPtr light, int size, int ncascades)
+{
+  return ShadowMapPtr(new ShadowMap(light,size,ncascades));
+}
+
+ShadowMap::ShadowMap (LightPtr light, int size, int ncascades)
+: m_light(light),
+  m_size(size),
+  m_ncascades(std::min(std::max(ncascades,1),int(MAX_CASCADES))),
+  m_lambda(0.75f),
+  m_max_distance(100.0f),
+  m_interval{1,1,1,1},
+  m_point_near(0.1f), m_point_far(50.0f),
+  m_frame(0),
+  m_rendered(0),
+  m_point(false),
+  m_point_pos(0.0f),
+  m_depth(nullptr)
+{
+  m_atlas = TexDepth::Make("shadowmap",m_size*m_ncascades,m_size);
+  m_atlas->SetCompareMode();
+  m_atlas_fbo = Framebuffer::Make(m_atlas);
+  m_static_atlas = TexDepth::Make("shadowmap",m_size*m_ncascades,m_size);
+  m_static_atlas_fbo = Framebuffer::Make(m_static_atlas);
+  m_cube = TexDepth::MakeCube("shadowcube",m_size);
+  m_cube->SetCompareMode();
+  m_cube_fbo = Framebuffer::Make(m_cube);
+  m_static_cube = TexDepth::MakeCube("shadowcube",m_size);
+  m_static_cube_fbo = Framebuffer::Make(m_static_cube);
+  for (Slot& slot : m_slots) {
+    slot.viewproj = glm::mat4(1.0f);
+    slot.valid = false;
+  }
+}
+
+ShadowMap::~ShadowMap ()
+{
+}
+
+void ShadowMap::SetSplitLambda (float lambda)
+{
+  m_lambda = lambda;
+}
+
+void ShadowMap::SetMaxDistance (float distance)
+{
+  m_max_distance = distance;
+}
+
+void ShadowMap::SetUpdateInterval (int cascade, int frames)
+{
+  m_interval[cascade] = std::max(frames,1);
+}
+
+void ShadowMap::SetPointRange (float znear, float zfar)
+{
+  m_point_near = znear;
+  m_point_far = zfar;
+  for (Slot& slot : m_slots)
+    slot.valid = false;
+}
+
+void ShadowMap::SetDepthShader (ShaderPtr shader)
+{
+  m_depth = shader;
+}
+
+int ShadowMap::GetRenderedCount () const
+{
+  return m_rendered;
+}
+
+TexDepthPtr ShadowMap::GetAtlas () const
+{
+  return m_atlas;
+}
+
+TexDepthPtr ShadowMap::GetCube () const
+{
+  return m_cube;
+}
+
+void ShadowMap::Update (NodePtr root, CameraPtr camera)
+{
+  if (!m_depth) {
+    m_depth = Shader::Make();
+    m_depth->AttachVertexShader("shaders/shadow/depth_vertex.glsl");
+    m_depth->AttachFragmentShader("shaders/shadow/depth_fragment.glsl");
+    m_depth->Link();
+  }
+  m_frame++;
+  m_rendered = 0;
+  std::vector<RenderItem> items;
+  root->Collect(items);
+  glm::mat4 view = camera->GetViewMatrix();
+  glm::mat4 proj = camera->GetProjMatrix();
+  glm::vec4 lpos = m_light->GetWorldPosition(view);
+
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT,viewport);
+  glEnable(GL_SCISSOR_TEST);
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(2.0f,4.0f);
+  if (lpos.w == 0.0f) {
+    if (m_point) {
+      m_point = false;
+      for (Slot& slot : m_slots)
+        slot.valid = false;
+    }
+    // casters in front of a cascade are clamped, not clipped
+    glEnable(GL_DEPTH_CLAMP);
+    UpdateCascades(items,view,proj,glm::normalize(glm::vec3(lpos)));
+    glDisable(GL_DEPTH_CLAMP);
+  }
+  else {
+    if (!m_point) {
+      m_point = true;
+      for (Slot& slot : m_slots)
+        slot.valid = false;
+    }
+    UpdateCube(items,glm::vec3(lpos)/lpos.w);
+  }
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glDisable(GL_SCISSOR_TEST);
+  m_atlas_fbo->Unbind();
+  glViewport(viewport[0],viewport[1],viewport[2],viewport[3]);
+}
+
+void ShadowMap::UpdateCascades (const std::vector<RenderItem>& items, const glm::mat4& view,
+                                const glm::mat4& proj, const glm::vec3& dir)
+{
+  float n, f;
+  if (proj[2][3] != 0.0f) {
+    n = proj[3][2] / (proj[2][2] - 1.0f);
+    f = proj[3][2] / (proj[2][2] + 1.0f);
+  }
+  else {  // orthographic
+    n = (proj[3][2] + 1.0f) / proj[2][2];
+    f = (proj[3][2] - 1.0f) / proj[2][2];
+  }
+  float maxdist = std::min(f,m_max_distance);
+  // frustum edges (near to far corners) in world space
+  glm::mat4 inv = glm::inverse(proj * view);
+  glm::vec3 corners[8];
+  for (int i=0; i<8; ++i) {
+    glm::vec4 p = inv * glm::vec4(i&1 ? 1.0f : -1.0f,i&2 ? 1.0f : -1.0f,i&4 ? 1.0f : -1.0f,1.0f);
+    corners[i] = glm::vec3(p) / p.w;
+  }
+  glm::vec3 up = std::fabs(dir.y) > 0.99f ? glm::vec3(1.0f,0.0f,0.0f) : glm::vec3(0.0f,1.0f,0.0f);
+  glm::mat4 lview = glm::lookAt(glm::vec3(0.0f),-dir,up);
+  float split = n;
+  for (int c=0; c<m_ncascades; ++c) {
+    float t = float(c+1) / m_ncascades;
+    float next = m_lambda*n*powf(maxdist/n,t) + (1.0f-m_lambda)*(n + (maxdist-n)*t);
+    Slot& slot = m_slots[c];
+    float a = (split - n) / (f - n), b = (next - n) / (f - n);
+    split = next;
+    if (slot.valid && m_frame - slot.last_frame < m_interval[c])
+      continue;
+    // bounding sphere of the slice: its size does not change with the
+    // camera orientation, which keeps the cascade stable
+    glm::vec3 points[8];
+    glm::vec3 center(0.0f);
+    for (int i=0; i<4; ++i) {
+      glm::vec3 edge = corners[i+4] - corners[i];
+      points[2*i+0] = corners[i] + edge*a;
+      points[2*i+1] = corners[i] + edge*b;
+      center += points[2*i+0] + points[2*i+1];
+    }
+    center /= 8.0f;
+    float radius = 0.0f;
+    for (int i=0; i<8; ++i)
+      radius = std::max(radius,glm::distance(points[i],center));
+    radius = ceilf(radius*16.0f) / 16.0f;
+    // snap to texels so that camera motion does not make the edges swim
+    float texel = 2.0f * radius / m_size;
+    glm::vec3 lc = glm::vec3(lview * glm::vec4(center,1.0f));
+    lc = glm::floor(lc / texel) * texel;
+    glm::mat4 lproj = glm::ortho(lc.x-radius,lc.x+radius,lc.y-radius,lc.y+radius,
+                                 -lc.z-radius,-lc.z+radius);
+    if (RenderSlot(slot,lproj*lview,false,items,c*m_size,0,m_atlas_fbo,m_static_atlas_fbo))
+      m_rendered++;
+  }
+}
+
+void ShadowMap::UpdateCube (const std::vector<RenderItem>& items, const glm::vec3& pos)
+{
+  static const glm::vec3 dirs[6] = {
+    {1.0f,0.0f,0.0f}, {-1.0f,0.0f,0.0f},
+    {0.0f,1.0f,0.0f}, {0.0f,-1.0f,0.0f},
+    {0.0f,0.0f,1.0f}, {0.0f,0.0f,-1.0f}
+  };
+  static const glm::vec3 ups[6] = {
+    {0.0f,-1.0f,0.0f}, {0.0f,-1.0f,0.0f},
+    {0.0f,0.0f,1.0f}, {0.0f,0.0f,-1.0f},
+    {0.0f,-1.0f,0.0f}, {0.0f,-1.0f,0.0f}
+  };
+  m_point_pos = pos;
+  glm::mat4 proj = glm::perspective(glm::radians(90.0f),1.0f,m_point_near,m_point_far);
+  for (int i=0; i<6; ++i) {
+    m_cube_fbo->SetDepthFace(i);
+    m_static_cube_fbo->SetDepthFace(i);
+    glm::mat4 viewproj = proj * glm::lookAt(pos,pos+dirs[i],ups[i]);
+    if (RenderSlot(m_slots[i],viewproj,true,items,0,0,m_cube_fbo,m_static_cube_fbo))
+      m_rendered++;
+  }
+}
+
+bool ShadowMap::RenderSlot (Slot& slot, const glm::mat4& viewproj, bool use_near,
+                            const std::vector<RenderItem>& items, int x, int y,
+                            FramebufferPtr fbo, FramebufferPtr static_fbo)
+{
+  Frustum frustum(viewproj,use_near);
+  std::vector<int> statics, dynamics;
+  size_t sh = Hash::Value(Hash::SEED,viewproj);
+  size_t dh = sh;
+  for (int i=0; i<int(items.size()); ++i) {
+    const RenderItem& item = items[i];
+    if (!frustum.Intersects(item.bounds))
+      continue;
+    size_t& h = item.is_static ? sh : dh;
+    const Shape* shape = item.shape.get();
+    h = Hash::Value(h,shape);
+    h = Hash::Value(h,item.model);
+    (item.is_static ? statics : dynamics).push_back(i);
+  }
+  bool redraw_static = !slot.valid || sh != slot.static_hash;
+  if (!redraw_static && dh == slot.dynamic_hash)
+    return false;
+  glViewport(x,y,m_size,m_size);
+  glScissor(x,y,m_size,m_size);
+  if (redraw_static) {
+    static_fbo->Bind();
+    glClear(GL_DEPTH_BUFFER_BIT);
+    DrawItems(items,statics,viewproj);
+  }
+  // start from the cached static casters and add the dynamic ones
+  glBindFramebuffer(GL_READ_FRAMEBUFFER,static_fbo->GetId());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER,fbo->GetId());
+  glBlitFramebuffer(x,y,x+m_size,y+m_size,x,y,x+m_size,y+m_size,GL_DEPTH_BUFFER_BIT,GL_NEAREST);
+  fbo->Bind();
+  DrawItems(items,dynamics,viewproj);
+  slot.viewproj = viewproj;
+  slot.static_hash = sh;
+  slot.dynamic_hash = dh;
+  slot.last_frame = m_frame;
+  slot.valid = true;
+  return true;
+}
+
+void ShadowMap::DrawItems (const std::vector<RenderItem>& items, const std::vector<int>& ids,
+                           const glm::mat4& viewproj)
+{
+  if (ids.empty())
+    return;
+  StatePtr st = State::Make(FixedCamera::Make(glm::mat4(1.0f),viewproj));
+  st->PushShader(m_depth);
+  for (int i : ids) {
+    st->LoadMatrix(items[i].model);
+    st->LoadMatrices();
+    items[i].shape->Draw(st);
+  }
+  st->PopShader();
+}
+
+void ShadowMap::Load (StatePtr st)
+{
+  ShaderPtr shd = st->GetShader();
+  // from the shader lighting space to world space
+  glm::mat4 toworld(1.0f);
+  if (shd->GetLightingSpace() == "camera")
+    toworld = glm::inverse(st->GetViewMatrix());
+  shd->SetUniform("shadow_point",m_point ? 1 : 0);
+  if (m_point) {
+    shd->SetUniform("shadow_toworld",toworld);
+    shd->SetUniform("shadow_lpos",m_point_pos);
+    shd->SetUniform("shadow_range",glm::vec4(m_point_near,m_point_far,0.0f,0.0f));
+  }
+  else {
+    // clip space of each cascade to its region of the atlas
+    std::vector<glm::mat4> mats(m_ncascades);
+    for (int c=0; c<m_ncascades; ++c) {
+      glm::mat4 bias = glm::translate(glm::mat4(1.0f),glm::vec3((c+0.5f)/m_ncascades,0.5f,0.5f));
+      bias = glm::scale(bias,glm::vec3(0.5f/m_ncascades,0.5f,0.5f));
+      mats[c] = bias * m_slots[c].viewproj * toworld;
+    }
+    shd->SetUniform("shadow_mats",mats);
+    shd->SetUniform("shadow_ncascades",m_ncascades);
+  }
+  // both samplers are always bound: different sampler types cannot share a unit
+  m_atlas->Load(st);
+  m_cube->Load(st);
+}
+
+void ShadowMap::Unload (StatePtr st)
+{
+  m_cube->Unload(st);
+  m_atlas->Unload(st);
+}
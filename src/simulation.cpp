@@ -0,0 +1,179 @@
+#include "simulation.h"
+
+#include <algorithm>
+
+static double Milliseconds (std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<double,std::milli>(d).count();
+}
+
+SimulationPtr Simulation::Make (ScenePtr scene, float step)
+{
+  return SimulationPtr(new Simulation(scene,step));
+}
+
+Simulation::Simulation (ScenePtr scene, float step)
+: m_scene(scene),
+  m_step(step),
+  m_max_steps(5),
+  m_store(nullptr),
+  m_prev(nullptr), m_curr(nullptr),
+  m_running(false),
+  m_update_total(0.0), m_render_total(0.0)
+{
+  ResetStats();
+}
+
+Simulation::~Simulation ()
+{
+  Stop();
+}
+
+void Simulation::SetMaxSteps (int n)
+{
+  m_max_steps = std::max(1,n);
+}
+
+float Simulation::GetStep () const
+{
+  return m_step;
+}
+
+void Simulation::Start ()
+{
+  if (m_running)
+    return;
+  // the store draws the scene; its locals are written by Render only
+  m_store = EntityStore::Make(m_scene);
+  ComponentArray<TransformComponent>& trfs = m_store->GetComponents<TransformComponent>();
+  m_sources.resize(trfs.Size());
+  for (int i=0; i<trfs.Size(); ++i) {
+    m_sources[i] = trfs[i].source;
+    trfs[i].source = nullptr;
+  }
+  m_pool.clear();
+  Capture(0);
+  m_prev = m_curr;
+  m_start = Clock::now();
+  m_running = true;
+  m_thread = std::thread(&Simulation::Run,this);
+}
+
+void Simulation::Stop ()
+{
+  if (!m_running)
+    return;
+  m_running = false;
+  m_thread.join();
+}
+
+bool Simulation::IsRunning () const
+{
+  return m_running;
+}
+
+// Copy the transforms into a snapshot no longer seen by Render, and
+// publish it as the current one
+void Simulation::Capture (long step)
+{
+  SnapshotPtr snap = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const SnapshotPtr& s : m_pool)
+      if (s != m_prev && s != m_curr && s.use_count() == 1) {
+        snap = s;
+        break;
+      }
+  }
+  if (!snap) {
+    snap = std::make_shared<Snapshot>();
+    m_pool.push_back(snap);
+  }
+  snap->step = step;
+  snap->matrices.resize(m_sources.size());
+  for (size_t i=0; i<m_sources.size(); ++i)
+    snap->matrices[i] = m_sources[i] ? m_sources[i]->GetMatrix() : glm::mat4(1.0f);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_prev = m_curr;
+  m_curr = snap;
+}
+
+void Simulation::Run ()
+{
+  auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_step));
+  long n = 0;
+  while (m_running) {
+    Clock::time_point now = Clock::now();
+    int count = 0;
+    while (m_start + (n+1)*step <= now && count < m_max_steps) {
+      Clock::time_point t0 = Clock::now();
+      m_scene->Update(m_step);
+      Clock::duration dt = Clock::now() - t0;
+      Capture(++n);
+      count++;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.steps++;
+      m_update_total += Milliseconds(dt);
+    }
+    if (count == m_max_steps && m_start + (n+1)*step <= now) {
+      // give up on the delay: the simulation slows down instead
+      long behind = long((now - m_start) / step) - n;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_start += behind*step;
+      m_stats.dropped += behind;
+    }
+    std::this_thread::sleep_until(m_start + (n+1)*step);
+  }
+}
+
+void Simulation::Render (CameraPtr camera)
+{
+  if (!m_store)
+    return;
+  Clock::time_point t0 = Clock::now();
+  SnapshotPtr prev, curr;
+  Clock::time_point start;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prev = m_prev;
+    curr = m_curr;
+    start = m_start;
+  }
+  // time since the current snapshot, in steps
+  double elapsed = std::chrono::duration<double>(t0 - start).count() / m_step;
+  float alpha = float(std::min(std::max(elapsed - double(curr->step),0.0),1.0));
+  if (prev->step == curr->step)
+    alpha = 1.0f;
+  // linear blend of the matrices: close enough to the rigid motion at
+  // simulation rates
+  ComponentArray<TransformComponent>& trfs = m_store->GetComponents<TransformComponent>();
+  for (int i=0; i<trfs.Size(); ++i)
+    trfs[i].local = prev->matrices[i] + alpha * (curr->matrices[i] - prev->matrices[i]);
+  m_store->UpdateTransforms();
+  m_store->Render(camera);
+  Clock::duration dt = Clock::now() - t0;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // released under the lock: Capture may reuse them once unreferenced
+  prev.reset();
+  curr.reset();
+  m_stats.frames++;
+  m_stats.alpha = alpha;
+  m_render_total += Milliseconds(dt);
+}
+
+Simulation::Stats Simulation::GetStats () const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Stats stats = m_stats;
+  stats.update = stats.steps > 0 ? m_update_total / stats.steps : 0.0;
+  stats.render = stats.frames > 0 ? m_render_total / stats.frames : 0.0;
+  return stats;
+}
+
+void Simulation::ResetStats ()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats = Stats{0,0,0.0,0,0.0,0.0f};
+  m_update_total = 0.0;
+  m_render_total = 0.0;
+}
@@ -0,0 +1,455 @@
+#include "softrenderer.h"
+#include "shader.h"
+#include "transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+static double Elapsed (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+static unsigned int Pack (const glm::vec4& c)
+{
+  unsigned int r = (unsigned int)(std::min(1.0f,std::max(0.0f,c.x)) * 255.0f + 0.5f);
+  unsigned int g = (unsigned int)(std::min(1.0f,std::max(0.0f,c.y)) * 255.0f + 0.5f);
+  unsigned int b = (unsigned int)(std::min(1.0f,std::max(0.0f,c.z)) * 255.0f + 0.5f);
+  unsigned int a = (unsigned int)(std::min(1.0f,std::max(0.0f,c.w)) * 255.0f + 0.5f);
+  return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+static glm::vec4 Unpack (unsigned int p)
+{
+  return glm::vec4(float(p & 0xff),float((p >> 8) & 0xff),float((p >> 16) & 0xff),
+                   float(p >> 24)) / 255.0f;
+}
+
+SoftRendererPtr SoftRenderer::Make (int width, int height, JobSystemPtr jobs)
+{
+  return SoftRendererPtr(new SoftRenderer(width,height,jobs));
+}
+
+SoftRenderer::SoftRenderer (int width, int height, JobSystemPtr jobs)
+: m_width((std::max(4,width) + 3) & ~3),
+  m_height(std::max(1,height)),
+  m_jobs(jobs),
+  m_view(1.0f), m_proj(1.0f),
+  m_eye(0.0f),
+  m_lpos(0.0f,0.0f,1.0f,0.0f),
+  m_lamb(0.2f,0.2f,0.2f,1.0f),
+  m_ldif(0.8f,0.8f,0.8f,1.0f),
+  m_lspe(1.0f,1.0f,1.0f,1.0f),
+  m_stats({0,0,0,0,0.0,0.0})
+{
+  m_tiles_x = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+  m_tiles_y = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+  m_bins.resize(size_t(m_tiles_x) * m_tiles_y);
+  m_fragments.resize(m_bins.size());
+  m_color.resize(size_t(m_width) * m_height,0);
+  m_depth.resize(size_t(m_width) * m_height,1.0f);
+  m_stencil.resize(size_t(m_width) * m_height,0);
+}
+
+SoftRenderer::~SoftRenderer ()
+{
+}
+
+int SoftRenderer::GetWidth () const
+{
+  return m_width;
+}
+
+int SoftRenderer::GetHeight () const
+{
+  return m_height;
+}
+
+void SoftRenderer::Begin (const glm::mat4& view, const glm::mat4& proj)
+{
+  m_view = view;
+  m_proj = proj;
+  m_eye = glm::vec3(glm::inverse(view)[3]);
+  m_stats = {0,0,0,0,0.0,0.0};
+}
+
+void SoftRenderer::Begin (CameraPtr camera)
+{
+  Begin(camera->GetViewMatrix(),camera->GetProjMatrix());
+}
+
+void SoftRenderer::Clear (const glm::vec4& color, float depth, unsigned char stencil)
+{
+  std::fill(m_color.begin(),m_color.end(),Pack(color));
+  std::fill(m_depth.begin(),m_depth.end(),depth);
+  std::fill(m_stencil.begin(),m_stencil.end(),stencil);
+}
+
+void SoftRenderer::SetLight (const glm::vec4& position, const glm::vec4& amb, const glm::vec4& dif,
+                             const glm::vec4& spe)
+{
+  m_lpos = position;
+  m_lamb = amb;
+  m_ldif = dif;
+  m_lspe = spe;
+}
+
+void SoftRenderer::SetLight (LightPtr light)
+{
+  SetLight(light->GetWorldPosition(m_view),light->GetAmbient(),light->GetDiffuse(),
+           light->GetSpecular());
+}
+
+SoftRenderer::Surface SoftRenderer::GetSurface (const Material& material)
+{
+  Surface surface;
+  surface.amb = material.GetAmbient();
+  surface.dif = material.GetDiffuse();
+  surface.spe = material.GetSpecular();
+  surface.shi = material.GetShininess();
+  surface.opacity = material.GetOpacity();
+  return surface;
+}
+
+const std::vector<unsigned int>& SoftRenderer::GetColor () const
+{
+  return m_color;
+}
+
+const std::vector<float>& SoftRenderer::GetDepth () const
+{
+  return m_depth;
+}
+
+const std::vector<unsigned char>& SoftRenderer::GetStencil () const
+{
+  return m_stencil;
+}
+
+const SoftRenderer::Stats& SoftRenderer::GetStats () const
+{
+  return m_stats;
+}
+
+void SoftRenderer::ClearCache ()
+{
+  m_meshes.clear();
+}
+
+void SoftRenderer::Draw (const MeshData& mesh, const glm::mat4& model, const Surface& surface,
+                         const DrawState& state)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  int draw = int(m_states.size());
+  m_states.push_back(state);
+  m_surfaces.push_back(surface);
+  m_stats.draws++;
+
+  // vertex stage: as the ilum_vert vertex shaders, in world space
+  glm::mat4 mvp = m_proj * m_view * model;
+  glm::mat3 nm = glm::transpose(glm::inverse(glm::mat3(model)));
+  int n = mesh.GetVertexCount();
+  m_vertices.resize(n);
+  auto shade = [&](int b, int e) {
+    for (int i=b; i<e; ++i) {
+      glm::vec4 coord(mesh.coords[i],1.0f);
+      glm::vec3 pos = glm::vec3(model * coord);
+      glm::vec3 normal = mesh.normals.empty() ? glm::vec3(0.0f,0.0f,1.0f) : mesh.normals[i];
+      normal = glm::normalize(nm * normal);
+      glm::vec3 light = m_lpos.w == 0.0f ? glm::normalize(glm::vec3(m_lpos)) :
+                                           glm::normalize(glm::vec3(m_lpos) - pos);
+      float ndotl = glm::dot(normal,light);
+      glm::vec4 color = surface.amb * m_lamb + surface.dif * m_ldif * std::max(0.0f,ndotl);
+      if (ndotl > 0.0f) {
+        glm::vec3 refl = glm::normalize(glm::reflect(-light,normal));
+        float s = std::max(0.0f,glm::dot(refl,glm::normalize(m_eye - pos)));
+        color += surface.spe * m_lspe * std::pow(s,surface.shi);
+      }
+      color.w = surface.opacity;
+      Vertex& v = m_vertices[i];
+      v.clip = mvp * coord;
+      v.color = color;
+      v.texcoord = mesh.texcoords.empty() ? glm::vec2(0.0f) : mesh.texcoords[i];
+    }
+  };
+  if (n > 4096)
+    (m_jobs ? m_jobs : JobSystem::GetDefault())->ParallelFor(0,n,4096,shade);
+  else
+    shade(0,n);
+
+  // primitive assembly: clip by the near plane (z >= -w)
+  for (size_t i=0; i+2<mesh.indices.size(); i+=3) {
+    const Vertex* in[3] = {&m_vertices[mesh.indices[i]],&m_vertices[mesh.indices[i+1]],
+                           &m_vertices[mesh.indices[i+2]]};
+    Vertex out[4];
+    int nout = 0;
+    for (int k=0; k<3; ++k) {
+      const Vertex& a = *in[k];
+      const Vertex& b = *in[(k+1)%3];
+      float da = a.clip.z + a.clip.w;
+      float db = b.clip.z + b.clip.w;
+      if (da >= 0.0f)
+        out[nout++] = a;
+      if ((da >= 0.0f) != (db >= 0.0f)) {
+        float t = da / (da - db);
+        Vertex& v = out[nout++];
+        v.clip = a.clip + (b.clip - a.clip) * t;
+        v.color = a.color + (b.color - a.color) * t;
+        v.texcoord = a.texcoord + (b.texcoord - a.texcoord) * t;
+      }
+    }
+    for (int k=2; k<nout; ++k)
+      Setup(out[0],out[k-1],out[k],draw,state.cull_back);
+  }
+  m_stats.triangles += mesh.GetTriangleCount();
+  m_stats.setup_time += Elapsed(t0);
+}
+
+void SoftRenderer::Setup (const Vertex& v0, const Vertex& v1, const Vertex& v2, int draw, bool cull)
+{
+  const Vertex* v[3] = {&v0,&v1,&v2};
+  float x[3], y[3];
+  Triangle tri;
+  for (int k=0; k<3; ++k) {
+    if (v[k]->clip.w <= 1e-6f)
+      return;
+    float inv = 1.0f / v[k]->clip.w;
+    x[k] = (v[k]->clip.x * inv * 0.5f + 0.5f) * m_width;
+    y[k] = (v[k]->clip.y * inv * 0.5f + 0.5f) * m_height;
+    tri.depth[k] = v[k]->clip.z * inv * 0.5f + 0.5f;
+    tri.invw[k] = inv;
+    tri.color[k] = v[k]->color;
+    tri.texcoord[k] = v[k]->texcoord;
+  }
+  float area = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+  if (std::fabs(area) < 1e-8f || (cull && area < 0.0f))
+    return;
+  if (area < 0.0f) {   // back face: rasterized counterclockwise
+    std::swap(x[1],x[2]);
+    std::swap(y[1],y[2]);
+    std::swap(tri.depth[1],tri.depth[2]);
+    std::swap(tri.invw[1],tri.invw[2]);
+    std::swap(tri.color[1],tri.color[2]);
+    std::swap(tri.texcoord[1],tri.texcoord[2]);
+    area = -area;
+  }
+  tri.xmin = std::max(0,int(std::floor(std::min({x[0],x[1],x[2]}))));
+  tri.ymin = std::max(0,int(std::floor(std::min({y[0],y[1],y[2]}))));
+  tri.xmax = std::min(m_width-1,int(std::ceil(std::max({x[0],x[1],x[2]}))));
+  tri.ymax = std::min(m_height-1,int(std::ceil(std::max({y[0],y[1],y[2]}))));
+  if (tri.xmin > tri.xmax || tri.ymin > tri.ymax)
+    return;
+  // edge k, from vertex k to k+1, scaled to the barycentric of vertex k+2
+  for (int k=0; k<3; ++k) {
+    int j = (k+1) % 3;
+    tri.edge[k][0] = (y[k] - y[j]) / area;
+    tri.edge[k][1] = (x[j] - x[k]) / area;
+    tri.edge[k][2] = ((y[j] - y[k]) * x[k] - (x[j] - x[k]) * y[k]) / area;
+  }
+  float dz1 = tri.depth[1] - tri.depth[0];
+  float dz2 = tri.depth[2] - tri.depth[0];
+  float a = (dz1*(y[2]-y[0]) - dz2*(y[1]-y[0])) / area;
+  float b = (dz2*(x[1]-x[0]) - dz1*(x[2]-x[0])) / area;
+  float c = tri.depth[0] - a*x[0] - b*y[0];
+  tri.depth[0] = a;
+  tri.depth[1] = b;
+  tri.depth[2] = c;
+  tri.draw = draw;
+  m_triangles.push_back(tri);
+  m_stats.rasterized++;
+}
+
+void SoftRenderer::Finish ()
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (std::vector<int>& bin : m_bins)
+    bin.clear();
+  for (int i=0; i<int(m_triangles.size()); ++i) {
+    const Triangle& tri = m_triangles[i];
+    for (int ty=tri.ymin/TILE_SIZE; ty<=tri.ymax/TILE_SIZE; ++ty)
+      for (int tx=tri.xmin/TILE_SIZE; tx<=tri.xmax/TILE_SIZE; ++tx)
+        m_bins[ty*m_tiles_x+tx].push_back(i);
+  }
+  std::fill(m_fragments.begin(),m_fragments.end(),0L);
+  JobSystemPtr jobs = m_jobs ? m_jobs : JobSystem::GetDefault();
+  jobs->ParallelFor(0,int(m_bins.size()),1,[this](int b, int e) {
+    for (int t=b; t<e; ++t)
+      RasterTile(t);
+  });
+  for (long f : m_fragments)
+    m_stats.fragments += f;
+  m_triangles.clear();
+  m_states.clear();
+  m_surfaces.clear();
+  m_stats.raster_time += Elapsed(t0);
+}
+
+// Triangles of a tile in submission order, 4 pixels at a time: coverage
+// and depth test for the 4, then stencil, shading and blending per pixel
+void SoftRenderer::RasterTile (int tile)
+{
+  int x0 = (tile % m_tiles_x) * TILE_SIZE;
+  int y0 = (tile / m_tiles_x) * TILE_SIZE;
+  int x1 = std::min(m_width,x0+TILE_SIZE) - 1;
+  int y1 = std::min(m_height,y0+TILE_SIZE) - 1;
+  long fragments = 0;
+  for (int i : m_bins[tile]) {
+    const Triangle& tri = m_triangles[i];
+    const DrawState& state = m_states[tri.draw];
+    const Surface& surface = m_surfaces[tri.draw];
+    const Image* texture = surface.texture.get();
+    int xb = std::max(tri.xmin,x0) & ~3;
+    int xe = std::min(tri.xmax,x1);
+    int yb = std::max(tri.ymin,y0);
+    int ye = std::min(tri.ymax,y1);
+#if defined(__SSE2__)
+    const __m128 offset = _mm_setr_ps(0.5f,1.5f,2.5f,3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 ea[3], za = _mm_set1_ps(tri.depth[0]);
+    for (int k=0; k<3; ++k)
+      ea[k] = _mm_set1_ps(tri.edge[k][0]);
+#endif
+    for (int y=yb; y<=ye; ++y) {
+      float py = y + 0.5f;
+      size_t row = size_t(y) * m_width;
+#if defined(__SSE2__)
+      __m128 erow[3], zrow = _mm_set1_ps(tri.depth[1]*py + tri.depth[2]);
+      for (int k=0; k<3; ++k)
+        erow[k] = _mm_set1_ps(tri.edge[k][1]*py + tri.edge[k][2]);
+#endif
+      for (int x=xb; x<=xe; x+=4) {
+        float e[3][4], z[4];
+        int mask = 0;
+#if defined(__SSE2__)
+        __m128 px = _mm_add_ps(_mm_set1_ps(float(x)),offset);
+        __m128 ev[3];
+        for (int k=0; k<3; ++k)
+          ev[k] = _mm_add_ps(_mm_mul_ps(ea[k],px),erow[k]);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(ev[0],zero),_mm_cmpge_ps(ev[1],zero)),
+                                   _mm_cmpge_ps(ev[2],zero));
+        __m128 zv = _mm_add_ps(_mm_mul_ps(za,px),zrow);
+        if (state.depth_test)
+          inside = _mm_and_ps(inside,_mm_cmplt_ps(zv,_mm_loadu_ps(&m_depth[row+x])));
+        mask = _mm_movemask_ps(inside);
+        if (!mask)
+          continue;
+        for (int k=0; k<3; ++k)
+          _mm_storeu_ps(e[k],ev[k]);
+        _mm_storeu_ps(z,zv);
+#else
+        for (int l=0; l<4; ++l) {
+          float px = x + l + 0.5f;
+          for (int k=0; k<3; ++k)
+            e[k][l] = tri.edge[k][0]*px + tri.edge[k][1]*py + tri.edge[k][2];
+          z[l] = tri.depth[0]*px + tri.depth[1]*py + tri.depth[2];
+          if (e[0][l] >= 0.0f && e[1][l] >= 0.0f && e[2][l] >= 0.0f &&
+              (!state.depth_test || z[l] < m_depth[row+x+l]))
+            mask |= 1 << l;
+        }
+        if (!mask)
+          continue;
+#endif
+        for (int l=0; l<4; ++l) {
+          if (!(mask & (1 << l)))
+            continue;
+          size_t p = row + x + l;
+          if (state.stencil_func != ALWAYS) {
+            bool equal = m_stencil[p] == state.stencil_ref;
+            if (equal != (state.stencil_func == EQUAL))
+              continue;
+          }
+          fragments++;
+          if (state.depth_write)
+            m_depth[p] = z[l];
+          if (state.stencil_op == REPLACE)
+            m_stencil[p] = state.stencil_ref;
+          else if (state.stencil_op == INCR && m_stencil[p] < 255)
+            m_stencil[p]++;
+          if (!state.color_write)
+            continue;
+          // perspective correct interpolation (e[k]: barycentric of vertex k+2)
+          float q0 = e[1][l] * tri.invw[0];
+          float q1 = e[2][l] * tri.invw[1];
+          float q2 = e[0][l] * tri.invw[2];
+          float inv = 1.0f / (q0 + q1 + q2);
+          glm::vec4 color = (tri.color[0]*q0 + tri.color[1]*q1 + tri.color[2]*q2) * inv;
+          if (texture) {
+            glm::vec2 uv = (tri.texcoord[0]*q0 + tri.texcoord[1]*q1 + tri.texcoord[2]*q2) * inv;
+            int w = texture->GetWidth(), h = texture->GetHeight(), nc = texture->GetNChannels();
+            int tx = int(std::floor(uv.x * w)) % w;
+            int ty = int(std::floor(uv.y * h)) % h;
+            const unsigned char* t = texture->GetData() + (size_t(ty < 0 ? ty+h : ty)*w +
+                                                           (tx < 0 ? tx+w : tx)) * nc;
+            glm::vec4 texel(t[0],nc > 1 ? t[1] : t[0],nc > 2 ? t[2] : t[0],nc > 3 ? t[3] : 255);
+            color = color * texel / 255.0f;
+          }
+          color = glm::clamp(color,0.0f,1.0f);
+          if (state.blend)
+            color = color * color.w + Unpack(m_color[p]) * (1.0f - color.w);
+          m_color[p] = Pack(color);
+        }
+      }
+    }
+  }
+  m_fragments[tile] = fragments;
+}
+
+void SoftRenderer::Render (NodePtr root, const DrawState& state)
+{
+  RenderNode(root.get(),glm::mat4(1.0f),Surface(),state);
+}
+
+void SoftRenderer::RenderNode (const Node* node, const glm::mat4& parent, Surface surface,
+                               const DrawState& state)
+{
+  // the light of a node's shader holds for its subtree
+  glm::vec4 light[4] = {m_lpos,m_lamb,m_ldif,m_lspe};
+  if (node->GetShader() && node->GetShader()->GetLight())
+    SetLight(node->GetShader()->GetLight());
+  const TransformPtr& trf = node->GetTransform();
+  glm::mat4 model = trf ? parent * trf->GetMatrix() : parent;
+  for (const AppearancePtr& app : node->GetAppearances()) {
+    const Material* material = dynamic_cast<const Material*>(app.get());
+    if (material)
+      surface = GetSurface(*material);
+  }
+  for (const ShapePtr& shp : node->GetShapes()) {
+    auto it = m_meshes.find(shp.get());
+    if (it == m_meshes.end()) {
+      MeshData data;
+      if (!shp->GetMeshData(data))
+        data.Clear();
+      it = m_meshes.emplace(shp.get(),std::move(data)).first;
+    }
+    if (!it->second.IsEmpty())
+      Draw(it->second,model,surface,state);
+  }
+  for (const NodePtr& child : node->GetNodes())
+    RenderNode(child.get(),model,surface,state);
+  SetLight(light[0],light[1],light[2],light[3]);
+}
+
+bool SoftRenderer::Save (const std::string& filename) const
+{
+  FILE* fp = fopen(filename.c_str(),"wb");
+  if (!fp)
+    return false;
+  fprintf(fp,"P6\n%d %d\n255\n",m_width,m_height);
+  std::vector<unsigned char> line(size_t(m_width) * 3);
+  for (int y=m_height-1; y>=0; --y) {
+    for (int x=0; x<m_width; ++x) {
+      unsigned int p = m_color[size_t(y)*m_width+x];
+      line[3*x+0] = (unsigned char)(p & 0xff);
+      line[3*x+1] = (unsigned char)((p >> 8) & 0xff);
+      line[3*x+2] = (unsigned char)((p >> 16) & 0xff);
+    }
+    fwrite(line.data(),1,line.size(),fp);
+  }
+  return fclose(fp) == 0;
+}
@@ -1,78 +1,104 @@
 #include "sphere.h"
+#include "allocation.h"
 #include "grid.h"
 #include "error.h"
-
-#include <cmath>
-#include <iostream>
+#include "geometrycache.h"
 
 #include <glad/glad.h>
 
+#include <cmath>
+#include <string>
+#include <vector>
+
 #define PI 3.14159265f
 
 SpherePtr Sphere::Make (int nstack, int nslice)
 {
-  return SpherePtr(new Sphere(nstack,nslice));
+  return Allocation::Make<Sphere>(nstack,nslice);
 }
 
-Sphere::Sphere (int nstack, int nslice)
+// Unit sphere over a (nstack x nslice) grid; sines and cosines are
+// evaluated once per grid column and row
+static void Vertices (const GridPtr& grid, std::vector<float>& coord, std::vector<float>& tangent)
 {
-  GridPtr grid = Grid::Make(nstack,nslice);
-  m_nind = grid->IndexCount();
-  // generate spherical coordinates
-  float* coord = new float[3*(nstack+1)*(nslice+1)];
-  float* tangent = new float[3*(nstack+1)*(nslice+1)];
+  int nx = grid->GetNx(), ny = grid->GetNy();
+  std::vector<float> sin_theta(nx+1), cos_theta(nx+1), sin_phi(ny+1), cos_phi(ny+1);
+  for (int i=0; i<=nx; ++i) {
+    float theta = float(i)/nx*2*PI;
+    sin_theta[i] = sin(theta);
+    cos_theta[i] = cos(theta);
+  }
+  for (int j=0; j<=ny; ++j) {
+    float phi = float(j)/ny*PI;
+    sin_phi[j] = sin(PI-phi);
+    cos_phi[j] = cos(PI-phi);
+  }
+  coord.resize(3*grid->VertexCount());
+  tangent.resize(3*grid->VertexCount());
   int nc = 0;
-  const float* texcoord = grid->GetCoords();
-  for (int i=0; i<2*grid->VertexCount(); i+=2) {
-    float theta = texcoord[i+0]*2*PI;
-    float phi = texcoord[i+1]*PI;
-    coord[nc+0] = sin(theta) * sin(PI-phi);
-    coord[nc+1] = cos(PI-phi);
-    coord[nc+2] = cos(theta) * sin(PI-phi);
-    tangent[nc+0] = cos(theta);
-    tangent[nc+1] = 0;
-    tangent[nc+2] = -sin(theta);
-    nc += 3;
+  for (int j=0; j<=ny; ++j) {
+    for (int i=0; i<=nx; ++i) {
+      coord[nc+0] = sin_theta[i] * sin_phi[j];
+      coord[nc+1] = cos_phi[j];
+      coord[nc+2] = cos_theta[i] * sin_phi[j];
+      tangent[nc+0] = cos_theta[i];
+      tangent[nc+1] = 0;
+      tangent[nc+2] = -sin_theta[i];
+      nc += 3;
+    }
   }
-  // create VAO
-  glGenVertexArrays(1,&m_vao);
-  glBindVertexArray(m_vao);
-  // create buffers
-  GLuint id[3];  // buffers: coord/normal, tangent, texcoord
-  glGenBuffers(3,id);
-  glBindBuffer(GL_ARRAY_BUFFER,id[0]);
-  glBufferData(GL_ARRAY_BUFFER,3*grid->VertexCount()*sizeof(float),coord,GL_STATIC_DRAW);
-  glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,0);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,0,0);
-  glEnableVertexAttribArray(1);
-  glBindBuffer(GL_ARRAY_BUFFER,id[1]);
-  glBufferData(GL_ARRAY_BUFFER,3*grid->VertexCount()*sizeof(float),tangent,GL_STATIC_DRAW);
-  glVertexAttribPointer(2,3,GL_FLOAT,GL_FALSE,0,0);
-  glEnableVertexAttribArray(2);
-  glBindBuffer(GL_ARRAY_BUFFER,id[2]);
-  glBufferData(GL_ARRAY_BUFFER,2*grid->VertexCount()*sizeof(float),texcoord,GL_STATIC_DRAW);
-  glVertexAttribPointer(3,2,GL_FLOAT,GL_FALSE,0,0); 
-  glEnableVertexAttribArray(3);
-  // create index buffer
-  GLuint index;
-  glGenBuffers(1,&index);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,index);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,m_nind*sizeof(unsigned int),grid->GetIndices(),GL_STATIC_DRAW);
-  delete [] tangent;
-  delete [] coord;
+}
+
+static VertexArrayPtr Build (int nstack, int nslice)
+{
+  GridPtr grid = Grid::Make(nstack,nslice);
+  std::vector<float> coord, tangent;
+  Vertices(grid,coord,tangent);
+  VertexArrayPtr array = VertexArray::Make();
+  int coords = array->AddBuffer(int(coord.size()),coord.data());
+  array->SetAttribute(Shape::COORD,coords,3);
+  array->SetAttribute(Shape::NORMAL,coords,3);
+  array->SetAttribute(Shape::TANGENT,array->AddBuffer(int(tangent.size()),tangent.data()),3);
+  array->SetAttribute(Shape::TEXCOORD,array->AddBuffer(2*grid->VertexCount(),grid->GetCoords()),2);
+  array->SetIndices(grid->IndexCount(),grid->GetIndices());
+  return array;
+}
+
+Sphere::Sphere (int nstack, int nslice)
+: m_array(GeometryCache::Get("sphere/"+std::to_string(nstack)+"/"+std::to_string(nslice),
+                             [nstack,nslice]() { return Build(nstack,nslice); }))
+{
 }
 
 Sphere::~Sphere () 
 {
 }
 
-void Sphere::Draw (StatePtr st)
+void Sphere::Draw (StatePtr )
+{
+  m_array->Draw();
+}
+
+BBox Sphere::GetBounds () const
 {
-  GLint prog = 0;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &prog);
-    std::cout << "[ModelShape::Draw] current program = " << prog << std::endl;
+  return BBox(glm::vec3(-1.0f),glm::vec3(1.0f));
+}
+
+MeshData Sphere::Geometry (int nstack, int nslice)
+{
+  GridPtr grid = Grid::Make(nstack,nslice);
+  std::vector<float> coord, tangent;
+  Vertices(grid,coord,tangent);
+  MeshData data;
+  data.SetAttribute(COORD,coord.data(),int(coord.size()),3);
+  data.SetAttribute(NORMAL,coord.data(),int(coord.size()),3);
+  data.SetAttribute(TANGENT,tangent.data(),int(tangent.size()),3);
+  data.SetAttribute(TEXCOORD,grid->GetCoords(),2*grid->VertexCount(),2);
+  data.SetPrimitives(GL_TRIANGLES,grid->IndexCount(),grid->GetIndices());
+  return data;
+}
 
-  glBindVertexArray(m_vao);
-  glDrawElements(GL_TRIANGLES,m_nind,GL_UNSIGNED_INT,0);
+bool Sphere::GetMeshData (MeshData& data) const
+{
+  return m_array->Read(data);
 }
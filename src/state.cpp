@@ -2,7 +2,9 @@
 #include "shader.h"
 #include "camera.h"
 #include "light.h"
+#include "occlusionculler.h"
 #include "shader.h"
+#include "uniformbuffer.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -19,7 +21,10 @@ StatePtr State::Make (CameraPtr camera)
 State::State (CameraPtr camera)
 : m_camera(camera),
   m_shader(),
-  m_stack{glm::mat4(1.0f)}
+  m_stack{glm::mat4(1.0f)},
+  m_has_matrices(false),
+  m_cull(false),
+  m_occlusion(nullptr)
 {
   glUseProgram(0);   // compatibility profile as default
 }
@@ -30,16 +35,19 @@ State::~State ()
 
 void State::PushShader (ShaderPtr shd)
 {
+  // nested nodes with the same program (e.g. ShaderVariants) do not switch
+  if (m_shader.empty() || m_shader.back() != shd)
+    shd->UseProgram();
   m_shader.push_back(shd);
-  shd->UseProgram();
 }
 
 void State::PopShader ()
 {
+  ShaderPtr shd = m_shader.back();
   m_shader.pop_back();
   if (m_shader.empty())
     glUseProgram(0);
-  else
+  else if (m_shader.back() != shd)
     m_shader.back()->UseProgram();
 }
 
@@ -57,6 +65,22 @@ CameraPtr State::GetCamera () const
   return m_camera;
 }
 
+const glm::mat4& State::GetViewMatrix ()
+{
+  if (!m_has_matrices) {
+    m_view = m_camera->GetViewMatrix();
+    m_proj = m_camera->GetProjMatrix();
+    m_has_matrices = true;
+  }
+  return m_view;
+}
+
+const glm::mat4& State::GetProjMatrix ()
+{
+  GetViewMatrix();
+  return m_proj;
+}
+
 void State::PushMatrix ()
 {
   m_stack.push_back(GetCurrentMatrix());
@@ -86,17 +110,76 @@ void State::LoadMatrices ()
 {
   // set matrices
   ShaderPtr shd = GetShader();
-  glm::mat4 mvp = m_camera->GetProjMatrix() * 
-                  m_camera->GetViewMatrix() * 
-                  GetCurrentMatrix();
+  const glm::mat4& view = GetViewMatrix();
+  glm::mat4 mvp = GetProjMatrix() * view * GetCurrentMatrix();
   glm::mat4 mv = GetCurrentMatrix();      // to global space
   if (shd->GetLightingSpace() == "camera") {
-    mv = m_camera->GetViewMatrix() * mv;  // to camera space
+    mv = view * mv;  // to camera space
   }
   glm::mat4 mn = glm::transpose(glm::inverse(mv));
-  shd->SetUniform("Mvp",mvp);
-  shd->SetUniform("Mv",mv);
-  shd->SetUniform("Mn",mn);
-  // load camera
-  m_camera->Load(shared_from_this());
+  LoadMatrices(mvp,mv,mn);
+}
+
+void State::LoadMatrices (const glm::mat4& mvp, const glm::mat4& mv, const glm::mat4& mn)
+{
+  ShaderPtr shd = GetShader();
+  if (shd->HasUniformBlock(UniformBuffer::DRAW)) {
+    // one write into the draw ring instead of three uniform calls
+    glm::mat4 block[3] = {mvp,mv,mn};
+    StreamBufferPtr stream = GetDrawStream();
+    int offset = stream->Write(block,sizeof(block),UniformBuffer::GetOffsetAlignment());
+    stream->BindUniform(UniformBuffer::DRAW,offset,sizeof(block));
+  }
+  else {
+    shd->SetUniform("Mvp",mvp);
+    shd->SetUniform("Mv",mv);
+    shd->SetUniform("Mn",mn);
+  }
+  // load camera: its position is part of the frame block, if any
+  if (!shd->HasUniformBlock(UniformBuffer::FRAME))
+    m_camera->Load(shared_from_this());
+}
+
+void State::SetCullFrustum (const Frustum& frustum)
+{
+  m_frustum = frustum;
+  m_cull = true;
+}
+
+void State::SetOcclusionCuller (OcclusionCullerPtr culler)
+{
+  m_occlusion = culler;
+}
+
+bool State::IsVisible (const BBox& bounds) const
+{
+  if (!m_cull && !m_occlusion)
+    return true;
+  BBox world = bounds.Transform(GetCurrentMatrix());
+  if (m_cull && !m_frustum.Intersects(world))
+    return false;
+  return !m_occlusion || m_occlusion->IsVisible(world);
+}
+
+// draw ring of the context: made on first use, released by
+// ReleaseDrawStream while the context is current; never destroyed at
+// exit, where the context may be gone
+static StreamBufferPtr& DrawStream ()
+{
+  static StreamBufferPtr* stream = new StreamBufferPtr();
+  return *stream;
+}
+
+StreamBufferPtr State::GetDrawStream ()
+{
+  // room for 1024 draws per section
+  StreamBufferPtr& stream = DrawStream();
+  if (!stream)
+    stream = StreamBuffer::Make(1024*256);
+  return stream;
+}
+
+void State::ReleaseDrawStream ()
+{
+  DrawStream() = nullptr;
 }
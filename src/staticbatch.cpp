@@ -0,0 +1,214 @@
+#include "staticbatch.h"
+#include "allocation.h"
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace {
+
+using Cell = std::array<int,3>;
+
+// batch being filled
+struct Pending {
+  MeshData data;
+  int shapes = 0;
+};
+
+// shapes drawn with the same shader and appearances
+struct Group {
+  ShaderPtr shader;
+  std::vector<AppearancePtr> apps;
+  std::map<Cell,Pending> cells;
+  std::vector<ShapePtr> batches;
+  std::vector<NodePtr> kept;       // shapes that could not be merged
+};
+
+class Batcher {
+  int m_max_vertices;
+  float m_chunk;
+  StaticBatch::Stats& m_stats;
+  std::vector<Group> m_groups;
+  // triangles of each shape, read once however many nodes share it
+  std::map<const Shape*,MeshData> m_data;
+public:
+  Batcher (int max_vertices, float chunk, StaticBatch::Stats& stats)
+  : m_max_vertices(max_vertices), m_chunk(chunk), m_stats(stats)
+  {
+  }
+  void Walk (const NodePtr& node, const glm::mat4& parent, ShaderPtr shader,
+             std::vector<AppearancePtr>& apps)
+  {
+    m_stats.nodes++;
+    glm::mat4 model = parent * node->GetMatrix();
+    if (node->GetShader())
+      shader = node->GetShader();
+    size_t napps = apps.size();
+    apps.insert(apps.end(),node->GetAppearances().begin(),node->GetAppearances().end());
+    for (const ShapePtr& shape : node->GetShapes())
+      Add(Find(shader,apps),shape,model);
+    for (const NodePtr& child : node->GetNodes())
+      Walk(child,model,shader,apps);
+    apps.resize(napps);
+  }
+  NodePtr Finish ()
+  {
+    NodePtr root = Node::Make();
+    for (Group& group : m_groups) {
+      for (auto& cell : group.cells)
+        Flush(group,cell.second);
+      NodePtr node = Node::Make();
+      if (group.shader)
+        node->SetShader(group.shader);
+      for (const AppearancePtr& app : group.apps)
+        node->AddAppearance(app);
+      for (const ShapePtr& batch : group.batches)
+        node->AddShape(batch);
+      for (const NodePtr& kept : group.kept)
+        node->AddNode(kept);
+      root->AddNode(node);
+    }
+    root->SetStatic(true);
+    return root;
+  }
+private:
+  Group& Find (const ShaderPtr& shader, const std::vector<AppearancePtr>& apps)
+  {
+    for (Group& group : m_groups)
+      if (group.shader == shader && group.apps == apps)
+        return group;
+    m_groups.push_back(Group());
+    m_groups.back().shader = shader;
+    m_groups.back().apps = apps;
+    return m_groups.back();
+  }
+  void Add (Group& group, const ShapePtr& shape, const glm::mat4& model)
+  {
+    auto it = m_data.find(shape.get());
+    if (it == m_data.end()) {
+      MeshData data;
+      if (!shape->GetMeshData(data))
+        data.Clear();
+      data.Complete();
+      it = m_data.emplace(shape.get(),std::move(data)).first;
+    }
+    if (it->second.IsEmpty()) {
+      // drawn on its own, with the matrix it had
+      TransformPtr trf = Transform::Make();
+      trf->MultMatrix(model);
+      group.kept.push_back(Node::Make(trf,{shape}));
+      m_stats.kept++;
+      return;
+    }
+    MeshData data = it->second;
+    data.Transform(model);
+    Cell cell = {0,0,0};
+    if (m_chunk > 0.0f) {
+      glm::vec3 center = data.GetBounds().GetCenter() / m_chunk;
+      cell = {int(floorf(center.x)),int(floorf(center.y)),int(floorf(center.z))};
+    }
+    Pending& pending = group.cells[cell];
+    if (pending.shapes > 0 &&
+        pending.data.GetVertexCount() + data.GetVertexCount() > m_max_vertices)
+      Flush(group,pending);
+    pending.data.Append(data);
+    pending.shapes++;
+  }
+  void Flush (Group& group, Pending& pending)
+  {
+    if (pending.shapes == 0)
+      return;
+    group.batches.push_back(StaticBatch::Make(pending.data,pending.shapes));
+    m_stats.shapes += pending.shapes;
+    m_stats.batches++;
+    m_stats.vertices += pending.data.GetVertexCount();
+    m_stats.triangles += pending.data.GetTriangleCount();
+    pending.data.Clear();
+    pending.shapes = 0;
+  }
+};
+
+}
+
+StaticBatchPtr StaticBatch::Make (const MeshData& data, int nshapes)
+{
+  return Allocation::Make<StaticBatch>(data,nshapes);
+}
+
+StaticBatch::StaticBatch (const MeshData& data, int nshapes)
+: m_array(VertexArray::Make()),
+  m_bounds(data.GetBounds()),
+  m_shapes(nshapes),
+  m_vertices(data.GetVertexCount()),
+  m_triangles(data.GetTriangleCount())
+{
+  int n = data.GetVertexCount();
+  m_array->SetAttribute(COORD,m_array->AddBuffer(3*n,&data.coords[0].x),3);
+  m_array->SetAttribute(NORMAL,m_array->AddBuffer(3*n,&data.normals[0].x),3);
+  m_array->SetAttribute(TANGENT,m_array->AddBuffer(4*n,&data.tangents[0].x),4);
+  m_array->SetAttribute(TEXCOORD,m_array->AddBuffer(2*n,&data.texcoords[0].x),2);
+  m_array->SetIndices(int(data.indices.size()),data.indices.data());
+}
+
+StaticBatch::~StaticBatch ()
+{
+}
+
+NodePtr StaticBatch::Build (NodePtr root, int max_vertices, float chunk, Stats* stats)
+{
+  Stats local = {0,0,0,0,0,0};
+  Batcher batcher(max_vertices,chunk,stats ? *stats : local);
+  std::vector<AppearancePtr> apps;
+  batcher.Walk(root,glm::mat4(1.0f),nullptr,apps);
+  return batcher.Finish();
+}
+
+StaticBatch::Stats StaticBatch::Apply (NodePtr root, int max_vertices, float chunk)
+{
+  Stats stats = {0,0,0,0,0,0};
+  std::vector<NodePtr> pending = {root};
+  while (!pending.empty()) {
+    NodePtr node = pending.back();
+    pending.pop_back();
+    // copy: children are replaced while iterating
+    std::vector<NodePtr> children(node->GetNodes().begin(),node->GetNodes().end());
+    for (const NodePtr& child : children) {
+      if (child->IsStatic())
+        node->ReplaceNode(child,Build(child,max_vertices,chunk,&stats));
+      else
+        pending.push_back(child);
+    }
+  }
+  return stats;
+}
+
+int StaticBatch::GetShapeCount () const
+{
+  return m_shapes;
+}
+
+int StaticBatch::GetVertexCount () const
+{
+  return m_vertices;
+}
+
+int StaticBatch::GetTriangleCount () const
+{
+  return m_triangles;
+}
+
+void StaticBatch::Draw (StatePtr )
+{
+  m_array->Draw();
+}
+
+BBox StaticBatch::GetBounds () const
+{
+  return m_bounds;
+}
+
+bool StaticBatch::GetMeshData (MeshData& data) const
+{
+  return m_array->Read(data);
+}
@@ -0,0 +1,88 @@
+#include "storagebuffer.h"
+
+#include <glad/glad.h>
+
+StorageBufferPtr StorageBuffer::Make (int size, const void* data)
+{
+  return StorageBufferPtr(new StorageBuffer(size,data));
+}
+
+StorageBuffer::StorageBuffer (int size, const void* data)
+: m_size(size)
+{
+  m_buffer.Create();
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_buffer.Get());
+  glBufferData(GL_SHADER_STORAGE_BUFFER,size,data,GL_DYNAMIC_DRAW);
+  m_buffer.SetBytes(size);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+}
+
+StorageBuffer::~StorageBuffer ()
+{
+}
+
+unsigned int StorageBuffer::GetId () const
+{
+  return m_buffer.Get();
+}
+
+int StorageBuffer::GetSize () const
+{
+  return m_size;
+}
+
+void StorageBuffer::SetData (const void* data, int size, int offset)
+{
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_buffer.Get());
+  if (offset + size > m_size) {
+    // grow in place (same id, for those holding it), keeping the bytes
+    // below offset through a temporary copy
+    int keep = offset < m_size ? offset : m_size;
+    GLBuffer saved;
+    if (keep > 0) {
+      saved.Create();
+      glBindBuffer(GL_COPY_WRITE_BUFFER,saved.Get());
+      glBufferData(GL_COPY_WRITE_BUFFER,keep,0,GL_STREAM_COPY);
+      glCopyBufferSubData(GL_SHADER_STORAGE_BUFFER,GL_COPY_WRITE_BUFFER,0,0,keep);
+    }
+    m_size = offset + size;
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_size,0,GL_DYNAMIC_DRAW);
+    m_buffer.SetBytes(m_size);
+    if (keep > 0) {
+      glBindBuffer(GL_COPY_READ_BUFFER,saved.Get());
+      glCopyBufferSubData(GL_COPY_READ_BUFFER,GL_SHADER_STORAGE_BUFFER,0,0,keep);
+      glBindBuffer(GL_COPY_READ_BUFFER,0);
+      glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+    }
+  }
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER,offset,size,data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+}
+
+void StorageBuffer::Reserve (int size)
+{
+  if (size <= m_size)
+    return;
+  m_size = size;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_buffer.Get());
+  glBufferData(GL_SHADER_STORAGE_BUFFER,m_size,0,GL_DYNAMIC_DRAW);
+  m_buffer.SetBytes(m_size);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+}
+
+void StorageBuffer::GetData (void* data, int size, int offset) const
+{
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_buffer.Get());
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,offset,size,data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+}
+
+ReadbackPtr StorageBuffer::GetDataAsync (int size, int offset) const
+{
+  return Readback::Make(m_buffer.Get(),offset,size);
+}
+
+void StorageBuffer::Bind (int binding) const
+{
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER,binding,m_buffer.Get());
+}
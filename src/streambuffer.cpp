@@ -0,0 +1,138 @@
+#include "streambuffer.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+
+StreamBufferPtr StreamBuffer::Make (int section_size, int nsections)
+{
+  return StreamBufferPtr(new StreamBuffer(section_size,nsections));
+}
+
+StreamBuffer::StreamBuffer (int section_size, int nsections)
+: m_section_size((section_size + 255) / 256 * 256),  // keep sections aligned for any binding
+  m_nsections(nsections),
+  m_section(0),
+  m_offset(0),
+  m_ptr(nullptr),
+  m_fences(nsections,nullptr),
+  m_stalls(0),
+  m_stall_time(0.0)
+{
+  int size = m_section_size * m_nsections;
+  m_buffer.Create();
+  m_buffer.SetBytes(size);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,m_buffer.Get());
+  if (GLAD_GL_VERSION_4_4) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER,size,0,flags);
+    m_ptr = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER,0,size,flags);
+  }
+  else
+    glBufferData(GL_COPY_WRITE_BUFFER,size,0,GL_STREAM_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+}
+
+StreamBuffer::~StreamBuffer ()
+{
+  for (void* fence : m_fences)
+    if (fence)
+      glDeleteSync((GLsync)fence);
+  if (m_ptr) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER,m_buffer.Get());
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  }
+}
+
+unsigned int StreamBuffer::GetId () const
+{
+  return m_buffer.Get();
+}
+
+int StreamBuffer::GetSectionSize () const
+{
+  return m_section_size;
+}
+
+bool StreamBuffer::IsPersistent () const
+{
+  return m_ptr != nullptr;
+}
+
+int StreamBuffer::Write (const void* data, int size, int align)
+{
+  if (size > m_section_size) {
+    std::cerr << "StreamBuffer: " << size << " bytes do not fit in a section of "
+              << m_section_size << std::endl;
+    exit(1);
+  }
+  int offset = (m_offset + align - 1) / align * align;
+  if (offset + size > m_section_size) {
+    NextSection();
+    offset = 0;
+  }
+  m_offset = offset + size;
+  offset += m_section * m_section_size;
+  if (m_ptr)
+    memcpy(m_ptr + offset,data,size);
+  else {
+    glBindBuffer(GL_COPY_WRITE_BUFFER,m_buffer.Get());
+    glBufferSubData(GL_COPY_WRITE_BUFFER,offset,size,data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  }
+  return offset;
+}
+
+void StreamBuffer::NextSection ()
+{
+  if (m_fences[m_section])
+    glDeleteSync((GLsync)m_fences[m_section]);
+  m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+  m_section = (m_section + 1) % m_nsections;
+  m_offset = 0;
+  WaitSection(m_section);
+}
+
+void StreamBuffer::WaitSection (int section)
+{
+  GLsync fence = (GLsync)m_fences[section];
+  if (!fence)
+    return;
+  GLenum status = glClientWaitSync(fence,0,0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    // the GPU is still reading this section: the CPU is ahead by a full ring
+    auto t0 = std::chrono::steady_clock::now();
+    do
+      status = glClientWaitSync(fence,GL_SYNC_FLUSH_COMMANDS_BIT,1000000);
+    while (status == GL_TIMEOUT_EXPIRED);
+    m_stalls++;
+    m_stall_time += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+  }
+  glDeleteSync(fence);
+  m_fences[section] = nullptr;
+}
+
+void StreamBuffer::BindUniform (int binding, int offset, int size) const
+{
+  glBindBufferRange(GL_UNIFORM_BUFFER,binding,m_buffer.Get(),offset,size);
+}
+
+int StreamBuffer::GetStallCount () const
+{
+  return m_stalls;
+}
+
+double StreamBuffer::GetStallTime () const
+{
+  return m_stall_time;
+}
+
+void StreamBuffer::ResetStats ()
+{
+  m_stalls = 0;
+  m_stall_time = 0.0;
+}
@@ -6,50 +6,88 @@
 
 #include <iostream>
 
-TexBufferPtr TexBuffer::Make (const std::string& varname, const std::vector<float>& data)
+TexBufferPtr TexBuffer::Make (const std::string& varname, const std::vector<float>& data,
+                              FORMAT format)
 {
-  return TexBufferPtr(new TexBuffer(varname,data));
+  return TexBufferPtr(new TexBuffer(varname,data,format));
 }
 
-TexBuffer::TexBuffer (const std::string& varname, const std::vector<float>& data)
-: m_varname(varname)
+TexBuffer::TexBuffer (const std::string& varname, const std::vector<float>& data, FORMAT format)
+: m_stream(nullptr),
+  m_offset(0),
+  m_size(0),
+  m_varname(varname),
+  m_format(format)
 {
-  glGenBuffers(1,&m_buffer);
-  glGenTextures(1,&m_tex);
+  m_buffer.Create();
+  m_tex.Create();
   SetData(data);
 }
 
 void TexBuffer::SetData (const std::vector<float>& data)
 {
-  glBindTexture(GL_TEXTURE_BUFFER,m_tex);
-  glBindBuffer(GL_TEXTURE_BUFFER,m_buffer);
-  glBufferData(GL_TEXTURE_BUFFER,
-               data.size()*sizeof(float),
-               data.data(),
-               GL_DYNAMIC_DRAW);
-  glTexBuffer(GL_TEXTURE_BUFFER,GL_R32F,m_buffer);
-  glBindTexture(GL_TEXTURE_2D,0);
+  int size = int(data.size()*sizeof(float));
+  glBindTexture(GL_TEXTURE_BUFFER,m_tex.Get());
+  if (GLAD_GL_VERSION_4_3 && size > 0) {
+    // no reallocation: each update goes to free space of the ring
+    static GLint align = 0;
+    if (align == 0)
+      glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT,&align);
+    if (!m_stream || m_stream->GetSectionSize() < size)
+      m_stream = StreamBuffer::Make(size);
+    m_offset = m_stream->Write(data.data(),size,align);
+    glTexBufferRange(GL_TEXTURE_BUFFER,GetInternalFormat(),m_stream->GetId(),m_offset,size);
+  }
+  else {
+    glBindBuffer(GL_TEXTURE_BUFFER,m_buffer.Get());
+    glBufferData(GL_TEXTURE_BUFFER,
+                 size,
+                 data.data(),
+                 GL_DYNAMIC_DRAW);
+    m_buffer.SetBytes(size);
+    glTexBuffer(GL_TEXTURE_BUFFER,GetInternalFormat(),m_buffer.Get());
+    m_stream = nullptr;
+    m_offset = 0;
+  }
+  m_size = size;
+  glBindTexture(GL_TEXTURE_BUFFER,0);
 }
 
 std::vector<float> TexBuffer::GetData () const
 {
-  std::vector<float> data;
-  glBindBuffer(GL_TEXTURE_BUFFER,m_buffer);
-  int size = 0;
-  glGetBufferParameteriv(GL_TEXTURE_BUFFER,GL_BUFFER_SIZE,&size);
-  data.resize(size/sizeof(float));
-  glGetBufferSubData(GL_TEXTURE_BUFFER,0,size,data.data());
+  std::vector<float> data(m_size/sizeof(float));
+  glBindBuffer(GL_TEXTURE_BUFFER,m_stream ? m_stream->GetId() : m_buffer.Get());
+  glGetBufferSubData(GL_TEXTURE_BUFFER,m_offset,m_size,data.data());
   glBindBuffer(GL_TEXTURE_BUFFER,0);
   return data;
 } 
 
+ReadbackPtr TexBuffer::GetDataAsync () const
+{
+  return Readback::Make(m_stream ? m_stream->GetId() : m_buffer.Get(),m_offset,m_size);
+}
+
+TexBuffer::FORMAT TexBuffer::GetFormat () const
+{
+  return m_format;
+}
+
+unsigned int TexBuffer::GetInternalFormat () const
+{
+  switch (m_format) {
+    case RG32F: return GL_RG32F;
+    case RGBA32F: return GL_RGBA32F;
+    default: return GL_R32F;
+  }
+}
+
 TexBuffer::~TexBuffer ()
 {
 }
 
 unsigned int TexBuffer::GetTexId () const
 {
-  return m_tex;
+  return m_tex.Get();
 }
 
 const std::string& TexBuffer::GetName () const
@@ -61,7 +99,7 @@ void TexBuffer::Load (StatePtr st)
 {
   ShaderPtr shd = st->GetShader();
   shd->ActiveTexture(m_varname.c_str());
-  glBindTexture(GL_TEXTURE_BUFFER,m_tex);
+  glBindTexture(GL_TEXTURE_BUFFER,m_tex.Get());
 }
 
 void TexBuffer::Unload (StatePtr st)
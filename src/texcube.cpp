@@ -1,5 +1,6 @@
 #include "texcube.h"
 #include "image.h"
+#include "resourcemanager.h"
 #include "state.h"
 
 #include <glad/glad.h>
@@ -14,38 +15,45 @@ TexCubePtr TexCube::Make (const std::string& varname, const std::string& filenam
 }
 
 TexCube::TexCube (const std::string& varname, const std::string& filename)
+: m_varname(varname)
 {
-  ImagePtr img = Image::Make(filename);
+  m_shared = ResourceManager::Get<GLTexture>(ResourceManager::TEXCUBE,filename,[&filename]() {
+    ImagePtr img = Image::Make(filename);
 
-  glGenTextures(1,&m_tex);
-  glBindTexture(GL_TEXTURE_CUBE_MAP,m_tex);
+    auto tex = std::make_shared<GLTexture>();
+    tex->Create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP,tex->Get());
 
-  // subimages' dimension
-  int w = img->GetWidth() / 4;
-  int h = img->GetHeight() / 3;
-  int x[] = {2*w,  0,  w,  w,  w,3*w};
-  int y[] = {  h,  h,2*h,  0,  h,  h};
-  GLenum face[] = {
-    GL_TEXTURE_CUBE_MAP_POSITIVE_X,  // right
-    GL_TEXTURE_CUBE_MAP_NEGATIVE_X,  // left
-    GL_TEXTURE_CUBE_MAP_POSITIVE_Y,  // top
-    GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,  // bottom
-    GL_TEXTURE_CUBE_MAP_POSITIVE_Z,  // front
-    GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,  // back
-  };
-  unsigned char* subimg = new unsigned char[w*h*img->GetNChannels()];
-  for (int i=0; i<6; ++i) {
-    img->ExtractSubimage(x[i],y[i],w,h,subimg);
-    glTexImage2D(face[i],0,GL_RGB,w,h,0,
-                 img->GetNChannels()==3?GL_RGB:GL_RGBA,
-                 GL_UNSIGNED_BYTE,subimg);
-  }
-  delete [] subimg;
-  glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);	
-  glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);	
-  glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_R,GL_CLAMP_TO_EDGE);	
+    // subimages' dimension
+    int w = img->GetWidth() / 4;
+    int h = img->GetHeight() / 3;
+    int x[] = {2*w,  0,  w,  w,  w,3*w};
+    int y[] = {  h,  h,2*h,  0,  h,  h};
+    GLenum face[] = {
+      GL_TEXTURE_CUBE_MAP_POSITIVE_X,  // right
+      GL_TEXTURE_CUBE_MAP_NEGATIVE_X,  // left
+      GL_TEXTURE_CUBE_MAP_POSITIVE_Y,  // top
+      GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,  // bottom
+      GL_TEXTURE_CUBE_MAP_POSITIVE_Z,  // front
+      GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,  // back
+    };
+    unsigned char* subimg = new unsigned char[w*h*img->GetNChannels()];
+    for (int i=0; i<6; ++i) {
+      img->ExtractSubimage(x[i],y[i],w,h,subimg);
+      glTexImage2D(face[i],0,GL_RGB,w,h,0,
+                   img->GetNChannels()==3?GL_RGB:GL_RGBA,
+                   GL_UNSIGNED_BYTE,subimg);
+    }
+    delete [] subimg;
+    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);	
+    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);	
+    glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_R,GL_CLAMP_TO_EDGE);	
+    tex->SetBytes(6L*w*h*3);
+    return ResourceManager::Resource{tex,0,tex->GetBytes()};
+  });
+  m_tex = m_shared->Get();
 }
 
 TexCube::~TexCube ()
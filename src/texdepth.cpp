@@ -7,22 +7,37 @@
 
 TexDepthPtr TexDepth::Make (const std::string& varname, int width, int height)
 {
-  return TexDepthPtr(new TexDepth(varname,width,height));
+  return TexDepthPtr(new TexDepth(varname,width,height,false));
 }
 
-TexDepth::TexDepth (const std::string& varname, int width, int height)
+TexDepthPtr TexDepth::MakeCube (const std::string& varname, int size)
+{
+  return TexDepthPtr(new TexDepth(varname,size,size,true));
+}
+
+TexDepth::TexDepth (const std::string& varname, int width, int height, bool cube)
 : m_varname(varname),
-  m_width(width), m_height(height)
+  m_width(width), m_height(height),
+  m_cube(cube)
 {
-  glGenTextures(1,&m_tex);
-  glBindTexture(GL_TEXTURE_2D,m_tex);
-  glTexImage2D(GL_TEXTURE_2D,0,GL_DEPTH_COMPONENT,m_width,m_height,0,
-               GL_DEPTH_COMPONENT,GL_FLOAT,0);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);	
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glBindTexture(GL_TEXTURE_2D,0);
+  GLenum target = m_cube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  m_tex.Create();
+  glBindTexture(target,m_tex.Get());
+  if (m_cube) {
+    for (int i=0; i<6; ++i)
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i,0,GL_DEPTH_COMPONENT,m_width,m_height,0,
+                   GL_DEPTH_COMPONENT,GL_FLOAT,0);
+    glTexParameteri(target,GL_TEXTURE_WRAP_R,GL_CLAMP_TO_EDGE);
+  }
+  else
+    glTexImage2D(GL_TEXTURE_2D,0,GL_DEPTH_COMPONENT,m_width,m_height,0,
+                 GL_DEPTH_COMPONENT,GL_FLOAT,0);
+  m_tex.SetBytes((m_cube ? 6L : 1L)*m_width*m_height*4);
+  glTexParameteri(target,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);	
+  glTexParameteri(target,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+  glTexParameteri(target,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+  glTexParameteri(target,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+  glBindTexture(target,0);
 }
 
 TexDepth::~TexDepth ()
@@ -31,22 +46,38 @@ TexDepth::~TexDepth ()
 
 unsigned int TexDepth::GetTexId () const
 {
-  return m_tex;
+  return m_tex.Get();
+}
+
+int TexDepth::GetWidth () const
+{
+  return m_width;
+}
+
+int TexDepth::GetHeight () const
+{
+  return m_height;
+}
+
+bool TexDepth::IsCube () const
+{
+  return m_cube;
 }
 
 void TexDepth::SetCompareMode ()
 {
-  glBindTexture(GL_TEXTURE_2D,m_tex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
-  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-  glBindTexture(GL_TEXTURE_2D,0);
+  GLenum target = m_cube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  glBindTexture(target,m_tex.Get());
+  glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  glTexParameteri (target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glBindTexture(target,0);
 }
 
 void TexDepth::Load (StatePtr st)
 {
   ShaderPtr shd = st->GetShader();
   shd->ActiveTexture(m_varname.c_str());
-  glBindTexture(GL_TEXTURE_2D,m_tex);
+  glBindTexture(m_cube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D,m_tex.Get());
 }
 
 void TexDepth::Unload (StatePtr st)
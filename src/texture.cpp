@@ -1,5 +1,6 @@
 #include "texture.h"
 #include "image.h"
+#include "resourcemanager.h"
 #include "state.h"
 
 #include <glm/gtc/type_ptr.hpp>
@@ -11,9 +12,9 @@ TexturePtr Texture::Make (const std::string& varname, const std::string& filenam
 {
   return TexturePtr(new Texture(varname,filename));
 }
-TexturePtr Texture::Make (const std::string& varname, int width, int height)
+TexturePtr Texture::Make (const std::string& varname, int width, int height, FORMAT format)
 {
-  return TexturePtr(new Texture(varname,width,height));
+  return TexturePtr(new Texture(varname,width,height,format));
 }
 TexturePtr Texture::Make (const std::string& varname, const glm::vec3& texel)
 {
@@ -23,28 +24,51 @@ TexturePtr Texture::Make (const std::string& varname, const glm::vec3& texel)
 Texture::Texture (const std::string& varname, const std::string& filename)
 : m_varname(varname)
 {
-  ImagePtr img = Image::Make(filename);
-  glGenTextures(1,&m_tex);
-  glBindTexture(GL_TEXTURE_2D,m_tex);
-  glTexImage2D(GL_TEXTURE_2D,0,img->GetNChannels()==3?GL_RGB:GL_RGBA,
-               img->GetWidth(),img->GetHeight(),0,
-               img->GetNChannels()==3?GL_RGB:GL_RGBA,
-               GL_UNSIGNED_BYTE,img->GetData());
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);	
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glBindTexture(GL_TEXTURE_2D,0);
+  m_shared = ResourceManager::Get<GLTexture>(ResourceManager::TEXTURE,filename,[&filename]() {
+    ImagePtr img = Image::Make(filename);
+    auto tex = std::make_shared<GLTexture>();
+    tex->Create();
+    glBindTexture(GL_TEXTURE_2D,tex->Get());
+    glTexImage2D(GL_TEXTURE_2D,0,img->GetNChannels()==3?GL_RGB:GL_RGBA,
+                 img->GetWidth(),img->GetHeight(),0,
+                 img->GetNChannels()==3?GL_RGB:GL_RGBA,
+                 GL_UNSIGNED_BYTE,img->GetData());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);	
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D,0);
+    // texels of all levels: 4/3 of the base one
+    long bytes = long(img->GetWidth())*img->GetHeight()*(img->GetNChannels()==3?3:4)*4/3;
+    tex->SetBytes(bytes);
+    return ResourceManager::Resource{tex,0,bytes};
+  });
+  m_tex = m_shared->Get();
 }
 
-Texture::Texture (const std::string& varname, int width, int height)
+Texture::Texture (const std::string& varname, int width, int height, FORMAT format)
 : m_varname(varname)
 {
-  glGenTextures(1,&m_tex);
+  // internal format, pixel format and type, bytes per texel
+  static const struct {
+    GLint internal;
+    GLenum format;
+    GLenum type;
+    int bytes;
+  } formats[] = {
+    {GL_RGB8,GL_RGB,GL_UNSIGNED_BYTE,3},
+    {GL_RGBA8,GL_RGBA,GL_UNSIGNED_BYTE,4},
+    {GL_R16F,GL_RED,GL_FLOAT,2},
+    {GL_RGBA16F,GL_RGBA,GL_FLOAT,8},
+  };
+  m_shared = std::make_shared<GLTexture>();
+  m_shared->Create();
+  m_tex = m_shared->Get();
   glBindTexture(GL_TEXTURE_2D,m_tex);
-  glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,width,height,0,
-               GL_RGB,GL_UNSIGNED_BYTE,0);
+  glTexImage2D(GL_TEXTURE_2D,0,formats[format].internal,width,height,0,
+               formats[format].format,formats[format].type,0);
+  m_shared->SetBytes(long(width)*height*formats[format].bytes);
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);	
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
@@ -60,9 +84,12 @@ Texture::Texture (const std::string& varname, const glm::vec3& texel)
     (unsigned char)(texel[1]*255),
     (unsigned char)(texel[2]*255),
   };
-  glGenTextures(1,&m_tex);
+  m_shared = std::make_shared<GLTexture>();
+  m_shared->Create();
+  m_tex = m_shared->Get();
   glBindTexture(GL_TEXTURE_2D,m_tex);
   glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,1,1,0,GL_RGB,GL_UNSIGNED_BYTE,color);
+  m_shared->SetBytes(3);
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);	
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
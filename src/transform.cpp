@@ -1,4 +1,5 @@
 #include "transform.h"
+#include "allocation.h"
 #include "state.h"
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -7,7 +8,7 @@
 
 TransformPtr Transform::Make ()
 {
-  return TransformPtr(new Transform());
+  return Allocation::Make<Transform>();
 }
 
 Transform::Transform ()
@@ -0,0 +1,116 @@
+#include "transparencypass.h"
+
+#include <glad/glad.h>
+
+TransparencyPassPtr TransparencyPass::Make (const std::string& vertex, const std::string& fragment)
+{
+  return TransparencyPassPtr(new TransparencyPass(vertex,fragment));
+}
+
+TransparencyPass::TransparencyPass (const std::string& vertex, const std::string& fragment)
+: m_composite(Shader::Make()),
+  m_width(0), m_height(0),
+  m_depth(nullptr),
+  m_opaque(nullptr),
+  m_accum(nullptr),
+  m_reveal(nullptr),
+  m_opaque_fbo(nullptr),
+  m_oit_fbo(nullptr),
+  m_fbo(0),
+  m_blend(false),
+  m_depth_func(0),
+  m_depth_mask(0)
+{
+  m_composite->AttachVertexShader(vertex);
+  m_composite->AttachFragmentShader(fragment);
+  m_composite->Link();
+  m_vao.Create();
+  for (int i=0; i<4; ++i) {
+    m_viewport[i] = 0;
+    m_blend_func[i] = 0;
+  }
+}
+
+TransparencyPass::~TransparencyPass ()
+{
+}
+
+ShaderPtr TransparencyPass::GetCompositeShader () const
+{
+  return m_composite;
+}
+
+void TransparencyPass::BeginOpaque ()
+{
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING,&m_fbo);
+  glGetIntegerv(GL_VIEWPORT,m_viewport);
+  int width = m_viewport[2] > 0 ? m_viewport[2] : 1;
+  int height = m_viewport[3] > 0 ? m_viewport[3] : 1;
+  if (width != m_width || height != m_height) {
+    m_width = width;
+    m_height = height;
+    m_depth = TexDepth::Make("depth",m_width,m_height);
+    m_opaque = Texture::Make("opaque",m_width,m_height,Texture::RGBA8);
+    m_accum = Texture::Make("accum",m_width,m_height,Texture::RGBA16F);
+    m_reveal = Texture::Make("reveal",m_width,m_height,Texture::R16F);
+    m_opaque_fbo = Framebuffer::Make(m_depth,{m_opaque});
+    m_oit_fbo = Framebuffer::Make(m_depth,{m_accum,m_reveal});
+  }
+  m_opaque_fbo->Bind();
+  glViewport(0,0,m_width,m_height);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void TransparencyPass::BeginTranslucent ()
+{
+  static const float zero[4] = {0.0f,0.0f,0.0f,0.0f};
+  static const float one[4] = {1.0f,1.0f,1.0f,1.0f};
+  m_blend = glIsEnabled(GL_BLEND) == GL_TRUE;
+  glGetIntegerv(GL_BLEND_SRC_RGB,&m_blend_func[0]);
+  glGetIntegerv(GL_BLEND_DST_RGB,&m_blend_func[1]);
+  glGetIntegerv(GL_BLEND_SRC_ALPHA,&m_blend_func[2]);
+  glGetIntegerv(GL_BLEND_DST_ALPHA,&m_blend_func[3]);
+  glGetIntegerv(GL_DEPTH_FUNC,&m_depth_func);
+  glGetBooleanv(GL_DEPTH_WRITEMASK,&m_depth_mask);
+  m_oit_fbo->Bind();
+  glClearBufferfv(GL_COLOR,0,zero);
+  glClearBufferfv(GL_COLOR,1,one);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFunci(0,GL_ONE,GL_ONE);
+  glBlendFunci(1,GL_ZERO,GL_ONE_MINUS_SRC_COLOR);
+}
+
+void TransparencyPass::Composite ()
+{
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+  glBindFramebuffer(GL_FRAMEBUFFER,m_fbo);
+  glViewport(m_viewport[0],m_viewport[1],m_viewport[2],m_viewport[3]);
+
+  // depth is always written: the composite replaces the target contents
+  glDepthFunc(GL_ALWAYS);
+  m_composite->UseProgram();
+  m_composite->SetUniform("viewport",glm::vec4(float(m_viewport[0]),float(m_viewport[1]),
+                                               float(m_viewport[2]),float(m_viewport[3])));
+  const char* names[] = {"opaque","accum","reveal","depth"};
+  unsigned int texs[] = {m_opaque->GetTexId(),m_accum->GetTexId(),m_reveal->GetTexId(),
+                         m_depth->GetTexId()};
+  for (int i=0; i<4; ++i) {
+    glActiveTexture(GL_TEXTURE0+i);
+    glBindTexture(GL_TEXTURE_2D,texs[i]);
+    m_composite->SetUniform(names[i],i);
+  }
+  glBindVertexArray(m_vao.Get());
+  glDrawArrays(GL_TRIANGLES,0,3);
+  glBindVertexArray(0);
+  for (int i=3; i>=0; --i) {
+    glActiveTexture(GL_TEXTURE0+i);
+    glBindTexture(GL_TEXTURE_2D,0);
+  }
+  glDepthFunc(m_depth_func);
+  glDepthMask(m_depth_mask);
+  glBlendFuncSeparate(m_blend_func[0],m_blend_func[1],m_blend_func[2],m_blend_func[3]);
+  if (m_blend)
+    glEnable(GL_BLEND);
+}
@@ -1,4 +1,5 @@
 #include "triangle.h"
+#include "allocation.h"
 
 #include <iostream>
 
@@ -6,20 +7,20 @@
 
 TrianglePtr Triangle::Make ()
 {
-  return TrianglePtr(new Triangle());
+  return Allocation::Make<Triangle>();
 }
 
 Triangle::Triangle ()
 {
   float coord[] = {-1.0f,0.0f,1.0f,0.0f,0.0f,1.0f};
   // create VAO
-  glGenVertexArrays(1,&m_vao);
-  glBindVertexArray(m_vao);
+  m_vao.Create();
+  glBindVertexArray(m_vao.Get());
   // create coord buffer
-  GLuint id;
-  glGenBuffers(1,&id);
-  glBindBuffer(GL_ARRAY_BUFFER,id);
+  m_coords.Create();
+  glBindBuffer(GL_ARRAY_BUFFER,m_coords.Get());
   glBufferData(GL_ARRAY_BUFFER,sizeof(coord),coord,GL_STATIC_DRAW);
+  m_coords.SetBytes(sizeof(coord));
   glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,0);  // coord
   glEnableVertexAttribArray(0);
 }
@@ -30,6 +31,20 @@ Triangle::~Triangle ()
 
 void Triangle::Draw (StatePtr )
 {
-  glBindVertexArray(m_vao);
+  glBindVertexArray(m_vao.Get());
   glDrawArrays(GL_TRIANGLES,0,3);
 }
+
+BBox Triangle::GetBounds () const
+{
+  return BBox(glm::vec3(-1.0f,0.0f,0.0f),glm::vec3(1.0f,1.0f,0.0f));
+}
+
+bool Triangle::GetMeshData (MeshData& data) const
+{
+  data.Clear();
+  data.coords = {glm::vec3(-1.0f,0.0f,0.0f),glm::vec3(1.0f,0.0f,0.0f),glm::vec3(0.0f,1.0f,0.0f)};
+  data.SetPrimitives(GL_TRIANGLES,3);
+  data.Complete();
+  return true;
+}
@@ -0,0 +1,67 @@
+#include "uniformbuffer.h"
+
+#include <glad/glad.h>
+
+UniformBufferPtr UniformBuffer::Make (int size)
+{
+  return UniformBufferPtr(new UniformBuffer(size));
+}
+
+UniformBuffer::UniformBuffer (int size)
+: m_size(size)
+{
+  m_ubo.Create();
+  glBindBuffer(GL_UNIFORM_BUFFER,m_ubo.Get());
+  glBufferData(GL_UNIFORM_BUFFER,size,0,GL_DYNAMIC_DRAW);
+  m_ubo.SetBytes(size);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+}
+
+UniformBuffer::~UniformBuffer ()
+{
+}
+
+unsigned int UniformBuffer::GetId () const
+{
+  return m_ubo.Get();
+}
+
+int UniformBuffer::GetSize () const
+{
+  return m_size;
+}
+
+void UniformBuffer::SetData (const void* data, int size, int offset)
+{
+  glBindBuffer(GL_UNIFORM_BUFFER,m_ubo.Get());
+  glBufferSubData(GL_UNIFORM_BUFFER,offset,size,data);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+}
+
+void UniformBuffer::Bind (int binding) const
+{
+  glBindBufferBase(GL_UNIFORM_BUFFER,binding,m_ubo.Get());
+}
+
+void UniformBuffer::BindRange (int binding, int offset, int size) const
+{
+  glBindBufferRange(GL_UNIFORM_BUFFER,binding,m_ubo.Get(),offset,size);
+}
+
+int UniformBuffer::GetOffsetAlignment ()
+{
+  static GLint align = 0;
+  if (align == 0)
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,&align);
+  return align;
+}
+
+const char* UniformBuffer::GetBlockName (int binding)
+{
+  switch (binding) {
+    case FRAME: return "FrameBlock";
+    case DRAW: return "DrawBlock";
+    case MATERIAL: return "MaterialBlock";
+  }
+  return "";
+}
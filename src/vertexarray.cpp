@@ -0,0 +1,101 @@
+#include "vertexarray.h"
+#include "geometrycache.h"
+
+#include <glad/glad.h>
+
+VertexArrayPtr VertexArray::Make ()
+{
+  return VertexArrayPtr(new VertexArray());
+}
+
+VertexArray::VertexArray ()
+: m_mode(GL_TRIANGLES),
+  m_count(0),
+  m_bytes(0)
+{
+  m_vao.Create();
+}
+
+VertexArray::~VertexArray ()
+{
+  GeometryCache::Account(-m_bytes);
+}
+
+int VertexArray::AddBuffer (int n, const float* data)
+{
+  GLBuffer buffer;
+  buffer.Create();
+  glBindBuffer(GL_ARRAY_BUFFER,buffer.Get());
+  glBufferData(GL_ARRAY_BUFFER,n*sizeof(float),data,GL_STATIC_DRAW);
+  buffer.SetBytes(long(n*sizeof(float)));
+  m_buffers.push_back(std::move(buffer));
+  m_bytes += long(n*sizeof(float));
+  GeometryCache::Account(long(n*sizeof(float)));
+  return int(m_buffers.size()) - 1;
+}
+
+void VertexArray::SetAttribute (int loc, int buffer, int ncomp)
+{
+  glBindVertexArray(m_vao.Get());
+  glBindBuffer(GL_ARRAY_BUFFER,m_buffers[buffer].Get());
+  glVertexAttribPointer(loc,ncomp,GL_FLOAT,GL_FALSE,0,0);
+  glEnableVertexAttribArray(loc);
+  m_attributes.push_back({loc,buffer,ncomp});
+}
+
+void VertexArray::SetIndices (int n, const unsigned int* indices)
+{
+  glBindVertexArray(m_vao.Get());
+  if (!m_index)
+    m_index.Create();
+  else {
+    m_bytes -= long(m_count*sizeof(unsigned int));
+    GeometryCache::Account(-long(m_count*sizeof(unsigned int)));
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,m_index.Get());
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,n*sizeof(unsigned int),indices,GL_STATIC_DRAW);
+  m_index.SetBytes(long(n*sizeof(unsigned int)));
+  m_count = n;
+  m_bytes += long(n*sizeof(unsigned int));
+  GeometryCache::Account(long(n*sizeof(unsigned int)));
+}
+
+void VertexArray::SetMode (unsigned int mode, int count)
+{
+  m_mode = mode;
+  if (!m_index)
+    m_count = count;
+}
+
+long VertexArray::GetBytes () const
+{
+  return m_bytes;
+}
+
+bool VertexArray::Read (MeshData& data) const
+{
+  data.Clear();
+  for (const Attribute& attrib : m_attributes) {
+    const GLBuffer& buffer = m_buffers[attrib.buffer];
+    std::vector<float> values(buffer.GetBytes()/sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER,buffer.Get());
+    glGetBufferSubData(GL_ARRAY_BUFFER,0,buffer.GetBytes(),values.data());
+    data.SetAttribute(attrib.loc,values.data(),int(values.size()),attrib.ncomp);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+  if (!m_index)
+    return data.SetPrimitives(m_mode,m_count);
+  std::vector<unsigned int> indices(m_count);
+  glBindVertexArray(m_vao.Get());
+  glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER,0,m_count*sizeof(unsigned int),indices.data());
+  return data.SetPrimitives(m_mode,m_count,indices.data());
+}
+
+void VertexArray::Draw () const
+{
+  glBindVertexArray(m_vao.Get());
+  if (m_index)
+    glDrawElements(m_mode,m_count,GL_UNSIGNED_INT,0);
+  else
+    glDrawArrays(m_mode,0,m_count);
+}